@@ -0,0 +1,236 @@
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocation_tracker.hpp"
+
+static constexpr size_t kSubsystemCount = static_cast<size_t>(AllocationSubsystemE::COUNT);
+
+// constant initialized, usable by operator new before any dynamic initialization
+static std::array<std::atomic<uint64_t>, kSubsystemCount> s_allocationCounts = {};
+static std::array<std::atomic<uint64_t>, kSubsystemCount> s_allocationBytes = {};
+static std::array<AllocationCountersT, kSubsystemCount> s_frameBegin = {};
+
+static thread_local AllocationSubsystemE t_subsystem = AllocationSubsystemE::OTHER;
+
+const char* getAllocationSubsystemName(const AllocationSubsystemE subsystem)
+{
+    switch (subsystem)
+    {
+    case AllocationSubsystemE::WSI:
+        return "wsi";
+    case AllocationSubsystemE::RENDERER:
+        return "renderer";
+    case AllocationSubsystemE::DEVICE:
+        return "device";
+    case AllocationSubsystemE::RESOURCES:
+        return "resources";
+    case AllocationSubsystemE::OTHER:
+    default:
+        return "other";
+    }
+}
+
+AllocationScope::AllocationScope(const AllocationSubsystemE subsystem) : m_previous(t_subsystem)
+{
+    t_subsystem = subsystem;
+}
+
+AllocationScope::~AllocationScope()
+{
+    t_subsystem = m_previous;
+}
+
+bool AllocationTracker::isEnabled()
+{
+#ifdef ENABLE_ALLOCATION_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocationTracker::beginFrame()
+{
+    for (size_t i = 0; i < kSubsystemCount; ++i)
+        s_frameBegin[i] = getTotalCounters(static_cast<AllocationSubsystemE>(i));
+}
+
+AllocationCountersT AllocationTracker::getTotalCounters(const AllocationSubsystemE subsystem)
+{
+    const size_t i = static_cast<size_t>(subsystem);
+    return AllocationCountersT{
+        .allocationCount = s_allocationCounts[i].load(std::memory_order_relaxed),
+        .bytes = s_allocationBytes[i].load(std::memory_order_relaxed),
+    };
+}
+
+AllocationCountersT AllocationTracker::getFrameCounters(const AllocationSubsystemE subsystem)
+{
+    const AllocationCountersT total = getTotalCounters(subsystem);
+    const AllocationCountersT& begin = s_frameBegin[static_cast<size_t>(subsystem)];
+    return AllocationCountersT{
+        .allocationCount = total.allocationCount - begin.allocationCount,
+        .bytes = total.bytes - begin.bytes,
+    };
+}
+
+uint64_t AllocationTracker::getFrameAllocationCount()
+{
+    uint64_t count = 0U;
+    for (size_t i = 0; i < kSubsystemCount; ++i)
+        count += getFrameCounters(static_cast<AllocationSubsystemE>(i)).allocationCount;
+    return count;
+}
+
+void AllocationTracker::dumpFrame(std::ostream& os)
+{
+    // the counts are read before the stream formats anything, which may allocate
+    std::array<AllocationCountersT, kSubsystemCount> counters;
+    for (size_t i = 0; i < kSubsystemCount; ++i)
+        counters[i] = getFrameCounters(static_cast<AllocationSubsystemE>(i));
+
+    os << "frame allocations :";
+    for (size_t i = 0; i < kSubsystemCount; ++i)
+    {
+        os << " " << getAllocationSubsystemName(static_cast<AllocationSubsystemE>(i)) << " "
+           << counters[i].allocationCount << " (" << counters[i].bytes << " bytes)"
+           << (i + 1 < kSubsystemCount ? "," : "");
+    }
+    os << std::endl;
+}
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+
+static inline void track(const size_t size)
+{
+    const size_t i = static_cast<size_t>(t_subsystem);
+    s_allocationCounts[i].fetch_add(1U, std::memory_order_relaxed);
+    s_allocationBytes[i].fetch_add(size, std::memory_order_relaxed);
+}
+
+static inline void* trackedAllocate(const size_t size)
+{
+    track(size);
+    return std::malloc(size == 0U ? 1U : size);
+}
+
+static inline void* trackedAllocate(const size_t size, const std::align_val_t alignment)
+{
+    track(size);
+    const size_t align = static_cast<size_t>(alignment);
+#if defined(_WIN32)
+    return _aligned_malloc(size == 0U ? 1U : size, align);
+#else
+    // aligned_alloc wants a size multiple of the alignment
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+}
+
+static inline void alignedFree(void* ptr)
+{
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void* operator new(const size_t size)
+{
+    void* ptr = trackedAllocate(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new[](const size_t size)
+{
+    void* ptr = trackedAllocate(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new(const size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size);
+}
+void* operator new[](const size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size);
+}
+void* operator new(const size_t size, const std::align_val_t alignment)
+{
+    void* ptr = trackedAllocate(size, alignment);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new[](const size_t size, const std::align_val_t alignment)
+{
+    void* ptr = trackedAllocate(size, alignment);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new(const size_t size, const std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size, alignment);
+}
+void* operator new[](const size_t size, const std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void* ptr, const size_t) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr, const size_t) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void* ptr, const std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+void operator delete[](void* ptr, const std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+void operator delete(void* ptr, const size_t, const std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+void operator delete[](void* ptr, const size_t, const std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+void operator delete(void* ptr, const std::align_val_t, const std::nothrow_t&) noexcept
+{
+    alignedFree(ptr);
+}
+void operator delete[](void* ptr, const std::align_val_t, const std::nothrow_t&) noexcept
+{
+    alignedFree(ptr);
+}
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief subsystem heap allocations are accounted to, set per thread by AllocationScope
+ *
+ */
+enum class AllocationSubsystemE
+{
+    OTHER = 0,
+    WSI = 1,
+    RENDERER = 2,
+    DEVICE = 3,
+    RESOURCES = 4,
+    COUNT = 5,
+};
+
+[[nodiscard]] const char* getAllocationSubsystemName(const AllocationSubsystemE subsystem);
+
+struct AllocationCountersT
+{
+    uint64_t allocationCount = 0U;
+    uint64_t bytes = 0U;
+};
+
+/**
+ * @brief accounts the heap allocations of the calling thread to a subsystem until destroyed,
+ * scopes nest
+ *
+ */
+class AllocationScope
+{
+  private:
+    AllocationSubsystemE m_previous;
+
+  public:
+    AllocationScope() = delete;
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+    AllocationScope(AllocationScope&&) = delete;
+    AllocationScope& operator=(AllocationScope&&) = delete;
+
+    explicit AllocationScope(const AllocationSubsystemE subsystem);
+    ~AllocationScope();
+};
+
+/**
+ * @brief counts the global operator new calls per subsystem and per frame
+ * the counting replacement of operator new and delete is only compiled with
+ * ENABLE_ALLOCATION_TRACKING, the counters stay at zero otherwise
+ *
+ */
+class AllocationTracker
+{
+  public:
+    AllocationTracker() = delete;
+
+    [[nodiscard]] static bool isEnabled();
+
+    /**
+     * @brief start counting a new frame, called once per frame by the main loop
+     *
+     */
+    static void beginFrame();
+
+    /**
+     * @brief allocations since the last beginFrame
+     *
+     */
+    [[nodiscard]] static AllocationCountersT getFrameCounters(const AllocationSubsystemE subsystem);
+    [[nodiscard]] static uint64_t getFrameAllocationCount();
+    /**
+     * @brief allocations since the start of the process
+     *
+     */
+    [[nodiscard]] static AllocationCountersT getTotalCounters(const AllocationSubsystemE subsystem);
+
+    /**
+     * @brief allocations of the current frame per subsystem, on a single line
+     *
+     */
+    static void dumpFrame(std::ostream& os);
+};
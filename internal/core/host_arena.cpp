@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <new>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "host_arena.hpp"
+
+static constexpr size_t kBlockAlignment = 64U;
+
+static inline size_t alignUp(const size_t value, const size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief offset of the first aligned address at or after the head of the block
+ *
+ */
+static inline size_t alignOffset(const uint8_t* data, const size_t head, const size_t alignment)
+{
+    const uintptr_t address = reinterpret_cast<uintptr_t>(data) + head;
+    return alignUp(address, alignment) - reinterpret_cast<uintptr_t>(data);
+}
+
+static HostArenaCreateInfoT s_threadFrameArenaCreateInfo = {};
+static std::atomic<uint64_t> s_frameIndex = 1U;
+
+HostArena::HostArena(const HostArenaCreateInfoT createInfo) : ci(createInfo)
+{
+    if (!createBlock(ci.blockSize))
+        std::cerr << "Failed to create a host arena block of " << ci.blockSize << " bytes"
+                  << std::endl;
+}
+
+HostArena::~HostArena()
+{
+    for (auto& block : m_blocks)
+        destroyBlock(block);
+}
+
+bool HostArena::createBlock(const size_t size)
+{
+    BlockT block;
+    block.size = size;
+
+    if (ci.bHugePages)
+    {
+#if defined(_WIN32)
+        // large pages need the SeLockMemoryPrivilege, regular pages are used when not granted
+        const size_t largePageSize = GetLargePageMinimum();
+        if (largePageSize > 0U)
+        {
+            block.size = alignUp(size, largePageSize);
+            block.data = static_cast<uint8_t*>(
+                VirtualAlloc(nullptr, block.size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                             PAGE_READWRITE));
+            if (block.data)
+                ++m_hugePageBlockCount;
+        }
+        if (!block.data)
+        {
+            block.data = static_cast<uint8_t*>(
+                VirtualAlloc(nullptr, block.size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+        }
+#elif defined(__linux__)
+        // reserved huge pages first, then transparent huge pages on regular mappings
+        constexpr size_t kHugePageSize = 2ULL << 20;
+        block.size = alignUp(size, kHugePageSize);
+        void* data = mmap(nullptr, block.size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED)
+            ++m_hugePageBlockCount;
+        else
+        {
+            data = mmap(nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1, 0);
+            if (data != MAP_FAILED && madvise(data, block.size, MADV_HUGEPAGE) == 0)
+                ++m_hugePageBlockCount;
+        }
+        block.data = data != MAP_FAILED ? static_cast<uint8_t*>(data) : nullptr;
+#endif
+        block.bPageMapped = block.data != nullptr;
+    }
+
+    if (!block.data)
+    {
+        block.size = size;
+        block.data = static_cast<uint8_t*>(
+            ::operator new(block.size, std::align_val_t(kBlockAlignment), std::nothrow));
+    }
+    if (!block.data)
+        return false;
+
+    m_blocks.emplace_back(block);
+    return true;
+}
+
+void HostArena::destroyBlock(BlockT& block)
+{
+    if (!block.bPageMapped)
+    {
+        ::operator delete(block.data, std::align_val_t(kBlockAlignment));
+        return;
+    }
+
+#if defined(_WIN32)
+    VirtualFree(block.data, 0, MEM_RELEASE);
+#elif defined(__linux__)
+    munmap(block.data, block.size);
+#endif
+}
+
+void* HostArena::allocate(const size_t size, const size_t alignment)
+{
+    // blocks are filled in order, the space left at the end of a block is lost until the reset
+    for (; m_currentBlock < m_blocks.size(); ++m_currentBlock)
+    {
+        auto& block = m_blocks[m_currentBlock];
+        const size_t offset = alignOffset(block.data, block.head, alignment);
+        if (offset + size <= block.size)
+        {
+            block.head = offset + size;
+            m_usedSize += size;
+            m_peakSize = std::max(m_peakSize, m_usedSize);
+            return block.data + offset;
+        }
+    }
+
+    if (!createBlock(std::max(ci.blockSize, size + alignment)))
+    {
+        std::cerr << "Failed to grow the host arena for " << size << " bytes" << std::endl;
+        return nullptr;
+    }
+    ++m_grownCount;
+
+    auto& block = m_blocks.back();
+    const size_t offset = alignOffset(block.data, 0U, alignment);
+    block.head = offset + size;
+    m_usedSize += size;
+    m_peakSize = std::max(m_peakSize, m_usedSize);
+    return block.data + offset;
+}
+
+void HostArena::reset()
+{
+    for (auto& block : m_blocks)
+        block.head = 0U;
+    m_currentBlock = 0U;
+    m_usedSize = 0U;
+}
+
+HostArena& HostArena::getThreadFrameArena()
+{
+    thread_local HostArena arena(s_threadFrameArenaCreateInfo);
+
+    const uint64_t frameIndex = s_frameIndex.load(std::memory_order_relaxed);
+    if (arena.m_frameIndex != frameIndex)
+    {
+        arena.reset();
+        arena.m_frameIndex = frameIndex;
+    }
+    return arena;
+}
+
+void HostArena::beginFrame()
+{
+    s_frameIndex.fetch_add(1U, std::memory_order_relaxed);
+}
+
+void HostArena::setThreadFrameArenaCreateInfo(const HostArenaCreateInfoT createInfo)
+{
+    s_threadFrameArenaCreateInfo = createInfo;
+}
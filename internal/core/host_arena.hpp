@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+struct HostArenaCreateInfoT
+{
+    size_t blockSize = 1ULL << 20;
+    /**
+     * @brief back the blocks with large pages when the system grants them (reserved huge pages or
+     * transparent huge pages on Linux, SeLockMemoryPrivilege on Windows), regular pages otherwise
+     *
+     */
+    bool bHugePages = false;
+};
+
+/**
+ * @brief linear allocator for transient host data
+ * allocations are bump pointers in large blocks and are never freed one by one, reset rewinds the
+ * whole arena, a block is added when the arena runs out of space and kept for the next uses, so
+ * the steady state makes no heap allocation
+ * only trivially destructible data can live in it since nothing is destroyed
+ * not thread safe, one arena per thread (see getThreadFrameArena)
+ *
+ */
+class HostArena
+{
+  private:
+    const HostArenaCreateInfoT ci;
+
+  private:
+    struct BlockT
+    {
+        uint8_t* data = nullptr;
+        size_t size = 0U;
+        size_t head = 0U;
+        bool bPageMapped = false;
+    };
+
+    std::vector<BlockT> m_blocks;
+    size_t m_currentBlock = 0U;
+
+    size_t m_usedSize = 0U;
+    size_t m_peakSize = 0U;
+    uint32_t m_grownCount = 0U;
+    uint32_t m_hugePageBlockCount = 0U;
+
+    /**
+     * @brief frame the thread frame arena was last rewound for
+     *
+     */
+    uint64_t m_frameIndex = 0U;
+
+    [[nodiscard]] bool createBlock(const size_t size);
+    static void destroyBlock(BlockT& block);
+
+  public:
+    HostArena() = delete;
+    HostArena(const HostArena&) = delete;
+    HostArena& operator=(const HostArena&) = delete;
+    HostArena(HostArena&&) = delete;
+    HostArena& operator=(HostArena&&) = delete;
+
+    explicit HostArena(const HostArenaCreateInfoT createInfo);
+    ~HostArena();
+
+    /**
+     * @return nullptr if a new block could not be created
+     */
+    [[nodiscard]] void* allocate(const size_t size,
+                                 const size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * @brief uninitialized storage for count elements
+     *
+     */
+    template<class T>
+        requires std::is_trivially_destructible<T>::value
+    [[nodiscard]] inline T* allocateArray(const size_t count)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief rewind the arena, everything allocated from it must not be in use anymore
+     *
+     */
+    void reset();
+
+    /**
+     * @brief arena of the calling thread, rewound the first time it is requested in a frame, its
+     * allocations stay valid until the end of the frame
+     *
+     */
+    [[nodiscard]] static HostArena& getThreadFrameArena();
+    /**
+     * @brief start a new frame for every thread frame arena, called once per frame by the main
+     * loop
+     *
+     */
+    static void beginFrame();
+    /**
+     * @brief create info of the thread frame arenas, must be set before any thread requests its
+     * arena
+     *
+     */
+    static void setThreadFrameArenaCreateInfo(const HostArenaCreateInfoT createInfo);
+
+  public:
+    [[nodiscard]] inline size_t getUsedSize() const { return m_usedSize; }
+    /**
+     * @brief largest size used between two resets
+     *
+     */
+    [[nodiscard]] inline size_t getPeakSize() const { return m_peakSize; }
+    /**
+     * @brief blocks created after the construction because the arena ran out of them
+     *
+     */
+    [[nodiscard]] inline uint32_t getGrownCount() const { return m_grownCount; }
+    [[nodiscard]] inline size_t getBlockCount() const { return m_blocks.size(); }
+    [[nodiscard]] inline uint32_t getHugePageBlockCount() const { return m_hugePageBlockCount; }
+};
+
+/**
+ * @brief standard allocator over an arena, for containers holding transient data
+ * deallocation is a no-op, the memory comes back when the arena is rewound
+ *
+ */
+template<class T> class HostArenaAllocator
+{
+  private:
+    HostArena* m_arena;
+
+    template<class U> friend class HostArenaAllocator;
+
+  public:
+    typedef T value_type;
+
+    explicit HostArenaAllocator(HostArena& arena) : m_arena(&arena) {}
+    template<class U>
+    HostArenaAllocator(const HostArenaAllocator<U>& other) : m_arena(other.m_arena)
+    {
+    }
+
+    [[nodiscard]] T* allocate(const size_t count)
+    {
+        return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, const size_t) {}
+
+    template<class U> bool operator==(const HostArenaAllocator<U>& other) const
+    {
+        return m_arena == other.m_arena;
+    }
+    template<class U> bool operator!=(const HostArenaAllocator<U>& other) const
+    {
+        return m_arena != other.m_arena;
+    }
+};
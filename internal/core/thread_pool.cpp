@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(const ThreadPoolCreateInfoT createInfo) : ci(createInfo)
+{
+    uint32_t threadCount = ci.threadCount;
+    if (threadCount == 0U)
+        threadCount = std::max(std::thread::hardware_concurrency(), 2U) - 1U;
+
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        m_workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_bStopping = true;
+        m_tasks.clear();
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+bool ThreadPool::isIdle()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_tasks.empty() && m_runningCount == 0U;
+}
+
+void ThreadPool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_bStopping || !m_tasks.empty(); });
+            if (m_bStopping)
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_runningCount;
+        }
+        task();
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        --m_runningCount;
+    }
+}
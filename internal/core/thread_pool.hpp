@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPoolCreateInfoT
+{
+    /**
+     * @brief 0 uses every hardware thread but the calling one, at least one worker is started
+     *
+     */
+    uint32_t threadCount = 0U;
+};
+
+/**
+ * @brief fixed set of worker threads running the submitted tasks in submission order
+ * tasks must not wait on each other, the pending ones are dropped on destruction after the running
+ * ones are done
+ *
+ */
+class ThreadPool
+{
+  private:
+    const ThreadPoolCreateInfoT ci;
+
+  private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::function<void()>> m_tasks;
+    uint32_t m_runningCount = 0U;
+    bool m_bStopping = false;
+
+    void run();
+
+  public:
+    ThreadPool() = delete;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    explicit ThreadPool(const ThreadPoolCreateInfoT createInfo);
+    ~ThreadPool();
+
+    /**
+     * @brief thread safe
+     *
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief no task is pending nor running
+     *
+     */
+    [[nodiscard]] bool isIdle();
+
+  public:
+    [[nodiscard]] inline size_t getThreadCount() const { return m_workers.size(); }
+};
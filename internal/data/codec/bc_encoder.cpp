@@ -0,0 +1,717 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <latch>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define BC_ENCODER_SSE2
+#endif
+
+#include "core/thread_pool.hpp"
+
+#include "bc_encoder.hpp"
+
+/**
+ * @brief texels of a block, channels stored apart so that four texels are processed per SIMD
+ * instruction
+ *
+ */
+struct alignas(16) BlockT
+{
+    float c[4][16];
+};
+
+static constexpr float kColorWeights[4] = {1.f, 1.f, 1.f, 0.f};
+static constexpr float kColorAlphaWeights[4] = {1.f, 1.f, 1.f, 1.f};
+
+/**
+ * @brief position of each BC1 index between the two endpoints
+ *
+ */
+static constexpr float kBC1IndexWeights[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+static constexpr float kBC4IndexWeights[8] = {0.f,       1.f,       1.f / 7.f, 2.f / 7.f,
+                                              3.f / 7.f, 4.f / 7.f, 5.f / 7.f, 6.f / 7.f};
+static constexpr uint32_t kBC7Weights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                             34, 38, 43, 47, 51, 55, 60, 64};
+
+const char* getBCFormatName(const BCFormatE format)
+{
+    switch (format)
+    {
+    case BCFormatE::BC1:
+        return "BC1";
+    case BCFormatE::BC3:
+        return "BC3";
+    case BCFormatE::BC4:
+        return "BC4";
+    case BCFormatE::BC5:
+        return "BC5";
+    case BCFormatE::BC7:
+    default:
+        return "BC7";
+    }
+}
+
+uint32_t getBCBlockSize(const BCFormatE format)
+{
+    return format == BCFormatE::BC1 || format == BCFormatE::BC4 ? 8U : 16U;
+}
+
+size_t getBCEncodedSize(const BCFormatE format, const uint32_t width, const uint32_t height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * getBCBlockSize(format);
+}
+
+VkFormat getBCVkFormat(const BCFormatE format, const bool bSRGB)
+{
+    switch (format)
+    {
+    case BCFormatE::BC1:
+        return bSRGB ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    case BCFormatE::BC3:
+        return bSRGB ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+    case BCFormatE::BC4:
+        return VK_FORMAT_BC4_UNORM_BLOCK;
+    case BCFormatE::BC5:
+        return VK_FORMAT_BC5_UNORM_BLOCK;
+    case BCFormatE::BC7:
+    default:
+        return bSRGB ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+    }
+}
+
+double BCEncodeStatsT::getMegapixelsPerSecondPerCore() const
+{
+    const double seconds = std::chrono::duration<double>(duration).count();
+    if (seconds <= 0.0 || threadCount == 0U)
+        return 0.0;
+    return static_cast<double>(pixelCount) / 1e6 / seconds / threadCount;
+}
+
+static void loadBlock(const BCSurfaceT& surface, const uint32_t blockX, const uint32_t blockY,
+                      BlockT& block)
+{
+    const size_t rowPitch = surface.rowPitch != 0U ? surface.rowPitch : surface.width * 4;
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+        const uint32_t sy = std::min(blockY * 4 + y, surface.height - 1);
+        for (uint32_t x = 0; x < 4; ++x)
+        {
+            const uint32_t sx = std::min(blockX * 4 + x, surface.width - 1);
+            const uint8_t* texel = surface.pixels + sy * rowPitch + sx * 4;
+            for (uint32_t c = 0; c < 4; ++c)
+                block.c[c][y * 4 + x] = texel[c];
+        }
+    }
+}
+
+/**
+ * @brief closest palette entry of each texel for the weighted squared distance
+ * @return the error of the block
+ */
+static float selectIndices(const BlockT& block, const float (*palette)[4],
+                           const uint32_t paletteSize, const float* weights, uint8_t* indices)
+{
+    float total = 0.f;
+#ifdef BC_ENCODER_SSE2
+    for (uint32_t i = 0; i < 16; i += 4)
+    {
+        const __m128 channels[4] = {
+            _mm_load_ps(&block.c[0][i]),
+            _mm_load_ps(&block.c[1][i]),
+            _mm_load_ps(&block.c[2][i]),
+            _mm_load_ps(&block.c[3][i]),
+        };
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (uint32_t p = 0; p < paletteSize; ++p)
+        {
+            __m128 distance = _mm_setzero_ps();
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const __m128 diff = _mm_sub_ps(channels[c], _mm_set1_ps(palette[p][c]));
+                const __m128 weighted = _mm_mul_ps(_mm_mul_ps(diff, diff), _mm_set1_ps(weights[c]));
+                distance = _mm_add_ps(distance, weighted);
+            }
+            const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+            best = _mm_min_ps(distance, best);
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(p))),
+                                     _mm_andnot_si128(closer, bestIndex));
+        }
+
+        alignas(16) int32_t selected[4];
+        alignas(16) float errors[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(selected), bestIndex);
+        _mm_store_ps(errors, best);
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            indices[i + k] = static_cast<uint8_t>(selected[k]);
+            total += errors[k];
+        }
+    }
+#else
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        float best = FLT_MAX;
+        for (uint32_t p = 0; p < paletteSize; ++p)
+        {
+            float distance = 0.f;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const float diff = block.c[c][i] - palette[p][c];
+                distance += diff * diff * weights[c];
+            }
+            if (distance < best)
+            {
+                best = distance;
+                indices[i] = static_cast<uint8_t>(p);
+            }
+        }
+        total += best;
+    }
+#endif
+    return total;
+}
+
+static void computeBoundingBox(const BlockT& block, const uint32_t channelCount, float lo[4],
+                               float hi[4])
+{
+    for (uint32_t c = 0; c < channelCount; ++c)
+    {
+        lo[c] = *std::min_element(block.c[c], block.c[c] + 16);
+        hi[c] = *std::max_element(block.c[c], block.c[c] + 16);
+    }
+}
+
+/**
+ * @brief endpoints at the extremes of the principal axis of the texels, found by power iteration
+ * of their covariance
+ *
+ */
+static void computePrincipalEndpoints(const BlockT& block, const uint32_t channelCount,
+                                      float e0[4], float e1[4])
+{
+    float mean[4] = {};
+    for (uint32_t c = 0; c < channelCount; ++c)
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+            mean[c] += block.c[c][i];
+        mean[c] /= 16.f;
+    }
+
+    float covariance[4][4] = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t a = 0; a < channelCount; ++a)
+        {
+            for (uint32_t b = a; b < channelCount; ++b)
+                covariance[a][b] += (block.c[a][i] - mean[a]) * (block.c[b][i] - mean[b]);
+        }
+    }
+    for (uint32_t a = 0; a < channelCount; ++a)
+    {
+        for (uint32_t b = 0; b < a; ++b)
+            covariance[a][b] = covariance[b][a];
+    }
+
+    // the diagonal of the bounding box is a good start, the iteration converges in a few steps
+    float lo[4], hi[4], axis[4] = {};
+    computeBoundingBox(block, channelCount, lo, hi);
+    for (uint32_t c = 0; c < channelCount; ++c)
+        axis[c] = hi[c] - lo[c];
+    for (uint32_t iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[4] = {};
+        float length = 0.f;
+        for (uint32_t a = 0; a < channelCount; ++a)
+        {
+            for (uint32_t b = 0; b < channelCount; ++b)
+                next[a] += covariance[a][b] * axis[b];
+            length += next[a] * next[a];
+        }
+        if (length < 1e-12f)
+            break;
+        length = 1.f / std::sqrt(length);
+        for (uint32_t c = 0; c < channelCount; ++c)
+            axis[c] = next[c] * length;
+    }
+
+    float tMin = FLT_MAX, tMax = -FLT_MAX;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        float t = 0.f;
+        for (uint32_t c = 0; c < channelCount; ++c)
+            t += (block.c[c][i] - mean[c]) * axis[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (uint32_t c = 0; c < channelCount; ++c)
+    {
+        e0[c] = std::clamp(mean[c] + tMin * axis[c], 0.f, 255.f);
+        e1[c] = std::clamp(mean[c] + tMax * axis[c], 0.f, 255.f);
+    }
+}
+
+/**
+ * @brief least squares endpoints for the selected indices, each index interpolating the endpoints
+ * with its weight
+ * @return false if the indices do not constrain both endpoints
+ */
+static bool refineEndpoints(const BlockT& block, const uint32_t firstChannel,
+                            const uint32_t channelCount, const uint8_t* indices,
+                            const float* indexWeights, float e0[4], float e1[4])
+{
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    float ax[4] = {}, bx[4] = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        const float t = indexWeights[indices[i]];
+        const float s = 1.f - t;
+        aa += s * s;
+        ab += s * t;
+        bb += t * t;
+        for (uint32_t c = firstChannel; c < firstChannel + channelCount; ++c)
+        {
+            ax[c] += s * block.c[c][i];
+            bx[c] += t * block.c[c][i];
+        }
+    }
+
+    const float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f)
+        return false;
+    const float inverse = 1.f / determinant;
+    for (uint32_t c = firstChannel; c < firstChannel + channelCount; ++c)
+    {
+        e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.f, 255.f);
+        e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.f, 255.f);
+    }
+    return true;
+}
+
+static inline uint16_t packRGB565(const float color[4])
+{
+    const uint32_t r = static_cast<uint32_t>(color[0] * 31.f / 255.f + 0.5f);
+    const uint32_t g = static_cast<uint32_t>(color[1] * 63.f / 255.f + 0.5f);
+    const uint32_t b = static_cast<uint32_t>(color[2] * 31.f / 255.f + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static inline void unpackRGB565(const uint16_t packed, float color[4])
+{
+    const uint32_t r = (packed >> 11) & 31U;
+    const uint32_t g = (packed >> 5) & 63U;
+    const uint32_t b = packed & 31U;
+    color[0] = static_cast<float>((r << 3) | (r >> 2));
+    color[1] = static_cast<float>((g << 2) | (g >> 4));
+    color[2] = static_cast<float>((b << 3) | (b >> 2));
+    color[3] = 0.f;
+}
+
+static void writeLittleEndian(uint8_t* dst, uint64_t value, const uint32_t byteCount)
+{
+    for (uint32_t i = 0; i < byteCount; ++i, value >>= 8)
+        dst[i] = static_cast<uint8_t>(value & 0xFFU);
+}
+
+/**
+ * @brief four color block, the endpoints are ordered so that decoders never pick the three color
+ * mode (whose last index is transparent black)
+ *
+ */
+static void encodeBC1(const BlockT& block, const BCQualityE quality, uint8_t* dst)
+{
+    float e0[4] = {}, e1[4] = {};
+    if (quality == BCQualityE::FAST)
+    {
+        // inset the box by a sixteenth to keep the interpolated colors inside the block range
+        computeBoundingBox(block, 3, e1, e0);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            const float inset = (e0[c] - e1[c]) / 16.f;
+            e0[c] -= inset;
+            e1[c] += inset;
+        }
+    }
+    else
+        computePrincipalEndpoints(block, 3, e0, e1);
+
+    const uint32_t refinementCount = quality == BCQualityE::HIGH     ? 4U
+                                     : quality == BCQualityE::NORMAL ? 1U
+                                                                     : 0U;
+    uint16_t best0 = 0U, best1 = 0U;
+    uint8_t bestIndices[16] = {}, indices[16];
+    float bestError = FLT_MAX;
+    for (uint32_t iteration = 0; iteration <= refinementCount; ++iteration)
+    {
+        uint16_t c0 = packRGB565(e0), c1 = packRGB565(e1);
+        if (c0 < c1)
+            std::swap(c0, c1);
+
+        float palette[4][4];
+        unpackRGB565(c0, palette[0]);
+        unpackRGB565(c1, palette[1]);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+            palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+        }
+
+        // equal endpoints would select the three color mode, every texel takes the first one
+        const float error = c0 == c1 ? selectIndices(block, palette, 1U, kColorWeights, indices)
+                                     : selectIndices(block, palette, 4U, kColorWeights, indices);
+        if (error < bestError)
+        {
+            bestError = error;
+            best0 = c0;
+            best1 = c1;
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+
+        if (iteration == refinementCount || c0 == c1)
+            break;
+        // the refined endpoints are ordered as the palette was
+        std::copy_n(palette[0], 3, e0);
+        std::copy_n(palette[1], 3, e1);
+        if (!refineEndpoints(block, 0U, 3U, indices, kBC1IndexWeights, e0, e1))
+            break;
+    }
+
+    uint64_t bits = 0U;
+    for (uint32_t i = 0; i < 16; ++i)
+        bits |= static_cast<uint64_t>(bestIndices[i]) << (2 * i);
+    writeLittleEndian(dst, best0, 2);
+    writeLittleEndian(dst + 2, best1, 2);
+    writeLittleEndian(dst + 4, bits, 4);
+}
+
+static void buildBC4Palette(const uint32_t e0, const uint32_t e1, const uint32_t channel,
+                            float palette[8][4])
+{
+    std::memset(palette, 0, sizeof(float) * 8 * 4);
+    palette[0][channel] = static_cast<float>(e0);
+    palette[1][channel] = static_cast<float>(e1);
+    if (e0 > e1)
+    {
+        for (uint32_t i = 2; i < 8; ++i)
+            palette[i][channel] = static_cast<float>((8 - i) * e0 + (i - 1) * e1) / 7.f;
+        return;
+    }
+    for (uint32_t i = 2; i < 6; ++i)
+        palette[i][channel] = static_cast<float>((6 - i) * e0 + (i - 1) * e1) / 5.f;
+    palette[6][channel] = 0.f;
+    palette[7][channel] = 255.f;
+}
+
+static void encodeBC4(const BlockT& block, const uint32_t channel, const BCQualityE quality,
+                      uint8_t* dst)
+{
+    float weights[4] = {};
+    weights[channel] = 1.f;
+
+    float lo = *std::min_element(block.c[channel], block.c[channel] + 16);
+    float hi = *std::max_element(block.c[channel], block.c[channel] + 16);
+
+    uint32_t best0 = 0U, best1 = 0U;
+    uint8_t bestIndices[16] = {}, indices[16];
+    float bestError = FLT_MAX;
+    float palette[8][4];
+
+    // eight interpolated values, the first endpoint is the largest
+    float e0[4] = {}, e1[4] = {};
+    e0[channel] = hi;
+    e1[channel] = lo;
+    const uint32_t refinementCount = quality == BCQualityE::FAST ? 0U : 2U;
+    for (uint32_t iteration = 0; iteration <= refinementCount; ++iteration)
+    {
+        uint32_t v0 = static_cast<uint32_t>(e0[channel] + 0.5f);
+        uint32_t v1 = static_cast<uint32_t>(e1[channel] + 0.5f);
+        if (v0 < v1)
+            std::swap(v0, v1);
+
+        buildBC4Palette(v0, v1, channel, palette);
+        // equal endpoints would select the six values mode, every texel takes the first one
+        const float error = v0 == v1 ? selectIndices(block, palette, 1U, weights, indices)
+                                     : selectIndices(block, palette, 8U, weights, indices);
+        if (error < bestError)
+        {
+            bestError = error;
+            best0 = v0;
+            best1 = v1;
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+
+        if (iteration == refinementCount || v0 == v1)
+            break;
+        e0[channel] = static_cast<float>(v0);
+        e1[channel] = static_cast<float>(v1);
+        if (!refineEndpoints(block, channel, 1U, indices, kBC4IndexWeights, e0, e1))
+            break;
+    }
+
+    // six interpolated values and exact 0 and 255, for blocks with a few extreme texels
+    if (quality == BCQualityE::HIGH)
+    {
+        float innerLo = 255.f, innerHi = 0.f;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const float value = block.c[channel][i];
+            if (value > 0.f && value < 255.f)
+            {
+                innerLo = std::min(innerLo, value);
+                innerHi = std::max(innerHi, value);
+            }
+        }
+        if (innerLo < innerHi)
+        {
+            const uint32_t v0 = static_cast<uint32_t>(innerLo + 0.5f);
+            const uint32_t v1 = static_cast<uint32_t>(innerHi + 0.5f);
+            buildBC4Palette(v0, v1, channel, palette);
+            const float error = selectIndices(block, palette, 8U, weights, indices);
+            if (error < bestError)
+            {
+                best0 = v0;
+                best1 = v1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+    }
+
+    uint64_t bits = 0U;
+    for (uint32_t i = 0; i < 16; ++i)
+        bits |= static_cast<uint64_t>(bestIndices[i]) << (3 * i);
+    dst[0] = static_cast<uint8_t>(best0);
+    dst[1] = static_cast<uint8_t>(best1);
+    writeLittleEndian(dst + 2, bits, 6);
+}
+
+class BitWriter
+{
+  private:
+    uint8_t* m_dst;
+    uint32_t m_position = 0U;
+
+  public:
+    explicit BitWriter(uint8_t* dst, const size_t size) : m_dst(dst) { std::memset(dst, 0, size); }
+
+    void write(const uint32_t value, const uint32_t bitCount)
+    {
+        for (uint32_t bit = 0; bit < bitCount; ++bit, ++m_position)
+        {
+            const uint32_t set = (value >> bit) & 1U;
+            m_dst[m_position >> 3] |= static_cast<uint8_t>(set << (m_position & 7));
+        }
+    }
+};
+
+/**
+ * @brief 7 bits per channel and a shared lowest bit per endpoint
+ *
+ */
+static void quantizeBC7Endpoint(const float endpoint[4], const uint32_t pBit, uint32_t quantized[4],
+                                uint32_t expanded[4])
+{
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        const float value = (endpoint[c] - static_cast<float>(pBit)) / 2.f;
+        quantized[c] = static_cast<uint32_t>(std::clamp(value + 0.5f, 0.f, 127.f));
+        expanded[c] = (quantized[c] << 1) | pBit;
+    }
+}
+
+static uint32_t selectBC7PBit(const float endpoint[4])
+{
+    float errors[2] = {};
+    for (uint32_t pBit = 0; pBit < 2; ++pBit)
+    {
+        uint32_t quantized[4], expanded[4];
+        quantizeBC7Endpoint(endpoint, pBit, quantized, expanded);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            const float diff = endpoint[c] - static_cast<float>(expanded[c]);
+            errors[pBit] += diff * diff;
+        }
+    }
+    return errors[1] < errors[0] ? 1U : 0U;
+}
+
+/**
+ * @brief mode 6 only, a single subset of RGBA endpoints with 16 interpolated values, the mode most
+ * real time encoders favor for its cost to quality ratio
+ *
+ */
+static void encodeBC7(const BlockT& block, const BCQualityE quality, uint8_t* dst)
+{
+    float e0[4] = {}, e1[4] = {};
+    if (quality == BCQualityE::FAST)
+        computeBoundingBox(block, 4, e0, e1);
+    else
+        computePrincipalEndpoints(block, 4, e0, e1);
+
+    float indexWeights[16];
+    for (uint32_t i = 0; i < 16; ++i)
+        indexWeights[i] = static_cast<float>(kBC7Weights[i]) / 64.f;
+
+    const uint32_t refinementCount = quality == BCQualityE::HIGH     ? 3U
+                                     : quality == BCQualityE::NORMAL ? 1U
+                                                                     : 0U;
+    uint32_t best0[4] = {}, best1[4] = {}, bestPBits[2] = {};
+    uint8_t bestIndices[16] = {}, indices[16];
+    float bestError = FLT_MAX;
+    for (uint32_t iteration = 0; iteration <= refinementCount; ++iteration)
+    {
+        // every combination of the shared bits is tried at the highest quality
+        uint32_t pBitCombinations[4][2] = {
+            {selectBC7PBit(e0), selectBC7PBit(e1)},
+            {0, 1},
+            {1, 0},
+            {1, 1},
+        };
+        const uint32_t combinationCount = quality == BCQualityE::HIGH ? 4U : 1U;
+        if (quality == BCQualityE::HIGH)
+        {
+            pBitCombinations[0][0] = 0U;
+            pBitCombinations[0][1] = 0U;
+        }
+
+        float iterationError = FLT_MAX;
+        uint8_t iterationIndices[16] = {};
+        for (uint32_t combination = 0; combination < combinationCount; ++combination)
+        {
+            uint32_t q0[4], q1[4], x0[4], x1[4];
+            quantizeBC7Endpoint(e0, pBitCombinations[combination][0], q0, x0);
+            quantizeBC7Endpoint(e1, pBitCombinations[combination][1], q1, x1);
+
+            float palette[16][4];
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    palette[i][c] = static_cast<float>(
+                        ((64 - kBC7Weights[i]) * x0[c] + kBC7Weights[i] * x1[c] + 32) >> 6);
+                }
+            }
+            const float error = selectIndices(block, palette, 16U, kColorAlphaWeights, indices);
+            if (error < iterationError)
+            {
+                iterationError = error;
+                std::memcpy(iterationIndices, indices, sizeof(indices));
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                std::copy_n(q0, 4, best0);
+                std::copy_n(q1, 4, best1);
+                bestPBits[0] = pBitCombinations[combination][0];
+                bestPBits[1] = pBitCombinations[combination][1];
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+
+        if (iteration == refinementCount)
+            break;
+        if (!refineEndpoints(block, 0U, 4U, iterationIndices, indexWeights, e0, e1))
+            break;
+    }
+
+    // the highest bit of the first index is implied to be zero
+    if (bestIndices[0] >= 8U)
+    {
+        std::swap(best0, best1);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for (uint32_t i = 0; i < 16; ++i)
+            bestIndices[i] = static_cast<uint8_t>(15U - bestIndices[i]);
+    }
+
+    BitWriter writer(dst, 16U);
+    writer.write(1U << 6, 7);
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        writer.write(best0[c], 7);
+        writer.write(best1[c], 7);
+    }
+    writer.write(bestPBits[0], 1);
+    writer.write(bestPBits[1], 1);
+    writer.write(bestIndices[0], 3);
+    for (uint32_t i = 1; i < 16; ++i)
+        writer.write(bestIndices[i], 4);
+}
+
+BCEncoder::BCEncoder(const BCEncoderCreateInfoT createInfo) : ci(createInfo) {}
+
+void BCEncoder::encodeRows(const BCSurfaceT& surface, const BCFormatE format,
+                           const uint32_t firstRow, const uint32_t lastRow, uint8_t* dst) const
+{
+    const uint32_t blockCountX = (surface.width + 3) / 4;
+    const uint32_t blockSize = getBCBlockSize(format);
+
+    BlockT block;
+    for (uint32_t y = firstRow; y < lastRow; ++y)
+    {
+        uint8_t* row = dst + static_cast<size_t>(y) * blockCountX * blockSize;
+        for (uint32_t x = 0; x < blockCountX; ++x)
+        {
+            loadBlock(surface, x, y, block);
+            uint8_t* out = row + static_cast<size_t>(x) * blockSize;
+            switch (format)
+            {
+            case BCFormatE::BC1:
+                encodeBC1(block, ci.quality, out);
+                break;
+            case BCFormatE::BC3:
+                encodeBC4(block, 3U, ci.quality, out);
+                encodeBC1(block, ci.quality, out + 8);
+                break;
+            case BCFormatE::BC4:
+                encodeBC4(block, 0U, ci.quality, out);
+                break;
+            case BCFormatE::BC5:
+                encodeBC4(block, 0U, ci.quality, out);
+                encodeBC4(block, 1U, ci.quality, out + 8);
+                break;
+            case BCFormatE::BC7:
+                encodeBC7(block, ci.quality, out);
+                break;
+            }
+        }
+    }
+}
+
+void BCEncoder::encode(const BCSurfaceT& surface, const BCFormatE format, uint8_t* dst)
+{
+    if (surface.width == 0U || surface.height == 0U)
+        return;
+
+    const auto begin = std::chrono::steady_clock::now();
+    const uint32_t blockCountY = (surface.height + 3) / 4;
+
+    uint32_t threadCount = 1U;
+    if (!ci.threadPool || blockCountY < 2U)
+        encodeRows(surface, format, 0U, blockCountY, dst);
+    else
+    {
+        // a few jobs per worker evens out the rows that encode slower
+        threadCount = static_cast<uint32_t>(ci.threadPool->getThreadCount());
+        const uint32_t jobCount = std::min(blockCountY, threadCount * 4U);
+        const uint32_t rowsPerJob = (blockCountY + jobCount - 1) / jobCount;
+        const uint32_t submittedCount = (blockCountY + rowsPerJob - 1) / rowsPerJob;
+
+        std::latch done(submittedCount);
+        for (uint32_t job = 0; job < submittedCount; ++job)
+        {
+            const uint32_t firstRow = job * rowsPerJob;
+            const uint32_t lastRow = std::min(firstRow + rowsPerJob, blockCountY);
+            ci.threadPool->submit([this, &surface, format, firstRow, lastRow, dst, &done]() {
+                encodeRows(surface, format, firstRow, lastRow, dst);
+                done.count_down();
+            });
+        }
+        done.wait();
+    }
+
+    m_stats.pixelCount += static_cast<uint64_t>(surface.width) * surface.height;
+    m_stats.duration += std::chrono::steady_clock::now() - begin;
+    m_stats.threadCount = threadCount;
+}
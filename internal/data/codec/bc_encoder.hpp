@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+class ThreadPool;
+
+/**
+ * @brief block compressed formats, 4x4 texel blocks
+ * BC1 : RGB, 8 bytes per block
+ * BC3 : RGBA, BC4 alpha then BC1 color, 16 bytes per block
+ * BC4 : R, 8 bytes per block
+ * BC5 : RG (normal maps), two BC4 blocks, 16 bytes per block
+ * BC7 : RGBA, 16 bytes per block, encoded in mode 6 (single subset, 4 bit indices)
+ *
+ */
+enum class BCFormatE
+{
+    BC1 = 0,
+    BC3 = 1,
+    BC4 = 2,
+    BC5 = 3,
+    BC7 = 4,
+};
+
+/**
+ * @brief FAST picks the endpoints from the bounding box of the block, NORMAL from its principal
+ * axis with one least squares refinement, HIGH refines further and tries every endpoint mode
+ *
+ */
+enum class BCQualityE
+{
+    FAST = 0,
+    NORMAL = 1,
+    HIGH = 2,
+};
+
+[[nodiscard]] const char* getBCFormatName(const BCFormatE format);
+[[nodiscard]] uint32_t getBCBlockSize(const BCFormatE format);
+[[nodiscard]] size_t getBCEncodedSize(const BCFormatE format, const uint32_t width,
+                                      const uint32_t height);
+/**
+ * @brief bSRGB only applies to the color formats (BC1, BC3, BC7)
+ *
+ */
+[[nodiscard]] VkFormat getBCVkFormat(const BCFormatE format, const bool bSRGB);
+
+struct BCEncoderCreateInfoT
+{
+    BCQualityE quality = BCQualityE::NORMAL;
+    /**
+     * @brief workers encoding the block rows in parallel, the calling thread encodes alone when
+     * null, encode waits for the workers and must not be called from one of them
+     *
+     */
+    ThreadPool* threadPool = nullptr;
+};
+
+/**
+ * @brief RGBA8 texels, partial blocks at the right and bottom edges replicate the last texels
+ *
+ */
+struct BCSurfaceT
+{
+    const uint8_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    /**
+     * @brief bytes between two rows, width * 4 if 0
+     *
+     */
+    size_t rowPitch = 0U;
+};
+
+struct BCEncodeStatsT
+{
+    uint64_t pixelCount = 0U;
+    std::chrono::nanoseconds duration = std::chrono::nanoseconds(0);
+    /**
+     * @brief threads that encoded blocks, the throughput is given per thread
+     *
+     */
+    uint32_t threadCount = 1U;
+
+    [[nodiscard]] double getMegapixelsPerSecondPerCore() const;
+};
+
+/**
+ * @brief CPU block compression encoder, usable offline (see the texture compressor tool) or at
+ * import time (TextureLoadInfoT::compression)
+ * the distance computations of the index selection run on SSE2 when available, four texels at a
+ * time, the rows of blocks are split across the thread pool if one is given
+ *
+ */
+class BCEncoder
+{
+  private:
+    const BCEncoderCreateInfoT ci;
+
+  private:
+    BCEncodeStatsT m_stats;
+
+    void encodeRows(const BCSurfaceT& surface, const BCFormatE format, const uint32_t firstRow,
+                    const uint32_t lastRow, uint8_t* dst) const;
+
+  public:
+    BCEncoder() = delete;
+    BCEncoder(const BCEncoder&) = delete;
+    BCEncoder& operator=(const BCEncoder&) = delete;
+    BCEncoder(BCEncoder&&) = delete;
+    BCEncoder& operator=(BCEncoder&&) = delete;
+
+    explicit BCEncoder(const BCEncoderCreateInfoT createInfo);
+
+    /**
+     * @brief dst must hold getBCEncodedSize bytes, blocks are written row by row
+     *
+     */
+    void encode(const BCSurfaceT& surface, const BCFormatE format, uint8_t* dst);
+
+  public:
+    /**
+     * @brief accumulated over every encode call
+     *
+     */
+    [[nodiscard]] inline const BCEncodeStatsT& getStats() const { return m_stats; }
+};
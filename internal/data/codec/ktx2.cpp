@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string_view>
+
+#include "ktx2.hpp"
+
+static constexpr uint8_t kKtx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                                0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+static constexpr size_t kHeaderSize = 80U;
+static constexpr size_t kLevelIndexEntrySize = 24U;
+
+// data format descriptor values (Khronos Data Format Specification)
+static constexpr uint8_t kModelRGBSDA = 1U;
+static constexpr uint8_t kModelBC1A = 128U;
+static constexpr uint8_t kModelBC3 = 130U;
+static constexpr uint8_t kModelBC4 = 131U;
+static constexpr uint8_t kModelBC5 = 132U;
+static constexpr uint8_t kModelBC7 = 134U;
+static constexpr uint8_t kModelETC1S = 163U;
+static constexpr uint8_t kModelUASTC = 166U;
+static constexpr uint8_t kPrimariesBT709 = 1U;
+static constexpr uint8_t kTransferLinear = 1U;
+static constexpr uint8_t kTransferSRGB = 2U;
+static constexpr uint8_t kChannelAlpha = 15U;
+static constexpr uint8_t kQualifierLinear = 0x10U;
+
+struct DfdSampleT
+{
+    uint16_t bitOffset;
+    uint8_t bitCount;
+    uint8_t channel;
+    uint32_t upper;
+};
+
+struct DfdT
+{
+    uint8_t model;
+    bool bSRGB;
+    bool bBlockCompressed;
+    uint8_t bytesPerBlock;
+    std::vector<DfdSampleT> samples;
+};
+
+static bool getDfd(const VkFormat format, DfdT& dfd)
+{
+    // blocks are described by one sample per 64 bits, with the full unsigned range
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        dfd = DfdT{kModelRGBSDA,
+                   format == VK_FORMAT_R8G8B8A8_SRGB,
+                   false,
+                   4U,
+                   {{0, 8, 0, 255U}, {8, 8, 1, 255U}, {16, 8, 2, 255U},
+                    {24, 8, kChannelAlpha, 255U}}};
+        return true;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        dfd = DfdT{kModelBC1A, format == VK_FORMAT_BC1_RGB_SRGB_BLOCK, true, 8U,
+                   {{0, 64, 0, UINT32_MAX}}};
+        return true;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        dfd = DfdT{kModelBC3, format == VK_FORMAT_BC3_SRGB_BLOCK, true, 16U,
+                   {{0, 64, kChannelAlpha, UINT32_MAX}, {64, 64, 0, UINT32_MAX}}};
+        return true;
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        dfd = DfdT{kModelBC4, false, true, 8U, {{0, 64, 0, UINT32_MAX}}};
+        return true;
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        dfd = DfdT{kModelBC5, false, true, 16U, {{0, 64, 0, UINT32_MAX}, {64, 64, 1, UINT32_MAX}}};
+        return true;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        dfd = DfdT{kModelBC7, format == VK_FORMAT_BC7_SRGB_BLOCK, true, 16U,
+                   {{0, 128, 0, UINT32_MAX}}};
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isKtx2FormatSupported(const VkFormat format)
+{
+    DfdT dfd;
+    return getDfd(format, dfd);
+}
+
+uint64_t getKtx2LevelSize(const Ktx2HeaderT& header, const uint32_t level)
+{
+    DfdT dfd;
+    if (!getDfd(header.format, dfd))
+        return 0U;
+
+    const uint64_t width = std::max(header.width >> level, 1U);
+    const uint64_t height = std::max(std::max(header.height, 1U) >> level, 1U);
+    const uint64_t blocksX = dfd.bBlockCompressed ? (width + 3) / 4 : width;
+    const uint64_t blocksY = dfd.bBlockCompressed ? (height + 3) / 4 : height;
+    return blocksX * blocksY * dfd.bytesPerBlock * std::max(header.layerCount, 1U);
+}
+
+static void append(std::vector<uint8_t>& out, uint64_t value, const uint32_t byteCount)
+{
+    for (uint32_t i = 0; i < byteCount; ++i, value >>= 8)
+        out.push_back(static_cast<uint8_t>(value & 0xFFU));
+}
+
+static void store(std::vector<uint8_t>& out, size_t offset, uint64_t value,
+                  const uint32_t byteCount)
+{
+    for (uint32_t i = 0; i < byteCount; ++i, value >>= 8)
+        out[offset + i] = static_cast<uint8_t>(value & 0xFFU);
+}
+
+static void pad(std::vector<uint8_t>& out, const size_t alignment)
+{
+    out.resize((out.size() + alignment - 1) / alignment * alignment, 0U);
+}
+
+static void appendDfd(std::vector<uint8_t>& out, const DfdT& dfd)
+{
+    const uint32_t blockSize = 24U + 16U * static_cast<uint32_t>(dfd.samples.size());
+    append(out, 4U + blockSize, 4);
+
+    append(out, 0U, 4); // vendor and descriptor type
+    append(out, 2U, 2); // version
+    append(out, blockSize, 2);
+    append(out, dfd.model, 1);
+    append(out, kPrimariesBT709, 1);
+    append(out, dfd.bSRGB ? kTransferSRGB : kTransferLinear, 1);
+    append(out, 0U, 1); // straight alpha
+    // texel block dimensions minus one
+    append(out, dfd.bBlockCompressed ? 3U : 0U, 1);
+    append(out, dfd.bBlockCompressed ? 3U : 0U, 1);
+    append(out, 0U, 2);
+    append(out, dfd.bytesPerBlock, 1);
+    append(out, 0U, 7);
+
+    for (const DfdSampleT& sample : dfd.samples)
+    {
+        // alpha is never encoded with the transfer function
+        const uint8_t qualifiers =
+            dfd.bSRGB && sample.channel == kChannelAlpha ? kQualifierLinear : 0U;
+        append(out, sample.bitOffset, 2);
+        append(out, sample.bitCount - 1U, 1);
+        append(out, sample.channel | qualifiers, 1);
+        append(out, 0U, 4); // sample position
+        append(out, 0U, 4); // lower
+        append(out, sample.upper, 4);
+    }
+}
+
+static void appendKeyValue(std::vector<uint8_t>& out, const std::string_view key,
+                           const std::string_view value)
+{
+    append(out, key.size() + value.size() + 2U, 4);
+    out.insert(out.end(), key.begin(), key.end());
+    out.push_back(0U);
+    out.insert(out.end(), value.begin(), value.end());
+    out.push_back(0U);
+    pad(out, 4U);
+}
+
+bool writeKtx2(const std::filesystem::path& filepath, const Ktx2ImageT& image)
+{
+    DfdT dfd;
+    if (!getDfd(image.format, dfd))
+    {
+        std::cerr << "Failed to write " << filepath << " : unsupported format " << image.format
+                  << std::endl;
+        return false;
+    }
+    if (image.levels.empty())
+    {
+        std::cerr << "Failed to write " << filepath << " : no level" << std::endl;
+        return false;
+    }
+
+    const uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+    std::vector<uint8_t> out(kHeaderSize + kLevelIndexEntrySize * levelCount, 0U);
+
+    const size_t dfdOffset = out.size();
+    appendDfd(out, dfd);
+    const size_t kvdOffset = out.size();
+    appendKeyValue(out, "KTXwriter", "Observer");
+    const size_t kvdSize = out.size() - kvdOffset;
+
+    std::memcpy(out.data(), kKtx2Identifier, sizeof(kKtx2Identifier));
+    store(out, 12, image.format, 4);
+    store(out, 16, 1U, 4); // type size
+    store(out, 20, image.width, 4);
+    store(out, 24, image.height, 4);
+    store(out, 28, 0U, 4); // depth
+    store(out, 32, image.layerCount > 1U ? image.layerCount : 0U, 4);
+    store(out, 36, 1U, 4); // faces
+    store(out, 40, levelCount, 4);
+    store(out, 44, 0U, 4); // supercompression
+    store(out, 48, dfdOffset, 4);
+    store(out, 52, kvdOffset - dfdOffset, 4);
+    store(out, 56, kvdOffset, 4);
+    store(out, 60, kvdSize, 4);
+    store(out, 64, 0U, 8); // supercompression global data
+    store(out, 72, 0U, 8);
+
+    // each level starts on a multiple of the block size and of 4
+    const size_t alignment = std::lcm<size_t>(dfd.bytesPerBlock, 4U);
+    for (uint32_t level = levelCount; level-- > 0;)
+    {
+        pad(out, alignment);
+        const size_t entry = kHeaderSize + kLevelIndexEntrySize * level;
+        store(out, entry, out.size(), 8);
+        store(out, entry + 8, image.levels[level].size(), 8);
+        store(out, entry + 16, image.levels[level].size(), 8);
+        out.insert(out.end(), image.levels[level].begin(), image.levels[level].end());
+    }
+
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(out.data()), out.size()))
+    {
+        std::cerr << "Failed to write " << filepath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool isKtx2BasisUniversal(const Ktx2HeaderT& header)
+{
+    return header.colorModel == kModelETC1S || header.colorModel == kModelUASTC ||
+           header.supercompression == Ktx2SupercompressionE::BASIS_LZ;
+}
+
+static uint64_t load(const uint8_t* data, const uint32_t byteCount)
+{
+    uint64_t value = 0U;
+    for (uint32_t i = byteCount; i-- > 0;)
+        value = (value << 8) | data[i];
+    return value;
+}
+
+bool readKtx2Header(const uint8_t* data, const size_t size, Ktx2HeaderT& header)
+{
+    if (size < kHeaderSize || std::memcmp(data, kKtx2Identifier, sizeof(kKtx2Identifier)) != 0)
+        return false;
+
+    header.format = static_cast<VkFormat>(load(data + 12, 4));
+    header.typeSize = static_cast<uint32_t>(load(data + 16, 4));
+    header.width = static_cast<uint32_t>(load(data + 20, 4));
+    header.height = static_cast<uint32_t>(load(data + 24, 4));
+    header.depth = static_cast<uint32_t>(load(data + 28, 4));
+    header.layerCount = static_cast<uint32_t>(load(data + 32, 4));
+    header.faceCount = static_cast<uint32_t>(load(data + 36, 4));
+    // 0 asks the loader to generate the levels, the caller decides what to do with it
+    header.levelCount = static_cast<uint32_t>(load(data + 40, 4));
+    header.supercompression = static_cast<Ktx2SupercompressionE>(load(data + 44, 4));
+    const uint64_t dfdOffset = load(data + 48, 4);
+    const uint64_t dfdSize = load(data + 52, 4);
+
+    if (size < kHeaderSize + kLevelIndexEntrySize * header.levelCount)
+        return false;
+
+    header.levels.resize(header.levelCount);
+    for (uint32_t level = 0; level < header.levelCount; ++level)
+    {
+        const uint8_t* entry = data + kHeaderSize + kLevelIndexEntrySize * level;
+        Ktx2LevelIndexT& index = header.levels[level];
+        index.offset = load(entry, 8);
+        index.length = load(entry + 8, 8);
+        index.uncompressedLength = load(entry + 16, 8);
+        if (index.offset > size || index.length > size - index.offset)
+            return false;
+    }
+
+    // the basic descriptor block follows the total size and the block header
+    if (dfdSize >= 4U + 24U && dfdOffset + dfdSize <= size)
+    {
+        header.colorModel = data[dfdOffset + 12];
+        header.bSRGB = data[dfdOffset + 14] == kTransferSRGB;
+    }
+    return true;
+}
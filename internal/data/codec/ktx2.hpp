@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+/**
+ * @brief 2D texture (array) as stored in a KTX2 container, the level data is laid out as
+ * vkCmdCopyBufferToImage expects it (tightly packed rows of texels or blocks, layer after layer)
+ *
+ */
+struct Ktx2ImageT
+{
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0U;
+    uint32_t height = 0U;
+    uint32_t layerCount = 1U;
+    /**
+     * @brief the first level first
+     *
+     */
+    std::vector<std::vector<uint8_t>> levels;
+};
+
+enum class Ktx2SupercompressionE
+{
+    NONE = 0,
+    BASIS_LZ = 1,
+    ZSTD = 2,
+    ZLIB = 3,
+};
+
+struct Ktx2LevelIndexT
+{
+    /**
+     * @brief from the start of the file
+     *
+     */
+    uint64_t offset = 0U;
+    uint64_t length = 0U;
+    uint64_t uncompressedLength = 0U;
+};
+
+/**
+ * @brief what the texture loader needs from the header, the level index and the data format
+ * descriptor, Basis Universal textures have an UNDEFINED format and the UASTC or ETC1S model
+ *
+ */
+struct Ktx2HeaderT
+{
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t typeSize = 0U;
+    uint32_t width = 0U;
+    uint32_t height = 0U;
+    uint32_t depth = 0U;
+    /**
+     * @brief 0 for a texture which is not an array
+     *
+     */
+    uint32_t layerCount = 0U;
+    uint32_t faceCount = 0U;
+    uint32_t levelCount = 0U;
+    Ktx2SupercompressionE supercompression = Ktx2SupercompressionE::NONE;
+    uint8_t colorModel = 0U;
+    bool bSRGB = false;
+    /**
+     * @brief the first level first, whatever the order of the data in the file
+     *
+     */
+    std::vector<Ktx2LevelIndexT> levels;
+};
+
+[[nodiscard]] bool isKtx2BasisUniversal(const Ktx2HeaderT& header);
+
+/**
+ * @brief formats the container can describe : RGBA8 and the BC formats of the BC encoder
+ *
+ */
+[[nodiscard]] bool isKtx2FormatSupported(const VkFormat format);
+
+/**
+ * @brief bytes of a level with all its layers as its format and extent imply, what an
+ * uncompressed level must hold, 0 if the format is not supported (Basis Universal included)
+ *
+ */
+[[nodiscard]] uint64_t getKtx2LevelSize(const Ktx2HeaderT& header, const uint32_t level);
+
+/**
+ * @brief write the image without supercompression, the levels are stored from the smallest to
+ * the largest as the specification recommends for streaming
+ * @return false if the format is not supported or the file could not be written
+ */
+[[nodiscard]] bool writeKtx2(const std::filesystem::path& filepath, const Ktx2ImageT& image);
+
+/**
+ * @brief parse the header and the level index, check that the levels lie within the data
+ * a level count of 0 (levels to generate by the loader) is kept as is, with no level
+ * @return false if the data is not a KTX2 file or is truncated
+ */
+[[nodiscard]] bool readKtx2Header(const uint8_t* data, const size_t size, Ktx2HeaderT& header);
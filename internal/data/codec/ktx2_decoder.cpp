@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#include <basisu_transcoder.h>
+#include <zstd.h>
+
+#include "ktx2_decoder.hpp"
+
+static constexpr uint32_t kTransferSRGB = 2U;
+
+struct TranscodeTargetT
+{
+    basist::transcoder_texture_format basisFormat;
+    VkFormat format;
+    VkFormat formatSRGB;
+};
+
+// from the best quality to the most widely supported
+static constexpr TranscodeTargetT kTargetsWithAlpha[] = {
+    {basist::transcoder_texture_format::cTFBC7_RGBA, VK_FORMAT_BC7_UNORM_BLOCK,
+     VK_FORMAT_BC7_SRGB_BLOCK},
+    {basist::transcoder_texture_format::cTFBC3_RGBA, VK_FORMAT_BC3_UNORM_BLOCK,
+     VK_FORMAT_BC3_SRGB_BLOCK},
+    {basist::transcoder_texture_format::cTFRGBA32, VK_FORMAT_R8G8B8A8_UNORM,
+     VK_FORMAT_R8G8B8A8_SRGB},
+};
+static constexpr TranscodeTargetT kTargetsOpaque[] = {
+    {basist::transcoder_texture_format::cTFBC7_RGBA, VK_FORMAT_BC7_UNORM_BLOCK,
+     VK_FORMAT_BC7_SRGB_BLOCK},
+    {basist::transcoder_texture_format::cTFBC1_RGB, VK_FORMAT_BC1_RGB_UNORM_BLOCK,
+     VK_FORMAT_BC1_RGB_SRGB_BLOCK},
+    {basist::transcoder_texture_format::cTFRGBA32, VK_FORMAT_R8G8B8A8_UNORM,
+     VK_FORMAT_R8G8B8A8_SRGB},
+};
+
+static std::once_flag s_transcoderInit;
+
+Ktx2Decoder::Ktx2Decoder(const Ktx2DecoderCreateInfoT createInfo) : ci(createInfo) {}
+
+Ktx2Decoder::~Ktx2Decoder() = default;
+
+bool Ktx2Decoder::open(const std::filesystem::path& filepath)
+{
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << filepath << std::endl;
+        return false;
+    }
+    m_data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(m_data.data()), m_data.size()) ||
+        !readKtx2Header(m_data.data(), m_data.size(), m_header))
+    {
+        std::cerr << "Failed to read " << filepath << " : not a KTX2 file" << std::endl;
+        return false;
+    }
+
+    if (m_header.faceCount != 1U || m_header.depth > 1U || m_header.width == 0U)
+    {
+        std::cerr << "Failed to read " << filepath << " : only 2D textures and arrays are supported"
+                  << std::endl;
+        return false;
+    }
+    if (m_header.levelCount == 0U)
+    {
+        std::cerr << "Failed to read " << filepath
+                  << " : generating the levels at load time is not supported" << std::endl;
+        return false;
+    }
+    // a level below 1x1 has no extent to copy to
+    const uint32_t maxLevelCount =
+        std::bit_width(std::max(m_header.width, std::max(m_header.height, 1U)));
+    if (m_header.levelCount > maxLevelCount)
+    {
+        std::cerr << "Failed to read " << filepath << " : " << m_header.levelCount
+                  << " levels for a " << m_header.width << "x" << m_header.height << " texture"
+                  << std::endl;
+        return false;
+    }
+    if (m_header.supercompression == Ktx2SupercompressionE::ZLIB)
+    {
+        std::cerr << "Failed to read " << filepath << " : zlib supercompression is not supported"
+                  << std::endl;
+        return false;
+    }
+
+    if (isKtx2BasisUniversal(m_header))
+    {
+        std::call_once(s_transcoderInit, []() { basist::basisu_transcoder_init(); });
+
+        m_transcoder = std::make_unique<basist::ktx2_transcoder>();
+        if (!m_transcoder->init(m_data.data(), static_cast<uint32_t>(m_data.size())) ||
+            !m_transcoder->start_transcoding())
+        {
+            std::cerr << "Failed to read " << filepath << " : invalid Basis Universal data"
+                      << std::endl;
+            return false;
+        }
+        if (!selectTranscodeFormat())
+        {
+            std::cerr << "Failed to read " << filepath << " : no transcoding target is supported"
+                      << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    m_format = m_header.format;
+    if (m_format == VK_FORMAT_UNDEFINED || !ci.isFormatSupported(m_format) ||
+        !isKtx2FormatSupported(m_format))
+    {
+        std::cerr << "Failed to read " << filepath << " : unsupported format " << m_format
+                  << std::endl;
+        return false;
+    }
+
+    // the staging slots are sized from the index while the copies use the extent, both must agree
+    for (uint32_t level = 0; level < m_header.levelCount; ++level)
+    {
+        const Ktx2LevelIndexT& index = m_header.levels[level];
+        const uint64_t length = m_header.supercompression == Ktx2SupercompressionE::NONE
+                                    ? index.length
+                                    : index.uncompressedLength;
+        if (length != getKtx2LevelSize(m_header, level))
+        {
+            std::cerr << "Failed to read " << filepath << " : level " << level << " holds "
+                      << length << " bytes instead of " << getKtx2LevelSize(m_header, level)
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Ktx2Decoder::selectTranscodeFormat()
+{
+    const bool bSRGB = m_transcoder->get_dfd_transfer_func() == kTransferSRGB;
+    const auto select = [&](const auto& targets) {
+        for (const TranscodeTargetT& target : targets)
+        {
+            const VkFormat format = bSRGB ? target.formatSRGB : target.format;
+            if (ci.isFormatSupported(format))
+            {
+                m_format = format;
+                m_transcodeFormat = static_cast<uint32_t>(target.basisFormat);
+                return true;
+            }
+        }
+        return false;
+    };
+    return m_transcoder->get_has_alpha() ? select(kTargetsWithAlpha) : select(kTargetsOpaque);
+}
+
+size_t Ktx2Decoder::getLevelSize(const uint32_t level) const
+{
+    if (!m_transcoder)
+    {
+        const Ktx2LevelIndexT& index = m_header.levels[level];
+        return m_header.supercompression == Ktx2SupercompressionE::NONE ? index.length
+                                                                        : index.uncompressedLength;
+    }
+
+    basist::ktx2_image_level_info info;
+    if (!m_transcoder->get_image_level_info(info, level, 0, 0))
+        return 0U;
+    const auto format = static_cast<basist::transcoder_texture_format>(m_transcodeFormat);
+    const size_t units = basist::basis_transcoder_format_is_uncompressed(format)
+                             ? static_cast<size_t>(info.m_orig_width) * info.m_orig_height
+                             : info.m_total_blocks;
+    return units * basist::basis_get_bytes_per_block_or_pixel(format) * getLayerCount();
+}
+
+bool Ktx2Decoder::decodeLevel(const uint32_t level, uint8_t* dst) const
+{
+    const Ktx2LevelIndexT& index = m_header.levels[level];
+    const uint8_t* src = m_data.data() + index.offset;
+
+    if (m_transcoder)
+    {
+        const auto format = static_cast<basist::transcoder_texture_format>(m_transcodeFormat);
+        const size_t layerSize = getLevelSize(level) / getLayerCount();
+        const uint32_t units =
+            static_cast<uint32_t>(layerSize / basist::basis_get_bytes_per_block_or_pixel(format));
+        // the transcoder is thread safe as long as each thread has its own state
+        basist::ktx2_transcoder_state state;
+        for (uint32_t layer = 0; layer < getLayerCount(); ++layer)
+        {
+            if (!m_transcoder->transcode_image_level(level, layer, 0, dst + layerSize * layer,
+                                                     units, format, 0, 0, 0, -1, -1, &state))
+            {
+                std::cerr << "Failed to transcode level " << level << " layer " << layer
+                          << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (m_header.supercompression == Ktx2SupercompressionE::ZSTD)
+    {
+        const size_t res = ZSTD_decompress(dst, index.uncompressedLength, src, index.length);
+        if (ZSTD_isError(res) || res != index.uncompressedLength)
+        {
+            std::cerr << "Failed to decompress level " << level << " : "
+                      << (ZSTD_isError(res) ? ZSTD_getErrorName(res) : "truncated") << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::memcpy(dst, src, index.length);
+    return true;
+}
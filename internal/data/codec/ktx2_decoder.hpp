@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ktx2.hpp"
+
+namespace basist
+{
+class ktx2_transcoder;
+}
+
+struct Ktx2DecoderCreateInfoT
+{
+    /**
+     * @brief whether the device can sample an optimal tiling image of the format, Basis Universal
+     * textures are transcoded to the first supported format among BC7, BC3 (BC1 without alpha)
+     * and RGBA8
+     *
+     */
+    std::function<bool(const VkFormat)> isFormatSupported;
+};
+
+/**
+ * @brief reads the levels of a KTX2 file into the layout vkCmdCopyBufferToImage expects
+ * the levels are either stored as is, Zstd supercompressed or Basis Universal (ETC1S or UASTC)
+ * encoded, decodeLevel may be called concurrently for different levels once open succeeded
+ * cube maps, 3D textures and zlib supercompression are not supported
+ *
+ */
+class Ktx2Decoder
+{
+  private:
+    const Ktx2DecoderCreateInfoT ci;
+
+  private:
+    std::vector<uint8_t> m_data;
+    Ktx2HeaderT m_header;
+    VkFormat m_format = VK_FORMAT_UNDEFINED;
+
+    std::unique_ptr<basist::ktx2_transcoder> m_transcoder;
+    /**
+     * @brief basist::transcoder_texture_format, kept out of the header
+     *
+     */
+    uint32_t m_transcodeFormat = 0U;
+
+    [[nodiscard]] bool selectTranscodeFormat();
+
+  public:
+    Ktx2Decoder() = delete;
+    Ktx2Decoder(const Ktx2Decoder&) = delete;
+    Ktx2Decoder& operator=(const Ktx2Decoder&) = delete;
+    Ktx2Decoder(Ktx2Decoder&&) = delete;
+    Ktx2Decoder& operator=(Ktx2Decoder&&) = delete;
+
+    explicit Ktx2Decoder(const Ktx2DecoderCreateInfoT createInfo);
+    ~Ktx2Decoder();
+
+    /**
+     * @brief read the file and choose the format of the image
+     * @return false if the file cannot be read or the texture cannot be sampled on this device
+     */
+    [[nodiscard]] bool open(const std::filesystem::path& filepath);
+
+    /**
+     * @brief bytes written by decodeLevel, every layer included
+     *
+     */
+    [[nodiscard]] size_t getLevelSize(const uint32_t level) const;
+    /**
+     * @brief decompress or transcode every layer of the level into dst, thread safe
+     *
+     */
+    [[nodiscard]] bool decodeLevel(const uint32_t level, uint8_t* dst) const;
+
+  public:
+    /**
+     * @brief format of the decoded levels, the transcoding target for Basis Universal textures
+     *
+     */
+    [[nodiscard]] inline VkFormat getFormat() const { return m_format; }
+    [[nodiscard]] inline uint32_t getWidth() const { return m_header.width; }
+    [[nodiscard]] inline uint32_t getHeight() const { return m_header.height; }
+    [[nodiscard]] inline uint32_t getLevelCount() const { return m_header.levelCount; }
+    [[nodiscard]] inline uint32_t getLayerCount() const
+    {
+        return std::max(m_header.layerCount, 1U);
+    }
+    [[nodiscard]] inline bool isBasisUniversal() const { return m_transcoder != nullptr; }
+};
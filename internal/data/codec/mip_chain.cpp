@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <bit>
+
+#include "mip_chain.hpp"
+
+static constexpr uint32_t kTexelSize = 4U;
+
+uint32_t getMipLevelCount(const uint32_t width, const uint32_t height)
+{
+    return std::bit_width(std::max(width, height));
+}
+
+void downsampleRGBA8(const uint8_t* src, const uint32_t width, const uint32_t height,
+                     uint8_t* dst)
+{
+    const uint32_t dstWidth = std::max(width / 2, 1U);
+    const uint32_t dstHeight = std::max(height / 2, 1U);
+    for (uint32_t y = 0; y < dstHeight; ++y)
+    {
+        const uint32_t y0 = std::min(2 * y, height - 1);
+        const uint32_t y1 = std::min(2 * y + 1, height - 1);
+        for (uint32_t x = 0; x < dstWidth; ++x)
+        {
+            const uint32_t x0 = std::min(2 * x, width - 1);
+            const uint32_t x1 = std::min(2 * x + 1, width - 1);
+            for (uint32_t c = 0; c < kTexelSize; ++c)
+            {
+                const uint32_t sum = src[(y0 * width + x0) * kTexelSize + c] +
+                                     src[(y0 * width + x1) * kTexelSize + c] +
+                                     src[(y1 * width + x0) * kTexelSize + c] +
+                                     src[(y1 * width + x1) * kTexelSize + c];
+                dst[(y * dstWidth + x) * kTexelSize + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+std::vector<MipLevelT> buildMipChain(std::vector<uint8_t>& pixels, const uint32_t width,
+                                     const uint32_t height, const uint32_t levelCount)
+{
+    std::vector<MipLevelT> levels(levelCount);
+    size_t size = 0U;
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        levels[level].width = std::max(width >> level, 1U);
+        levels[level].height = std::max(height >> level, 1U);
+        levels[level].offset = size;
+        levels[level].size =
+            static_cast<size_t>(levels[level].width) * levels[level].height * kTexelSize;
+        size += levels[level].size;
+    }
+
+    pixels.resize(size);
+    for (uint32_t level = 1; level < levelCount; ++level)
+    {
+        const MipLevelT& previous = levels[level - 1];
+        downsampleRGBA8(pixels.data() + previous.offset, previous.width, previous.height,
+                        pixels.data() + levels[level].offset);
+    }
+    return levels;
+}
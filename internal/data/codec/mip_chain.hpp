@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MipLevelT
+{
+    uint32_t width;
+    uint32_t height;
+    size_t offset;
+    size_t size;
+};
+
+/**
+ * @brief levels down to 1x1
+ *
+ */
+[[nodiscard]] uint32_t getMipLevelCount(const uint32_t width, const uint32_t height);
+
+/**
+ * @brief 2x2 box filter of an RGBA8 level into the next one, the texels are averaged as stored (no
+ * linearization of SRGB data)
+ *
+ */
+void downsampleRGBA8(const uint8_t* src, const uint32_t width, const uint32_t height,
+                     uint8_t* dst);
+
+/**
+ * @brief append the levels after the first one to pixels, which holds the RGBA8 texels of the
+ * first level on input
+ * @return the levels in storage order, the first one first
+ */
+[[nodiscard]] std::vector<MipLevelT> buildMipChain(std::vector<uint8_t>& pixels,
+                                                   const uint32_t width, const uint32_t height,
+                                                   const uint32_t levelCount);
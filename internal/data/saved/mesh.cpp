@@ -39,12 +39,16 @@ void Mesh::loadLocal(const std::shared_ptr<ResourceLoadInfoT> loadInfo)
         .size = r->bufferSize,
         .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .bMovable = true,
+        .allocationType = AllocationTypeE::MESH,
     });
     r->indexCount = host->indices.size();
     r->indexBuffer = loadInfo->deviceptr->createBuffer(BufferCreateInfoT{
         .size = host->getIndexDataSize(),
         .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .bMovable = true,
+        .allocationType = AllocationTypeE::MESH,
     });
 
     gpuSideLoaded.test_and_set();
@@ -71,9 +71,14 @@ class MeshRenderDescription : public RenderableABC
      */
     std::shared_ptr<GPUMesh> meshView;
 
+    PerDrawDataT m_perDraw;
+
   public:
     MeshRenderDescription() = delete;
     MeshRenderDescription(std::shared_ptr<GPUMesh> meshView) : meshView(meshView) {}
 
     const GPUMesh* getGPUMesh() const { return meshView.get(); }
+
+    [[nodiscard]] const PerDrawDataT* getPerDrawData() const override { return &m_perDraw; }
+    [[nodiscard]] PerDrawDataT& getPerDrawData() { return m_perDraw; }
 };
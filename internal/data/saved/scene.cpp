@@ -5,10 +5,34 @@
 
 #include "device/memory/buffer.hpp"
 #include "device/memory/descriptor.hpp"
+#include "device/memory/descriptor_writer.hpp"
 #include "engine/uniform.hpp"
 
+#include "renderer/gpu_scene_buffer.hpp"
+
 #include "scene.hpp"
 
+/**
+ * @brief bounding sphere around the bounding box of the mesh vertices
+ *
+ */
+static glm::vec4 computeBoundingSphere(const GPUMesh& mesh)
+{
+    if (!mesh.vertices || mesh.vertexCount == 0)
+        return glm::vec4(0.f);
+
+    const auto* vertices = static_cast<const Vertex*>(mesh.vertices);
+    glm::vec3 min = vertices[0].position;
+    glm::vec3 max = vertices[0].position;
+    for (uint32_t i = 1; i < mesh.vertexCount; ++i)
+    {
+        min = glm::min(min, vertices[i].position);
+        max = glm::max(max, vertices[i].position);
+    }
+    const glm::vec3 center = (min + max) * 0.5f;
+    return glm::vec4(center, glm::length(max - center));
+}
+
 void Scene::loadHost(const uint64_t index, const std::shared_ptr<ResourceLoadInfoT> loadInfo)
 {
     auto r = std::make_shared<CPUScene>(index);
@@ -40,12 +64,8 @@ void Scene::loadLocal(const std::shared_ptr<ResourceLoadInfoT> loadInfo)
     fragmentShaderCreateInfo->stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     fragmentShaderCreateInfo->entryPoint = "main";
 
-    r->m_renderStates
-        .push_back(
-            std::make_unique<RenderState>(
-                RenderStateCreateInfoT{
-                    .deviceptr = loadInfo->deviceptr,
-                    .pipelineCreateInfo =
+    // every pipeline of the scene is compiled in a single batch
+    std::vector<PipelineCreateInfoT> pipelineCreateInfos = {
                         PipelineCreateInfoT{
                                             .device = loadInfo->deviceptr,
                                             .shaderStages =
@@ -100,39 +120,85 @@ void Scene::loadLocal(const std::shared_ptr<ResourceLoadInfoT> loadInfo)
                                                 VkDescriptorSetLayoutBinding{
                                                     .binding = 0,
                                                     .descriptorType =
-                                                        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                                        li && li->uniformRing
+                                                            ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                                                            : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
                                                     .descriptorCount = 1,
                                                     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
                                                     .pImmutableSamplers = nullptr,
                                                 },
                                             }},
-                                }, .poolSizes =
+                                }, .pushConstantRanges =
                                 {
-                                    VkDescriptorPoolSize{
-                                        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                                        .descriptorCount = 1,
+                                    VkPushConstantRange{
+                                        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                                        .offset = 0,
+                                        .size = sizeof(PushConstantsPerObject),
                                     },
                                 }, .renderPass =
                                 li && li->renderPass.has_value() ? li->renderPass.value() : nullptr,
+                                            .name = "triangle",
+                                            .backend = li && li->pipelineBackend.has_value()
+                                                ? li->pipelineBackend.value()
+                                                : PipelineBackendE::PIPELINE,
                                             },
-    }));
-    auto bufferCreateInfo = std::make_shared<UniformBufferCreateInfoT>();
-    bufferCreateInfo->size = sizeof(UniformPerObject);
-    bufferCreateInfo->devicePtr = loadInfo->deviceptr;
-    bufferCreateInfo->type = DescriptorTypeE::UNIFORM_BUFFER;
-    bufferCreateInfo->frequency = DescriptorFrequencyE::PER_OBJECT;
-    bufferCreateInfo->setLayoutIndex = 0;
-    bufferCreateInfo->backBufferCount = static_cast<uint32_t>(li->type);
-    r->m_uniformBuffers.push_back(std::make_unique<UniformBuffer>(bufferCreateInfo));
-
-    r->m_renderStates.back()->getPipeline()->writeDescriptorSets(DescriptorFrequencyE::PER_OBJECT,
-                                                                 0, *r->m_uniformBuffers.back());
+    };
+    for (auto& pipeline :
+         device->createPipelines(pipelineCreateInfos, li ? li->threadPool : nullptr))
+    {
+        if (pipeline)
+            r->m_renderStates.push_back(std::make_unique<RenderState>(std::move(pipeline)));
+    }
+    // the device reported why, the scene is left empty
+    if (r->m_renderStates.empty())
+        return;
+
+    // descriptor writes of every pipeline are submitted at once
+    DescriptorWriter writer(loadInfo->deviceptr);
+    if (li && li->uniformRing)
+    {
+        // the renderer writes the object uniforms in its ring every frame
+        r->m_renderStates.back()->getPipeline()->writeDescriptorSets(
+            DescriptorFrequencyE::PER_OBJECT, 0, 0, *li->uniformRing, writer);
+    }
+    else
+    {
+        auto bufferCreateInfo = std::make_shared<UniformBufferCreateInfoT>();
+        bufferCreateInfo->size = sizeof(UniformPerObject);
+        bufferCreateInfo->devicePtr = loadInfo->deviceptr;
+        bufferCreateInfo->type = DescriptorTypeE::UNIFORM_BUFFER;
+        bufferCreateInfo->frequency = DescriptorFrequencyE::PER_OBJECT;
+        bufferCreateInfo->setLayoutIndex = 0;
+        bufferCreateInfo->backBufferCount = static_cast<uint32_t>(li->type);
+        r->m_uniformBuffers.push_back(std::make_unique<UniformBuffer>(bufferCreateInfo));
+
+        r->m_renderStates.back()->getPipeline()->writeDescriptorSets(
+            DescriptorFrequencyE::PER_OBJECT, 0, *r->m_uniformBuffers.back(), writer);
+    }
+    writer.flush();
 
     auto host = std::static_pointer_cast<CPUScene>(hostResource);
     for (int i = 0; i < host->m_meshes.size(); ++i)
     {
-        r->m_renderStates[0]->addObject(std::make_shared<MeshRenderDescription>(
-            std::static_pointer_cast<GPUMesh>(host->m_meshes[i]->localResource)));
+        auto mesh = std::static_pointer_cast<GPUMesh>(host->m_meshes[i]->localResource);
+        auto object = std::make_shared<MeshRenderDescription>(mesh);
+        object->getPerDrawData().constants = {
+            .model = glm::mat4(1.f),
+            .objectId = static_cast<uint32_t>(i),
+        };
+
+        // the record is uploaded once, then again only when the instance changes
+        if (li && li->sceneBuffer)
+        {
+            GPUInstanceT instance = {
+                .transform = object->getPerDrawData().constants.model,
+                .boundingSphere = computeBoundingSphere(*mesh),
+            };
+            uint32_t instanceIndex = li->sceneBuffer->add(instance);
+            if (instanceIndex != -1U)
+                object->getPerDrawData().constants.objectId = instanceIndex;
+        }
+        r->m_renderStates[0]->addObject(std::move(object));
     }
 }
 
@@ -6,13 +6,39 @@
 
 class RenderPass;
 enum class BufferingTypeE;
+enum class PipelineBackendE;
 class Buffer;
 class UniformBuffer;
+class UniformRing;
+class GPUSceneBuffer;
+class ThreadPool;
 
 struct SceneLoadInfoT : public ResourceLoadInfoT
 {
     std::optional<const RenderPass*> renderPass;
     BufferingTypeE type;
+    /**
+     * @brief pipeline backend of the scene pipelines, PIPELINE if empty
+     *
+     */
+    std::optional<PipelineBackendE> pipelineBackend;
+    /**
+     * @brief per object uniforms are read from this ring with dynamic offsets if set, from a
+     * uniform buffer otherwise
+     *
+     */
+    const UniformRing* uniformRing = nullptr;
+    /**
+     * @brief every mesh gets an instance record in this buffer if set, its index is the object id
+     * given to the draws
+     *
+     */
+    GPUSceneBuffer* sceneBuffer = nullptr;
+    /**
+     * @brief workers compiling the scene pipelines along with the loading thread if set
+     *
+     */
+    ThreadPool* threadPool = nullptr;
 };
 
 /**
@@ -0,0 +1,537 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <tuple>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "codec/ktx2_decoder.hpp"
+#include "codec/mip_chain.hpp"
+#include "core/thread_pool.hpp"
+#include "graphics/device/device.hpp"
+#include "graphics/device/memory/bindless_table.hpp"
+#include "graphics/device/memory/buffer.hpp"
+#include "graphics/device/memory/image_uploader.hpp"
+#include "graphics/device/physical_device.hpp"
+#include "texture_streamer.hpp"
+
+#include "texture.hpp"
+
+static constexpr uint32_t kTexelSize = 4U;
+// the levels up to this extent are uploaded first, a few kilobytes which show a blurry texture
+// while the larger levels are still decoding
+static constexpr uint32_t kTailExtent = 64U;
+// a multiple of 4 and of every block size
+static constexpr VkDeviceSize kLevelAlignment = 16U;
+
+/**
+ * @return the mapped staging buffer, null if it could not be mapped
+ */
+static std::pair<std::shared_ptr<Buffer>, uint8_t*> createStaging(const LogicalDevice* device,
+                                                                  const VkDeviceSize size)
+{
+    auto staging = device->createBuffer(BufferCreateInfoT{
+        .size = size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        .allocationType = AllocationTypeE::STAGING,
+    });
+    void* mapped = nullptr;
+    device->mapBufferMemory(staging, &mapped);
+    if (!mapped)
+    {
+        device->destroyBuffer(staging);
+        return {nullptr, nullptr};
+    }
+    return {std::move(staging), static_cast<uint8_t*>(mapped)};
+}
+
+static void finishStaging(const LogicalDevice* device, const std::shared_ptr<Buffer>& staging)
+{
+    if (!staging->memory->isHostCoherent())
+        device->getMemoryAllocator()->flush(*staging->memory, 0, VK_WHOLE_SIZE);
+    device->getMemoryAllocator()->unmapMemory(*staging->memory);
+}
+
+/**
+ * @brief the same copies, read from host memory starting at data instead of a buffer
+ *
+ */
+static std::vector<VkMemoryToImageCopyEXT> toHostRegions(
+    const std::vector<VkBufferImageCopy>& regions, const uint8_t* data)
+{
+    std::vector<VkMemoryToImageCopyEXT> out(regions.size());
+    for (size_t i = 0; i < regions.size(); ++i)
+    {
+        out[i] = VkMemoryToImageCopyEXT{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,
+            .pHostPointer = data + regions[i].bufferOffset,
+            .memoryRowLength = regions[i].bufferRowLength,
+            .memoryImageHeight = regions[i].bufferImageHeight,
+            .imageSubresource = regions[i].imageSubresource,
+            .imageOffset = regions[i].imageOffset,
+            .imageExtent = regions[i].imageExtent,
+        };
+    }
+    return out;
+}
+
+void GPUTexture::publishView(const uint32_t baseLevel)
+{
+    const ImageCreateInfoT& info = image->info;
+    auto newView = deviceptr->createImageView(ImageViewCreateInfoT{
+        .image = image->handle,
+        .format = info.format,
+        .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        .viewType = info.arrayLayers > 1U ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D,
+        .baseMipLevel = baseLevel,
+        .levelCount = info.mipLevels - baseLevel,
+        .layerCount = info.arrayLayers,
+    });
+
+    auto* bindless = deviceptr->getBindlessTable();
+    if (bindless)
+    {
+        if (bindlessIndex != UINT32_MAX)
+            bindless->release(BindlessBindingE::SAMPLED_IMAGE, bindlessIndex);
+        bindlessIndex = bindless->registerImage(newView->handle, image->layout);
+    }
+    // the frames in flight may still sample the previous view
+    if (view)
+        previousViews.push_back(std::move(view));
+    view = std::move(newView);
+    viewBaseLevel = baseLevel;
+
+    bReady.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief decode the file, fill a staging buffer and hand the copy to the device image uploader,
+ * runs on a worker thread
+ *
+ */
+static void loadTexture(Texture* texture, const std::shared_ptr<TextureLoadInfoT> li)
+{
+    auto host = std::static_pointer_cast<CPUTexture>(texture->hostResource);
+    auto local = std::static_pointer_cast<GPUTexture>(texture->localResource);
+    const LogicalDevice* device = li->deviceptr;
+
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* data =
+        stbi_load(li->filepath.value().string().c_str(), &width, &height, &channels, kTexelSize);
+    if (!data)
+    {
+        std::cerr << "Failed to load texture " << li->filepath.value() << " : "
+                  << stbi_failure_reason() << std::endl;
+        return;
+    }
+    host->width = static_cast<uint32_t>(width);
+    host->height = static_cast<uint32_t>(height);
+
+    host->pixels.assign(data, data + static_cast<size_t>(host->width) * host->height * kTexelSize);
+    stbi_image_free(data);
+
+    const bool bCompress = li->compression.has_value() &&
+                           device->getPhysicalDevice()->getFeatures().textureCompressionBC;
+    const VkFormat format = bCompress ? getBCVkFormat(li->compression.value(), li->bSRGB)
+                            : li->bSRGB ? VK_FORMAT_R8G8B8A8_SRGB
+                                        : VK_FORMAT_R8G8B8A8_UNORM;
+    const uint32_t mipLevels = li->bGenerateMips ? getMipLevelCount(host->width, host->height) : 1U;
+    ImageUploader* uploader = device->getImageUploader();
+    // host copies skip the staging buffer but record no blit, block compressed formats cannot be
+    // blitted to
+    const bool bHostCopy = uploader->supportsHostCopy(format);
+    const bool bBlitMips = !bHostCopy && !bCompress && mipLevels > 1U &&
+                           ImageUploader::supportsBlitMips(device->getPhysicalDevice(), format);
+
+    // every level is built here when the device cannot blit them
+    std::vector<MipLevelT> levels =
+        buildMipChain(host->pixels, host->width, host->height, bBlitMips ? 1U : mipLevels);
+    if (bCompress)
+    {
+        // this thread is a worker already, the pool is busy with the other loads
+        BCEncoder encoder(BCEncoderCreateInfoT{.quality = li->compressionQuality});
+        std::vector<uint8_t> encoded;
+        for (auto& level : levels)
+        {
+            const size_t encodedSize =
+                getBCEncodedSize(li->compression.value(), level.width, level.height);
+            encoded.resize(encoded.size() + encodedSize);
+            encoder.encode(
+                BCSurfaceT{
+                    .pixels = host->pixels.data() + level.offset,
+                    .width = level.width,
+                    .height = level.height,
+                },
+                li->compression.value(), encoded.data() + encoded.size() - encodedSize);
+            level.offset = encoded.size() - encodedSize;
+            level.size = encodedSize;
+        }
+        host->pixels = std::move(encoded);
+    }
+
+    std::vector<VkBufferImageCopy> regions(levels.size());
+    for (uint32_t level = 0; level < levels.size(); ++level)
+    {
+        regions[level] = VkBufferImageCopy{
+            .bufferOffset = levels[level].offset,
+            .bufferRowLength = 0U,
+            .bufferImageHeight = 0U,
+            .imageSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0U,
+                    .layerCount = 1U,
+                },
+            .imageOffset = {0, 0, 0},
+            .imageExtent = {levels[level].width, levels[level].height, 1U},
+        };
+    }
+    const VkDeviceSize size = host->pixels.size();
+    texture->cpuSideLoaded.test_and_set();
+
+    local->image = device->createImage(ImageCreateInfoT{
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent = {host->width, host->height, 1U},
+        .mipLevels = mipLevels,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT |
+                 (bHostCopy ? VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT
+                            : VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                                  (bBlitMips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0U)),
+    });
+    auto onUploaded = [texture, local]() {
+        local->publishView(0U);
+        texture->gpuSideLoaded.test_and_set();
+        texture->loaded.test_and_set();
+    };
+
+    if (bHostCopy)
+    {
+        if (!uploader->copyFromHost(local->image, toHostRegions(regions, host->pixels.data()), size,
+                                    std::move(onUploaded)))
+            std::cerr << "Failed to upload texture " << li->filepath.value() << std::endl;
+        host->pixels = {};
+        return;
+    }
+
+    auto staging = createStaging(device, size);
+    if (!staging.first)
+        return;
+    std::copy_n(host->pixels.data(), size, staging.second);
+    finishStaging(device, staging.first);
+
+    // the pixels live in the staging buffer from now on
+    host->pixels = {};
+
+    uploader->enqueue(ImageUploadT{
+        .image = local->image,
+        .staging = std::move(staging.first),
+        .regions = std::move(regions),
+        .bGenerateMips = bBlitMips,
+        .onRecorded = std::move(onUploaded),
+    });
+}
+
+/**
+ * @brief levels of a KTX2 texture decoded straight into the staging buffer of their group, the
+ * last level decoded in a group hands it to the image uploader, or copies it from the host
+ *
+ */
+struct Ktx2LevelGroupT
+{
+    uint32_t firstLevel = 0U;
+    uint32_t lastLevel = 0U;
+    std::shared_ptr<Buffer> staging;
+    /**
+     * @brief replaces the staging buffer when the image is copied from the host
+     *
+     */
+    std::vector<uint8_t> hostData;
+    uint8_t* mapped = nullptr;
+    std::vector<VkBufferImageCopy> regions;
+    std::atomic<uint32_t> pendingLevels = 0U;
+    std::atomic<bool> bFailed = false;
+};
+
+struct Ktx2LoadT
+{
+    Texture* texture;
+    std::shared_ptr<TextureLoadInfoT> li;
+    /**
+     * @brief handed to the streamer once the mip tail is uploaded, for the larger levels
+     *
+     */
+    std::shared_ptr<Ktx2Decoder> decoder;
+    bool bHostCopy = false;
+    /**
+     * @brief level of the file stored in the first level of the image, the tail level when the
+     * texture is streamed
+     *
+     */
+    uint32_t imageBaseLevel = 0U;
+    /**
+     * @brief the mip tail first, then the larger levels
+     *
+     */
+    Ktx2LevelGroupT groups[2];
+    /**
+     * @brief levels whose upload is recorded, only accessed by the render thread
+     *
+     */
+    std::vector<bool> recordedLevels;
+
+    Ktx2LoadT(Texture* t, const std::shared_ptr<TextureLoadInfoT>& loadInfo,
+              const Ktx2DecoderCreateInfoT decoderInfo)
+        : texture(t), li(loadInfo), decoder(std::make_shared<Ktx2Decoder>(decoderInfo))
+    {
+    }
+};
+
+static void onKtx2LevelsRecorded(const std::shared_ptr<Ktx2LoadT>& load,
+                                 const Ktx2LevelGroupT& group)
+{
+    auto local = std::static_pointer_cast<GPUTexture>(load->texture->localResource);
+    std::fill(load->recordedLevels.begin() + group.firstLevel,
+              load->recordedLevels.begin() + group.lastLevel, true);
+
+    // the view starts at the largest level below which every level is resident
+    uint32_t baseLevel = static_cast<uint32_t>(load->recordedLevels.size());
+    while (baseLevel > 0U && load->recordedLevels[baseLevel - 1])
+        --baseLevel;
+    // the larger levels may be recorded before the tail, the texture has no view until it is
+    const uint32_t viewBaseLevel = baseLevel - load->imageBaseLevel;
+    if (viewBaseLevel < local->image->info.mipLevels && viewBaseLevel < local->viewBaseLevel)
+        local->publishView(viewBaseLevel);
+
+    if (baseLevel == load->imageBaseLevel)
+    {
+        if (load->li->streamer)
+            load->li->streamer->add(local, load->decoder, load->imageBaseLevel);
+        load->texture->gpuSideLoaded.test_and_set();
+        load->texture->loaded.test_and_set();
+    }
+}
+
+static void decodeKtx2Level(const std::shared_ptr<Ktx2LoadT>& load, Ktx2LevelGroupT& group,
+                            const uint32_t level)
+{
+    const VkDeviceSize offset = group.regions[level - group.firstLevel].bufferOffset;
+    if (!load->decoder->decodeLevel(level, group.mapped + offset))
+        group.bFailed.store(true, std::memory_order_relaxed);
+    if (group.pendingLevels.fetch_sub(1U, std::memory_order_acq_rel) != 1U)
+        return;
+
+    const LogicalDevice* device = load->li->deviceptr;
+    if (group.staging)
+        finishStaging(device, group.staging);
+    if (group.bFailed.load(std::memory_order_relaxed))
+    {
+        if (group.staging)
+            device->destroyBuffer(group.staging);
+        group.hostData = {};
+        return;
+    }
+    if (&group == &load->groups[1] || load->groups[1].firstLevel == load->groups[1].lastLevel)
+        load->texture->cpuSideLoaded.test_and_set();
+
+    auto local = std::static_pointer_cast<GPUTexture>(load->texture->localResource);
+    auto onUploaded = [load, &group]() { onKtx2LevelsRecorded(load, group); };
+    if (load->bHostCopy)
+    {
+        if (!device->getImageUploader()->copyFromHost(
+                local->image, toHostRegions(group.regions, group.hostData.data()),
+                group.hostData.size(), std::move(onUploaded)))
+            std::cerr << "Failed to upload texture " << load->li->filepath.value() << std::endl;
+        group.hostData = {};
+        return;
+    }
+
+    device->getImageUploader()->enqueue(ImageUploadT{
+        .image = local->image,
+        .staging = std::move(group.staging),
+        .regions = std::move(group.regions),
+        .bGenerateMips = false,
+        .onRecorded = std::move(onUploaded),
+    });
+}
+
+/**
+ * @brief read the KTX2 header, create the image with every level and layer, then decode the
+ * levels from the smallest to the largest, in parallel on the thread pool when there is one
+ * the mip tail is uploaded as soon as it is decoded so that the texture shows up early, the view
+ * moves to the first level once the others are uploaded
+ * streamed textures stop at the mip tail, their image only holds it until the streamer grows it
+ *
+ */
+static void loadKtx2Texture(Texture* texture, const std::shared_ptr<TextureLoadInfoT> li)
+{
+    auto host = std::static_pointer_cast<CPUTexture>(texture->hostResource);
+    auto local = std::static_pointer_cast<GPUTexture>(texture->localResource);
+    const LogicalDevice* device = li->deviceptr;
+    const PhysicalDevice* physicalDevice = device->getPhysicalDevice();
+
+    auto load = std::make_shared<Ktx2LoadT>(
+        texture, li,
+        Ktx2DecoderCreateInfoT{
+            .isFormatSupported =
+                [physicalDevice](const VkFormat format) {
+                    return (physicalDevice->getFormatProperties(format).optimalTilingFeatures &
+                            VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+                },
+        });
+    Ktx2Decoder& decoder = *load->decoder;
+    if (!decoder.open(li->filepath.value()))
+        return;
+    host->width = decoder.getWidth();
+    host->height = decoder.getHeight();
+
+    const uint32_t levelCount = decoder.getLevelCount();
+    const uint32_t layerCount = decoder.getLayerCount();
+    // the tail starts at the first level which fits in kTailExtent, or at the last one
+    uint32_t tailLevel = 0U;
+    while (tailLevel + 1 < levelCount &&
+           std::max(host->width >> tailLevel, host->height >> tailLevel) > kTailExtent)
+        ++tailLevel;
+    load->groups[0].firstLevel = tailLevel;
+    load->groups[0].lastLevel = levelCount;
+    load->groups[1].firstLevel = 0U;
+    load->groups[1].lastLevel = li->streamer ? 0U : tailLevel;
+    load->recordedLevels.assign(levelCount, false);
+    load->bHostCopy = device->getImageUploader()->supportsHostCopy(decoder.getFormat());
+    load->imageBaseLevel = li->streamer ? tailLevel : 0U;
+    const uint32_t baseLevel = load->imageBaseLevel;
+
+    for (Ktx2LevelGroupT& group : load->groups)
+    {
+        if (group.firstLevel == group.lastLevel)
+            continue;
+
+        VkDeviceSize size = 0U;
+        for (uint32_t level = group.firstLevel; level < group.lastLevel; ++level)
+        {
+            group.regions.push_back(VkBufferImageCopy{
+                .bufferOffset = size,
+                .bufferRowLength = 0U,
+                .bufferImageHeight = 0U,
+                .imageSubresource =
+                    {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = level - baseLevel,
+                        .baseArrayLayer = 0U,
+                        .layerCount = layerCount,
+                    },
+                .imageOffset = {0, 0, 0},
+                .imageExtent = {std::max(host->width >> level, 1U),
+                                std::max(host->height >> level, 1U), 1U},
+            });
+            size += (decoder.getLevelSize(level) + kLevelAlignment - 1) / kLevelAlignment *
+                    kLevelAlignment;
+        }
+
+        if (load->bHostCopy)
+        {
+            group.hostData.resize(size);
+            group.mapped = group.hostData.data();
+        }
+        else
+            std::tie(group.staging, group.mapped) = createStaging(device, size);
+        if (!group.mapped)
+        {
+            if (&group != &load->groups[0] && load->groups[0].staging)
+            {
+                finishStaging(device, load->groups[0].staging);
+                device->destroyBuffer(load->groups[0].staging);
+            }
+            return;
+        }
+        group.pendingLevels.store(group.lastLevel - group.firstLevel, std::memory_order_relaxed);
+    }
+
+    // the streamer copies the resident levels into the image replacing this one
+    local->image = device->createImage(ImageCreateInfoT{
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = decoder.getFormat(),
+        .extent = {std::max(host->width >> baseLevel, 1U), std::max(host->height >> baseLevel, 1U),
+                   1U},
+        .mipLevels = levelCount - baseLevel,
+        .arrayLayers = layerCount,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT |
+                 (load->bHostCopy ? VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT
+                                  : VK_IMAGE_USAGE_TRANSFER_DST_BIT) |
+                 (li->streamer ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0U),
+    });
+    local->residentLevel = baseLevel;
+
+    // the pool runs the tasks in submission order, the smallest levels are decoded first
+    for (uint32_t level = levelCount; level-- > baseLevel;)
+    {
+        Ktx2LevelGroupT& group = load->groups[level >= tailLevel ? 0 : 1];
+        if (li->threadPool)
+            li->threadPool->submit(
+                [load, &group, level]() { decodeKtx2Level(load, group, level); });
+        else
+            decodeKtx2Level(load, group, level);
+    }
+}
+
+void Texture::loadHost(const uint64_t index, const std::shared_ptr<ResourceLoadInfoT> loadInfo)
+{
+    auto r = std::make_shared<CPUTexture>(index);
+    hostResource = r;
+    r->m_filepath = loadInfo->filepath.value_or("");
+}
+
+void Texture::loadLocal(const std::shared_ptr<ResourceLoadInfoT> loadInfo)
+{
+    auto li = std::dynamic_pointer_cast<TextureLoadInfoT>(loadInfo);
+    assert(li && li->filepath.has_value());
+
+    auto r = std::make_shared<GPUTexture>();
+    localResource = r;
+    r->deviceptr = loadInfo->deviceptr;
+    r->sampler = loadInfo->deviceptr->createSampler(li->sampler);
+
+    // decoding takes milliseconds per texture, the caller only waits for it without a pool
+    const auto load = li->filepath->extension() == ".ktx2" ? loadKtx2Texture : loadTexture;
+    if (li->threadPool)
+        li->threadPool->submit([this, li, load]() { load(this, li); });
+    else
+        load(this, li);
+}
+
+void Texture::unloadHost()
+{
+    std::static_pointer_cast<CPUTexture>(hostResource)->pixels = {};
+}
+void Texture::unloadLocal()
+{
+    auto r = std::static_pointer_cast<GPUTexture>(localResource);
+    // the image may be replaced by a residency change still in flight, the streamer releases it
+    if (r->streamer)
+    {
+        r->streamer->remove(*r);
+        r->deviceptr->destroySampler(r->sampler);
+        return;
+    }
+    if (r->bindlessIndex != UINT32_MAX)
+        r->deviceptr->getBindlessTable()->release(BindlessBindingE::SAMPLED_IMAGE,
+                                                  r->bindlessIndex);
+    if (r->view)
+        r->deviceptr->destroyImageView(r->view);
+    for (auto& view : r->previousViews)
+        r->deviceptr->destroyImageView(view);
+    if (r->image)
+        r->deviceptr->destroyImage(r->image);
+    r->deviceptr->destroySampler(r->sampler);
+}
+
+std::size_t TextureLoadInfoT::hash() const
+{
+    std::size_t h = ResourceLoadInfoT::hash() ^ (std::hash<bool>{}(bSRGB) << 1);
+    if (compression.has_value())
+        h ^= std::hash<uint32_t>{}(static_cast<uint32_t>(compression.value()) + 1U) << 2;
+    return h;
+}
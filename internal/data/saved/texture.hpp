@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "resource.hpp"
+
+#include "codec/bc_encoder.hpp"
+
+#include "graphics/device/memory/image.hpp"
+
+class ThreadPool;
+class TextureStreamer;
+
+struct TextureLoadInfoT : public ResourceLoadInfoT
+{
+    /**
+     * @brief color textures are sampled in linear space from an SRGB format, data textures
+     * (normals, masks) are read as UNORM
+     *
+     */
+    bool bSRGB = true;
+    bool bGenerateMips = true;
+    SamplerCreateInfoT sampler = {.maxAnisotropy = 16.f};
+    /**
+     * @brief block compress the levels at import time, the texture stays uncompressed if the
+     * device does not support the BC formats
+     *
+     */
+    std::optional<BCFormatE> compression;
+    BCQualityE compressionQuality = BCQualityE::FAST;
+    /**
+     * @brief workers decoding the file and filling the staging buffer, the load happens on the
+     * calling thread when null
+     *
+     */
+    ThreadPool* threadPool = nullptr;
+    /**
+     * @brief KTX2 textures only load their mip tail, the streamer brings in the larger levels
+     * depending on the screen area they cover (all of them until they are reported), other
+     * textures are loaded whole
+     *
+     */
+    TextureStreamer* streamer = nullptr;
+
+    virtual std::size_t hash() const override;
+};
+
+/**
+ * @brief sampled 2D image loaded from a PNG, JPEG or KTX2 file
+ * the file is decoded off the render thread and its staging copy recorded by the device image
+ * uploader, the GPU side is usable once GPUTexture::isReady returns true, before that draws use a
+ * fallback
+ * KTX2 files keep their levels and layers, Zstd supercompressed levels are inflated and Basis
+ * Universal ones transcoded to a BC format of the device, level by level on the thread pool, the
+ * mip tail becomes visible before the larger levels are uploaded
+ * with VK_EXT_host_image_copy the loading thread writes the image itself, no staging buffer
+ * streamed KTX2 textures keep only the levels granted by the TextureStreamer in their image
+ * a texture must not be unloaded while it is loading
+ *
+ */
+class Texture : public ResourceABC
+{
+  public:
+    void loadHost(const uint64_t index, const std::shared_ptr<ResourceLoadInfoT> loadInfo);
+    void loadLocal(const std::shared_ptr<ResourceLoadInfoT> loadInfo);
+
+    void unloadHost();
+    void unloadLocal();
+};
+
+class CPUTexture : public HostResourceABC
+{
+  public:
+    uint32_t width = 0U;
+    uint32_t height = 0U;
+    /**
+     * @brief RGBA8 texels or BC blocks of the levels stored in the staging buffer, only level 0
+     * when the mips are blitted by the device, freed once copied, unused by KTX2 files which are
+     * decoded straight into the staging buffer
+     *
+     */
+    std::vector<uint8_t> pixels;
+
+  public:
+    CPUTexture() = delete;
+    CPUTexture(uint64_t index) : HostResourceABC(index) {}
+};
+
+class GPUTexture : public LocalResourceABC
+{
+  public:
+    std::shared_ptr<Image> image;
+    /**
+     * @brief covers the levels from viewBaseLevel, replaced as the larger levels are uploaded
+     *
+     */
+    std::shared_ptr<ImageView> view;
+    std::shared_ptr<Sampler> sampler;
+    /**
+     * @brief views replaced while streaming the levels, still read by the frames in flight
+     *
+     */
+    std::vector<std::shared_ptr<ImageView>> previousViews;
+    uint32_t viewBaseLevel = UINT32_MAX;
+    /**
+     * @brief level of the file stored in the first level of the image, the larger ones are not
+     * resident, only streamed textures start above 0
+     *
+     */
+    uint32_t residentLevel = 0U;
+
+    /**
+     * @brief set when the texture is streamed, feedbackIndex is then its slot in the streamer
+     * feedback buffers
+     *
+     */
+    TextureStreamer* streamer = nullptr;
+    uint32_t feedbackIndex = UINT32_MAX;
+
+    /**
+     * @brief index of the view in the sampled image array of the device bindless table, changes
+     * with the view
+     *
+     */
+    uint32_t bindlessIndex = UINT32_MAX;
+
+    /**
+     * @brief set by the render thread once the first levels are recorded, image view and bindless
+     * index are valid from then on
+     *
+     */
+    std::atomic<bool> bReady = false;
+
+    [[nodiscard]] inline bool isReady() const { return bReady.load(std::memory_order_acquire); }
+
+    /**
+     * @brief make the levels of the image from baseLevel to the last one visible to the shaders,
+     * the previous view is kept in previousViews, render thread only
+     *
+     */
+    void publishView(const uint32_t baseLevel);
+};
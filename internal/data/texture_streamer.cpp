@@ -0,0 +1,607 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numbers>
+
+#include "codec/ktx2_decoder.hpp"
+#include "core/thread_pool.hpp"
+#include "graphics/device/device.hpp"
+#include "graphics/device/memory/bindless_table.hpp"
+#include "graphics/device/memory/buffer.hpp"
+#include "graphics/device/memory/image_uploader.hpp"
+#include "saved/texture.hpp"
+
+#include "texture_streamer.hpp"
+
+// a multiple of 4 and of every block size
+static constexpr VkDeviceSize kLevelAlignment = 16U;
+
+/**
+ * @brief a texture moving into an image starting at another level of the file, shared by the
+ * tasks decoding the missing levels
+ *
+ */
+struct ResidencyChangeT
+{
+    uint32_t slot = 0U;
+    uint32_t level = 0U;
+    std::shared_ptr<Image> image;
+    std::shared_ptr<Image> source;
+    std::vector<VkImageCopy> copies;
+
+    std::shared_ptr<Buffer> staging;
+    uint8_t* mapped = nullptr;
+    std::vector<VkBufferImageCopy> regions;
+    std::atomic<uint32_t> pendingLevels = 0U;
+    std::atomic<bool> bFailed = false;
+    std::atomic<bool> bEnqueued = false;
+};
+
+static void enqueueChange(const LogicalDevice* device,
+                          const std::shared_ptr<ResidencyChangeT>& change,
+                          std::function<void()> onRecorded)
+{
+    // a failed change only reports back to the render thread
+    const bool bFailed = change->bFailed.load(std::memory_order_relaxed);
+    change->bEnqueued.store(true, std::memory_order_release);
+    device->getImageUploader()->enqueue(ImageUploadT{
+        .image = change->image,
+        .staging = bFailed ? nullptr : std::move(change->staging),
+        .regions = bFailed ? std::vector<VkBufferImageCopy>{} : std::move(change->regions),
+        .source = bFailed ? nullptr : change->source,
+        .copies = bFailed ? std::vector<VkImageCopy>{} : std::move(change->copies),
+        .onRecorded = std::move(onRecorded),
+    });
+}
+
+static void decodeChangeLevel(const LogicalDevice* device, const Ktx2Decoder& decoder,
+                              const std::shared_ptr<ResidencyChangeT>& change, const uint32_t level,
+                              std::function<void()> onRecorded)
+{
+    const VkDeviceSize offset = change->regions[level - change->level].bufferOffset;
+    if (!decoder.decodeLevel(level, change->mapped + offset))
+        change->bFailed.store(true, std::memory_order_relaxed);
+    if (change->pendingLevels.fetch_sub(1U, std::memory_order_acq_rel) != 1U)
+        return;
+
+    if (!change->staging->memory->isHostCoherent())
+        device->getMemoryAllocator()->flush(*change->staging->memory, 0, VK_WHOLE_SIZE);
+    device->getMemoryAllocator()->unmapMemory(*change->staging->memory);
+    change->mapped = nullptr;
+    if (change->bFailed.load(std::memory_order_relaxed))
+        device->destroyBuffer(change->staging);
+
+    enqueueChange(device, change, std::move(onRecorded));
+}
+
+TextureStreamer::TextureStreamer(const TextureStreamerCreateInfoT createInfo) : ci(createInfo)
+{
+    m_textures.resize(ci.capacity);
+    m_freeSlots.reserve(ci.capacity);
+    for (uint32_t slot = ci.capacity; slot-- > 0;)
+        m_freeSlots.push_back(slot);
+    m_order.reserve(ci.capacity);
+    m_candidates.reserve(ci.capacity);
+
+    m_budget = ci.budget;
+    if (m_budget == 0U)
+    {
+        std::vector<HeapBudgetT> budgets;
+        ci.device->getMemoryAllocator()->getHeapBudgets(&budgets);
+        for (const HeapBudgetT& heap : budgets)
+        {
+            if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                m_budget = std::max(m_budget, heap.budget / 2);
+        }
+    }
+
+    // written by the shaders, read back once the frame is done
+    auto* bindless = ci.device->getBindlessTable();
+    for (uint32_t frame = 0; frame < ci.framesInFlight; ++frame)
+    {
+        auto buffer = ci.device->createBuffer(BufferCreateInfoT{
+            .size = sizeof(uint32_t) * ci.capacity,
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        });
+        void* mapped = nullptr;
+        ci.device->mapBufferMemory(buffer, &mapped);
+        if (mapped)
+        {
+            std::fill_n(static_cast<uint32_t*>(mapped), ci.capacity, UINT32_MAX);
+            if (!buffer->memory->isHostCoherent())
+                ci.device->getMemoryAllocator()->flush(*buffer->memory, 0, VK_WHOLE_SIZE);
+        }
+
+        m_feedbackMapped.push_back(static_cast<uint32_t*>(mapped));
+        m_feedbackBindlessIndices.push_back(bindless ? bindless->registerBuffer(buffer->handle)
+                                                     : UINT32_MAX);
+        m_feedbackBuffers.push_back(std::move(buffer));
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    for (uint32_t slot = 0; slot < ci.capacity; ++slot)
+    {
+        if (m_textures[slot].bUsed)
+            release(slot);
+    }
+
+    // the uploader destroys the staging buffers it was given
+    for (auto& change : m_changes)
+    {
+        if (!change->bEnqueued.load(std::memory_order_acquire) && change->staging)
+        {
+            if (change->mapped)
+                ci.device->getMemoryAllocator()->unmapMemory(*change->staging->memory);
+            ci.device->destroyBuffer(change->staging);
+        }
+        ci.device->destroyImage(change->image);
+    }
+    for (auto& retired : m_retired)
+    {
+        if (retired.view)
+            ci.device->destroyImageView(retired.view);
+        if (retired.image)
+            ci.device->destroyImage(retired.image);
+    }
+
+    auto* bindless = ci.device->getBindlessTable();
+    for (uint32_t frame = 0; frame < ci.framesInFlight; ++frame)
+    {
+        if (m_feedbackBindlessIndices[frame] != UINT32_MAX)
+            bindless->release(BindlessBindingE::STORAGE_BUFFER, m_feedbackBindlessIndices[frame]);
+        if (m_feedbackMapped[frame])
+            ci.device->getMemoryAllocator()->unmapMemory(*m_feedbackBuffers[frame]->memory);
+        ci.device->destroyBuffer(m_feedbackBuffers[frame]);
+    }
+
+    if (m_changeCount > 0U)
+    {
+        std::cout << "Texture streaming : " << m_changeCount << " residency changes ("
+                  << (m_streamedBytes >> 20) << " MiB decoded)" << std::endl;
+    }
+}
+
+void TextureStreamer::add(const std::shared_ptr<GPUTexture>& local,
+                          std::shared_ptr<Ktx2Decoder> decoder, const uint32_t tailLevel)
+{
+    if (m_freeSlots.empty())
+    {
+        std::cerr << "Failed to stream texture : " << ci.capacity
+                  << " textures are streamed already, it keeps its mip tail" << std::endl;
+        return;
+    }
+    const uint32_t slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+
+    StreamedTextureT& texture = m_textures[slot];
+    texture = StreamedTextureT{};
+    texture.local = local;
+    texture.decoder = std::move(decoder);
+    texture.tailLevel = tailLevel;
+    texture.residentLevel = tailLevel;
+    texture.targetLevel = tailLevel;
+    // nothing reported yet, the budget decides how far it grows
+    texture.wantedLevel = 0U;
+    texture.lastReportedUpdate = m_updateIndex;
+    texture.bUsed = true;
+
+    const uint32_t levelCount = texture.decoder->getLevelCount();
+    texture.imageSizes.assign(levelCount + 1, 0U);
+    for (uint32_t level = levelCount; level-- > 0;)
+        texture.imageSizes[level] = texture.imageSizes[level + 1] +
+                                    texture.decoder->getLevelSize(level);
+
+    local->streamer = this;
+    local->feedbackIndex = slot;
+    m_committedBytes += texture.imageSizes[tailLevel];
+    m_allocatedBytes += texture.imageSizes[tailLevel];
+}
+
+void TextureStreamer::remove(GPUTexture& local)
+{
+    StreamedTextureT& texture = m_textures[local.feedbackIndex];
+    if (texture.bChanging)
+        texture.bRemoved = true;
+    else
+        release(local.feedbackIndex);
+}
+
+void TextureStreamer::release(const uint32_t slot)
+{
+    StreamedTextureT& texture = m_textures[slot];
+    GPUTexture& local = *texture.local;
+
+    auto* bindless = ci.device->getBindlessTable();
+    if (bindless && local.bindlessIndex != UINT32_MAX)
+        bindless->release(BindlessBindingE::SAMPLED_IMAGE, local.bindlessIndex);
+    local.bindlessIndex = UINT32_MAX;
+
+    m_committedBytes -= texture.imageSizes[texture.residentLevel];
+    retire(std::move(local.image), std::move(local.view),
+           texture.imageSizes[texture.residentLevel]);
+    for (auto& view : local.previousViews)
+        retire(nullptr, std::move(view), 0U);
+    local.previousViews.clear();
+    local.streamer = nullptr;
+    local.feedbackIndex = UINT32_MAX;
+
+    texture = StreamedTextureT{};
+    m_freeSlots.push_back(slot);
+}
+
+void TextureStreamer::retire(std::shared_ptr<Image> image, std::shared_ptr<ImageView> view,
+                             const VkDeviceSize size)
+{
+    m_retired.emplace_back(RetiredT{
+        .frameIndex = m_frameIndex,
+        .image = std::move(image),
+        .view = std::move(view),
+        .size = size,
+    });
+}
+
+void TextureStreamer::reportCoverage(const GPUTexture& local, const float screenArea,
+                                     const float uvArea)
+{
+    if (local.feedbackIndex == UINT32_MAX || screenArea <= 0.f)
+        return;
+    StreamedTextureT& texture = m_textures[local.feedbackIndex];
+
+    // one texel per pixel, each level divides the texel count by 4
+    const float texels = static_cast<float>(texture.decoder->getWidth()) *
+                         static_cast<float>(texture.decoder->getHeight()) * uvArea;
+    const float level = std::clamp(0.5f * std::log2(texels / screenArea), 0.f,
+                                   static_cast<float>(texture.tailLevel));
+    texture.reportedLevel = std::min(texture.reportedLevel, static_cast<uint32_t>(level));
+    texture.reportedArea = std::max(texture.reportedArea, screenArea);
+}
+
+void TextureStreamer::reportLevel(const GPUTexture& local, const uint32_t level)
+{
+    if (local.feedbackIndex == UINT32_MAX)
+        return;
+    StreamedTextureT& texture = m_textures[local.feedbackIndex];
+    texture.reportedLevel = std::min(texture.reportedLevel, level);
+}
+
+float TextureStreamer::estimateScreenArea(const float radius, const float distance,
+                                          const float projectionScale)
+{
+    // the camera is inside the sphere, the texture may cover the whole screen
+    if (distance <= radius)
+        return std::numeric_limits<float>::max();
+    const float projectedRadius = radius * projectionScale / distance;
+    return std::numbers::pi_v<float> * projectedRadius * projectedRadius;
+}
+
+void TextureStreamer::readFeedback(const uint32_t frameIndex)
+{
+    uint32_t* feedback = m_feedbackMapped[frameIndex];
+    if (!feedback)
+        return;
+
+    auto& memory = *m_feedbackBuffers[frameIndex]->memory;
+    if (!memory.isHostCoherent())
+        ci.device->getMemoryAllocator()->invalidate(memory, 0, VK_WHOLE_SIZE);
+    for (uint32_t slot = 0; slot < ci.capacity; ++slot)
+    {
+        if (feedback[slot] == UINT32_MAX)
+            continue;
+        StreamedTextureT& texture = m_textures[slot];
+        if (texture.bUsed)
+            texture.reportedLevel = std::min(texture.reportedLevel, feedback[slot]);
+        feedback[slot] = UINT32_MAX;
+    }
+    if (!memory.isHostCoherent())
+        ci.device->getMemoryAllocator()->flush(memory, 0, VK_WHOLE_SIZE);
+}
+
+void TextureStreamer::update(const uint32_t frameIndex)
+{
+    m_frameIndex = frameIndex;
+    ++m_updateIndex;
+
+    // the frame that last used this slot is done with the retired images
+    for (auto it = m_retired.begin(); it != m_retired.end();)
+    {
+        if (it->frameIndex != frameIndex)
+        {
+            ++it;
+            continue;
+        }
+        if (it->view)
+            ci.device->destroyImageView(it->view);
+        if (it->image)
+            ci.device->destroyImage(it->image);
+        m_allocatedBytes -= it->size;
+        it = m_retired.erase(it);
+    }
+
+    readFeedback(frameIndex);
+    for (StreamedTextureT& texture : m_textures)
+    {
+        if (!texture.bUsed)
+            continue;
+        if (texture.reportedLevel != UINT32_MAX)
+        {
+            texture.wantedLevel =
+                std::clamp(texture.reportedLevel, texture.finestLevel, texture.tailLevel);
+            texture.wantedArea = texture.reportedArea;
+            texture.lastReportedUpdate = m_updateIndex;
+            texture.bReported = true;
+        }
+        else if (texture.bReported &&
+                 m_updateIndex - texture.lastReportedUpdate > ci.keepUpdateCount)
+        {
+            texture.wantedLevel = texture.tailLevel;
+            texture.wantedArea = 0.f;
+        }
+        texture.reportedLevel = UINT32_MAX;
+        texture.reportedArea = 0.f;
+    }
+
+    assignTargets();
+    startChanges();
+}
+
+void TextureStreamer::assignTargets()
+{
+    // the tails are always resident, the rest of the budget goes one level at a time to the
+    // texture missing the most levels
+    VkDeviceSize committed = 0U;
+    m_candidates.clear();
+    for (uint32_t slot = 0; slot < ci.capacity; ++slot)
+    {
+        StreamedTextureT& texture = m_textures[slot];
+        if (!texture.bUsed)
+            continue;
+        texture.targetLevel = texture.tailLevel;
+        committed += texture.imageSizes[texture.tailLevel];
+        if (texture.wantedLevel < texture.tailLevel)
+            m_candidates.push_back(slot);
+    }
+
+    const auto isLessUrgent = [this](const uint32_t a, const uint32_t b) {
+        const StreamedTextureT& ta = m_textures[a];
+        const StreamedTextureT& tb = m_textures[b];
+        // the levels seen on screen come before the ones of the textures nothing reported
+        if (ta.bReported != tb.bReported)
+            return !ta.bReported;
+        const uint32_t missingA = ta.targetLevel - ta.wantedLevel;
+        const uint32_t missingB = tb.targetLevel - tb.wantedLevel;
+        return missingA != missingB ? missingA < missingB : ta.wantedArea < tb.wantedArea;
+    };
+    std::make_heap(m_candidates.begin(), m_candidates.end(), isLessUrgent);
+    while (!m_candidates.empty())
+    {
+        std::pop_heap(m_candidates.begin(), m_candidates.end(), isLessUrgent);
+        StreamedTextureT& texture = m_textures[m_candidates.back()];
+
+        const VkDeviceSize growth =
+            texture.imageSizes[texture.targetLevel - 1] - texture.imageSizes[texture.targetLevel];
+        if (committed + growth > m_budget)
+        {
+            // the smaller levels of the others may still fit
+            m_candidates.pop_back();
+            continue;
+        }
+        committed += growth;
+        --texture.targetLevel;
+
+        if (texture.targetLevel > texture.wantedLevel)
+            std::push_heap(m_candidates.begin(), m_candidates.end(), isLessUrgent);
+        else
+            m_candidates.pop_back();
+    }
+}
+
+void TextureStreamer::startChanges()
+{
+    uint32_t startedCount = 0U;
+
+    // evictions first, they make room for the textures growing
+    for (uint32_t slot = 0; slot < ci.capacity && startedCount < ci.maxChangesPerUpdate; ++slot)
+    {
+        const StreamedTextureT& texture = m_textures[slot];
+        if (texture.bUsed && !texture.bChanging && !texture.bRemoved &&
+            texture.targetLevel > texture.residentLevel)
+        {
+            startChange(slot, texture.targetLevel);
+            ++startedCount;
+        }
+    }
+
+    m_order.clear();
+    for (uint32_t slot = 0; slot < ci.capacity; ++slot)
+    {
+        const StreamedTextureT& texture = m_textures[slot];
+        if (texture.bUsed && !texture.bChanging && !texture.bRemoved &&
+            texture.targetLevel < texture.residentLevel)
+            m_order.push_back(slot);
+    }
+    std::sort(m_order.begin(), m_order.end(), [this](const uint32_t a, const uint32_t b) {
+        const StreamedTextureT& ta = m_textures[a];
+        const StreamedTextureT& tb = m_textures[b];
+        const uint32_t missingA = ta.residentLevel - ta.targetLevel;
+        const uint32_t missingB = tb.residentLevel - tb.targetLevel;
+        return missingA != missingB ? missingA > missingB : ta.wantedArea > tb.wantedArea;
+    });
+
+    // a texture only grows once the evictions it waits for are started
+    for (const uint32_t slot : m_order)
+    {
+        if (startedCount >= ci.maxChangesPerUpdate)
+            break;
+        const StreamedTextureT& texture = m_textures[slot];
+        const VkDeviceSize growth =
+            texture.imageSizes[texture.targetLevel] - texture.imageSizes[texture.residentLevel];
+        if (m_committedBytes + growth > m_budget)
+            continue;
+        startChange(slot, texture.targetLevel);
+        ++startedCount;
+    }
+}
+
+void TextureStreamer::startChange(const uint32_t slot, const uint32_t level)
+{
+    StreamedTextureT& texture = m_textures[slot];
+    const Ktx2Decoder& decoder = *texture.decoder;
+    const ImageCreateInfoT& info = texture.local->image->info;
+    const uint32_t levelCount = decoder.getLevelCount();
+    const uint32_t width = decoder.getWidth();
+    const uint32_t height = decoder.getHeight();
+    const auto getExtent = [width, height](const uint32_t l) {
+        return VkExtent3D{std::max(width >> l, 1U), std::max(height >> l, 1U), 1U};
+    };
+
+    auto change = std::make_shared<ResidencyChangeT>();
+    change->slot = slot;
+    change->level = level;
+    change->source = texture.local->image;
+    change->image = ci.device->createImage(ImageCreateInfoT{
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = info.format,
+        .extent = getExtent(level),
+        .mipLevels = levelCount - level,
+        .arrayLayers = info.arrayLayers,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                 VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+    });
+
+    // the levels both images hold are copied by the device
+    for (uint32_t l = std::max(level, texture.residentLevel); l < levelCount; ++l)
+    {
+        change->copies.push_back(VkImageCopy{
+            .srcSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = l - texture.residentLevel,
+                    .baseArrayLayer = 0U,
+                    .layerCount = info.arrayLayers,
+                },
+            .srcOffset = {0, 0, 0},
+            .dstSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = l - level,
+                    .baseArrayLayer = 0U,
+                    .layerCount = info.arrayLayers,
+                },
+            .dstOffset = {0, 0, 0},
+            .extent = getExtent(l),
+        });
+    }
+
+    // the others are decoded from the file
+    VkDeviceSize size = 0U;
+    for (uint32_t l = level; l < texture.residentLevel; ++l)
+    {
+        change->regions.push_back(VkBufferImageCopy{
+            .bufferOffset = size,
+            .bufferRowLength = 0U,
+            .bufferImageHeight = 0U,
+            .imageSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = l - level,
+                    .baseArrayLayer = 0U,
+                    .layerCount = info.arrayLayers,
+                },
+            .imageOffset = {0, 0, 0},
+            .imageExtent = getExtent(l),
+        });
+        size += (decoder.getLevelSize(l) + kLevelAlignment - 1) / kLevelAlignment *
+                kLevelAlignment;
+    }
+    if (size > 0U)
+    {
+        change->staging = ci.device->createBuffer(BufferCreateInfoT{
+            .size = size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            .allocationType = AllocationTypeE::STAGING,
+        });
+        void* mapped = nullptr;
+        ci.device->mapBufferMemory(change->staging, &mapped);
+        if (!mapped)
+        {
+            ci.device->destroyBuffer(change->staging);
+            ci.device->destroyImage(change->image);
+            return;
+        }
+        change->mapped = static_cast<uint8_t*>(mapped);
+    }
+
+    texture.bChanging = true;
+    m_committedBytes += texture.imageSizes[level] - texture.imageSizes[texture.residentLevel];
+    m_allocatedBytes += texture.imageSizes[level];
+    m_streamedBytes += size;
+    ++m_changeCount;
+    m_changes.push_back(change);
+
+    auto onRecorded = [this, change]() { onChangeRecorded(change); };
+    if (level >= texture.residentLevel)
+    {
+        enqueueChange(ci.device, change, std::move(onRecorded));
+        return;
+    }
+
+    // the smallest levels first, the pool runs the tasks in submission order
+    change->pendingLevels.store(texture.residentLevel - level, std::memory_order_relaxed);
+    for (uint32_t l = texture.residentLevel; l-- > level;)
+    {
+        if (ci.threadPool)
+        {
+            ci.threadPool->submit([device = ci.device, decoder = texture.decoder, change, l,
+                                   onRecorded]() {
+                decodeChangeLevel(device, *decoder, change, l, onRecorded);
+            });
+        }
+        else
+            decodeChangeLevel(ci.device, decoder, change, l, onRecorded);
+    }
+}
+
+void TextureStreamer::onChangeRecorded(const std::shared_ptr<ResidencyChangeT>& change)
+{
+    m_changes.erase(std::find(m_changes.begin(), m_changes.end(), change));
+
+    StreamedTextureT& texture = m_textures[change->slot];
+    texture.bChanging = false;
+    const VkDeviceSize size = texture.imageSizes[change->level];
+    const VkDeviceSize previousSize = texture.imageSizes[texture.residentLevel];
+
+    if (change->bFailed.load(std::memory_order_relaxed) || texture.bRemoved)
+    {
+        m_committedBytes += previousSize - size;
+        retire(std::move(change->image), nullptr, size);
+        if (texture.bRemoved)
+        {
+            release(change->slot);
+            return;
+        }
+        // the texture stays with the levels it has
+        std::cerr << "Failed to stream level " << change->level << " of texture "
+                  << change->slot << std::endl;
+        texture.finestLevel = texture.residentLevel;
+        texture.wantedLevel = std::max(texture.wantedLevel, texture.finestLevel);
+        return;
+    }
+
+    GPUTexture& local = *texture.local;
+    retire(std::move(local.image), nullptr, previousSize);
+    local.image = std::move(change->image);
+    local.residentLevel = change->level;
+    local.publishView(0U);
+    for (auto& view : local.previousViews)
+        retire(nullptr, std::move(view), 0U);
+    local.previousViews.clear();
+
+    texture.residentLevel = change->level;
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+class ThreadPool;
+class Buffer;
+class Image;
+class ImageView;
+class Ktx2Decoder;
+class GPUTexture;
+struct ResidencyChangeT;
+
+struct TextureStreamerCreateInfoT
+{
+    const LogicalDevice* device;
+    /**
+     * @brief workers decoding the streamed levels, they are decoded on the render thread when null
+     *
+     */
+    ThreadPool* threadPool = nullptr;
+
+    /**
+     * @brief device memory the images of the streamed textures may use, 0 takes half of the
+     * budget of the largest device local heap
+     * the images being replaced are not counted, they are released framesInFlight updates later
+     *
+     */
+    VkDeviceSize budget = 0U;
+    uint32_t framesInFlight = 3U;
+    /**
+     * @brief streamed textures at once, each one has a slot in the feedback buffers
+     *
+     */
+    uint32_t capacity = 4096U;
+    /**
+     * @brief residency changes started per update, each one creates an image and copies the
+     * resident levels into it
+     *
+     */
+    uint32_t maxChangesPerUpdate = 4U;
+    /**
+     * @brief updates during which a texture keeps its levels once it is not reported anymore, the
+     * textures never reported keep wanting all their levels
+     *
+     */
+    uint32_t keepUpdateCount = 120U;
+};
+
+/**
+ * @brief keeps the larger levels of the streamed textures resident depending on the screen area
+ * they cover, within a device memory budget
+ * textures start with their mip tail, the levels they need are reported each frame either from the
+ * CPU (reportCoverage, from the projected bounds of the draws) or by the shaders, which write the
+ * finest level they sample into the feedback buffer of the frame
+ * the budget is granted one level at a time to the textures missing the most levels, the larger
+ * covered areas first, textures not reported for keepUpdateCount updates fall back to their tail
+ * a texture never reported wants all its levels, a draw loop with no coverage estimate or shaders
+ * without feedback would otherwise leave it at its tail
+ * a residency change decodes the missing levels on the thread pool, then the device image uploader
+ * copies them and the kept levels into a new image which replaces the previous one
+ * only KTX2 textures are streamed, their decoder keeps the file in host memory
+ * render thread only
+ *
+ */
+class TextureStreamer
+{
+  private:
+    const TextureStreamerCreateInfoT ci;
+
+  private:
+    struct StreamedTextureT
+    {
+        std::shared_ptr<GPUTexture> local;
+        std::shared_ptr<Ktx2Decoder> decoder;
+        /**
+         * @brief smallest level always resident, first resident level of the file, and the one
+         * granted by the budget
+         *
+         */
+        uint32_t tailLevel = 0U;
+        uint32_t residentLevel = 0U;
+        uint32_t targetLevel = 0U;
+        /**
+         * @brief finest level the file could be decoded at, raised when decoding fails
+         *
+         */
+        uint32_t finestLevel = 0U;
+        /**
+         * @brief finest level reported since the last update, UINT32_MAX if none, and the one
+         * kept until keepUpdateCount updates without report
+         *
+         */
+        uint32_t reportedLevel = UINT32_MAX;
+        uint32_t wantedLevel = 0U;
+        uint64_t lastReportedUpdate = 0U;
+        /**
+         * @brief reported at least once, only then may it fall back to its tail
+         *
+         */
+        bool bReported = false;
+        /**
+         * @brief largest screen area reported since the last update, in pixels, and the one kept
+         *
+         */
+        float reportedArea = 0.f;
+        float wantedArea = 0.f;
+        /**
+         * @brief bytes of the image when it starts at each level of the file
+         *
+         */
+        std::vector<VkDeviceSize> imageSizes;
+        bool bUsed = false;
+        bool bChanging = false;
+        bool bRemoved = false;
+    };
+    std::vector<StreamedTextureT> m_textures;
+    std::vector<uint32_t> m_freeSlots;
+
+    struct RetiredT
+    {
+        uint32_t frameIndex;
+        std::shared_ptr<Image> image;
+        std::shared_ptr<ImageView> view;
+        VkDeviceSize size;
+    };
+    std::vector<RetiredT> m_retired;
+    /**
+     * @brief changes whose upload is not recorded yet, released with the streamer if it never is
+     *
+     */
+    std::vector<std::shared_ptr<ResidencyChangeT>> m_changes;
+
+    /**
+     * @brief one per frame in flight, UINT32_MAX per slot when nothing was sampled
+     *
+     */
+    std::vector<std::shared_ptr<Buffer>> m_feedbackBuffers;
+    std::vector<uint32_t*> m_feedbackMapped;
+    std::vector<uint32_t> m_feedbackBindlessIndices;
+
+    VkDeviceSize m_budget = 0U;
+    /**
+     * @brief images the textures hold once the running changes are done, checked against the
+     * budget, and the images actually allocated, the created and retired ones included
+     *
+     */
+    VkDeviceSize m_committedBytes = 0U;
+    VkDeviceSize m_allocatedBytes = 0U;
+    uint64_t m_updateIndex = 0U;
+    uint32_t m_frameIndex = 0U;
+
+    /**
+     * @brief reused by each update so that the frame loop does not allocate
+     *
+     */
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_candidates;
+
+    uint64_t m_changeCount = 0U;
+    uint64_t m_streamedBytes = 0U;
+
+    void readFeedback(const uint32_t frameIndex);
+    void assignTargets();
+    void startChanges();
+    void startChange(const uint32_t slot, const uint32_t level);
+    void onChangeRecorded(const std::shared_ptr<ResidencyChangeT>& change);
+
+    void retire(std::shared_ptr<Image> image, std::shared_ptr<ImageView> view,
+                const VkDeviceSize size);
+    void release(const uint32_t slot);
+
+  public:
+    TextureStreamer() = delete;
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+    TextureStreamer(TextureStreamer&&) = delete;
+    TextureStreamer& operator=(TextureStreamer&&) = delete;
+
+    explicit TextureStreamer(const TextureStreamerCreateInfoT createInfo);
+    /**
+     * @brief the device must be idle and the thread pool stopped, the textures removed
+     *
+     */
+    ~TextureStreamer();
+
+    /**
+     * @brief stream the texture from now on, its image holds the levels from tailLevel, called by
+     * the texture once its mip tail is uploaded
+     *
+     */
+    void add(const std::shared_ptr<GPUTexture>& local, std::shared_ptr<Ktx2Decoder> decoder,
+             const uint32_t tailLevel);
+    /**
+     * @brief release the image, views and bindless index of the texture once the frames in flight
+     * are done with them, after its residency change if one is running
+     *
+     */
+    void remove(GPUTexture& local);
+
+    /**
+     * @brief the texture covers screenArea pixels this frame, with uvArea the area of the texture
+     * coordinates range the draw covers (more than 1 for repeated textures)
+     *
+     */
+    void reportCoverage(const GPUTexture& local, const float screenArea, const float uvArea = 1.f);
+    /**
+     * @brief the texture is sampled from this level of the file
+     *
+     */
+    void reportLevel(const GPUTexture& local, const uint32_t level);
+
+    /**
+     * @brief read the feedback of the frame, grant the budget and start the residency changes,
+     * once per frame after the fence of the frame was waited on and before the device image
+     * uploader records
+     *
+     */
+    void update(const uint32_t frameIndex);
+
+    /**
+     * @brief pixels covered by a sphere of this radius at this distance from the camera,
+     * projectionScale being the viewport height divided by twice the tangent of half the vertical
+     * field of view
+     *
+     */
+    [[nodiscard]] static float estimateScreenArea(const float radius, const float distance,
+                                                  const float projectionScale);
+
+  public:
+    /**
+     * @brief storage buffer of UINT32_MAX initialized uint values indexed by
+     * GPUTexture::feedbackIndex, the shaders of the frame atomicMin the level of the file they
+     * sample (computed with the extent of the first level) into it
+     *
+     */
+    [[nodiscard]] inline const std::shared_ptr<Buffer>& getFeedbackBuffer(
+        const uint32_t frameIndex) const
+    {
+        return m_feedbackBuffers[frameIndex];
+    }
+    /**
+     * @brief index of the feedback buffer in the bindless storage buffer array, UINT32_MAX without
+     * bindless table
+     *
+     */
+    [[nodiscard]] inline uint32_t getFeedbackBindlessIndex(const uint32_t frameIndex) const
+    {
+        return m_feedbackBindlessIndices[frameIndex];
+    }
+    [[nodiscard]] inline VkDeviceSize getBudget() const { return m_budget; }
+    [[nodiscard]] inline VkDeviceSize getCommittedBytes() const { return m_committedBytes; }
+    [[nodiscard]] inline VkDeviceSize getAllocatedBytes() const { return m_allocatedBytes; }
+    [[nodiscard]] inline bool isIdle() const { return m_changes.empty(); }
+};
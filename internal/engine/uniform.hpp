@@ -20,6 +20,17 @@ class UniformPerMaterial
 
 class UniformPerObject
 {
+  public:
     glm::mat4 viewProj;
     glm::mat4 mvp;
 };
+
+/**
+ * @brief per draw data given with push constants (the first 128 bytes are always available)
+ *
+ */
+struct PushConstantsPerObject
+{
+    glm::mat4 model;
+    uint32_t objectId;
+};
@@ -7,6 +7,7 @@
 
 class Semaphore;
 class Buffer;
+class DescriptorAllocator;
 
 enum class BufferingTypeE
 {
@@ -48,6 +49,12 @@ struct BackBufferAOST
      *
      */
     VkFence inFlightFence;
+    /**
+     * @brief descriptor sets used by this back buffer only, reset as a whole once the in flight
+     * fence is signaled
+     *
+     */
+    std::shared_ptr<DescriptorAllocator> transientDescriptorAllocator;
 
 } typedef BackBufferT;
 
@@ -0,0 +1,238 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "context.hpp"
+#include "symbols.hpp"
+
+#include "call_tracker.hpp"
+
+static constexpr size_t kCallCount = static_cast<size_t>(CallE::COUNT);
+
+static std::array<std::atomic<uint64_t>, kCallCount> s_callCounts = {};
+static std::array<std::atomic<uint64_t>, kCallCount> s_callNanoseconds = {};
+static std::array<CallCountersT, kCallCount> s_frameBegin = {};
+static uint64_t s_frameCount = 0U;
+
+const char* getCallName(const CallE call)
+{
+    switch (call)
+    {
+    case CallE::CMD_BIND_PIPELINE:
+        return "vkCmdBindPipeline";
+    case CallE::CMD_BIND_DESCRIPTOR_SETS:
+        return "vkCmdBindDescriptorSets";
+    case CallE::CMD_PUSH_DESCRIPTOR_SET:
+        return "vkCmdPushDescriptorSetKHR";
+    case CallE::CMD_PUSH_CONSTANTS:
+        return "vkCmdPushConstants";
+    case CallE::CMD_BIND_VERTEX_BUFFERS:
+        return "vkCmdBindVertexBuffers";
+    case CallE::CMD_BIND_INDEX_BUFFER:
+        return "vkCmdBindIndexBuffer";
+    case CallE::CMD_DRAW_INDEXED:
+        return "vkCmdDrawIndexed";
+    case CallE::CMD_DISPATCH:
+        return "vkCmdDispatch";
+    case CallE::CMD_PIPELINE_BARRIER:
+        return "vkCmdPipelineBarrier";
+    case CallE::ALLOCATE_DESCRIPTOR_SETS:
+        return "vkAllocateDescriptorSets";
+    case CallE::UPDATE_DESCRIPTOR_SETS:
+        return "vkUpdateDescriptorSets";
+    case CallE::UPDATE_DESCRIPTOR_SET_WITH_TEMPLATE:
+        return "vkUpdateDescriptorSetWithTemplate";
+    case CallE::CREATE_GRAPHICS_PIPELINES:
+        return "vkCreateGraphicsPipelines";
+    case CallE::ALLOCATE_MEMORY:
+        return "vkAllocateMemory";
+    case CallE::WAIT_FOR_FENCES:
+        return "vkWaitForFences";
+    case CallE::ACQUIRE_NEXT_IMAGE:
+        return "vkAcquireNextImageKHR";
+    case CallE::QUEUE_SUBMIT:
+        return "vkQueueSubmit";
+    case CallE::QUEUE_PRESENT:
+        return "vkQueuePresentKHR";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief reading the clock costs as much as recording a command, only the calls that may block,
+ * compile or allocate are timed
+ *
+ */
+static constexpr bool isTimedCall(const CallE call)
+{
+    switch (call)
+    {
+    case CallE::ALLOCATE_DESCRIPTOR_SETS:
+    case CallE::UPDATE_DESCRIPTOR_SETS:
+    case CallE::CREATE_GRAPHICS_PIPELINES:
+    case CallE::ALLOCATE_MEMORY:
+    case CallE::WAIT_FOR_FENCES:
+    case CallE::ACQUIRE_NEXT_IMAGE:
+    case CallE::QUEUE_SUBMIT:
+    case CallE::QUEUE_PRESENT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool CallTracker::isEnabled()
+{
+#ifdef ENABLE_CALL_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool CallTracker::isTimed(const CallE call)
+{
+    return isTimedCall(call);
+}
+
+#ifdef ENABLE_CALL_TRACKING
+
+using Clock = std::chrono::steady_clock;
+
+struct CallTimerT
+{
+    size_t index;
+    Clock::time_point start;
+
+    explicit CallTimerT(const size_t callIndex) : index(callIndex), start(Clock::now()) {}
+    ~CallTimerT()
+    {
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+        s_callNanoseconds[index].fetch_add(elapsed.count(), std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief one trampoline per entry point and per kind of function table, the function it replaced
+ * is kept in next
+ *
+ */
+template<CallE Call, class TSymbols, class TFunction> struct CallHookT;
+
+template<CallE Call, class TSymbols, class TResult, class... TArgs>
+struct CallHookT<Call, TSymbols, TResult(VKAPI_PTR*)(TArgs...)>
+{
+    static inline TResult(VKAPI_PTR* next)(TArgs...) = nullptr;
+
+    static TResult VKAPI_PTR call(TArgs... args)
+    {
+        constexpr size_t i = static_cast<size_t>(Call);
+        s_callCounts[i].fetch_add(1U, std::memory_order_relaxed);
+        if constexpr (isTimedCall(Call))
+        {
+            CallTimerT timer(i);
+            return next(args...);
+        }
+        else
+            return next(args...);
+    }
+};
+
+template<CallE Call, class TSymbols, class TClass, class TFunction>
+static void hook(TSymbols* symbols, TFunction TClass::*member)
+{
+    using HookT = CallHookT<Call, TSymbols, TFunction>;
+
+    TFunction& function = symbols->*member;
+    // not loaded (extension not enabled) or already wrapped
+    if (function == nullptr || function == &HookT::call)
+        return;
+    HookT::next = function;
+    function = &HookT::call;
+}
+
+template<class TSymbols> static void hookAll(TSymbols* symbols)
+{
+    hook<CallE::CMD_BIND_PIPELINE>(symbols, &TSymbols::CmdBindPipeline);
+    hook<CallE::CMD_BIND_DESCRIPTOR_SETS>(symbols, &TSymbols::CmdBindDescriptorSets);
+    hook<CallE::CMD_PUSH_DESCRIPTOR_SET>(symbols, &TSymbols::CmdPushDescriptorSetKHR);
+    hook<CallE::CMD_PUSH_CONSTANTS>(symbols, &TSymbols::CmdPushConstants);
+    hook<CallE::CMD_BIND_VERTEX_BUFFERS>(symbols, &TSymbols::CmdBindVertexBuffers);
+    hook<CallE::CMD_BIND_INDEX_BUFFER>(symbols, &TSymbols::CmdBindIndexBuffer);
+    hook<CallE::CMD_DRAW_INDEXED>(symbols, &TSymbols::CmdDrawIndexed);
+    hook<CallE::CMD_DISPATCH>(symbols, &TSymbols::CmdDispatch);
+    hook<CallE::CMD_PIPELINE_BARRIER>(symbols, &TSymbols::CmdPipelineBarrier);
+    hook<CallE::ALLOCATE_DESCRIPTOR_SETS>(symbols, &TSymbols::AllocateDescriptorSets);
+    hook<CallE::UPDATE_DESCRIPTOR_SETS>(symbols, &TSymbols::UpdateDescriptorSets);
+    hook<CallE::UPDATE_DESCRIPTOR_SET_WITH_TEMPLATE>(symbols,
+                                                     &TSymbols::UpdateDescriptorSetWithTemplate);
+    hook<CallE::CREATE_GRAPHICS_PIPELINES>(symbols, &TSymbols::CreateGraphicsPipelines);
+    hook<CallE::ALLOCATE_MEMORY>(symbols, &TSymbols::AllocateMemory);
+    hook<CallE::WAIT_FOR_FENCES>(symbols, &TSymbols::WaitForFences);
+    hook<CallE::ACQUIRE_NEXT_IMAGE>(symbols, &TSymbols::AcquireNextImageKHR);
+    hook<CallE::QUEUE_SUBMIT>(symbols, &TSymbols::QueueSubmit);
+    hook<CallE::QUEUE_PRESENT>(symbols, &TSymbols::QueuePresentKHR);
+}
+
+#endif
+
+void CallTracker::install(ContextABC* cx, DeviceDispatchT* dispatch)
+{
+#ifdef ENABLE_CALL_TRACKING
+    // the trampolines keep a single next function per table kind, so a single device is tracked
+    hookAll(cx);
+    hookAll(dispatch);
+#endif
+}
+
+void CallTracker::beginFrame()
+{
+    for (size_t i = 0; i < kCallCount; ++i)
+        s_frameBegin[i] = getTotalCounters(static_cast<CallE>(i));
+    ++s_frameCount;
+}
+
+uint64_t CallTracker::getFrameCount()
+{
+    return s_frameCount;
+}
+
+CallCountersT CallTracker::getTotalCounters(const CallE call)
+{
+    const size_t i = static_cast<size_t>(call);
+    return CallCountersT{
+        .callCount = s_callCounts[i].load(std::memory_order_relaxed),
+        .nanoseconds = s_callNanoseconds[i].load(std::memory_order_relaxed),
+    };
+}
+
+CallCountersT CallTracker::getFrameCounters(const CallE call)
+{
+    const CallCountersT total = getTotalCounters(call);
+    const CallCountersT& begin = s_frameBegin[static_cast<size_t>(call)];
+    return CallCountersT{
+        .callCount = total.callCount - begin.callCount,
+        .nanoseconds = total.nanoseconds - begin.nanoseconds,
+    };
+}
+
+void CallTracker::dumpFrame(std::ostream& os)
+{
+    std::array<CallCountersT, kCallCount> counters;
+    for (size_t i = 0; i < kCallCount; ++i)
+        counters[i] = getFrameCounters(static_cast<CallE>(i));
+
+    os << "frame calls :";
+    for (size_t i = 0; i < kCallCount; ++i)
+    {
+        if (counters[i].callCount == 0U)
+            continue;
+        const CallE call = static_cast<CallE>(i);
+        os << " " << getCallName(call) << " " << counters[i].callCount;
+        if (isTimedCall(call))
+            os << " (" << counters[i].nanoseconds / 1000U << " us)";
+    }
+    os << std::endl;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+class ContextABC;
+struct DeviceDispatchT;
+
+/**
+ * @brief entry points counted by the CallTracker
+ *
+ */
+enum class CallE
+{
+    CMD_BIND_PIPELINE = 0,
+    CMD_BIND_DESCRIPTOR_SETS = 1,
+    CMD_PUSH_DESCRIPTOR_SET = 2,
+    CMD_PUSH_CONSTANTS = 3,
+    CMD_BIND_VERTEX_BUFFERS = 4,
+    CMD_BIND_INDEX_BUFFER = 5,
+    CMD_DRAW_INDEXED = 6,
+    CMD_DISPATCH = 7,
+    CMD_PIPELINE_BARRIER = 8,
+    ALLOCATE_DESCRIPTOR_SETS = 9,
+    UPDATE_DESCRIPTOR_SETS = 10,
+    UPDATE_DESCRIPTOR_SET_WITH_TEMPLATE = 11,
+    CREATE_GRAPHICS_PIPELINES = 12,
+    ALLOCATE_MEMORY = 13,
+    WAIT_FOR_FENCES = 14,
+    ACQUIRE_NEXT_IMAGE = 15,
+    QUEUE_SUBMIT = 16,
+    QUEUE_PRESENT = 17,
+    COUNT = 18,
+};
+
+[[nodiscard]] const char* getCallName(const CallE call);
+
+struct CallCountersT
+{
+    uint64_t callCount = 0U;
+    /**
+     * @brief time spent in the driver, only measured for the calls that may block or compile
+     * (see isTimed), zero for the others
+     *
+     */
+    uint64_t nanoseconds = 0U;
+};
+
+/**
+ * @brief counts the vulkan calls per entry point and per frame
+ * install replaces the function pointers of the context and of a dispatch table by counting
+ * trampolines, it is only compiled with ENABLE_CALL_TRACKING, the counters stay at zero otherwise
+ * the functions VMA fetched for itself are not counted
+ *
+ */
+class CallTracker
+{
+  public:
+    CallTracker() = delete;
+
+    [[nodiscard]] static bool isEnabled();
+    [[nodiscard]] static bool isTimed(const CallE call);
+
+    /**
+     * @brief wrap the counted functions of the context and of the dispatch table of one device,
+     * before other threads record or submit, installing twice is harmless
+     *
+     */
+    static void install(ContextABC* cx, DeviceDispatchT* dispatch);
+
+    /**
+     * @brief start counting a new frame, called once per frame by the main loop
+     *
+     */
+    static void beginFrame();
+    [[nodiscard]] static uint64_t getFrameCount();
+
+    /**
+     * @brief calls since the last beginFrame
+     *
+     */
+    [[nodiscard]] static CallCountersT getFrameCounters(const CallE call);
+    /**
+     * @brief calls since the install
+     *
+     */
+    [[nodiscard]] static CallCountersT getTotalCounters(const CallE call);
+
+    /**
+     * @brief calls of the current frame per entry point, on a single line, the entry points not
+     * called are left out
+     *
+     */
+    static void dumpFrame(std::ostream& os);
+};
@@ -1,5 +1,3 @@
-#pragma once
-
 #include <iostream>
 
 #include "device/device.hpp"
@@ -7,11 +5,20 @@
 
 #include "context.hpp"
 
+#if defined(_WIN32)
+static constexpr const char* kVulkanLibrary = "vulkan-1";
+#elif defined(__APPLE__)
+static constexpr const char* kVulkanLibrary = "libvulkan.1.dylib";
+#else
+static constexpr const char* kVulkanLibrary = "libvulkan.so.1";
+#endif
+
 ContextDLL::ContextDLL(const ContextCreateInfoT createInfo) : ContextABC(createInfo)
 {
-    m_loader = std::make_unique<f6::bin::DynamicLibraryLoader>("vulkan-1");
+    m_loader = std::make_unique<f6::bin::DynamicLibraryLoader>(kVulkanLibrary);
     InstanceSymbolsLoaderT::load(this, m_loader.get());
-    DeviceSymbolsLoaderT::load(this, m_loader.get());
+    if (GetInstanceProcAddr == nullptr)
+        return;
     enumerateAvailableInstanceLayers();
     enumerateAvailableInstanceExtensions();
 }
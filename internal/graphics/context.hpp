@@ -45,6 +45,11 @@ struct ContextCreateInfoT
     std::vector<const char*> layers;
     std::vector<const char*> instanceExtensions;
     std::vector<const char*> deviceExtensions;
+    /**
+     * @brief device extensions enabled only if the physical device supports them
+     *
+     */
+    std::vector<const char*> optionalDeviceExtensions;
 };
 
 class ContextABC : public InstanceSymbolsT,
@@ -103,8 +108,13 @@ class ContextABC : public InstanceSymbolsT,
     {
         return ci.deviceExtensions;
     }
+    inline const std::vector<const char*> getOptionalDeviceExtensions() const
+    {
+        return ci.optionalDeviceExtensions;
+    }
 };
 
+#ifndef ENABLE_DYNAMIC_LOADER
 /**
  * @brief context using the VulkanSDK as symbols loader
  *
@@ -126,7 +136,9 @@ class ContextSDK : public ContextABC, public SDKSymbolsLoaderT
     }
 
     void loadTop(const Instance* inst) override { SDKSymbolsLoaderT::load(this, inst); }
+    void loadBottom(const LogicalDevice* dev) override { SDKSymbolsLoaderT::load(this, dev); }
 };
+#endif
 
 // TODO
 class ContextGlad : public ContextABC
@@ -158,7 +170,9 @@ class ContextVolk : public ContextABC
  * Context object contains symbols loader and instance creation utils
  * this object is used to call api functions
  * this implementation allows the Context to use any loader (custom/glad/volk/vulkansdk)
- * context directly loading the symbols from the vulkan-1.dll in the OS folder
+ * context directly loading the symbols from the vulkan loader library of the OS at runtime
+ * only vkGetInstanceProcAddr is taken from the library, everything else is resolved through it
+ * extension functions are resolved only when their extension is enabled, null otherwise
  */
 class ContextDLL : public ContextABC,
                    public InstanceSymbolsLoaderT,
@@ -178,6 +192,10 @@ class ContextDLL : public ContextABC,
 
     ContextDLL(const ContextCreateInfoT createInfo);
 
-    void loadTop(const Instance* inst) override { InstanceSymbolsLoader2T::load(this, inst); }
+    void loadTop(const Instance* inst) override
+    {
+        InstanceSymbolsLoader2T::load(this, inst);
+        DeviceSymbolsLoaderT::load(this, inst);
+    }
     void loadBottom(const LogicalDevice* dev) override { DeviceSymbolsLoader2T::load(this, dev); }
 };
\ No newline at end of file
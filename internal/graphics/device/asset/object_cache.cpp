@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+#include "device/memory/image.hpp"
+#include "framebuffer.hpp"
+
+#include "render_pass.hpp"
+
+#include "object_cache.hpp"
+
+ObjectCache::~ObjectCache()
+{
+    auto* cx = ci.device->getContext();
+    const VkDevice device = ci.device->getHandle();
+
+    for (auto& [handle, entry] : m_framebuffers.entries)
+        cx->DestroyFramebuffer(device, handle, nullptr);
+    for (auto& [handle, entry] : m_imageViews.entries)
+        cx->DestroyImageView(device, handle, nullptr);
+    for (auto& [handle, entry] : m_renderPasses.entries)
+        cx->DestroyRenderPass(device, handle, nullptr);
+    for (auto& [handle, entry] : m_samplers.entries)
+        cx->DestroySampler(device, handle, nullptr);
+}
+
+StateKeyT ObjectCache::makeSamplerKey(const SamplerCreateInfoT& ci)
+{
+    StateKeyT key;
+    key.add(ci.magFilter).add(ci.minFilter).add(ci.mipmapMode).add(ci.addressMode);
+    key.add(ci.maxAnisotropy).add(ci.maxLod);
+    return key;
+}
+
+StateKeyT ObjectCache::makeImageViewKey(const ImageViewCreateInfoT& ci)
+{
+    StateKeyT key;
+    key.add(ci.image.value_or(VK_NULL_HANDLE)).add(ci.format.value_or(VK_FORMAT_UNDEFINED));
+    key.add(ci.aspect).add(ci.viewType);
+    key.add(ci.baseMipLevel).add(ci.levelCount).add(ci.layerCount);
+    return key;
+}
+
+static void addAttachment(StateKeyT& key, const Attachment& attachment)
+{
+    const VkAttachmentDescription& d = attachment.first;
+    key.add(d.flags).add(d.format).add(d.samples);
+    key.add(d.loadOp).add(d.storeOp).add(d.stencilLoadOp).add(d.stencilStoreOp);
+    key.add(d.initialLayout).add(d.finalLayout);
+    key.add(attachment.second.attachment).add(attachment.second.layout);
+}
+
+StateKeyT ObjectCache::makeRenderPassKey(const RenderPassCreateInfoT& ci)
+{
+    StateKeyT key;
+    addRenderPassCompatibility(key, ci);
+
+    for (const auto& a : ci.colorAttachments)
+        addAttachment(key, a);
+    if (ci.depthAttachment.has_value())
+        addAttachment(key, ci.depthAttachment.value());
+    key.add(ci.dependencies.size());
+    for (const auto& d : ci.dependencies)
+    {
+        key.add(d.srcSubpass).add(d.dstSubpass).add(d.srcStageMask).add(d.dstStageMask);
+        key.add(d.srcAccessMask).add(d.dstAccessMask).add(d.dependencyFlags);
+    }
+    return key;
+}
+
+void ObjectCache::addRenderPassCompatibility(StateKeyT& key, const RenderPassCreateInfoT& ci)
+{
+    key.add(ci.colorAttachments.size());
+    for (const auto& a : ci.colorAttachments)
+        key.add(a.first.format).add(a.first.samples);
+    key.add(ci.depthAttachment.has_value());
+    if (ci.depthAttachment.has_value())
+        key.add(ci.depthAttachment->first.format).add(ci.depthAttachment->first.samples);
+    key.add(ci.subpasses.size());
+    for (const auto& s : ci.subpasses)
+    {
+        key.add(s.pipelineBindPoint).add(s.colorAttachmentIndices.size());
+        for (const auto& index : s.colorAttachmentIndices)
+            key.add(index);
+    }
+}
+
+StateKeyT ObjectCache::makeFramebufferKey(const FramebufferCreateInfoT& ci)
+{
+    StateKeyT key;
+    addRenderPassCompatibility(key, ci.renderPass->info);
+    key.add(ci.attachments.size());
+    for (const auto& view : ci.attachments)
+        key.add(view->handle);
+    key.add(ci.width).add(ci.height);
+    return key;
+}
+
+template<class THandle>
+THandle ObjectCache::acquire(PoolT<THandle>& pool, const StateKeyT& key,
+                             const std::function<THandle()>& create,
+                             std::vector<uint64_t> dependencies)
+{
+    auto it = pool.lookup.find(key);
+    if (it != pool.lookup.end())
+    {
+        auto& entry = pool.entries[it->second];
+        ++entry.refCount;
+        // revived before its frame came back, it stays in the retired list until then
+        entry.releaseFrame = UINT32_MAX;
+        ++m_hitCount;
+        return it->second;
+    }
+
+    const THandle handle = create();
+    if (handle == VK_NULL_HANDLE)
+        return VK_NULL_HANDLE;
+    ++m_missCount;
+
+    pool.lookup[key] = handle;
+    pool.entries[handle] = EntryT<THandle>{
+        .key = key,
+        .refCount = 1U,
+        .dependencies = std::move(dependencies),
+    };
+    return handle;
+}
+
+template<class THandle> void ObjectCache::release(PoolT<THandle>& pool, const THandle handle)
+{
+    auto it = pool.entries.find(handle);
+    if (it == pool.entries.end() || it->second.refCount == 0U)
+        return;
+    if (--it->second.refCount > 0U)
+        return;
+
+    it->second.releaseFrame = m_frameIndex;
+    pool.retired.push_back(handle);
+}
+
+template<class THandle, class TDestroy>
+void ObjectCache::collect(PoolT<THandle>& pool, const uint32_t frameIndex, TDestroy destroy)
+{
+    for (size_t i = 0; i < pool.retired.size();)
+    {
+        auto it = pool.entries.find(pool.retired[i]);
+        // acquired again, or destroyed through another copy of the handle in the list
+        if (it != pool.entries.end() && it->second.refCount == 0U &&
+            it->second.releaseFrame != frameIndex)
+        {
+            ++i;
+            continue;
+        }
+        if (it != pool.entries.end() && it->second.refCount == 0U)
+        {
+            if (!it->second.bDetached)
+                pool.lookup.erase(it->second.key);
+            destroy(it->first);
+            pool.entries.erase(it);
+        }
+        pool.retired[i] = pool.retired.back();
+        pool.retired.pop_back();
+    }
+}
+
+template<class THandle> void ObjectCache::detach(PoolT<THandle>& pool, const uint64_t dependency)
+{
+    for (auto& [handle, entry] : pool.entries)
+    {
+        if (entry.bDetached || std::find(entry.dependencies.begin(), entry.dependencies.end(),
+                                         dependency) == entry.dependencies.end())
+            continue;
+        pool.lookup.erase(entry.key);
+        entry.bDetached = true;
+    }
+}
+
+VkSampler ObjectCache::acquireSampler(const StateKeyT& key,
+                                      const std::function<VkSampler()>& create)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return acquire(m_samplers, key, create, {});
+}
+
+void ObjectCache::releaseSampler(const VkSampler sampler)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    release(m_samplers, sampler);
+}
+
+VkImageView ObjectCache::acquireImageView(const StateKeyT& key, const VkImage image,
+                                          const std::function<VkImageView()>& create)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return acquire(m_imageViews, key, create, {reinterpret_cast<uint64_t>(image)});
+}
+
+void ObjectCache::releaseImageView(const VkImageView view)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    release(m_imageViews, view);
+}
+
+VkRenderPass ObjectCache::acquireRenderPass(const StateKeyT& key,
+                                            const std::function<VkRenderPass()>& create)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return acquire(m_renderPasses, key, create, {});
+}
+
+void ObjectCache::releaseRenderPass(const VkRenderPass renderPass)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    release(m_renderPasses, renderPass);
+}
+
+VkFramebuffer ObjectCache::acquireFramebuffer(const StateKeyT& key,
+                                              const std::vector<VkImageView>& attachments,
+                                              const std::function<VkFramebuffer()>& create)
+{
+    std::vector<uint64_t> dependencies(attachments.size());
+    for (size_t i = 0; i < attachments.size(); ++i)
+        dependencies[i] = reinterpret_cast<uint64_t>(attachments[i]);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return acquire(m_framebuffers, key, create, std::move(dependencies));
+}
+
+void ObjectCache::releaseFramebuffer(const VkFramebuffer framebuffer)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    release(m_framebuffers, framebuffer);
+}
+
+void ObjectCache::forgetImage(const VkImage image)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    detach(m_imageViews, reinterpret_cast<uint64_t>(image));
+}
+
+void ObjectCache::collect(const uint32_t frameIndex)
+{
+    auto* cx = ci.device->getContext();
+    const VkDevice device = ci.device->getHandle();
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_frameIndex = frameIndex;
+
+    collect(m_framebuffers, frameIndex, [&](const VkFramebuffer framebuffer) {
+        cx->DestroyFramebuffer(device, framebuffer, nullptr);
+    });
+    collect(m_imageViews, frameIndex, [&](const VkImageView view) {
+        // a later view may get the same handle
+        detach(m_framebuffers, reinterpret_cast<uint64_t>(view));
+        cx->DestroyImageView(device, view, nullptr);
+    });
+    collect(m_renderPasses, frameIndex, [&](const VkRenderPass renderPass) {
+        cx->DestroyRenderPass(device, renderPass, nullptr);
+    });
+    collect(m_samplers, frameIndex, [&](const VkSampler sampler) {
+        cx->DestroySampler(device, sampler, nullptr);
+    });
+}
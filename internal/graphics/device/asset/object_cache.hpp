@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "device/state_key.hpp"
+
+class LogicalDevice;
+struct SamplerCreateInfoT;
+struct ImageViewCreateInfoT;
+struct RenderPassCreateInfoT;
+struct FramebufferCreateInfoT;
+
+struct ObjectCacheCreateInfoT
+{
+    const LogicalDevice* device;
+};
+
+/**
+ * @brief content addressed cache of the samplers, image views, render passes and framebuffers
+ * identical objects are created once and shared, every acquire must be matched with a release
+ * an object whose last reference is released stays in the cache until the frame that released it
+ * comes back (see collect), it is reused if acquired again meanwhile
+ *
+ */
+class ObjectCache
+{
+  private:
+    const ObjectCacheCreateInfoT ci;
+
+  private:
+    template<class THandle> struct EntryT
+    {
+        StateKeyT key;
+        uint32_t refCount = 0U;
+        /**
+         * @brief frame slot that released the last reference, UINT32_MAX while referenced
+         *
+         */
+        uint32_t releaseFrame = UINT32_MAX;
+        /**
+         * @brief handles the object was made from (the image of a view, the attachments of a
+         * framebuffer), it leaves the lookup once one of them is destroyed
+         *
+         */
+        std::vector<uint64_t> dependencies;
+        bool bDetached = false;
+    };
+    template<class THandle> struct PoolT
+    {
+        std::unordered_map<StateKeyT, THandle, StateKeyHashT> lookup;
+        std::unordered_map<THandle, EntryT<THandle>> entries;
+        /**
+         * @brief released objects waiting for their frame, some may have been acquired again
+         *
+         */
+        std::vector<THandle> retired;
+    };
+
+    std::mutex m_mutex;
+
+    PoolT<VkSampler> m_samplers;
+    PoolT<VkImageView> m_imageViews;
+    PoolT<VkRenderPass> m_renderPasses;
+    PoolT<VkFramebuffer> m_framebuffers;
+
+    uint32_t m_frameIndex = 0U;
+
+    uint64_t m_hitCount = 0U;
+    uint64_t m_missCount = 0U;
+
+    template<class THandle>
+    [[nodiscard]] THandle acquire(PoolT<THandle>& pool, const StateKeyT& key,
+                                  const std::function<THandle()>& create,
+                                  std::vector<uint64_t> dependencies);
+    template<class THandle> void release(PoolT<THandle>& pool, const THandle handle);
+    template<class THandle, class TDestroy>
+    void collect(PoolT<THandle>& pool, const uint32_t frameIndex, TDestroy destroy);
+    /**
+     * @brief the objects made from this handle are not returned anymore, it is being destroyed
+     * and a new object may get the same handle
+     *
+     */
+    template<class THandle> void detach(PoolT<THandle>& pool, const uint64_t dependency);
+
+  public:
+    ObjectCache() = delete;
+    ObjectCache(const ObjectCache&) = delete;
+    ObjectCache& operator=(const ObjectCache&) = delete;
+    ObjectCache(ObjectCache&&) = delete;
+    ObjectCache& operator=(ObjectCache&&) = delete;
+
+    explicit ObjectCache(const ObjectCacheCreateInfoT createInfo) : ci(createInfo) {}
+
+    /**
+     * @brief destroys every object still in the cache, the device must be idle
+     *
+     */
+    ~ObjectCache();
+
+    [[nodiscard]] static StateKeyT makeSamplerKey(const SamplerCreateInfoT& createInfo);
+    [[nodiscard]] static StateKeyT makeImageViewKey(const ImageViewCreateInfoT& createInfo);
+    /**
+     * @brief hash of the whole create info, load/store operations and layouts included
+     *
+     */
+    [[nodiscard]] static StateKeyT makeRenderPassKey(const RenderPassCreateInfoT& createInfo);
+    /**
+     * @brief render pass compatibility : attachment formats and sample counts, subpass structure
+     *
+     */
+    static void addRenderPassCompatibility(StateKeyT& key, const RenderPassCreateInfoT& createInfo);
+    /**
+     * @brief render pass compatibility, attachment views and extent, a framebuffer can be used
+     * with any compatible render pass
+     *
+     */
+    [[nodiscard]] static StateKeyT makeFramebufferKey(const FramebufferCreateInfoT& createInfo);
+
+    /**
+     * @brief returns the cached object for this key or creates it with the given function, under
+     * the lock of the cache
+     *
+     */
+    [[nodiscard]] VkSampler acquireSampler(const StateKeyT& key,
+                                           const std::function<VkSampler()>& create);
+    void releaseSampler(const VkSampler sampler);
+
+    [[nodiscard]] VkImageView acquireImageView(const StateKeyT& key, const VkImage image,
+                                               const std::function<VkImageView()>& create);
+    void releaseImageView(const VkImageView view);
+
+    [[nodiscard]] VkRenderPass acquireRenderPass(const StateKeyT& key,
+                                                 const std::function<VkRenderPass()>& create);
+    void releaseRenderPass(const VkRenderPass renderPass);
+
+    [[nodiscard]] VkFramebuffer acquireFramebuffer(const StateKeyT& key,
+                                                   const std::vector<VkImageView>& attachments,
+                                                   const std::function<VkFramebuffer()>& create);
+    void releaseFramebuffer(const VkFramebuffer framebuffer);
+
+    /**
+     * @brief the views of this image are not returned anymore, called before the image is
+     * destroyed
+     *
+     */
+    void forgetImage(const VkImage image);
+
+    /**
+     * @brief destroy the objects released the last time this frame slot was used, once per frame
+     * after the fence of the frame was waited on
+     *
+     */
+    void collect(const uint32_t frameIndex);
+
+  public:
+    [[nodiscard]] inline uint64_t getHitCount() const { return m_hitCount; }
+    [[nodiscard]] inline uint64_t getMissCount() const { return m_missCount; }
+};
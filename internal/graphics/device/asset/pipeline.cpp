@@ -5,58 +5,177 @@
 #include "device.hpp"
 #include "device/memory/buffer.hpp"
 #include "device/memory/descriptor.hpp"
+#include "device/memory/descriptor_allocator.hpp"
+#include "device/memory/descriptor_writer.hpp"
+#include "device/memory/image.hpp"
+#include "device/memory/uniform_ring.hpp"
+
+#include "pipeline_library.hpp"
 
 #include "pipeline.hpp"
 
-void Pipeline::recreateDescriptorSets(const BufferingTypeE& type)
+GraphicsPipelineStatesT::GraphicsPipelineStatesT(const PipelineCreateInfoT& ci)
+{
+    shaderStages.resize(ci.shaderStages.size());
+    for (int i = 0; i < ci.shaderStages.size(); ++i)
+    {
+        shaderStages[i] =
+            std::static_pointer_cast<GPUShader>(ci.shaderStages[i]->localResource)->createInfo;
+    }
+
+    dynamicState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(ci.dynamicStates.size()),
+        .pDynamicStates = ci.dynamicStates.data(),
+    };
+
+    // vertex (enabling the binding for the Vertex structure)
+    vertexInputState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .vertexBindingDescriptionCount = static_cast<uint32_t>(ci.vertexBindings.size()),
+        .pVertexBindingDescriptions = ci.vertexBindings.data(),
+        .vertexAttributeDescriptionCount = static_cast<uint32_t>(ci.vertexAttributes.size()),
+        .pVertexAttributeDescriptions = ci.vertexAttributes.data(),
+    };
+
+    // draw mode
+    inputAssemblyState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = ci.topology,
+        .primitiveRestartEnable = ci.bPrimitiveRestartEnable,
+    };
+
+    // viewport (dynamic)
+    viewportState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+
+    // rasterizer
+    rasterizationState = ci.rasterizerCreateInfo;
+
+    // multisampling, anti-aliasing
+    multisampleState = ci.multisamplingCreateInfo;
+
+    depthStencilState = ci.depthStencilCreateInfo;
+
+    // color blending
+    colorBlendState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .attachmentCount = static_cast<uint32_t>(ci.colorBlendAttachment.size()),
+        .pAttachments = ci.colorBlendAttachment.data(),
+        .blendConstants = {ci.blendConstants[0], ci.blendConstants[1], ci.blendConstants[2],
+                           ci.blendConstants[3]},
+    };
+}
+
+VkPipeline Pipeline::getBindHandle() const
+{
+    if (m_optimized)
+    {
+        VkPipeline optimized = m_optimized->handle.load(std::memory_order_acquire);
+        if (optimized != VK_NULL_HANDLE)
+            return optimized;
+    }
+    return m_handle;
+}
+
+std::vector<VkDescriptorSetLayout> Pipeline::getPipelineLayoutSetLayouts() const
+{
+    std::vector<VkDescriptorSetLayout> out;
+    out.reserve(m_setLayouts.size() + 1);
+    if (usesBindless())
+        out.push_back(m_bindlessSetLayout);
+    out.insert(out.end(), m_setLayouts.begin(), m_setLayouts.end());
+    return out;
+}
+
+bool Pipeline::recreateDescriptorSets(const BufferingTypeE& type)
 {
     assert(ci.device);
 
-    ci.type = type;
     int backBufferCount = static_cast<uint32_t>(type);
-    const auto& cx = ci.device->getContext();
-
-    m_descriptorBlocks.clear();
-    m_descriptorBlocks.reserve(backBufferCount);
+    auto* allocator = ci.device->getDescriptorAllocator();
 
+    // the previous sets are only replaced once every back buffer got its own
+    std::vector<std::unique_ptr<DescriptorBlock>> blocks;
+    blocks.reserve(backBufferCount);
     for (int i = 0; i < backBufferCount; ++i)
     {
-        VkDescriptorPoolCreateInfo createInfo = {
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-            .maxSets = static_cast<uint32_t>(m_setLayouts.size()),
-            .poolSizeCount = static_cast<uint32_t>(ci.poolSizes.size()),
-            .pPoolSizes = ci.poolSizes.data(),
-        };
-
-        m_descriptorBlocks.emplace_back(std::make_unique<DescriptorBlock>());
-        auto& block = m_descriptorBlocks[i];
-        VkResult res =
-            cx->CreateDescriptorPool(ci.device->getHandle(), &createInfo, nullptr, &block->pool);
-        if (res != VK_SUCCESS)
-            std::cerr << "Failed to create descriptor pool : " << res << std::endl;
-
-        VkDescriptorSetAllocateInfo allocInfo = {
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-            .descriptorPool = block->pool,
-            .descriptorSetCount = static_cast<uint32_t>(m_setLayouts.size()),
-            .pSetLayouts = m_setLayouts.data(),
-        };
+        blocks.emplace_back(std::make_unique<DescriptorBlock>());
+        auto& block = blocks[i];
 
+        // one set per set description, the set layouts follow the same order, push descriptor
+        // sets are not allocated
+        std::vector<VkDescriptorSetLayout> layouts;
+        layouts.reserve(m_setLayouts.size());
         for (int j = 0; j < ci.setDescriptions.size(); ++j)
         {
-            const auto& desc = ci.setDescriptions[j];
+            if (!ci.setDescriptions[j].bPushDescriptor)
+                layouts.push_back(m_setLayouts[j]);
+        }
+        if (layouts.empty())
+            continue;
+
+        std::vector<VkDescriptorSet> sets(layouts.size());
+        if (!allocator->allocate(layouts.data(), static_cast<uint32_t>(layouts.size()),
+                                 sets.data(), &block->pool))
+        {
+            for (const auto& allocated : blocks)
+            {
+                for (const auto& [frequency, s] : allocated->sets)
+                    allocator->free(allocated->pool, static_cast<uint32_t>(s.size()), s.data());
+            }
+            return false;
+        }
+
+        auto set = sets.begin();
+        for (const auto& desc : ci.setDescriptions)
+        {
+            if (!desc.bPushDescriptor)
+                block->sets[desc.frequency].push_back(*set++);
+        }
+    }
+
+    freeDescriptorSets();
+    m_descriptorBlocks = std::move(blocks);
+    ci.type = type;
 
-            block->sets[desc.frequency].resize(desc.setLayoutBindings.size());
-            res = cx->AllocateDescriptorSets(ci.device->getHandle(), &allocInfo,
-                                             block->sets[desc.frequency].data());
-            if (res != VK_SUCCESS)
-                std::cerr << "Failed to allocate descriptor sets : " << res << std::endl;
+    // update templates only depend on the set layouts
+    if (m_updateTemplates.empty())
+    {
+        for (int j = 0; j < ci.setDescriptions.size(); ++j)
+        {
+            const auto& desc = ci.setDescriptions[j];
+            if (desc.bPushDescriptor)
+                continue;
+            m_updateTemplates[desc.frequency].push_back(std::make_shared<DescriptorUpdateTemplate>(
+                DescriptorUpdateTemplateCreateInfoT{
+                    .device = ci.device,
+                    .setLayout = m_setLayouts[j],
+                    .entries = DescriptorUpdateTemplate::makePackedEntries(desc.setLayoutBindings),
+                }));
         }
     }
+    return true;
+}
+
+void Pipeline::freeDescriptorSets()
+{
+    auto* allocator = ci.device->getDescriptorAllocator();
+    for (const auto& block : m_descriptorBlocks)
+    {
+        for (const auto& [frequency, sets] : block->sets)
+            allocator->free(block->pool, static_cast<uint32_t>(sets.size()), sets.data());
+    }
+    m_descriptorBlocks.clear();
 }
 
 void Pipeline::writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
-                                   const UniformBuffer& ubo) const
+                                   const UniformBuffer& ubo, DescriptorWriter& writer) const
 {
     const auto& buff = ubo.getBuffer();
     assert((size_t)buff->size == m_descriptorBlocks.size() * ubo.size);
@@ -64,24 +183,47 @@ void Pipeline::writeDescriptorSets(const DescriptorFrequencyE frequency, const u
     for (int i = 0; i < m_descriptorBlocks.size(); ++i)
     {
         const auto& sets = m_descriptorBlocks[i]->sets[frequency];
+        writer.writeBuffer(sets[setIndex], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, buff->handle,
+                           i * ubo.size, ubo.size);
+    }
+}
 
-        VkDescriptorBufferInfo bufferInfo = {
-            .buffer = buff->handle,
-            .offset = i * ubo.size,
-            .range = ubo.size,
-        };
-
-        VkWriteDescriptorSet writes = VkWriteDescriptorSet{
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = sets[setIndex],
-            .dstBinding = 0,
-            .dstArrayElement = 0,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-            .pBufferInfo = &bufferInfo,
-            .pTexelBufferView = nullptr,
-        };
-        ci.device->getContext()->UpdateDescriptorSets(ci.device->getHandle(), 1, &writes, 0,
-                                                      nullptr);
+void Pipeline::writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                                   const UniformBuffer& ubo) const
+{
+    DescriptorWriter writer(ci.device);
+    writeDescriptorSets(frequency, setIndex, ubo, writer);
+    writer.flush();
+}
+
+void Pipeline::writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                                   const uint32_t binding, const UniformRing& ring,
+                                   DescriptorWriter& writer) const
+{
+    // every back buffer points at the whole ring, the frame region is chosen by the dynamic offset
+    for (int i = 0; i < m_descriptorBlocks.size(); ++i)
+    {
+        const auto& sets = m_descriptorBlocks[i]->sets[frequency];
+        writer.writeBuffer(sets[setIndex], binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                           ring.getBuffer()->handle, 0, ring.getBindingRange());
     }
 }
+
+void Pipeline::writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                                   const uint32_t binding, const ImageView& view,
+                                   const Sampler& sampler, DescriptorWriter& writer) const
+{
+    for (int i = 0; i < m_descriptorBlocks.size(); ++i)
+    {
+        const auto& sets = m_descriptorBlocks[i]->sets[frequency];
+        writer.writeImage(sets[setIndex], binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                          view.handle, sampler.handle, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+}
+
+void Pipeline::updateDescriptorSet(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                                   const uint32_t backBufferIndex, const void* data) const
+{
+    const auto& sets = m_descriptorBlocks[backBufferIndex]->sets[frequency];
+    m_updateTemplates.at(frequency)[setIndex]->update(sets[setIndex], data);
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -17,6 +18,12 @@ struct DescriptorCreateInfoT;
 class DescriptorABC;
 enum class DescriptorFrequencyE;
 class UniformBuffer;
+class UniformRing;
+class ImageView;
+class Sampler;
+class DescriptorWriter;
+class DescriptorUpdateTemplate;
+struct OptimizedPipelineT;
 
 enum class PipelineTypeE
 {
@@ -43,6 +50,25 @@ enum class PipelineTypeE
 
 enum class BufferingTypeE;
 
+/**
+ * @brief how the pipeline state is given to the device
+ *
+ */
+enum class PipelineBackendE
+{
+    /**
+     * @brief state baked in a VkPipeline
+     *
+     */
+    PIPELINE = 0,
+    /**
+     * @brief VK_EXT_shader_object, no pipeline compilation, the whole state is set with dynamic
+     * state commands at record time, falls back to PIPELINE if the device does not support it
+     *
+     */
+    SHADER_OBJECT = 1,
+};
+
 struct PipelineCreateInfoT
 {
     const LogicalDevice* device;
@@ -124,20 +150,93 @@ struct PipelineCreateInfoT
     {
         DescriptorFrequencyE frequency;
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings;
+        /**
+         * @brief VK_KHR_push_descriptor, no set is allocated, the descriptors are written in the
+         * command buffer at draw time (see RenderState::PerDrawChannelT)
+         * without the extension, one set per draw is allocated from the transient allocator of
+         * the back buffer instead
+         *
+         */
+        bool bPushDescriptor = false;
     };
     std::vector<DescriptorSetDescriptionT> setDescriptions;
 
-    std::vector<VkDescriptorPoolSize> poolSizes;
     std::vector<VkPushConstantRange> pushConstantRanges;
 
+    /**
+     * @brief the device bindless set (BindlessTable) is set 0 of the pipeline layout, the sets of
+     * setDescriptions follow it, ignored if the device does not support bindless descriptors
+     *
+     */
+    bool bBindless = false;
+
     const RenderPass* renderPass;
     uint32_t subpassIndex = 0;
+
+    /**
+     * @brief debug name, used in the pipeline creation report
+     *
+     */
+    std::string name;
+
+    PipelineBackendE backend = PipelineBackendE::PIPELINE;
+};
+
+/**
+ * @brief Vulkan fixed function and shader stage structures built from a PipelineCreateInfoT
+ * the structures point into this object and into the create info, both must outlive the pipeline
+ * creation
+ *
+ */
+struct GraphicsPipelineStatesT
+{
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+
+    VkPipelineDynamicStateCreateInfo dynamicState;
+    VkPipelineVertexInputStateCreateInfo vertexInputState;
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState;
+    VkPipelineViewportStateCreateInfo viewportState;
+    VkPipelineRasterizationStateCreateInfo rasterizationState;
+    VkPipelineMultisampleStateCreateInfo multisampleState;
+    VkPipelineDepthStencilStateCreateInfo depthStencilState;
+    VkPipelineColorBlendStateCreateInfo colorBlendState;
+
+    GraphicsPipelineStatesT() = delete;
+    GraphicsPipelineStatesT(const GraphicsPipelineStatesT&) = delete;
+    GraphicsPipelineStatesT& operator=(const GraphicsPipelineStatesT&) = delete;
+    GraphicsPipelineStatesT(GraphicsPipelineStatesT&&) = delete;
+    GraphicsPipelineStatesT& operator=(GraphicsPipelineStatesT&&) = delete;
+
+    explicit GraphicsPipelineStatesT(const PipelineCreateInfoT& createInfo);
+};
+
+/**
+ * @brief Vulkan pipeline objects backing a Pipeline
+ *
+ */
+struct PipelineHandlesT
+{
+    VkPipeline handle = VK_NULL_HANDLE;
+    /**
+     * @brief set when handle is a fast linked pipeline library, the optimized pipeline replaces it
+     * once the background link is done
+     *
+     */
+    std::shared_ptr<OptimizedPipelineT> optimized;
 };
 
+/**
+ * @brief descriptor sets of a back buffer, allocated from the device descriptor allocator
+ *
+ */
 class DescriptorBlock
 {
   public:
-    VkDescriptorPool pool;
+    /**
+     * @brief pool the sets were allocated from, owned by the allocator
+     *
+     */
+    VkDescriptorPool pool = VK_NULL_HANDLE;
 
     std::unordered_map<DescriptorFrequencyE, std::vector<VkDescriptorSet>> sets;
 };
@@ -160,9 +259,29 @@ class Pipeline
      */
     std::vector<std::unique_ptr<DescriptorBlock>> m_descriptorBlocks;
     std::vector<VkDescriptorSetLayout> m_setLayouts;
+    /**
+     * @brief owned by the device bindless table, null if the pipeline does not use it
+     *
+     */
+    VkDescriptorSetLayout m_bindlessSetLayout = VK_NULL_HANDLE;
     VkPipelineLayout m_layout;
+    /**
+     * @brief update template of each set, packed as described by
+     * DescriptorUpdateTemplate::makePackedEntries, same indexing as the descriptor sets
+     *
+     */
+    std::unordered_map<DescriptorFrequencyE, std::vector<std::shared_ptr<DescriptorUpdateTemplate>>>
+        m_updateTemplates;
+
+    VkPipeline m_handle = VK_NULL_HANDLE;
+    std::shared_ptr<OptimizedPipelineT> m_optimized;
 
-    VkPipeline m_handle;
+    /**
+     * @brief shader objects replacing the pipeline (PipelineBackendE::SHADER_OBJECT), one per stage
+     *
+     */
+    std::vector<VkShaderStageFlagBits> m_shaderObjectStages;
+    std::vector<VkShaderEXT> m_shaderObjects;
 
   public:
     Pipeline() = delete;
@@ -173,10 +292,48 @@ class Pipeline
         // TODO
     }
 
-    void recreateDescriptorSets(const BufferingTypeE& type);
+    /**
+     * @brief allocate the sets of each back buffer of this buffering type
+     *
+     * @return false if the sets could not be allocated, the previous ones are kept
+     */
+    [[nodiscard]] bool recreateDescriptorSets(const BufferingTypeE& type);
+    /**
+     * @brief give the descriptor sets back to the device descriptor allocator
+     *
+     */
+    void freeDescriptorSets();
     // TODO : do other types of descriptors
+    /**
+     * @brief queue the writes of the set for every back buffer, submitted when the writer is
+     * flushed
+     *
+     */
+    void writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                             const UniformBuffer& ubo, DescriptorWriter& writer) const;
     void writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
                              const UniformBuffer& ubo) const;
+    /**
+     * @brief queue the writes of a UNIFORM_BUFFER_DYNAMIC binding pointing into the ring
+     *
+     */
+    void writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                             const uint32_t binding, const UniformRing& ring,
+                             DescriptorWriter& writer) const;
+    /**
+     * @brief queue the writes of a COMBINED_IMAGE_SAMPLER binding, the image is expected in the
+     * SHADER_READ_ONLY_OPTIMAL layout
+     *
+     */
+    void writeDescriptorSets(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                             const uint32_t binding, const ImageView& view,
+                             const Sampler& sampler, DescriptorWriter& writer) const;
+    /**
+     * @brief write a whole set of a back buffer from its packed descriptor infos in one call
+     *
+     */
+    void updateDescriptorSet(const DescriptorFrequencyE frequency, const uint32_t setIndex,
+                             const uint32_t backBufferIndex, const void* data) const;
 
   public:
     [[nodiscard]] std::vector<VkDescriptorSetLayout>& getSetLayouts() { return m_setLayouts; }
@@ -184,12 +341,48 @@ class Pipeline
     {
         return m_setLayouts;
     }
+    [[nodiscard]] VkDescriptorSetLayout& getBindlessSetLayout() { return m_bindlessSetLayout; }
+    [[nodiscard]] bool usesBindless() const { return m_bindlessSetLayout != VK_NULL_HANDLE; }
+    /**
+     * @brief index of the first set of the set descriptions in the pipeline layout
+     *
+     */
+    [[nodiscard]] uint32_t getFirstSetIndex() const { return usesBindless() ? 1U : 0U; }
+    /**
+     * @brief every set layout of the pipeline layout, the bindless one included
+     *
+     */
+    [[nodiscard]] std::vector<VkDescriptorSetLayout> getPipelineLayoutSetLayouts() const;
     [[nodiscard]] VkPipelineLayout& getLayoutHandle() { return m_layout; }
     [[nodiscard]] const VkPipelineLayout& getLayoutHandle() const { return m_layout; }
 
     [[nodiscard]] VkPipeline& getHandle() { return m_handle; }
     [[nodiscard]] const VkPipeline& getHandle() const { return m_handle; }
 
+    [[nodiscard]] std::shared_ptr<OptimizedPipelineT>& getOptimized() { return m_optimized; }
+    /**
+     * @brief handle to bind, the optimized pipeline once available, the created one otherwise
+     *
+     */
+    [[nodiscard]] VkPipeline getBindHandle() const;
+
+    [[nodiscard]] std::vector<VkShaderStageFlagBits>& getShaderObjectStages()
+    {
+        return m_shaderObjectStages;
+    }
+    [[nodiscard]] const std::vector<VkShaderStageFlagBits>& getShaderObjectStages() const
+    {
+        return m_shaderObjectStages;
+    }
+    [[nodiscard]] std::vector<VkShaderEXT>& getShaderObjects() { return m_shaderObjects; }
+    [[nodiscard]] const std::vector<VkShaderEXT>& getShaderObjects() const
+    {
+        return m_shaderObjects;
+    }
+    [[nodiscard]] bool usesShaderObjects() const { return !m_shaderObjects.empty(); }
+
+    [[nodiscard]] const PipelineCreateInfoT& getCreateInfo() const { return ci; }
+
     [[nodiscard]] const std::vector<VkDescriptorSet>& getDescriptorSetHandles(
         uint32_t backBufferIndex, const DescriptorFrequencyE type) const
     {
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <f6/reader.hpp>
+
+#include "context.hpp"
+#include "device/device.hpp"
+
+#include "pipeline_cache.hpp"
+
+// "OPCH"
+static constexpr uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x4843504FU;
+static constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 1U;
+
+/**
+ * @brief FNV-1a, only used to detect truncated or corrupted files
+ *
+ */
+static uint64_t checksum(const char* data, const size_t size)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+PipelineCache::PipelineCache(const PipelineCacheCreateInfoT createInfo) : ci(createInfo)
+{
+    const auto& props = ci.device->getPhysicalDevice()->getProperties();
+
+    std::stringstream filename;
+    filename << "pipeline_cache_" << std::hex << props.vendorID << '_' << props.deviceID << ".bin";
+    m_filepath = ci.directory / filename.str();
+
+    std::vector<char> data = readValidatedData();
+    m_bWarm = !data.empty();
+
+    VkPipelineCacheCreateInfo cacheCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+
+    auto* cx = ci.device->getContext();
+    VkResult res =
+        cx->CreatePipelineCache(ci.device->getHandle(), &cacheCreateInfo, nullptr, &m_handle);
+    if (res != VK_SUCCESS && m_bWarm)
+    {
+        // the driver refused the blob, start from an empty cache
+        std::cerr << "Failed to create pipeline cache from " << m_filepath << " : " << res
+                  << std::endl;
+        m_bWarm = false;
+        cacheCreateInfo.initialDataSize = 0;
+        cacheCreateInfo.pInitialData = nullptr;
+        res = cx->CreatePipelineCache(ci.device->getHandle(), &cacheCreateInfo, nullptr, &m_handle);
+    }
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create pipeline cache : " << res << std::endl;
+        m_handle = VK_NULL_HANDLE;
+        return;
+    }
+
+    std::cout << "pipeline cache " << m_filepath << " : " << (m_bWarm ? "warm" : "cold") << " ("
+              << data.size() << " bytes)" << std::endl;
+}
+
+PipelineCache::~PipelineCache()
+{
+    auto* cx = ci.device->getContext();
+
+    mergeWorkerCaches();
+    if (m_handle)
+        cx->DestroyPipelineCache(ci.device->getHandle(), m_handle, nullptr);
+}
+
+std::vector<char> PipelineCache::readValidatedData() const
+{
+    if (!std::filesystem::exists(m_filepath))
+        return {};
+
+    auto file = f6::bin::read(m_filepath.string());
+    if (!file.has_value() || file.value().size() < sizeof(PipelineCacheFileHeaderT))
+        return {};
+
+    const std::vector<char>& content = file.value();
+
+    PipelineCacheFileHeaderT header;
+    std::memcpy(&header, content.data(), sizeof(PipelineCacheFileHeaderT));
+
+    const auto& props = ci.device->getPhysicalDevice()->getProperties();
+    if (header.magic != PIPELINE_CACHE_FILE_MAGIC ||
+        header.fileVersion != PIPELINE_CACHE_FILE_VERSION || header.vendorID != props.vendorID ||
+        header.deviceID != props.deviceID || header.driverVersion != props.driverVersion ||
+        std::memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        std::cout << "pipeline cache " << m_filepath << " was written by another device or driver"
+                  << std::endl;
+        return {};
+    }
+
+    if (header.dataSize != content.size() - sizeof(PipelineCacheFileHeaderT))
+        return {};
+
+    const char* data = content.data() + sizeof(PipelineCacheFileHeaderT);
+    if (header.dataChecksum != checksum(data, header.dataSize))
+        return {};
+
+    // the driver header must match as well, otherwise the driver would silently ignore the blob
+    if (header.dataSize < sizeof(VkPipelineCacheHeaderVersionOne))
+        return {};
+    VkPipelineCacheHeaderVersionOne driverHeader;
+    std::memcpy(&driverHeader, data, sizeof(VkPipelineCacheHeaderVersionOne));
+    if (driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        driverHeader.vendorID != props.vendorID || driverHeader.deviceID != props.deviceID ||
+        std::memcmp(driverHeader.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        return {};
+
+    return std::vector<char>(data, data + header.dataSize);
+}
+
+VkPipelineCache PipelineCache::createWorkerCache(const bool bSeeded)
+{
+    VkPipelineCacheCreateInfo cacheCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    };
+
+    // reading the main cache needs no synchronization, merging into it does
+    std::vector<char> data;
+    if (bSeeded && m_handle)
+    {
+        auto* cx = ci.device->getContext();
+        size_t size = 0;
+        if (cx->GetPipelineCacheData(ci.device->getHandle(), m_handle, &size, nullptr) ==
+            VK_SUCCESS)
+        {
+            data.resize(size);
+            if (cx->GetPipelineCacheData(ci.device->getHandle(), m_handle, &size, data.data()) !=
+                VK_SUCCESS)
+                size = 0;
+            data.resize(size);
+        }
+        cacheCreateInfo.initialDataSize = data.size();
+        cacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+    }
+
+    VkPipelineCache out;
+    VkResult res = ci.device->getContext()->CreatePipelineCache(ci.device->getHandle(),
+                                                                &cacheCreateInfo, nullptr, &out);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create worker pipeline cache : " << res << std::endl;
+        return VK_NULL_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> guard(m_workerCachesMutex);
+    m_workerCaches.push_back(out);
+    return out;
+}
+
+void PipelineCache::merge(const std::vector<VkPipelineCache>& workerCaches)
+{
+    auto* cx = ci.device->getContext();
+
+    if (workerCaches.empty())
+        return;
+
+    if (m_handle)
+    {
+        VkResult res = cx->MergePipelineCaches(ci.device->getHandle(), m_handle,
+                                               static_cast<uint32_t>(workerCaches.size()),
+                                               workerCaches.data());
+        if (res != VK_SUCCESS)
+            std::cerr << "Failed to merge pipeline caches : " << res << std::endl;
+    }
+
+    for (VkPipelineCache cache : workerCaches)
+        cx->DestroyPipelineCache(ci.device->getHandle(), cache, nullptr);
+}
+
+void PipelineCache::mergeWorkerCaches()
+{
+    std::lock_guard<std::mutex> guard(m_workerCachesMutex);
+    merge(m_workerCaches);
+    m_workerCaches.clear();
+}
+
+void PipelineCache::mergeWorkerCaches(const std::vector<VkPipelineCache>& workerCaches)
+{
+    std::lock_guard<std::mutex> guard(m_workerCachesMutex);
+
+    // the caches merged by another caller in the meantime (save) are gone already
+    std::vector<VkPipelineCache> owned;
+    for (VkPipelineCache cache : workerCaches)
+    {
+        auto it = std::find(m_workerCaches.begin(), m_workerCaches.end(), cache);
+        if (it == m_workerCaches.end())
+            continue;
+        owned.push_back(cache);
+        m_workerCaches.erase(it);
+    }
+    merge(owned);
+}
+
+bool PipelineCache::save()
+{
+    if (!m_handle)
+        return false;
+
+    mergeWorkerCaches();
+
+    auto* cx = ci.device->getContext();
+
+    size_t size = 0;
+    VkResult res = cx->GetPipelineCacheData(ci.device->getHandle(), m_handle, &size, nullptr);
+    if (res != VK_SUCCESS || size == 0)
+        return false;
+
+    std::vector<char> data(size);
+    res = cx->GetPipelineCacheData(ci.device->getHandle(), m_handle, &size, data.data());
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to retrieve pipeline cache data : " << res << std::endl;
+        return false;
+    }
+    data.resize(size);
+
+    const auto& props = ci.device->getPhysicalDevice()->getProperties();
+    // the padding after the uuid is written to the file as well, it must not be left uninitialized
+    PipelineCacheFileHeaderT header;
+    std::memset(&header, 0, sizeof(PipelineCacheFileHeaderT));
+    header.magic = PIPELINE_CACHE_FILE_MAGIC;
+    header.fileVersion = PIPELINE_CACHE_FILE_VERSION;
+    header.vendorID = props.vendorID;
+    header.deviceID = props.deviceID;
+    header.driverVersion = props.driverVersion;
+    std::memcpy(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = data.size();
+    header.dataChecksum = checksum(data.data(), data.size());
+
+    // write to a temporary file then rename it, a crash while writing must not leave a truncated
+    // cache behind
+    std::filesystem::path tmp = m_filepath;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cerr << "Failed to open " << tmp << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(PipelineCacheFileHeaderT));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.flush();
+        if (!file)
+        {
+            std::cerr << "Failed to write " << tmp << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, m_filepath, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to replace " << m_filepath << " : " << ec.message() << std::endl;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+
+    std::cout << "pipeline cache " << m_filepath << " saved (" << data.size() << " bytes, "
+              << getCreationCount() << " pipelines created in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(getCreationTime()).count()
+              << " ms)" << std::endl;
+    return true;
+}
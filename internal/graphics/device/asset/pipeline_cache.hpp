@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+
+struct PipelineCacheCreateInfoT
+{
+    const LogicalDevice* device;
+    /**
+     * @brief directory in which the cache file is read and written, the file name is derived from
+     * the physical device identifiers so that several devices do not overwrite the same file
+     *
+     */
+    std::filesystem::path directory = ".";
+};
+
+/**
+ * @brief header written in front of the driver blob
+ * the driver's own header (VkPipelineCacheHeaderVersionOne) does not carry the driver version, a
+ * driver update must invalidate the file as well
+ *
+ */
+struct PipelineCacheFileHeaderT
+{
+    uint32_t magic;
+    uint32_t fileVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t dataChecksum;
+};
+
+/**
+ * @brief disk persisted pipeline cache owned by the logical device
+ * worker threads compiling pipelines can request their own cache in order to avoid contention on
+ * the main one, worker caches are merged into the main cache before it is written back
+ *
+ */
+class PipelineCache
+{
+  private:
+    const PipelineCacheCreateInfoT ci;
+
+  private:
+    VkPipelineCache m_handle = VK_NULL_HANDLE;
+
+    std::mutex m_workerCachesMutex;
+    std::vector<VkPipelineCache> m_workerCaches;
+
+    std::filesystem::path m_filepath;
+    /**
+     * @brief true if the cache was successfully loaded from disk
+     *
+     */
+    bool m_bWarm = false;
+
+    /**
+     * @brief time spent in pipeline creation calls using this cache (nanoseconds)
+     *
+     */
+    std::atomic<uint64_t> m_creationTime = 0ULL;
+    std::atomic<uint32_t> m_creationCount = 0U;
+
+    /**
+     * @brief read the cache file and returns the driver blob if the file matches the current
+     * physical device and driver, an empty array otherwise
+     *
+     */
+    std::vector<char> readValidatedData() const;
+
+    /**
+     * @brief merge the caches into the main one then destroy them, the mutex must be held
+     *
+     */
+    void merge(const std::vector<VkPipelineCache>& workerCaches);
+
+  public:
+    PipelineCache() = delete;
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+    PipelineCache(PipelineCache&&) = delete;
+    PipelineCache& operator=(PipelineCache&&) = delete;
+
+    explicit PipelineCache(const PipelineCacheCreateInfoT createInfo);
+
+    ~PipelineCache();
+
+    /**
+     * @brief create an empty cache to be used by a single worker thread, or one holding the
+     * content of the main cache for a worker living as long as the device
+     * the cache is owned by this object and merged in mergeWorkerCaches()
+     *
+     */
+    [[nodiscard]] VkPipelineCache createWorkerCache(const bool bSeeded = false);
+    /**
+     * @brief merge all the worker caches into the main cache and destroy them
+     * worker threads must not use their cache anymore
+     *
+     */
+    void mergeWorkerCaches();
+    /**
+     * @brief merge these worker caches only, the ones of other callers stay in use
+     *
+     */
+    void mergeWorkerCaches(const std::vector<VkPipelineCache>& workerCaches);
+
+    /**
+     * @brief write the cache back to disk (written to a temporary file then renamed)
+     *
+     */
+    bool save();
+
+    void recordCreation(const std::chrono::nanoseconds duration)
+    {
+        m_creationTime += static_cast<uint64_t>(duration.count());
+        ++m_creationCount;
+    }
+
+  public:
+    [[nodiscard]] inline VkPipelineCache getHandle() const { return m_handle; }
+    [[nodiscard]] inline bool isWarm() const { return m_bWarm; }
+    [[nodiscard]] inline const std::filesystem::path& getFilepath() const { return m_filepath; }
+
+    [[nodiscard]] inline std::chrono::nanoseconds getCreationTime() const
+    {
+        return std::chrono::nanoseconds(m_creationTime.load());
+    }
+    [[nodiscard]] inline uint32_t getCreationCount() const { return m_creationCount.load(); }
+};
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "pipeline_creation_report.hpp"
+
+static const char* stageName(const VkShaderStageFlagBits stage)
+{
+    switch (stage)
+    {
+    case VK_SHADER_STAGE_VERTEX_BIT:
+        return "vertex";
+    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+        return "tessellation control";
+    case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+        return "tessellation evaluation";
+    case VK_SHADER_STAGE_GEOMETRY_BIT:
+        return "geometry";
+    case VK_SHADER_STAGE_FRAGMENT_BIT:
+        return "fragment";
+    case VK_SHADER_STAGE_COMPUTE_BIT:
+        return "compute";
+    default:
+        return "other";
+    }
+}
+
+void PipelineCreationReport::add(PipelineCreationFeedbackT feedback)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_entries.emplace_back(std::move(feedback));
+}
+
+void PipelineCreationReport::clear()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_entries.clear();
+}
+
+std::vector<PipelineCreationFeedbackT> PipelineCreationReport::getSortedEntries() const
+{
+    std::vector<PipelineCreationFeedbackT> out;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        out = m_entries;
+    }
+
+    // the driver duration is preferred, the measured one is used when there is no feedback
+    std::sort(out.begin(), out.end(),
+              [](const PipelineCreationFeedbackT& a, const PipelineCreationFeedbackT& b) {
+                  auto da = a.bValid ? a.duration : a.wallDuration;
+                  auto db = b.bValid ? b.duration : b.wallDuration;
+                  return da > db;
+              });
+    return out;
+}
+
+void PipelineCreationReport::dump(std::ostream& os) const
+{
+    std::vector<PipelineCreationFeedbackT> entries = getSortedEntries();
+
+    std::chrono::nanoseconds total(0);
+    uint32_t cacheHits = 0U;
+    for (const auto& e : entries)
+    {
+        total += e.bValid ? e.duration : e.wallDuration;
+        cacheHits += e.bCacheHit ? 1U : 0U;
+    }
+
+    auto ms = [](const std::chrono::nanoseconds d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    os << "pipeline creation report : " << entries.size() << " pipelines, " << cacheHits
+       << " cache hits, " << std::fixed << std::setprecision(3) << ms(total) << " ms\n";
+    for (const auto& e : entries)
+    {
+        auto d = e.bValid ? e.duration : e.wallDuration;
+        os << '\t' << (e.name.empty() ? "<unnamed>" : e.name) << " [" << std::hex << e.key
+           << std::dec << "] : " << ms(d) << " ms";
+        if (total.count() > 0)
+            os << " (" << 100.0 * d.count() / total.count() << " %)";
+        os << (e.bCacheHit ? ", cache hit" : "") << (e.bValid ? "" : ", no driver feedback")
+           << '\n';
+
+        for (const auto& s : e.stages)
+        {
+            if (!s.bValid)
+                continue;
+            os << "\t\t" << stageName(s.stage) << " : " << ms(s.duration) << " ms"
+               << (s.bCacheHit ? ", cache hit" : "") << '\n';
+        }
+    }
+    os << std::defaultfloat << std::flush;
+}
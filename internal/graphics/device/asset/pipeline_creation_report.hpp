@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+/**
+ * @brief creation feedback of a single pipeline compilation
+ * driver durations and cache hits come from VK_EXT_pipeline_creation_feedback (core in 1.3), they
+ * are only meaningful if bValid is set
+ *
+ */
+struct PipelineCreationFeedbackT
+{
+    struct StageFeedbackT
+    {
+        VkShaderStageFlagBits stage;
+        bool bValid = false;
+        bool bCacheHit = false;
+        std::chrono::nanoseconds duration = std::chrono::nanoseconds(0);
+    };
+
+    std::string name;
+    std::size_t key = 0;
+
+    bool bValid = false;
+    /**
+     * @brief the pipeline was found in the pipeline cache without compilation
+     *
+     */
+    bool bCacheHit = false;
+    /**
+     * @brief duration reported by the driver
+     *
+     */
+    std::chrono::nanoseconds duration = std::chrono::nanoseconds(0);
+    /**
+     * @brief duration measured around the creation call
+     *
+     */
+    std::chrono::nanoseconds wallDuration = std::chrono::nanoseconds(0);
+
+    std::vector<StageFeedbackT> stages;
+};
+
+/**
+ * @brief collects the creation feedback of every pipeline compiled by a device
+ * thread safe, pipelines may be compiled from worker threads
+ *
+ */
+class PipelineCreationReport
+{
+  private:
+    mutable std::mutex m_mutex;
+    std::vector<PipelineCreationFeedbackT> m_entries;
+
+  public:
+    void add(PipelineCreationFeedbackT feedback);
+    void clear();
+
+    /**
+     * @brief copy of the entries sorted from the most expensive to the cheapest pipeline
+     *
+     */
+    [[nodiscard]] std::vector<PipelineCreationFeedbackT> getSortedEntries() const;
+
+    /**
+     * @brief print the entries sorted by cost with their share of the total compilation time
+     *
+     */
+    void dump(std::ostream& os) const;
+};
@@ -0,0 +1,322 @@
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+
+#include "pipeline_cache.hpp"
+#include "pipeline_state_cache.hpp"
+
+#include "pipeline_library.hpp"
+
+void OptimizedPipelineT::abandon()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    if (bAbandoned)
+        return;
+    bAbandoned = true;
+
+    VkPipeline optimized = handle.exchange(VK_NULL_HANDLE);
+    if (optimized != VK_NULL_HANDLE)
+        device->getContext()->DestroyPipeline(device->getHandle(), optimized, nullptr);
+
+    // the linked pipelines do not need their libraries anymore
+    device->getPipelineLibrary()->release(libraries);
+}
+
+PipelineLibrary::PipelineLibrary(const PipelineLibraryCreateInfoT createInfo) : ci(createInfo)
+{
+    // merged by the pipeline cache when it is saved, the linker is stopped by then
+    m_linkCache = ci.device->getPipelineCache()->createWorkerCache(true);
+    m_worker = std::thread(&PipelineLibrary::work, this);
+}
+
+PipelineLibrary::~PipelineLibrary()
+{
+    stop();
+
+    auto* cx = ci.device->getContext();
+    for (auto& [key, entry] : m_libraries)
+        cx->DestroyPipeline(ci.device->getHandle(), entry.handle, nullptr);
+
+    auto ms = [](const std::chrono::nanoseconds d) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+    };
+    std::cout << "pipeline library : " << getLibraryCount() << " libraries in "
+              << ms(getLibraryTime()) << " ms, " << getFastLinkCount() << " fast links in "
+              << ms(getFastLinkTime()) << " ms, " << getOptimizedLinkCount()
+              << " optimized links in " << ms(getOptimizedLinkTime()) << " ms" << std::endl;
+}
+
+void PipelineLibrary::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_jobsMutex);
+        m_bStop = true;
+        m_jobs.clear();
+    }
+    m_jobsCondition.notify_all();
+
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+VkPipeline PipelineLibrary::acquireLibrary(const StateKeyT& key,
+                                           const std::function<VkPipeline()>& create)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_librariesMutex);
+        auto it = m_libraries.find(key);
+        if (it != m_libraries.end())
+        {
+            ++it->second.refCount;
+            return it->second.handle;
+        }
+    }
+
+    // compiling may take a while, do not hold the lock
+    auto start = std::chrono::steady_clock::now();
+    VkPipeline library = create();
+    if (library == VK_NULL_HANDLE)
+        return VK_NULL_HANDLE;
+    m_libraryTime += (std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> guard(m_librariesMutex);
+    auto& entry = m_libraries[key];
+    if (entry.handle != VK_NULL_HANDLE)
+    {
+        // another thread compiled the same part in the meantime
+        ci.device->getContext()->DestroyPipeline(ci.device->getHandle(), library, nullptr);
+    }
+    else
+    {
+        entry.handle = library;
+        m_libraryKeys[library] = key;
+        ++m_libraryCount;
+    }
+
+    ++entry.refCount;
+    return entry.handle;
+}
+
+void PipelineLibrary::release(
+    const std::array<VkPipeline, static_cast<size_t>(PipelineLibraryPartE::COUNT)>& libraries)
+{
+    std::lock_guard<std::mutex> guard(m_librariesMutex);
+    for (const VkPipeline library : libraries)
+    {
+        auto it = m_libraryKeys.find(library);
+        if (it == m_libraryKeys.end())
+            continue;
+
+        auto entry = m_libraries.find(it->second);
+        if (--entry->second.refCount > 0U)
+            continue;
+
+        ci.device->getContext()->DestroyPipeline(ci.device->getHandle(), library, nullptr);
+        m_libraries.erase(entry);
+        m_libraryKeys.erase(it);
+    }
+}
+
+VkPipeline PipelineLibrary::createLibrary(const PipelineLibraryPartE part,
+                                          const PipelineCreateInfoT& createInfo,
+                                          const GraphicsPipelineStatesT& states,
+                                          const VkPipelineLayout layout,
+                                          const VkPipelineCache cache)
+{
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+    };
+
+    // the link time optimization information must be retained for the background link
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &libraryCreateInfo,
+        .flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+                 VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT,
+        .pDynamicState = &states.dynamicState,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    // shader stages are split between the pre-rasterization and the fragment shader libraries
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    auto selectStages = [&states, &stages](const bool bFragment) {
+        for (const auto& stage : states.shaderStages)
+        {
+            if ((stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT) == bFragment)
+                stages.push_back(stage);
+        }
+    };
+
+    switch (part)
+    {
+    case PipelineLibraryPartE::VERTEX_INPUT:
+        libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+        pipelineCreateInfo.pVertexInputState = &states.vertexInputState;
+        pipelineCreateInfo.pInputAssemblyState = &states.inputAssemblyState;
+        break;
+    case PipelineLibraryPartE::PRE_RASTERIZATION:
+        libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+        selectStages(false);
+        pipelineCreateInfo.pViewportState = &states.viewportState;
+        pipelineCreateInfo.pRasterizationState = &states.rasterizationState;
+        pipelineCreateInfo.layout = layout;
+        break;
+    case PipelineLibraryPartE::FRAGMENT_SHADER:
+        libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+        selectStages(true);
+        pipelineCreateInfo.pMultisampleState = &states.multisampleState;
+        pipelineCreateInfo.pDepthStencilState = &states.depthStencilState;
+        pipelineCreateInfo.layout = layout;
+        break;
+    case PipelineLibraryPartE::FRAGMENT_OUTPUT:
+        libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+        pipelineCreateInfo.pMultisampleState = &states.multisampleState;
+        pipelineCreateInfo.pColorBlendState = &states.colorBlendState;
+        break;
+    default:
+        return VK_NULL_HANDLE;
+    }
+
+    pipelineCreateInfo.stageCount = static_cast<uint32_t>(stages.size());
+    pipelineCreateInfo.pStages = stages.empty() ? nullptr : stages.data();
+
+    if (part != PipelineLibraryPartE::VERTEX_INPUT && createInfo.renderPass)
+    {
+        pipelineCreateInfo.renderPass = createInfo.renderPass->handle;
+        pipelineCreateInfo.subpass = createInfo.subpassIndex;
+    }
+
+    VkPipeline out = VK_NULL_HANDLE;
+    VkResult res = ci.device->getContext()->CreateGraphicsPipelines(
+        ci.device->getHandle(), cache, 1, &pipelineCreateInfo, nullptr, &out);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create graphics pipeline library : " << res << std::endl;
+        return VK_NULL_HANDLE;
+    }
+    return out;
+}
+
+PipelineHandlesT PipelineLibrary::link(const PipelineCreateInfoT& createInfo,
+                                       const VkPipelineLayout layout, const StateKeyT& layoutKey,
+                                       const VkPipelineCache cache,
+                                       VkPipelineCreationFeedbackCreateInfo* feedback)
+{
+    GraphicsPipelineStatesT states(createInfo);
+
+    auto optimized = std::make_shared<OptimizedPipelineT>();
+    optimized->device = ci.device;
+    optimized->layout = layout;
+    // worker caches may be gone by the time the background link runs
+    optimized->cache = m_linkCache;
+    optimized->libraries.fill(VK_NULL_HANDLE);
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(PipelineLibraryPartE::COUNT); ++i)
+    {
+        const auto part = static_cast<PipelineLibraryPartE>(i);
+        optimized->libraries[i] = acquireLibrary(
+            PipelineStateCache::makePipelineLibraryKey(part, createInfo, layoutKey),
+            [this, part, &createInfo, &states, layout, cache]() {
+                return createLibrary(part, createInfo, states, layout, cache);
+            });
+        if (optimized->libraries[i] == VK_NULL_HANDLE)
+        {
+            release(optimized->libraries);
+            return {};
+        }
+    }
+
+    VkPipelineLibraryCreateInfoKHR linkCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .pNext = feedback,
+        .libraryCount = static_cast<uint32_t>(optimized->libraries.size()),
+        .pLibraries = optimized->libraries.data(),
+    };
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &linkCreateInfo,
+        .layout = layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    PipelineHandlesT out;
+    auto start = std::chrono::steady_clock::now();
+    VkResult res = ci.device->getContext()->CreateGraphicsPipelines(
+        ci.device->getHandle(), cache, 1, &pipelineCreateInfo, nullptr, &out.handle);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to link graphics pipeline libraries : " << res << std::endl;
+        release(optimized->libraries);
+        return {};
+    }
+    m_fastLinkTime += (std::chrono::steady_clock::now() - start).count();
+    ++m_fastLinkCount;
+
+    out.optimized = optimized;
+    {
+        std::lock_guard<std::mutex> guard(m_jobsMutex);
+        if (!m_bStop)
+            m_jobs.push_back(std::move(optimized));
+    }
+    m_jobsCondition.notify_one();
+
+    return out;
+}
+
+void PipelineLibrary::work()
+{
+    for (;;)
+    {
+        std::shared_ptr<OptimizedPipelineT> job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobsMutex);
+            m_jobsCondition.wait(lock, [this]() { return m_bStop || !m_jobs.empty(); });
+            if (m_bStop)
+                return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        linkOptimized(*job);
+    }
+}
+
+void PipelineLibrary::linkOptimized(OptimizedPipelineT& optimized)
+{
+    std::lock_guard<std::mutex> guard(optimized.mutex);
+    if (optimized.bAbandoned)
+        return;
+
+    VkPipelineLibraryCreateInfoKHR linkCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .libraryCount = static_cast<uint32_t>(optimized.libraries.size()),
+        .pLibraries = optimized.libraries.data(),
+    };
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &linkCreateInfo,
+        .flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT,
+        .layout = optimized.layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    VkPipeline out = VK_NULL_HANDLE;
+    auto start = std::chrono::steady_clock::now();
+    VkResult res = ci.device->getContext()->CreateGraphicsPipelines(
+        ci.device->getHandle(), optimized.cache, 1, &pipelineCreateInfo, nullptr, &out);
+    if (res != VK_SUCCESS)
+    {
+        // the fast linked pipeline stays in use
+        std::cerr << "Failed to create optimized pipeline : " << res << std::endl;
+        return;
+    }
+    m_optimizedLinkTime += (std::chrono::steady_clock::now() - start).count();
+    ++m_optimizedLinkCount;
+
+    optimized.handle.store(out, std::memory_order_release);
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "device/state_key.hpp"
+
+#include "pipeline.hpp"
+
+class LogicalDevice;
+
+/**
+ * @brief parts of a graphics pipeline compiled independently with VK_EXT_graphics_pipeline_library
+ *
+ */
+enum class PipelineLibraryPartE : uint32_t
+{
+    VERTEX_INPUT = 0,
+    PRE_RASTERIZATION = 1,
+    FRAGMENT_SHADER = 2,
+    FRAGMENT_OUTPUT = 3,
+
+    COUNT = 4,
+};
+
+/**
+ * @brief link time optimized pipeline replacing a fast linked one
+ * the handle is published by the background linker, readers only load it
+ *
+ */
+struct OptimizedPipelineT
+{
+    const LogicalDevice* device;
+
+    std::array<VkPipeline, static_cast<size_t>(PipelineLibraryPartE::COUNT)> libraries;
+    VkPipelineLayout layout;
+    VkPipelineCache cache;
+
+    std::atomic<VkPipeline> handle = VK_NULL_HANDLE;
+
+    /**
+     * @brief held while linking, abandon() waits for a link in progress since the link still uses
+     * the layout
+     *
+     */
+    std::mutex mutex;
+    bool bAbandoned = false;
+
+    /**
+     * @brief the owner does not need the optimized pipeline anymore, destroys it if it was already
+     * published, a pending link is skipped and the libraries are released, abandoning twice is
+     * harmless
+     *
+     */
+    void abandon();
+};
+
+struct PipelineLibraryCreateInfoT
+{
+    const LogicalDevice* device;
+};
+
+/**
+ * @brief graphics pipeline library cache and linker
+ * the four library parts are cached by partial keys and shared between pipelines, a new state
+ * combination only compiles the parts not seen yet then fast links them, an optimized pipeline is
+ * linked in the background and replaces the fast linked one once ready
+ * libraries are refcounted by the pipelines linked from them and destroyed with the last one, their
+ * keys hold the content of the layout so a layout handle reused by the driver never matches
+ *
+ */
+class PipelineLibrary
+{
+  private:
+    const PipelineLibraryCreateInfoT ci;
+
+  private:
+    struct LibraryEntryT
+    {
+        VkPipeline handle = VK_NULL_HANDLE;
+        uint32_t refCount = 0U;
+    };
+
+    std::mutex m_librariesMutex;
+    std::unordered_map<StateKeyT, LibraryEntryT, StateKeyHashT> m_libraries;
+    std::unordered_map<VkPipeline, StateKeyT> m_libraryKeys;
+
+    std::mutex m_jobsMutex;
+    std::condition_variable m_jobsCondition;
+    std::deque<std::shared_ptr<OptimizedPipelineT>> m_jobs;
+    bool m_bStop = false;
+    std::thread m_worker;
+    /**
+     * @brief worker cache of the background linker, the main cache is the destination of the
+     * merges of the pipeline batches and cannot be used concurrently
+     *
+     */
+    VkPipelineCache m_linkCache = VK_NULL_HANDLE;
+
+    std::atomic<uint32_t> m_libraryCount = 0U;
+    std::atomic<uint32_t> m_fastLinkCount = 0U;
+    std::atomic<uint32_t> m_optimizedLinkCount = 0U;
+    std::atomic<std::chrono::nanoseconds::rep> m_libraryTime = 0;
+    std::atomic<std::chrono::nanoseconds::rep> m_fastLinkTime = 0;
+    std::atomic<std::chrono::nanoseconds::rep> m_optimizedLinkTime = 0;
+
+    /**
+     * @brief returns the cached library for this key or compiles it, adds a reference
+     * if two threads compile the same part concurrently, the first inserted library is kept
+     *
+     */
+    [[nodiscard]] VkPipeline acquireLibrary(const StateKeyT& key,
+                                            const std::function<VkPipeline()>& create);
+
+    [[nodiscard]] VkPipeline createLibrary(const PipelineLibraryPartE part,
+                                           const PipelineCreateInfoT& createInfo,
+                                           const GraphicsPipelineStatesT& states,
+                                           const VkPipelineLayout layout,
+                                           const VkPipelineCache cache);
+
+    void work();
+    void linkOptimized(OptimizedPipelineT& optimized);
+
+  public:
+    PipelineLibrary() = delete;
+    PipelineLibrary(const PipelineLibrary&) = delete;
+    PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+    PipelineLibrary(PipelineLibrary&&) = delete;
+    PipelineLibrary& operator=(PipelineLibrary&&) = delete;
+
+    explicit PipelineLibrary(const PipelineLibraryCreateInfoT createInfo);
+    /**
+     * @brief stops the background linker and destroys the libraries
+     *
+     */
+    ~PipelineLibrary();
+
+    /**
+     * @brief fast link a pipeline from its cached parts and queue its optimized link
+     * the feedback, if any, only gets the pipeline feedback (libraries carry the stages)
+     *
+     */
+    [[nodiscard]] PipelineHandlesT link(const PipelineCreateInfoT& createInfo,
+                                        const VkPipelineLayout layout,
+                                        const StateKeyT& layoutKey,
+                                        const VkPipelineCache cache,
+                                        VkPipelineCreationFeedbackCreateInfo* feedback = nullptr);
+
+    /**
+     * @brief drop a reference to each library, the unused ones are destroyed
+     *
+     */
+    void release(const std::array<VkPipeline, static_cast<size_t>(PipelineLibraryPartE::COUNT)>&
+                     libraries);
+
+    /**
+     * @brief drop the pending optimized links and join the background linker
+     * must be called before the pipeline layouts are destroyed
+     *
+     */
+    void stop();
+
+  public:
+    [[nodiscard]] inline uint32_t getLibraryCount() const { return m_libraryCount.load(); }
+    [[nodiscard]] inline uint32_t getFastLinkCount() const { return m_fastLinkCount.load(); }
+    [[nodiscard]] inline uint32_t getOptimizedLinkCount() const
+    {
+        return m_optimizedLinkCount.load();
+    }
+    [[nodiscard]] inline std::chrono::nanoseconds getLibraryTime() const
+    {
+        return std::chrono::nanoseconds(m_libraryTime.load());
+    }
+    [[nodiscard]] inline std::chrono::nanoseconds getFastLinkTime() const
+    {
+        return std::chrono::nanoseconds(m_fastLinkTime.load());
+    }
+    [[nodiscard]] inline std::chrono::nanoseconds getOptimizedLinkTime() const
+    {
+        return std::chrono::nanoseconds(m_optimizedLinkTime.load());
+    }
+};
@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+#include "device/memory/descriptor.hpp"
+
+#include "object_cache.hpp"
+
+#include "pipeline_state_cache.hpp"
+
+PipelineStateCache::~PipelineStateCache()
+{
+    auto* cx = ci.device->getContext();
+
+    for (auto& [key, entry] : m_pipelines)
+    {
+        if (entry.handles.optimized)
+            entry.handles.optimized->abandon();
+        cx->DestroyPipeline(ci.device->getHandle(), entry.handles.handle, nullptr);
+    }
+    for (auto& [key, entry] : m_pipelineLayouts)
+        cx->DestroyPipelineLayout(ci.device->getHandle(), entry.handle, nullptr);
+    for (auto& [key, entry] : m_setLayouts)
+        cx->DestroyDescriptorSetLayout(ci.device->getHandle(), entry.handle, nullptr);
+}
+
+StateKeyT PipelineStateCache::makeSetLayoutKey(
+    const PipelineCreateInfoT::DescriptorSetDescriptionT& description)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings = description.setLayoutBindings;
+    std::sort(bindings.begin(), bindings.end(),
+              [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+                  return a.binding < b.binding;
+              });
+
+    StateKeyT key;
+    key.add(description.bPushDescriptor);
+    key.add(bindings.size());
+    for (const auto& b : bindings)
+    {
+        key.add(b.binding).add(b.descriptorType).add(b.descriptorCount).add(b.stageFlags);
+        key.add(b.pImmutableSamplers);
+    }
+    return key;
+}
+
+StateKeyT PipelineStateCache::makePipelineLayoutKey(
+    const std::vector<VkDescriptorSetLayout>& setLayouts,
+    const std::vector<VkPushConstantRange>& pushConstantRanges) const
+{
+    StateKeyT key;
+    key.add(setLayouts.size());
+    for (const auto& layout : setLayouts)
+    {
+        // the other set layouts (bindless) live as long as the device, their handle is stable
+        auto it = m_setLayoutKeys.find(layout);
+        if (it != m_setLayoutKeys.end())
+            key.add(it->second);
+        else
+            key.add(layout);
+    }
+    key.add(pushConstantRanges.size());
+    for (const auto& range : pushConstantRanges)
+        key.add(range.stageFlags).add(range.offset).add(range.size);
+    return key;
+}
+
+/**
+ * @brief the order of the dynamic states does not matter, returns them sorted
+ *
+ */
+static std::vector<VkDynamicState> addDynamicStates(StateKeyT& key, const PipelineCreateInfoT& ci)
+{
+    std::vector<VkDynamicState> dynamicStates = ci.dynamicStates;
+    std::sort(dynamicStates.begin(), dynamicStates.end());
+    key.add(dynamicStates.size());
+    for (const auto& state : dynamicStates)
+        key.add(state);
+    return dynamicStates;
+}
+
+/**
+ * @brief shaders, identified by their code rather than by their module
+ *
+ */
+static void addShaderStages(StateKeyT& key, const PipelineCreateInfoT& ci, const bool bFragment)
+{
+    for (const auto& shader : ci.shaderStages)
+    {
+        auto gpu = std::static_pointer_cast<GPUShader>(shader->localResource);
+        if ((gpu->createInfo.stage == VK_SHADER_STAGE_FRAGMENT_BIT) != bFragment)
+            continue;
+
+        key.add(gpu->createInfo.stage).add(gpu->createInfo.pName);
+        key.add(gpu->codeSize).add(gpu->codeHash);
+    }
+}
+
+static void addVertexInput(StateKeyT& key, const PipelineCreateInfoT& ci)
+{
+    key.add(ci.vertexBindings.size());
+    for (const auto& b : ci.vertexBindings)
+        key.add(b.binding).add(b.stride).add(b.inputRate);
+    key.add(ci.vertexAttributes.size());
+    for (const auto& a : ci.vertexAttributes)
+        key.add(a.location).add(a.binding).add(a.format).add(a.offset);
+
+    key.add(ci.topology).add(ci.bPrimitiveRestartEnable);
+}
+
+static void addPreRasterization(StateKeyT& key, const PipelineCreateInfoT& ci,
+                                const std::vector<VkDynamicState>& dynamicStates)
+{
+    auto isDynamic = [&dynamicStates](const VkDynamicState state) {
+        return std::binary_search(dynamicStates.begin(), dynamicStates.end(), state);
+    };
+
+    addShaderStages(key, ci, false);
+
+    // the viewport and scissor are always dynamic (viewport state without pViewports), the
+    // viewport size does not take part in the key
+
+    const auto& r = ci.rasterizerCreateInfo;
+    key.add(r.depthClampEnable).add(r.rasterizerDiscardEnable).add(r.polygonMode);
+    key.add(r.cullMode).add(r.frontFace).add(r.depthBiasEnable);
+    if (r.depthBiasEnable && !isDynamic(VK_DYNAMIC_STATE_DEPTH_BIAS))
+        key.add(r.depthBiasConstantFactor).add(r.depthBiasClamp).add(r.depthBiasSlopeFactor);
+    if (!isDynamic(VK_DYNAMIC_STATE_LINE_WIDTH))
+        key.add(r.lineWidth);
+}
+
+static void addMultisampling(StateKeyT& key, const PipelineCreateInfoT& ci)
+{
+    const auto& m = ci.multisamplingCreateInfo;
+    key.add(m.rasterizationSamples).add(m.sampleShadingEnable);
+    if (m.sampleShadingEnable)
+        key.add(m.minSampleShading);
+    key.add(m.alphaToCoverageEnable).add(m.alphaToOneEnable);
+}
+
+static void addFragmentShader(StateKeyT& key, const PipelineCreateInfoT& ci)
+{
+    addShaderStages(key, ci, true);
+    addMultisampling(key, ci);
+
+    const auto& d = ci.depthStencilCreateInfo;
+    key.add(d.depthTestEnable).add(d.depthWriteEnable).add(d.depthCompareOp);
+    key.add(d.depthBoundsTestEnable);
+    if (d.depthBoundsTestEnable)
+        key.add(d.minDepthBounds).add(d.maxDepthBounds);
+    key.add(d.stencilTestEnable);
+    if (d.stencilTestEnable)
+    {
+        for (const VkStencilOpState& s : {d.front, d.back})
+        {
+            key.add(s.failOp).add(s.passOp).add(s.depthFailOp).add(s.compareOp);
+            key.add(s.compareMask).add(s.writeMask).add(s.reference);
+        }
+    }
+}
+
+static void addFragmentOutput(StateKeyT& key, const PipelineCreateInfoT& ci,
+                              const std::vector<VkDynamicState>& dynamicStates)
+{
+    addMultisampling(key, ci);
+
+    bool bUsesBlendConstants = false;
+    key.add(ci.colorBlendAttachment.size());
+    for (const auto& a : ci.colorBlendAttachment)
+    {
+        key.add(a.blendEnable).add(a.colorWriteMask);
+        if (!a.blendEnable)
+            continue;
+
+        key.add(a.srcColorBlendFactor).add(a.dstColorBlendFactor).add(a.colorBlendOp);
+        key.add(a.srcAlphaBlendFactor).add(a.dstAlphaBlendFactor).add(a.alphaBlendOp);
+        for (VkBlendFactor f : {a.srcColorBlendFactor, a.dstColorBlendFactor,
+                                a.srcAlphaBlendFactor, a.dstAlphaBlendFactor})
+        {
+            bUsesBlendConstants |= f >= VK_BLEND_FACTOR_CONSTANT_COLOR &&
+                                   f <= VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_ALPHA;
+        }
+    }
+    if (bUsesBlendConstants && !std::binary_search(dynamicStates.begin(), dynamicStates.end(),
+                                                   VK_DYNAMIC_STATE_BLEND_CONSTANTS))
+        key.add(ci.blendConstants);
+}
+
+/**
+ * @brief render pass compatibility : formats and sample counts, not load/store operations
+ *
+ */
+static void addRenderPass(StateKeyT& key, const PipelineCreateInfoT& ci)
+{
+    key.add(ci.renderPass != nullptr);
+    if (!ci.renderPass)
+        return;
+
+    ObjectCache::addRenderPassCompatibility(key, ci.renderPass->info);
+    key.add(ci.subpassIndex);
+}
+
+StateKeyT PipelineStateCache::makePipelineKey(const PipelineCreateInfoT& ci,
+                                              const VkPipelineLayout layout)
+{
+    StateKeyT key;
+
+    std::vector<VkDynamicState> dynamicStates = addDynamicStates(key, ci);
+    addVertexInput(key, ci);
+    addPreRasterization(key, ci, dynamicStates);
+    addFragmentShader(key, ci);
+    addFragmentOutput(key, ci, dynamicStates);
+
+    key.add(layout);
+    addRenderPass(key, ci);
+
+    return key;
+}
+
+StateKeyT PipelineStateCache::makePipelineLibraryKey(const PipelineLibraryPartE part,
+                                                     const PipelineCreateInfoT& ci,
+                                                     const StateKeyT& layoutKey)
+{
+    StateKeyT key;
+    key.add(part);
+
+    std::vector<VkDynamicState> dynamicStates = addDynamicStates(key, ci);
+    switch (part)
+    {
+    case PipelineLibraryPartE::VERTEX_INPUT:
+        addVertexInput(key, ci);
+        // the vertex input interface does not depend on the layout nor on the render pass
+        return key;
+    case PipelineLibraryPartE::PRE_RASTERIZATION:
+        addPreRasterization(key, ci, dynamicStates);
+        key.add(layoutKey);
+        break;
+    case PipelineLibraryPartE::FRAGMENT_SHADER:
+        addFragmentShader(key, ci);
+        key.add(layoutKey);
+        break;
+    case PipelineLibraryPartE::FRAGMENT_OUTPUT:
+        addFragmentOutput(key, ci, dynamicStates);
+        break;
+    default:
+        break;
+    }
+    addRenderPass(key, ci);
+
+    return key;
+}
+
+VkDescriptorSetLayout PipelineStateCache::acquireSetLayout(
+    const PipelineCreateInfoT::DescriptorSetDescriptionT& description)
+{
+    StateKeyT key = makeSetLayoutKey(description);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto& entry = m_setLayouts[key];
+    if (entry.handle == VK_NULL_HANDLE)
+    {
+        // without VK_KHR_push_descriptor the set is allocated per draw from the transient
+        // allocator of the back buffer
+        VkDescriptorSetLayoutCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .flags = description.bPushDescriptor && ci.device->supportsPushDescriptors()
+                         ? static_cast<VkDescriptorSetLayoutCreateFlags>(
+                               VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
+                         : 0U,
+            .bindingCount = static_cast<uint32_t>(description.setLayoutBindings.size()),
+            .pBindings = description.setLayoutBindings.data(),
+        };
+
+        VkResult res = ci.device->getContext()->CreateDescriptorSetLayout(
+            ci.device->getHandle(), &createInfo, nullptr, &entry.handle);
+        if (res != VK_SUCCESS)
+        {
+            std::cerr << "Failed to create descriptor set layout : " << res << std::endl;
+            m_setLayouts.erase(key);
+            return VK_NULL_HANDLE;
+        }
+        m_setLayoutKeys[entry.handle] = key;
+    }
+
+    ++entry.refCount;
+    return entry.handle;
+}
+
+void PipelineStateCache::releaseSetLayout(const VkDescriptorSetLayout setLayout)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_setLayoutKeys.find(setLayout);
+    if (it == m_setLayoutKeys.end())
+        return;
+
+    auto& entry = m_setLayouts[it->second];
+    if (--entry.refCount > 0U)
+        return;
+
+    ci.device->getContext()->DestroyDescriptorSetLayout(ci.device->getHandle(), entry.handle,
+                                                        nullptr);
+    m_setLayouts.erase(it->second);
+    m_setLayoutKeys.erase(it);
+}
+
+VkPipelineLayout PipelineStateCache::acquirePipelineLayout(
+    const std::vector<VkDescriptorSetLayout>& setLayouts,
+    const std::vector<VkPushConstantRange>& pushConstantRanges)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    StateKeyT key = makePipelineLayoutKey(setLayouts, pushConstantRanges);
+    auto& entry = m_pipelineLayouts[key];
+    if (entry.handle == VK_NULL_HANDLE)
+    {
+        VkPipelineLayoutCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+            .pSetLayouts = setLayouts.data(),
+            .pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size()),
+            .pPushConstantRanges = pushConstantRanges.empty() ? nullptr : pushConstantRanges.data(),
+        };
+
+        VkResult res = ci.device->getContext()->CreatePipelineLayout(
+            ci.device->getHandle(), &createInfo, nullptr, &entry.handle);
+        if (res != VK_SUCCESS)
+        {
+            std::cerr << "Failed to create pipeline layout : " << res << std::endl;
+            m_pipelineLayouts.erase(key);
+            return VK_NULL_HANDLE;
+        }
+        m_pipelineLayoutKeys[entry.handle] = key;
+    }
+
+    ++entry.refCount;
+    return entry.handle;
+}
+
+void PipelineStateCache::releasePipelineLayout(const VkPipelineLayout layout)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_pipelineLayoutKeys.find(layout);
+    if (it == m_pipelineLayoutKeys.end())
+        return;
+
+    auto& entry = m_pipelineLayouts[it->second];
+    if (--entry.refCount > 0U)
+        return;
+
+    ci.device->getContext()->DestroyPipelineLayout(ci.device->getHandle(), entry.handle, nullptr);
+    m_pipelineLayouts.erase(it->second);
+    m_pipelineLayoutKeys.erase(it);
+}
+
+StateKeyT PipelineStateCache::getPipelineLayoutKey(const VkPipelineLayout layout)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_pipelineLayoutKeys.find(layout);
+    return it != m_pipelineLayoutKeys.end() ? it->second : StateKeyT{};
+}
+
+PipelineHandlesT PipelineStateCache::acquirePipeline(
+    const StateKeyT& key, const std::function<PipelineHandlesT()>& create)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        auto it = m_pipelines.find(key);
+        if (it != m_pipelines.end())
+        {
+            ++it->second.refCount;
+            return it->second.handles;
+        }
+    }
+
+    // compiling may take a while, do not hold the lock
+    PipelineHandlesT pipeline = create();
+    if (pipeline.handle == VK_NULL_HANDLE)
+        return {};
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto& entry = m_pipelines[key];
+    if (entry.handles.handle != VK_NULL_HANDLE)
+    {
+        // another thread compiled the same state in the meantime
+        if (pipeline.optimized)
+            pipeline.optimized->abandon();
+        ci.device->getContext()->DestroyPipeline(ci.device->getHandle(), pipeline.handle, nullptr);
+    }
+    else
+    {
+        entry.handles = pipeline;
+        m_pipelineKeys[pipeline.handle] = key;
+    }
+
+    ++entry.refCount;
+    return entry.handles;
+}
+
+void PipelineStateCache::releasePipeline(const VkPipeline pipeline)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_pipelineKeys.find(pipeline);
+    if (it == m_pipelineKeys.end())
+        return;
+
+    auto& entry = m_pipelines[it->second];
+    if (--entry.refCount > 0U)
+        return;
+
+    // waits for a background link in progress, it uses the layout released next
+    if (entry.handles.optimized)
+        entry.handles.optimized->abandon();
+    ci.device->getContext()->DestroyPipeline(ci.device->getHandle(), entry.handles.handle,
+                                             nullptr);
+    m_pipelines.erase(it->second);
+    m_pipelineKeys.erase(it);
+}
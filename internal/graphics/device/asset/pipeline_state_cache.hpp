@@ -0,0 +1,125 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "device/state_key.hpp"
+
+#include "pipeline.hpp"
+#include "pipeline_library.hpp"
+
+class LogicalDevice;
+
+struct PipelineStateCacheCreateInfoT
+{
+    const LogicalDevice* device;
+};
+
+/**
+ * @brief content addressed cache of the objects making a pipeline
+ * identical descriptor set layouts, pipeline layouts and pipelines are created once and shared,
+ * every acquire must be matched with a release, the object is destroyed with its last reference
+ *
+ */
+class PipelineStateCache
+{
+  private:
+    const PipelineStateCacheCreateInfoT ci;
+
+  private:
+    template<class THandle> struct EntryT
+    {
+        THandle handle = VK_NULL_HANDLE;
+        uint32_t refCount = 0U;
+    };
+    struct PipelineEntryT
+    {
+        PipelineHandlesT handles;
+        uint32_t refCount = 0U;
+    };
+
+    std::mutex m_mutex;
+
+    std::unordered_map<StateKeyT, EntryT<VkDescriptorSetLayout>, StateKeyHashT> m_setLayouts;
+    std::unordered_map<StateKeyT, EntryT<VkPipelineLayout>, StateKeyHashT> m_pipelineLayouts;
+    std::unordered_map<StateKeyT, PipelineEntryT, StateKeyHashT> m_pipelines;
+
+    /**
+     * @brief reverse lookup used when releasing a handle
+     *
+     */
+    std::unordered_map<VkDescriptorSetLayout, StateKeyT> m_setLayoutKeys;
+    std::unordered_map<VkPipelineLayout, StateKeyT> m_pipelineLayoutKeys;
+    std::unordered_map<VkPipeline, StateKeyT> m_pipelineKeys;
+
+    /**
+     * @brief the set layouts of the cache are described by their key, the mutex must be held
+     *
+     */
+    [[nodiscard]] StateKeyT makePipelineLayoutKey(
+        const std::vector<VkDescriptorSetLayout>& setLayouts,
+        const std::vector<VkPushConstantRange>& pushConstantRanges) const;
+
+  public:
+    PipelineStateCache() = delete;
+    PipelineStateCache(const PipelineStateCache&) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache&) = delete;
+    PipelineStateCache(PipelineStateCache&&) = delete;
+    PipelineStateCache& operator=(PipelineStateCache&&) = delete;
+
+    explicit PipelineStateCache(const PipelineStateCacheCreateInfoT createInfo) : ci(createInfo) {}
+
+    /**
+     * @brief destroys every object still in the cache
+     *
+     */
+    ~PipelineStateCache();
+
+    [[nodiscard]] static StateKeyT makeSetLayoutKey(
+        const PipelineCreateInfoT::DescriptorSetDescriptionT& description);
+    /**
+     * @brief hash of the whole normalized create info : shader code, vertex input, fixed function
+     * states and render pass compatibility (formats and sample counts, not load/store operations)
+     * the layout is part of the key, it is already deduplicated by content
+     *
+     */
+    [[nodiscard]] static StateKeyT makePipelineKey(const PipelineCreateInfoT& createInfo,
+                                                   const VkPipelineLayout layout);
+    /**
+     * @brief hash of the subset of the create info consumed by one graphics pipeline library part
+     * the layout is given by its content key (getPipelineLayoutKey), libraries outlive the layout
+     * they were compiled with and a later layout may reuse its handle
+     *
+     */
+    [[nodiscard]] static StateKeyT makePipelineLibraryKey(const PipelineLibraryPartE part,
+                                                          const PipelineCreateInfoT& createInfo,
+                                                          const StateKeyT& layoutKey);
+
+    [[nodiscard]] VkDescriptorSetLayout acquireSetLayout(
+        const PipelineCreateInfoT::DescriptorSetDescriptionT& description);
+    void releaseSetLayout(const VkDescriptorSetLayout setLayout);
+
+    [[nodiscard]] VkPipelineLayout acquirePipelineLayout(
+        const std::vector<VkDescriptorSetLayout>& setLayouts,
+        const std::vector<VkPushConstantRange>& pushConstantRanges);
+    void releasePipelineLayout(const VkPipelineLayout layout);
+    /**
+     * @brief content key of a layout acquired from this cache, empty for the other layouts
+     *
+     */
+    [[nodiscard]] StateKeyT getPipelineLayoutKey(const VkPipelineLayout layout);
+
+    /**
+     * @brief returns the cached pipeline for this key or creates it with the given function
+     * the creation happens outside of the lock, if two threads compile the same state
+     * concurrently, the first inserted pipeline is kept and the other one is destroyed
+     *
+     */
+    [[nodiscard]] PipelineHandlesT acquirePipeline(
+        const StateKeyT& key, const std::function<PipelineHandlesT()>& create);
+    void releasePipeline(const VkPipeline pipeline);
+};
@@ -58,4 +58,18 @@ class GPUShader : public LocalResourceABC
   public:
     VkShaderModule module;
     VkPipelineShaderStageCreateInfo createInfo;
+
+    /**
+     * @brief size and hash of the SPIR-V code, used to identify the shader in pipeline state keys
+     *
+     */
+    size_t codeSize = 0;
+    uint64_t codeHash = 0ULL;
+
+    /**
+     * @brief SPIR-V code, kept when shader objects are enabled since VK_EXT_shader_object compiles
+     * from code rather than from a module
+     *
+     */
+    std::vector<char> code;
 };
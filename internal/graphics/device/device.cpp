@@ -1,5 +1,12 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <latch>
+
+#include "core/thread_pool.hpp"
 
 #include "context.hpp"
 #include "instance.hpp"
@@ -7,13 +14,22 @@
 
 #include "surface.hpp"
 
+#include "asset/object_cache.hpp"
 #include "asset/pipeline.hpp"
+#include "asset/pipeline_cache.hpp"
+#include "asset/pipeline_creation_report.hpp"
+#include "asset/pipeline_library.hpp"
+#include "asset/pipeline_state_cache.hpp"
 #include "asset/render_pass.hpp"
 #include "asset/shader.hpp"
 #include "backbuffer.hpp"
 #include "framebuffer.hpp"
+#include "memory/bindless_table.hpp"
 #include "memory/buffer.hpp"
+#include "memory/defragmenter.hpp"
+#include "memory/descriptor_allocator.hpp"
 #include "memory/image.hpp"
+#include "memory/image_uploader.hpp"
 #include "swapchain.hpp"
 #include "synchronization.hpp"
 
@@ -30,33 +46,77 @@ LogicalDevice::LogicalDevice(const LogicalDeviceCreateInfoT createInfo)
         return;
     }
 
+    const auto* deviceCreateInfo = (VkDeviceCreateInfo*)createInfo.createInfo;
+    m_deviceExtensions.assign(deviceCreateInfo->ppEnabledExtensionNames,
+                              deviceCreateInfo->ppEnabledExtensionNames +
+                                  deviceCreateInfo->enabledExtensionCount);
+    m_bShaderObjects = isExtensionEnabled(VK_EXT_SHADER_OBJECT_EXTENSION_NAME) &&
+                       physicalHandle->getShaderObjectFeatures().shaderObject;
+    m_bPushDescriptors = isExtensionEnabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    m_bHostImageCopy = isExtensionEnabled(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) &&
+                       physicalHandle->getHostImageCopyFeatures().hostImageCopy;
+
     cx->loadBottom(this);
+    m_dispatch.load(cx, m_handle);
 
     retrieveQueues();
     createCommandPools();
-    createAllocator();
+    createAllocator(createInfo.allocatorBackend);
+    m_descriptorAllocator = std::make_unique<DescriptorAllocator>(DescriptorAllocatorCreateInfoT{
+        .device = this,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+    });
+    // the indexing features are only enabled along with the extension before Vulkan 1.2
+    if (physicalHandle->supportsBindless() &&
+        (physicalHandle->getProperties().apiVersion >= VK_API_VERSION_1_2 ||
+         isExtensionEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)))
+        m_bindlessTable = std::make_unique<BindlessTable>(BindlessTableCreateInfoT{.device = this});
+    createPipelineCache(createInfo.pipelineCacheDirectory);
+    m_pipelineCreationReport = std::make_unique<PipelineCreationReport>();
+    if (isExtensionEnabled(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+        physicalHandle->getGraphicsPipelineLibraryFeatures().graphicsPipelineLibrary)
+    {
+        m_pipelineLibrary =
+            std::make_unique<PipelineLibrary>(PipelineLibraryCreateInfoT{.device = this});
+    }
+    m_pipelineStateCache =
+        std::make_unique<PipelineStateCache>(PipelineStateCacheCreateInfoT{.device = this});
+    m_objectCache = std::make_unique<ObjectCache>(ObjectCacheCreateInfoT{.device = this});
 }
 
-void LogicalDevice::createAllocator()
+void LogicalDevice::createPipelineCache(const std::filesystem::path& directory)
 {
-    VmaVulkanFunctions vulkanFunctions = {};
-    vulkanFunctions.vkGetInstanceProcAddr = cx->GetInstanceProcAddr;
-    vulkanFunctions.vkGetDeviceProcAddr = cx->GetDeviceProcAddr;
+    m_pipelineCache = std::make_unique<PipelineCache>(PipelineCacheCreateInfoT{
+        .device = this,
+        .directory = directory,
+    });
+}
+
+void LogicalDevice::destroyPipelineCache()
+{
+    if (!m_pipelineCache)
+        return;
 
-    VmaAllocatorCreateInfo allocatorCreateInfo = {};
-    allocatorCreateInfo.flags = VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
-    allocatorCreateInfo.vulkanApiVersion = VK_API_VERSION_1_2;
-    allocatorCreateInfo.physicalDevice = physicalHandle->getHandle();
-    allocatorCreateInfo.device = m_handle;
-    allocatorCreateInfo.instance = physicalHandle->getInstance()->getHandle();
-    allocatorCreateInfo.pVulkanFunctions = &vulkanFunctions;
+    m_pipelineCache->save();
+    m_pipelineCache.reset();
+}
 
-    vmaCreateAllocator(&allocatorCreateInfo, &allocator);
+void LogicalDevice::createAllocator(const AllocatorBackendE backend)
+{
+    m_memoryAllocator = std::make_unique<MemoryAllocator>(MemoryAllocatorCreateInfoT{
+        .device = this,
+        .backend = backend,
+    });
+    m_defragmenter = std::make_unique<Defragmenter>(DefragmenterCreateInfoT{.device = this});
+    m_imageUploader = std::make_unique<ImageUploader>(ImageUploaderCreateInfoT{.device = this});
 }
 
 void LogicalDevice::destroyAllocator()
 {
-    vmaDestroyAllocator(allocator);
+    // staging buffers go back to the allocator
+    m_imageUploader.reset();
+    m_defragmenter.reset();
+    m_memoryAllocator.reset();
 }
 
 void LogicalDevice::destroyCommandPools()
@@ -74,6 +134,17 @@ void LogicalDevice::destroyCommandPools()
 
 LogicalDevice::~LogicalDevice()
 {
+    // background links use pipeline layouts owned by the state cache
+    if (m_pipelineLibrary)
+        m_pipelineLibrary->stop();
+    m_pipelineStateCache.reset();
+    m_pipelineLibrary.reset();
+    m_objectCache.reset();
+    destroyPipelineCache();
+
+    m_bindlessTable.reset();
+    m_descriptorAllocator.reset();
+
     destroyAllocator();
 
     destroyCommandPools();
@@ -81,6 +152,14 @@ LogicalDevice::~LogicalDevice()
     cx->DestroyDevice(m_handle, nullptr);
 }
 
+bool LogicalDevice::isExtensionEnabled(const char* extensionName) const
+{
+    return std::any_of(m_deviceExtensions.begin(), m_deviceExtensions.end(),
+                       [extensionName](const char* enabled) {
+                           return std::strcmp(enabled, extensionName) == 0;
+                       });
+}
+
 void LogicalDevice::wait() const
 {
     cx->DeviceWaitIdle(m_handle);
@@ -98,9 +177,9 @@ void LogicalDevice::waitForPresentQueue() const
 void LogicalDevice::mapBufferMemory(const std::shared_ptr<Buffer>& buffer,
                                     void** mappedMemory) const
 {
-    // cx->MapMemory(m_handle, buffer->memory->GetMemory(), 0, buffer->size, 0, mappedMemory);
-    // TODO : abstraction
-    vmaMapMemory(allocator, buffer->memory, mappedMemory);
+    VkResult res = m_memoryAllocator->mapMemory(*buffer->memory, mappedMemory);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to map buffer memory : " << res << std::endl;
 }
 
 std::unique_ptr<SwapChain> LogicalDevice::createSwapChain(SwapChainCreateInfoT ci) const
@@ -255,6 +334,8 @@ void LogicalDevice::destroySwapChain(SwapChain& sc) const
         destroyImageView(sc.depthImageView.value());
     if (sc.depthImage.has_value())
         destroyImage(sc.depthImage.value());
+    for (const auto& image : sc.images)
+        m_objectCache->forgetImage(image);
     cx->DestroySwapchainKHR(m_handle, sc.getHandle(), nullptr);
 }
 
@@ -265,8 +346,7 @@ std::shared_ptr<ImageView> LogicalDevice::createImageView(const ImageViewCreateI
     VkImageViewCreateInfo createInfo = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .image = ci.image.value(),
-        // TODO : move these parameters in createinfo structure
-        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .viewType = ci.viewType,
         .format = ci.format.value(),
         .components =
             {
@@ -278,23 +358,27 @@ std::shared_ptr<ImageView> LogicalDevice::createImageView(const ImageViewCreateI
         .subresourceRange =
             {
                          .aspectMask = ci.aspect,
-                         .baseMipLevel = 0,
-                         .levelCount = 1,
+                         .baseMipLevel = ci.baseMipLevel,
+                         .levelCount = ci.levelCount,
                          .baseArrayLayer = 0,
-                         .layerCount = 1,
+                         .layerCount = ci.layerCount,
                          },
     };
 
-    VkImageView imageView;
-    VkResult res = cx->CreateImageView(m_handle, &createInfo, nullptr, &imageView);
-    if (res != VK_SUCCESS)
-        std::cerr << "Failed to create image view : " << res << std::endl;
+    VkImageView imageView = m_objectCache->acquireImageView(
+        ObjectCache::makeImageViewKey(ci), ci.image.value(), [&]() {
+            VkImageView handle = VK_NULL_HANDLE;
+            VkResult res = cx->CreateImageView(m_handle, &createInfo, nullptr, &handle);
+            if (res != VK_SUCCESS)
+                std::cerr << "Failed to create image view : " << res << std::endl;
+            return handle;
+        });
 
     return std::make_shared<ImageView>(imageView);
 }
 void LogicalDevice::destroyImageView(std::shared_ptr<ImageView>& pData) const
 {
-    cx->DestroyImageView(m_handle, pData->handle, nullptr);
+    m_objectCache->releaseImageView(pData->handle);
 }
 
 std::unique_ptr<RenderPass> LogicalDevice::createRenderPass(const RenderPassCreateInfoT ci) const
@@ -344,9 +428,14 @@ std::unique_ptr<RenderPass> LogicalDevice::createRenderPass(const RenderPassCrea
     };
 
     auto out = std::make_unique<RenderPass>();
-    VkResult res = cx->CreateRenderPass(m_handle, &createInfo, nullptr, &out->handle);
-    if (res != VK_SUCCESS)
-        std::cerr << "Failed to create render pass : " << res << std::endl;
+    out->handle =
+        m_objectCache->acquireRenderPass(ObjectCache::makeRenderPassKey(ci), [&]() {
+            VkRenderPass handle = VK_NULL_HANDLE;
+            VkResult res = cx->CreateRenderPass(m_handle, &createInfo, nullptr, &handle);
+            if (res != VK_SUCCESS)
+                std::cerr << "Failed to create render pass : " << res << std::endl;
+            return handle;
+        });
 
     out->info = ci;
 
@@ -354,7 +443,7 @@ std::unique_ptr<RenderPass> LogicalDevice::createRenderPass(const RenderPassCrea
 }
 void LogicalDevice::destroyRenderPass(RenderPass* pData) const
 {
-    cx->DestroyRenderPass(m_handle, pData->handle, nullptr);
+    m_objectCache->releaseRenderPass(pData->handle);
 }
 
 std::shared_ptr<Framebuffer> LogicalDevice::createFramebuffer(const FramebufferCreateInfoT ci) const
@@ -377,15 +466,20 @@ std::shared_ptr<Framebuffer> LogicalDevice::createFramebuffer(const FramebufferC
     auto out = std::make_shared<Framebuffer>();
     out->width = ci.width;
     out->height = ci.height;
-    VkResult res = cx->CreateFramebuffer(m_handle, &createInfo, nullptr, &out->handle);
-    if (res != VK_SUCCESS)
-        std::cerr << "Failed to create framebuffer : " << res << std::endl;
+    out->handle = m_objectCache->acquireFramebuffer(
+        ObjectCache::makeFramebufferKey(ci), attachments, [&]() {
+            VkFramebuffer handle = VK_NULL_HANDLE;
+            VkResult res = cx->CreateFramebuffer(m_handle, &createInfo, nullptr, &handle);
+            if (res != VK_SUCCESS)
+                std::cerr << "Failed to create framebuffer : " << res << std::endl;
+            return handle;
+        });
 
     return out;
 }
 void LogicalDevice::destroyFramebuffer(std::shared_ptr<Framebuffer>& pData) const
 {
-    cx->DestroyFramebuffer(m_handle, pData->handle, nullptr);
+    m_objectCache->releaseFramebuffer(pData->handle);
 }
 
 std::shared_ptr<GPUShader> LogicalDevice::createShader(const ShaderCreateInfoT ci) const
@@ -403,6 +497,17 @@ std::shared_ptr<GPUShader> LogicalDevice::createShader(const ShaderCreateInfoT c
     if (res != VK_SUCCESS)
         std::cerr << "Failed to create shader module : " << res << std::endl;
 
+    if (supportsShaderObjects())
+        out->code = ci.source.value();
+
+    out->codeSize = ci.source.value().size();
+    out->codeHash = 0xcbf29ce484222325ULL;
+    for (const char c : ci.source.value())
+    {
+        out->codeHash ^= static_cast<uint8_t>(c);
+        out->codeHash *= 0x100000001b3ULL;
+    }
+
     out->createInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .stage = ci.stage,
@@ -417,151 +522,296 @@ void LogicalDevice::destroyShader(std::shared_ptr<GPUShader>& pData) const
     cx->DestroyShaderModule(m_handle, pData->module, nullptr);
 }
 
-std::unique_ptr<Pipeline> LogicalDevice::createPipeline(const PipelineCreateInfoT ci) const
+PipelineHandlesT LogicalDevice::compilePipeline(const PipelineCreateInfoT& ci,
+                                                const VkPipelineLayout layout,
+                                                const VkPipelineCache cache,
+                                                const std::size_t key) const
 {
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStagesCreateInfos(ci.shaderStages.size());
-    for (int i = 0; i < ci.shaderStages.size(); ++i)
+    GraphicsPipelineStatesT states(ci);
+
+    // creation feedback (core in 1.3)
+    VkPipelineCreationFeedback pipelineFeedback = {};
+    std::vector<VkPipelineCreationFeedback> stageFeedbacks(states.shaderStages.size());
+    VkPipelineCreationFeedbackCreateInfo feedbackCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+        .pPipelineCreationFeedback = &pipelineFeedback,
+        .pipelineStageCreationFeedbackCount = static_cast<uint32_t>(stageFeedbacks.size()),
+        .pPipelineStageCreationFeedbacks = stageFeedbacks.data(),
+    };
+
+    PipelineHandlesT out;
+    auto start = std::chrono::steady_clock::now();
+    if (m_pipelineLibrary)
     {
-        shaderStagesCreateInfos[i] =
-            std::static_pointer_cast<GPUShader>(ci.shaderStages[i]->localResource)->createInfo;
+        // the stages are compiled in the libraries, the link only reports the pipeline feedback
+        feedbackCreateInfo.pipelineStageCreationFeedbackCount = 0U;
+        stageFeedbacks.clear();
+        const StateKeyT layoutKey = m_pipelineStateCache->getPipelineLayoutKey(layout);
+        out = m_pipelineLibrary->link(ci, layout, layoutKey, cache, &feedbackCreateInfo);
+        if (out.handle == VK_NULL_HANDLE)
+            return {};
     }
+    else
+    {
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = &feedbackCreateInfo,
+            // shader stage
+            .stageCount = static_cast<uint32_t>(states.shaderStages.size()),
+            .pStages = states.shaderStages.data(),
+            // fixed function stage
+            .pVertexInputState = &states.vertexInputState,
+            .pInputAssemblyState = &states.inputAssemblyState,
+            .pViewportState = &states.viewportState,
+            .pRasterizationState = &states.rasterizationState,
+            .pMultisampleState = &states.multisampleState,
+            .pDepthStencilState = &states.depthStencilState,
+            .pColorBlendState = &states.colorBlendState,
+            .pDynamicState = &states.dynamicState,
+            // pipeline layout
+            .layout = layout,
+            .subpass = ci.subpassIndex,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1,
+        };
+        if (ci.renderPass)
+            pipelineCreateInfo.renderPass = ci.renderPass->handle;
 
-    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        .dynamicStateCount = static_cast<uint32_t>(ci.dynamicStates.size()),
-        .pDynamicStates = ci.dynamicStates.data(),
+        VkResult res = cx->CreateGraphicsPipelines(m_handle, cache, 1, &pipelineCreateInfo,
+                                                   nullptr, &out.handle);
+        if (res != VK_SUCCESS)
+        {
+            std::cerr << "Failed to create graphics pipeline : " << res << std::endl;
+            return {};
+        }
+    }
+    auto wallDuration = std::chrono::steady_clock::now() - start;
+    m_pipelineCache->recordCreation(wallDuration);
+
+    PipelineCreationFeedbackT feedback = {
+        .name = ci.name,
+        .key = key,
+        .bValid = (pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0,
+        .bCacheHit = (pipelineFeedback.flags &
+                      VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0,
+        .duration = std::chrono::nanoseconds(pipelineFeedback.duration),
+        .wallDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(wallDuration),
     };
+    feedback.stages.resize(stageFeedbacks.size());
+    for (int i = 0; i < stageFeedbacks.size(); ++i)
+    {
+        feedback.stages[i] = {
+            .stage = states.shaderStages[i].stage,
+            .bValid = (stageFeedbacks[i].flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0,
+            .bCacheHit = (stageFeedbacks[i].flags &
+                          VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0,
+            .duration = std::chrono::nanoseconds(stageFeedbacks[i].duration),
+        };
+    }
+    m_pipelineCreationReport->add(std::move(feedback));
 
-    // vertex (enabling the binding for the Vertex structure)
-    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = static_cast<uint32_t>(ci.vertexBindings.size()),
-        .pVertexBindingDescriptions = ci.vertexBindings.data(),
-        .vertexAttributeDescriptionCount = static_cast<uint32_t>(ci.vertexAttributes.size()),
-        .pVertexAttributeDescriptions = ci.vertexAttributes.data(),
-    };
+    return out;
+}
 
-    // draw mode
-    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = ci.topology,
-        .primitiveRestartEnable = ci.bPrimitiveRestartEnable,
-    };
+std::unique_ptr<Pipeline> LogicalDevice::createPipeline(const PipelineCreateInfoT ci) const
+{
+    return createPipelineWithCache(ci, m_pipelineCache->getHandle());
+}
 
-    // viewport
-    VkViewport viewport = {
-        .x = 0.f,
-        .y = 0.f,
-        .width = static_cast<float>(ci.viewportWidth),
-        .height = static_cast<float>(ci.viewportHeight),
-        .minDepth = 0.f,
-        .maxDepth = 1.f,
-    };
+std::unique_ptr<Pipeline> LogicalDevice::createPipelineWithCache(const PipelineCreateInfoT& ci,
+                                                                 const VkPipelineCache cache) const
+{
+    auto out = std::make_unique<Pipeline>(ci);
 
-    VkRect2D scissor = {
-        .offset = {0, 0},
-        .extent =
-            VkExtent2D{
-                   .width = ci.viewportWidth,
-                   .height = ci.viewportHeight,
-                   },
-    };
+    // pipeline layout
+    auto& setLayouts = out->getSetLayouts();
+    setLayouts.resize(ci.setDescriptions.size());
+    for (int i = 0; i < ci.setDescriptions.size(); ++i)
+        setLayouts[i] = m_pipelineStateCache->acquireSetLayout(ci.setDescriptions[i]);
 
-    VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .scissorCount = 1,
-    };
+    if (ci.bBindless && m_bindlessTable)
+        out->getBindlessSetLayout() = m_bindlessTable->getSetLayout();
 
-    // rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = ci.rasterizerCreateInfo;
+    out->getLayoutHandle() = m_pipelineStateCache->acquirePipelineLayout(
+        out->getPipelineLayoutSetLayouts(), ci.pushConstantRanges);
 
-    // multisampling, anti-aliasing
-    VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = ci.multisamplingCreateInfo;
+    // descriptor sets, a pipeline without them would be indexed past its blocks
+    if (!out->recreateDescriptorSets(ci.type))
+    {
+        std::cerr << "Failed to allocate the descriptor sets of "
+                  << (ci.name.empty() ? "pipeline" : ci.name) << std::endl;
+        destroyPipeline(out.get());
+        return nullptr;
+    }
 
-    VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = ci.depthStencilCreateInfo;
+    const VkPipelineLayout layout = out->getLayoutHandle();
+    if (ci.backend == PipelineBackendE::SHADER_OBJECT)
+    {
+        if (supportsShaderObjects())
+        {
+            if (createShaderObjects(ci, *out))
+                return out;
+            std::cout << (ci.name.empty() ? "pipeline" : ci.name)
+                      << " falls back to a pipeline" << std::endl;
+        }
+        else
+        {
+            std::cout << "shader objects are not supported, "
+                      << (ci.name.empty() ? "pipeline" : ci.name) << " falls back to a pipeline"
+                      << std::endl;
+        }
+    }
 
-    // color blending
-    VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .logicOpEnable = VK_FALSE,
-        .logicOp = VK_LOGIC_OP_COPY,
-        .attachmentCount = static_cast<uint32_t>(ci.colorBlendAttachment.size()),
-        .pAttachments = ci.colorBlendAttachment.data(),
-        .blendConstants = {ci.blendConstants[0], ci.blendConstants[1], ci.blendConstants[2],
-                           ci.blendConstants[3]},
-    };
+    const StateKeyT key = PipelineStateCache::makePipelineKey(ci, layout);
+    PipelineHandlesT handles = m_pipelineStateCache->acquirePipeline(
+        key, [this, &ci, layout, cache, &key]() {
+            return compilePipeline(ci, layout, cache, key.hash);
+        });
+    out->getHandle() = handles.handle;
+    out->getOptimized() = std::move(handles.optimized);
 
-    auto out = std::make_unique<Pipeline>(ci);
+    return out;
+}
 
-    // pipeline layout
-    auto& setLayouts = out->getSetLayouts();
-    setLayouts.resize(ci.setDescriptions.size());
-    for (int i = 0; i < ci.setDescriptions.size(); ++i)
+/**
+ * @brief shared with the pool tasks, the create infos and the pipelines belong to the caller and
+ * are only touched below count, a task running after the batch is done draws an index past it and
+ * reads nothing but the batch itself
+ *
+ */
+struct PipelineBatchT
+{
+    const PipelineCreateInfoT* createInfos;
+    std::unique_ptr<Pipeline>* out;
+    const size_t count;
+    std::atomic<size_t> next = 0;
+    std::latch done;
+    /**
+     * @brief created for the tasks of this batch, merged once it is done
+     *
+     */
+    std::vector<VkPipelineCache> workerCaches;
+
+    explicit PipelineBatchT(const std::vector<PipelineCreateInfoT>& infos,
+                            std::vector<std::unique_ptr<Pipeline>>& pipelines)
+        : createInfos(infos.data()), out(pipelines.data()), count(infos.size()),
+          done(static_cast<ptrdiff_t>(infos.size()))
     {
-        VkDescriptorSetLayoutCreateInfo createInfo = {
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .bindingCount = static_cast<uint32_t>(ci.setDescriptions[i].setLayoutBindings.size()),
-            .pBindings = ci.setDescriptions[i].setLayoutBindings.data(),
-        };
-
-        VkResult res =
-            cx->CreateDescriptorSetLayout(m_handle, &createInfo, nullptr, &setLayouts[i]);
-        if (res != VK_SUCCESS)
-            std::cerr << "Failed to create descriptor set layout : " << res << std::endl;
     }
+};
 
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
-        .pSetLayouts = setLayouts.data(),
-        .pushConstantRangeCount = static_cast<uint32_t>(ci.pushConstantRanges.size()),
-        .pPushConstantRanges =
-            ci.pushConstantRanges.empty() ? nullptr : ci.pushConstantRanges.data(),
+std::vector<std::unique_ptr<Pipeline>> LogicalDevice::createPipelines(
+    const std::vector<PipelineCreateInfoT>& createInfos, ThreadPool* threadPool) const
+{
+    std::vector<std::unique_ptr<Pipeline>> out(createInfos.size());
+    if (createInfos.empty())
+        return out;
+
+    // workers pull the next create info, expensive pipelines do not stall a whole slice
+    auto batch = std::make_shared<PipelineBatchT>(createInfos, out);
+    auto work = [this](PipelineBatchT& b, const VkPipelineCache cache) {
+        for (size_t i = b.next.fetch_add(1); i < b.count; i = b.next.fetch_add(1))
+        {
+            b.out[i] = createPipelineWithCache(b.createInfos[i], cache);
+            b.done.count_down();
+        }
     };
 
-    VkResult res = cx->CreatePipelineLayout(m_handle, &pipelineLayoutCreateInfo, nullptr,
-                                            &out->getLayoutHandle());
-    if (res != VK_SUCCESS)
-        std::cerr << "Failed to create pipeline layout : " << res << std::endl;
-
-    // descriptor pool and sets
-    out->recreateDescriptorSets(ci.type);
-
-    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        // shader stage
-        .stageCount = static_cast<uint32_t>(shaderStagesCreateInfos.size()),
-        .pStages = shaderStagesCreateInfos.data(),
-        // fixed function stage
-        .pVertexInputState = &vertexInputCreateInfo,
-        .pInputAssemblyState = &inputAssemblyCreateInfo,
-        .pViewportState = &viewportStateCreateInfo,
-        .pRasterizationState = &rasterizerCreateInfo,
-        .pMultisampleState = &multisamplingCreateInfo,
-        .pDepthStencilState = &depthStencilCreateInfo,
-        .pColorBlendState = &colorBlendCreateInfo,
-        .pDynamicState = &dynamicStateCreateInfo,
-        // pipeline layout
-        .layout = out->getLayoutHandle(),
-        .subpass = ci.subpassIndex,
-        .basePipelineHandle = VK_NULL_HANDLE,
-        .basePipelineIndex = -1,
-    };
-    if (ci.renderPass)
-        pipelineCreateInfo.renderPass = ci.renderPass->handle;
+    if (threadPool && createInfos.size() > 1U)
+    {
+        const size_t workerCount = std::min(threadPool->getThreadCount(), createInfos.size() - 1);
+        batch->workerCaches.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; ++i)
+        {
+            const VkPipelineCache cache = m_pipelineCache->createWorkerCache();
+            batch->workerCaches.push_back(cache);
+            threadPool->submit([batch, work, cache]() { work(*batch, cache); });
+        }
+    }
 
-    res = cx->CreateGraphicsPipelines(m_handle, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr,
-                                      &out->getHandle());
-    if (res != VK_SUCCESS)
-        std::cerr << "Failed to create graphics pipeline : " << res << std::endl;
+    // the calling thread takes part, the batch completes even if the pool is busy with loads
+    work(*batch, m_pipelineCache->getHandle());
+    batch->done.wait();
+
+    // the worker caches of concurrent batches are still in use
+    m_pipelineCache->mergeWorkerCaches(batch->workerCaches);
 
     return out;
 }
+bool LogicalDevice::createShaderObjects(const PipelineCreateInfoT& ci, Pipeline& out) const
+{
+    const auto setLayouts = out.getPipelineLayoutSetLayouts();
+
+    std::vector<std::shared_ptr<GPUShader>> shaders(ci.shaderStages.size());
+    for (int i = 0; i < ci.shaderStages.size(); ++i)
+        shaders[i] = std::static_pointer_cast<GPUShader>(ci.shaderStages[i]->localResource);
+
+    bool bHasFragment = std::any_of(shaders.begin(), shaders.end(), [](const auto& shader) {
+        return shader->createInfo.stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+    });
+
+    // the stages are linked together, the driver can optimize across them like a pipeline
+    std::vector<VkShaderCreateInfoEXT> createInfos(shaders.size());
+    for (int i = 0; i < shaders.size(); ++i)
+    {
+        const auto& shader = shaders[i];
+        createInfos[i] = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+            .flags = shaders.size() > 1 ? VK_SHADER_CREATE_LINK_STAGE_BIT_EXT : 0U,
+            .stage = shader->createInfo.stage,
+            .nextStage = shader->createInfo.stage == VK_SHADER_STAGE_VERTEX_BIT && bHasFragment
+                             ? static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_FRAGMENT_BIT)
+                             : 0U,
+            .codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT,
+            .codeSize = shader->code.size(),
+            .pCode = shader->code.data(),
+            .pName = shader->createInfo.pName,
+            .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+            .pSetLayouts = setLayouts.data(),
+            .pushConstantRangeCount = static_cast<uint32_t>(ci.pushConstantRanges.size()),
+            .pPushConstantRanges = ci.pushConstantRanges.data(),
+        };
+        out.getShaderObjectStages().push_back(shader->createInfo.stage);
+    }
+
+    auto& shaderObjects = out.getShaderObjects();
+    shaderObjects.resize(createInfos.size());
+
+    auto start = std::chrono::steady_clock::now();
+    VkResult res = cx->CreateShadersEXT(m_handle, static_cast<uint32_t>(createInfos.size()),
+                                        createInfos.data(), nullptr, shaderObjects.data());
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create shader objects : " << res << std::endl;
+        // some stages may have been created (incompatible binary)
+        for (VkShaderEXT shader : shaderObjects)
+        {
+            if (shader != VK_NULL_HANDLE)
+                cx->DestroyShaderEXT(m_handle, shader, nullptr);
+        }
+        shaderObjects.clear();
+        out.getShaderObjectStages().clear();
+        return false;
+    }
+
+    // reported along with the pipelines to compare both paths at startup
+    m_pipelineCreationReport->add(PipelineCreationFeedbackT{
+        .name = (ci.name.empty() ? std::string("<unnamed>") : ci.name) + " (shader objects)",
+        .wallDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start),
+    });
+    return true;
+}
+
 void LogicalDevice::destroyPipeline(Pipeline* pData) const
 {
-    cx->DestroyPipelineLayout(m_handle, pData->getLayoutHandle(), nullptr);
-    cx->DestroyPipeline(m_handle, pData->getHandle(), nullptr);
+    pData->freeDescriptorSets();
+    for (VkShaderEXT shader : pData->getShaderObjects())
+        cx->DestroyShaderEXT(m_handle, shader, nullptr);
+    m_pipelineStateCache->releasePipeline(pData->getHandle());
+    m_pipelineStateCache->releasePipelineLayout(pData->getLayoutHandle());
+    for (const auto& setLayout : pData->getSetLayouts())
+        m_pipelineStateCache->releaseSetLayout(setLayout);
 }
 
 std::shared_ptr<Semaphore> LogicalDevice::createSemaphore(const SemaphoreCreateInfoT ci) const
@@ -617,11 +867,15 @@ std::shared_ptr<BackBufferAOST> LogicalDevice::createBackBufferAOS(
     if (res != VK_SUCCESS)
         std::cerr << "Failed to create fence : " << res << std::endl;
 
+    out->transientDescriptorAllocator =
+        std::make_shared<DescriptorAllocator>(DescriptorAllocatorCreateInfoT{.device = this});
+
     return out;
 }
 
 void LogicalDevice::destroyBackBufferAOS(std::shared_ptr<BackBufferAOST>& pData) const
 {
+    pData->transientDescriptorAllocator.reset();
     cx->DestroyFence(m_handle, pData->inFlightFence, nullptr);
     if (pData->beforeSubmissionSemaphores.has_value())
     {
@@ -668,23 +922,43 @@ std::shared_ptr<Buffer> LogicalDevice::createBuffer(const BufferCreateInfoT ci)
     VkBufferCreateInfo bufferInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
     bufferInfo.size = ci.size;
     bufferInfo.usage = ci.usage;
-
-    VmaAllocationCreateInfo allocInfo = {};
-    allocInfo.requiredFlags = ci.memoryPropertyFlags;
+    bufferInfo.sharingMode = ci.sharingMode;
+    // moves copy the content to a new buffer
+    if (ci.bMovable)
+        bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
     auto out = std::make_shared<Buffer>();
-    vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, &out->handle, &out->memory, nullptr);
+    VkResult res = m_memoryAllocator->createBuffer(
+        bufferInfo, AllocationCreateInfoT{
+            .requiredFlags = ci.memoryPropertyFlags,
+            .bMovable = ci.bMovable,
+            .type = ci.allocationType,
+        },
+        &out->handle, &out->memory);
     out->size = ci.size;
+    out->usage = bufferInfo.usage;
+    out->sharingMode = ci.sharingMode;
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to create buffer : " << res << std::endl;
+    else if (ci.bMovable)
+        m_defragmenter->registerBuffer(out);
 
     return out;
 }
 void LogicalDevice::destroyBuffer(std::shared_ptr<Buffer>& pData) const
 {
-    vmaDestroyBuffer(allocator, pData->handle, pData->memory);
+    // a buffer being moved is destroyed once the move is done
+    if (m_defragmenter->releaseBuffer(pData))
+        return;
+    m_memoryAllocator->destroyBuffer(pData->handle, pData->memory);
 }
 
 std::shared_ptr<Image> LogicalDevice::createImage(const ImageCreateInfoT ci) const
 {
+    auto out = std::make_shared<Image>();
+    out->info = ci;
+    out->layout = ci.initialLayout;
+
     VkImageCreateInfo createInfo = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .flags = 0,
@@ -700,23 +974,68 @@ std::shared_ptr<Image> LogicalDevice::createImage(const ImageCreateInfoT ci) con
         .initialLayout = ci.initialLayout,
     };
 
-    auto out = std::make_shared<Image>();
-    // TODO : create image handle
+    VkResult res = m_memoryAllocator->createImage(
+        createInfo, AllocationCreateInfoT{
+            .preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            .type = ci.allocationType,
+        },
+        &out->handle, &out->memory);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to create image : " << res << std::endl;
 
-    // TODO : allocate memory for image
+    return out;
+}
 
-    VmaAllocationCreateInfo allocInfo = {};
-    allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+void LogicalDevice::destroyImage(std::shared_ptr<Image>& pData) const
+{
+    // a later image may get the same handle, its views must not be found in the cache
+    m_objectCache->forgetImage(pData->handle);
+    m_memoryAllocator->destroyImage(pData->handle, pData->memory);
+}
 
-    // TODO : make allocator abstraction
-    vmaCreateImage(allocator, &createInfo, &allocInfo, &out->handle, &out->memory, nullptr);
+std::shared_ptr<Sampler> LogicalDevice::createSampler(const SamplerCreateInfoT ci) const
+{
+    auto out = std::make_shared<Sampler>();
+    out->info = ci;
+
+    // the feature is enabled at device creation when supported
+    const bool bAnisotropy =
+        ci.maxAnisotropy > 1.f && physicalHandle->getFeatures().samplerAnisotropy;
+    VkSamplerCreateInfo createInfo = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = ci.magFilter,
+        .minFilter = ci.minFilter,
+        .mipmapMode = ci.mipmapMode,
+        .addressModeU = ci.addressMode,
+        .addressModeV = ci.addressMode,
+        .addressModeW = ci.addressMode,
+        .mipLodBias = 0.f,
+        .anisotropyEnable = bAnisotropy ? VK_TRUE : VK_FALSE,
+        .maxAnisotropy = bAnisotropy ? std::min(ci.maxAnisotropy,
+                                                physicalHandle->getLimits().maxSamplerAnisotropy)
+                                     : 1.f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.f,
+        .maxLod = ci.maxLod,
+        .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    out->handle = m_objectCache->acquireSampler(ObjectCache::makeSamplerKey(ci), [&]() {
+        VkSampler handle = VK_NULL_HANDLE;
+        VkResult res = cx->CreateSampler(m_handle, &createInfo, nullptr, &handle);
+        if (res != VK_SUCCESS)
+            std::cerr << "Failed to create sampler : " << res << std::endl;
+        return handle;
+    });
 
     return out;
 }
 
-void LogicalDevice::destroyImage(std::shared_ptr<Image>& pData) const
+void LogicalDevice::destroySampler(std::shared_ptr<Sampler>& pData) const
 {
-    vmaDestroyImage(allocator, pData->handle, pData->memory);
+    m_objectCache->releaseSampler(pData->handle);
 }
 
 void LogicalDevice::retrieveQueues()
@@ -803,7 +1122,3 @@ void LogicalDevice::createCommandPools()
     }
 #endif
 }
-
-// TODO : move in an allocator implementation file
-#define VMA_IMPLEMENTATION
-#include <vk_mem_alloc.h>
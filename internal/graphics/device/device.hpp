@@ -1,11 +1,14 @@
 #pragma once
 
+#include <filesystem>
+#include <memory>
 #include <vector>
 
-#include <vk_mem_alloc.h>
 #include <vulkan/vulkan.h>
 
+#include "device/memory/memoryallocator.hpp"
 #include "physical_device.hpp"
+#include "symbols.hpp"
 
 class ContextABC;
 
@@ -27,6 +30,8 @@ class GPUShader;
 struct ShaderCreateInfoT;
 class Image;
 struct ImageCreateInfoT;
+class Sampler;
+struct SamplerCreateInfoT;
 struct BackBufferAOST;
 struct BackBufferSOAT;
 struct BackBufferCreateInfoT;
@@ -34,6 +39,17 @@ class Semaphore;
 struct SemaphoreCreateInfoT;
 class DescriptorBlock;
 struct DescriptorBlockCreateInfoT;
+class DescriptorAllocator;
+class BindlessTable;
+class Defragmenter;
+class ThreadPool;
+class ImageUploader;
+class PipelineCache;
+class PipelineStateCache;
+class ObjectCache;
+class PipelineCreationReport;
+class PipelineLibrary;
+struct PipelineHandlesT;
 
 struct LogicalDeviceCreateInfoT
 {
@@ -41,6 +57,18 @@ struct LogicalDeviceCreateInfoT
     const PhysicalDevice* physicalHandle;
     void* createInfo;
 
+    /**
+     * @brief directory where the pipeline cache is persisted
+     *
+     */
+    std::filesystem::path pipelineCacheDirectory = ".";
+
+    /**
+     * @brief backend of the device memory allocator
+     *
+     */
+    AllocatorBackendE allocatorBackend = AllocatorBackendE::VMA;
+
 } typedef DeviceCreateInfoT;
 
 class LogicalDevice
@@ -52,6 +80,11 @@ class LogicalDevice
   private:
     // TODO : abstraction handle
     VkDevice m_handle;
+    /**
+     * @brief functions of this device, called without going through the loader
+     *
+     */
+    DeviceDispatchT m_dispatch;
 
     std::vector<const char*> m_deviceExtensions;
 
@@ -60,9 +93,88 @@ class LogicalDevice
     void createCommandPools();
     void destroyCommandPools();
 
-    void createAllocator();
+    /**
+     * @brief every buffer and image memory is allocated from it
+     *
+     */
+    std::unique_ptr<MemoryAllocator> m_memoryAllocator;
+    /**
+     * @brief moves the buffers and images created movable when the memory gets fragmented
+     *
+     */
+    std::unique_ptr<Defragmenter> m_defragmenter;
+    /**
+     * @brief staging copies of the images loaded by other threads, recorded by the renderer
+     *
+     */
+    std::unique_ptr<ImageUploader> m_imageUploader;
+
+    void createAllocator(const AllocatorBackendE backend);
     void destroyAllocator();
 
+    /**
+     * @brief allocator of the descriptor sets living as long as their owner (sets can be freed)
+     *
+     */
+    std::unique_ptr<DescriptorAllocator> m_descriptorAllocator;
+    /**
+     * @brief only created when the descriptor indexing features are supported
+     *
+     */
+    std::unique_ptr<BindlessTable> m_bindlessTable;
+
+    std::unique_ptr<PipelineCache> m_pipelineCache;
+
+    void createPipelineCache(const std::filesystem::path& directory);
+    void destroyPipelineCache();
+
+    std::unique_ptr<PipelineStateCache> m_pipelineStateCache;
+    /**
+     * @brief samplers, image views, render passes and framebuffers shared by content
+     *
+     */
+    std::unique_ptr<ObjectCache> m_objectCache;
+
+    std::unique_ptr<PipelineCreationReport> m_pipelineCreationReport;
+
+    /**
+     * @brief only created when VK_EXT_graphics_pipeline_library is enabled
+     *
+     */
+    std::unique_ptr<PipelineLibrary> m_pipelineLibrary;
+
+    bool m_bShaderObjects = false;
+    bool m_bPushDescriptors = false;
+    bool m_bHostImageCopy = false;
+
+    /**
+     * @brief create the Vulkan pipeline object described by the create info, used by the pipeline
+     * state cache on a cache miss, fast linked from graphics pipeline libraries when available
+     * the creation feedback is recorded in the pipeline creation report
+     *
+     */
+    [[nodiscard]] PipelineHandlesT compilePipeline(const PipelineCreateInfoT& createInfo,
+                                                   const VkPipelineLayout layout,
+                                                   const VkPipelineCache cache,
+                                                   const std::size_t key) const;
+
+    /**
+     * @brief createPipeline compiling through the given pipeline cache, a worker thread must use
+     * its own cache
+     *
+     */
+    [[nodiscard]] std::unique_ptr<Pipeline> createPipelineWithCache(
+        const PipelineCreateInfoT& createInfo, const VkPipelineCache cache) const;
+
+    /**
+     * @brief create one linked VkShaderEXT per stage instead of a pipeline, the layouts of the
+     * pipeline must be created
+     *
+     * @return false if the driver refused the shaders, out has no shader object left
+     */
+    [[nodiscard]] bool createShaderObjects(const PipelineCreateInfoT& createInfo,
+                                           Pipeline& out) const;
+
   public:
     VkQueue graphicsQueue = nullptr;
     VkQueue presentQueue = nullptr;
@@ -94,10 +206,6 @@ class LogicalDevice
     VkCommandPool commandPoolEncode;
 #endif
 
-    // TODO : right now we are using the raw vma handle, create an abstraction to switch with any
-    // allocators
-    VmaAllocator allocator;
-
     LogicalDevice() = delete;
     LogicalDevice(const LogicalDeviceCreateInfoT createInfo);
     LogicalDevice(const LogicalDevice& copy) = delete;
@@ -107,6 +215,25 @@ class LogicalDevice
 
     ~LogicalDevice();
 
+    [[nodiscard]] bool isExtensionEnabled(const char* extensionName) const;
+    /**
+     * @brief VK_EXT_shader_object is enabled, pipelines can use PipelineBackendE::SHADER_OBJECT
+     *
+     */
+    [[nodiscard]] inline bool supportsShaderObjects() const { return m_bShaderObjects; }
+    /**
+     * @brief VK_KHR_push_descriptor is enabled, bPushDescriptor sets are pushed instead of being
+     * allocated per draw
+     *
+     */
+    [[nodiscard]] inline bool supportsPushDescriptors() const { return m_bPushDescriptors; }
+    /**
+     * @brief VK_EXT_host_image_copy is enabled, images can be written from the host (see
+     * ImageUploader::copyFromHost)
+     *
+     */
+    [[nodiscard]] inline bool supportsHostImageCopy() const { return m_bHostImageCopy; }
+
     void wait() const;
     void waitForGraphicsQueue() const;
     void waitForPresentQueue() const;
@@ -123,6 +250,12 @@ class LogicalDevice
      */
     void destroySwapChain(SwapChain& sc) const;
 
+    /**
+     * @brief image views, render passes, framebuffers and samplers are shared with every other
+     * object created with an identical create info (see ObjectCache), destroying one releases
+     * the shared handle, destroyed once the frames in flight are done with it
+     *
+     */
     [[nodiscard]] std::shared_ptr<ImageView> createImageView(
         const ImageViewCreateInfoT createInfo) const;
     void destroyImageView(std::shared_ptr<ImageView>& pData) const;
@@ -131,6 +264,10 @@ class LogicalDevice
         const RenderPassCreateInfoT createInfo) const;
     void destroyRenderPass(RenderPass* pData) const;
 
+    /**
+     * @brief shared by render pass compatibility, attachments and extent
+     *
+     */
     [[nodiscard]] std::shared_ptr<Framebuffer> createFramebuffer(
         const FramebufferCreateInfoT createInfo) const;
     void destroyFramebuffer(std::shared_ptr<Framebuffer>& pData) const;
@@ -138,8 +275,24 @@ class LogicalDevice
     [[nodiscard]] std::shared_ptr<GPUShader> createShader(const ShaderCreateInfoT createInfo) const;
     void destroyShader(std::shared_ptr<GPUShader>& pData) const;
 
+    /**
+     * @brief create a pipeline, the Vulkan pipeline, its layout and its set layouts are shared
+     * with every other pipeline created with an identical state
+     * null if its descriptor sets could not be allocated
+     *
+     */
     [[nodiscard]] std::unique_ptr<Pipeline> createPipeline(
         const PipelineCreateInfoT createInfo) const;
+    /**
+     * @brief create a batch of pipelines concurrently, the calling thread takes part in the work
+     * each worker compiles through its own pipeline cache, merged into the device cache afterwards
+     *
+     * @param threadPool workers helping the calling thread, it works alone if null
+     * @return the pipelines in the order of the create infos, null where createPipeline failed
+     */
+    [[nodiscard]] std::vector<std::unique_ptr<Pipeline>> createPipelines(
+        const std::vector<PipelineCreateInfoT>& createInfos,
+        ThreadPool* threadPool = nullptr) const;
     void destroyPipeline(Pipeline* pData) const;
 
     [[nodiscard]] std::shared_ptr<Semaphore> createSemaphore(
@@ -170,6 +323,9 @@ class LogicalDevice
     [[nodiscard]] std::shared_ptr<Image> createImage(const ImageCreateInfoT createInfo) const;
     void destroyImage(std::shared_ptr<Image>& pData) const;
 
+    [[nodiscard]] std::shared_ptr<Sampler> createSampler(const SamplerCreateInfoT createInfo) const;
+    void destroySampler(std::shared_ptr<Sampler>& pData) const;
+
     /**
      * @brief device "unique" creation function
      * adds too much complexity
@@ -199,5 +355,34 @@ class LogicalDevice
     [[nodiscard]] inline const VkDevice& getHandle() const { return m_handle; }
 
     [[nodiscard]] inline ContextABC* getContext() const { return cx; }
+    /**
+     * @brief to be preferred over the context in the loops recording or submitting commands
+     *
+     */
+    [[nodiscard]] inline const DeviceDispatchT* getDispatch() const { return &m_dispatch; }
+    [[nodiscard]] inline DeviceDispatchT* getDispatch() { return &m_dispatch; }
+    [[nodiscard]] inline const PhysicalDevice* getPhysicalDevice() const { return physicalHandle; }
+
+    [[nodiscard]] inline DescriptorAllocator* getDescriptorAllocator() const
+    {
+        return m_descriptorAllocator.get();
+    }
+    [[nodiscard]] inline BindlessTable* getBindlessTable() const { return m_bindlessTable.get(); }
+    [[nodiscard]] inline MemoryAllocator* getMemoryAllocator() const
+    {
+        return m_memoryAllocator.get();
+    }
+    [[nodiscard]] inline Defragmenter* getDefragmenter() const { return m_defragmenter.get(); }
+    [[nodiscard]] inline ImageUploader* getImageUploader() const { return m_imageUploader.get(); }
+    [[nodiscard]] inline PipelineCache* getPipelineCache() const { return m_pipelineCache.get(); }
+    [[nodiscard]] inline ObjectCache* getObjectCache() const { return m_objectCache.get(); }
+    [[nodiscard]] inline PipelineLibrary* getPipelineLibrary() const
+    {
+        return m_pipelineLibrary.get();
+    }
+    [[nodiscard]] inline PipelineCreationReport* getPipelineCreationReport() const
+    {
+        return m_pipelineCreationReport.get();
+    }
 
 } typedef Device;
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "allocator_benchmark.hpp"
+
+struct BenchmarkBufferT
+{
+    VkBuffer handle = VK_NULL_HANDLE;
+    std::shared_ptr<AllocationABC> memory;
+};
+
+AllocatorBenchmarkResultT runAllocatorBenchmark(AllocatorI& allocator,
+                                                const AllocatorBenchmarkInfoT& info)
+{
+    AllocatorBenchmarkResultT out;
+
+    std::mt19937 generator(info.seed);
+    std::uniform_real_distribution<double> sizeDistribution(std::log2(info.minSize),
+                                                            std::log2(info.maxSize));
+    std::uniform_int_distribution<uint32_t> slotDistribution(0U, info.liveCount - 1U);
+
+    std::chrono::nanoseconds allocateTime(0);
+    std::chrono::nanoseconds freeTime(0);
+    uint32_t freeCount = 0U;
+
+    auto allocate = [&](BenchmarkBufferT& buffer) {
+        VkBufferCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = static_cast<VkDeviceSize>(std::exp2(sizeDistribution(generator))),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        VkResult res = allocator.createBuffer(
+            createInfo, AllocationCreateInfoT{.requiredFlags = info.memoryPropertyFlags},
+            &buffer.handle, &buffer.memory);
+        allocateTime += std::chrono::steady_clock::now() - start;
+
+        ++out.allocationCount;
+        if (res != VK_SUCCESS)
+        {
+            ++out.failedCount;
+            buffer = {};
+        }
+    };
+    auto release = [&](BenchmarkBufferT& buffer) {
+        if (buffer.handle == VK_NULL_HANDLE)
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+        allocator.destroyBuffer(buffer.handle, buffer.memory);
+        freeTime += std::chrono::steady_clock::now() - start;
+
+        ++freeCount;
+        buffer = {};
+    };
+
+    std::vector<BenchmarkBufferT> buffers(info.liveCount);
+    for (auto& buffer : buffers)
+        allocate(buffer);
+
+    // random holes are punched and refilled with other sizes, which fragments the blocks
+    for (uint32_t i = 0; i < info.churnCount; ++i)
+    {
+        auto& buffer = buffers[slotDistribution(generator)];
+        release(buffer);
+        allocate(buffer);
+    }
+
+    out.stats = allocator.getStats();
+
+    for (auto& buffer : buffers)
+        release(buffer);
+
+    if (out.allocationCount > 0U)
+        out.allocateNanoseconds = static_cast<double>(allocateTime.count()) / out.allocationCount;
+    if (freeCount > 0U)
+        out.freeNanoseconds = static_cast<double>(freeTime.count()) / freeCount;
+    return out;
+}
+
+void printAllocatorBenchmark(const char* name, const AllocatorBenchmarkResultT& result)
+{
+    std::cout << name << " : " << result.allocationCount << " allocations ("
+              << result.failedCount << " failed), " << result.allocateNanoseconds
+              << " ns per allocation, " << result.freeNanoseconds << " ns per free, "
+              << result.stats.blockCount << " blocks (" << result.stats.dedicatedAllocationCount
+              << " dedicated), " << (result.stats.reservedBytes >> 20) << " MiB reserved for "
+              << (result.stats.usedBytes >> 20) << " MiB used, fragmentation "
+              << result.stats.getFragmentation() << std::endl;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "memoryallocator.hpp"
+
+struct AllocatorBenchmarkInfoT
+{
+    /**
+     * @brief resources alive at the same time once the warm up is done
+     *
+     */
+    uint32_t liveCount = 2048U;
+    /**
+     * @brief random free then allocate pairs after the warm up
+     *
+     */
+    uint32_t churnCount = 20000U;
+    VkDeviceSize minSize = 256U;
+    VkDeviceSize maxSize = 4ULL << 20;
+    VkMemoryPropertyFlags memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    uint32_t seed = 1U;
+};
+
+struct AllocatorBenchmarkResultT
+{
+    uint32_t allocationCount = 0U;
+    uint32_t failedCount = 0U;
+    /**
+     * @brief average, buffer creation included (the same for every backend)
+     *
+     */
+    double allocateNanoseconds = 0.0;
+    double freeNanoseconds = 0.0;
+    /**
+     * @brief taken after the churn, before the resources are released
+     *
+     */
+    AllocatorStatsT stats;
+};
+
+/**
+ * @brief allocate and free buffers of random log-uniform sizes through the allocator, the same
+ * seed produces the same sequence so that backends can be compared
+ *
+ */
+[[nodiscard]] AllocatorBenchmarkResultT runAllocatorBenchmark(AllocatorI& allocator,
+                                                              const AllocatorBenchmarkInfoT& info);
+
+void printAllocatorBenchmark(const char* name, const AllocatorBenchmarkResultT& result);
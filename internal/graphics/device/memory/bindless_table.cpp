@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+
+#include "bindless_table.hpp"
+
+/**
+ * @brief per stage resources left to the descriptor sets bound along with the bindless set
+ *
+ */
+static constexpr uint32_t kReservedPerStageResources = 64U;
+
+static constexpr VkDescriptorType kBindlessTypes[] = {
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+
+BindlessTable::BindlessTable(const BindlessTableCreateInfoT createInfo)
+    : ci(createInfo), m_writer(createInfo.device)
+{
+    auto* cx = ci.device->getContext();
+    const auto& props = ci.device->getPhysicalDevice()->getDescriptorIndexingProperties();
+
+    // the bindings are visible to every stage, the per stage limits apply to each of them
+    auto& capacities = ci.capacities;
+    capacities[0] = std::min({capacities[0], props.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                              props.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+    capacities[1] = std::min({capacities[1], props.maxDescriptorSetUpdateAfterBindSampledImages,
+                              props.maxPerStageDescriptorUpdateAfterBindSampledImages});
+    capacities[2] = std::min({capacities[2], props.maxDescriptorSetUpdateAfterBindSamplers,
+                              props.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+    // samplers are not resources, buffers and images share what the other sets leave
+    const uint32_t resourceBudget =
+        props.maxPerStageUpdateAfterBindResources > kReservedPerStageResources
+            ? props.maxPerStageUpdateAfterBindResources - kReservedPerStageResources
+            : 0U;
+    const uint64_t resourceCount = uint64_t(capacities[0]) + capacities[1];
+    if (resourceCount > resourceBudget)
+    {
+        capacities[0] = static_cast<uint32_t>(capacities[0] * uint64_t(resourceBudget) /
+                                              resourceCount);
+        capacities[1] = resourceBudget - capacities[0];
+    }
+
+    std::array<VkDescriptorSetLayoutBinding, static_cast<size_t>(BindlessBindingE::COUNT)>
+        bindings;
+    std::array<VkDescriptorBindingFlags, static_cast<size_t>(BindlessBindingE::COUNT)> flags;
+    std::array<VkDescriptorPoolSize, static_cast<size_t>(BindlessBindingE::COUNT)> poolSizes;
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i] = {
+            .binding = i,
+            .descriptorType = kBindlessTypes[i],
+            .descriptorCount = capacities[i],
+            .stageFlags = VK_SHADER_STAGE_ALL,
+        };
+        // unused descriptors stay unwritten, registrations happen while the set is in use
+        flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                   VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                   VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        poolSizes[i] = {.type = kBindlessTypes[i], .descriptorCount = capacities[i]};
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlags = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(flags.size()),
+        .pBindingFlags = flags.data(),
+    };
+    VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlags,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+    VkResult res =
+        cx->CreateDescriptorSetLayout(ci.device->getHandle(), &layoutCreateInfo, nullptr,
+                                      &m_setLayout);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create bindless descriptor set layout : " << res << std::endl;
+        return;
+    }
+
+    VkDescriptorPoolCreateInfo poolCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+    res = cx->CreateDescriptorPool(ci.device->getHandle(), &poolCreateInfo, nullptr, &m_pool);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create bindless descriptor pool : " << res << std::endl;
+        return;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_setLayout,
+    };
+    res = cx->AllocateDescriptorSets(ci.device->getHandle(), &allocInfo, &m_set);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to allocate bindless descriptor set : " << res << std::endl;
+}
+
+BindlessTable::~BindlessTable()
+{
+    auto* cx = ci.device->getContext();
+    if (m_pool != VK_NULL_HANDLE)
+        cx->DestroyDescriptorPool(ci.device->getHandle(), m_pool, nullptr);
+    if (m_setLayout != VK_NULL_HANDLE)
+        cx->DestroyDescriptorSetLayout(ci.device->getHandle(), m_setLayout, nullptr);
+}
+
+uint32_t BindlessTable::acquireIndex(const BindlessBindingE binding)
+{
+    auto& slots = m_slots[static_cast<size_t>(binding)];
+    if (!slots.freeIndices.empty())
+    {
+        uint32_t index = slots.freeIndices.back();
+        slots.freeIndices.pop_back();
+        return index;
+    }
+    if (slots.next < ci.capacities[static_cast<size_t>(binding)])
+        return slots.next++;
+
+    std::cerr << "Bindless table is full" << std::endl;
+    return kInvalidBindlessIndex;
+}
+
+uint32_t BindlessTable::registerBuffer(const VkBuffer buffer, const VkDeviceSize offset,
+                                       const VkDeviceSize range)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    uint32_t index = acquireIndex(BindlessBindingE::STORAGE_BUFFER);
+    if (index != kInvalidBindlessIndex)
+    {
+        m_writer.writeBuffer(m_set, static_cast<uint32_t>(BindlessBindingE::STORAGE_BUFFER),
+                             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffer, offset, range, index);
+    }
+    return index;
+}
+
+uint32_t BindlessTable::registerImage(const VkImageView view, const VkImageLayout layout)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    uint32_t index = acquireIndex(BindlessBindingE::SAMPLED_IMAGE);
+    if (index != kInvalidBindlessIndex)
+    {
+        m_writer.writeImage(m_set, static_cast<uint32_t>(BindlessBindingE::SAMPLED_IMAGE),
+                            VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, view, VK_NULL_HANDLE, layout, index);
+    }
+    return index;
+}
+
+uint32_t BindlessTable::registerSampler(const VkSampler sampler)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    uint32_t index = acquireIndex(BindlessBindingE::SAMPLER);
+    if (index != kInvalidBindlessIndex)
+    {
+        m_writer.writeImage(m_set, static_cast<uint32_t>(BindlessBindingE::SAMPLER),
+                            VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, sampler,
+                            VK_IMAGE_LAYOUT_UNDEFINED, index);
+    }
+    return index;
+}
+
+void BindlessTable::release(const BindlessBindingE binding, const uint32_t index)
+{
+    if (index == kInvalidBindlessIndex)
+        return;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_retired.push_back(RetiredIndexT{
+        .binding = binding,
+        .index = index,
+        .flushIndex = m_flushIndex,
+    });
+}
+
+void BindlessTable::flush()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_writer.flush();
+
+    ++m_flushIndex;
+    while (!m_retired.empty() && m_retired.front().flushIndex + ci.framesInFlight <= m_flushIndex)
+    {
+        const auto& retired = m_retired.front();
+        m_slots[static_cast<size_t>(retired.binding)].freeIndices.push_back(retired.index);
+        m_retired.pop_front();
+    }
+}
+
+void BindlessTable::bind(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint bindPoint,
+                         const VkPipelineLayout layout, const uint32_t setIndex) const
+{
+    ci.device->getDispatch()->CmdBindDescriptorSets(commandBuffer, bindPoint, layout, setIndex,
+                                                    1, &m_set, 0, nullptr);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "descriptor_writer.hpp"
+
+class LogicalDevice;
+
+/**
+ * @brief bindings of the bindless set, shaders declare one unsized array per binding
+ *
+ */
+enum class BindlessBindingE : uint32_t
+{
+    STORAGE_BUFFER = 0,
+    SAMPLED_IMAGE = 1,
+    SAMPLER = 2,
+
+    COUNT = 3,
+};
+
+constexpr uint32_t kInvalidBindlessIndex = UINT32_MAX;
+
+struct BindlessTableCreateInfoT
+{
+    const LogicalDevice* device;
+
+    /**
+     * @brief descriptor count of each binding, clamped to the update after bind limits of the set
+     * and of a single stage
+     *
+     */
+    std::array<uint32_t, static_cast<size_t>(BindlessBindingE::COUNT)> capacities = {
+        65536U,
+        16384U,
+        256U,
+    };
+
+    /**
+     * @brief a released index is only reused this many flushes later, when no frame in flight can
+     * still read it
+     *
+     */
+    uint32_t framesInFlight = 3U;
+};
+
+/**
+ * @brief one large update after bind descriptor set of storage buffers, sampled images and
+ * samplers (descriptor indexing, core in Vulkan 1.2)
+ * resources are registered once and addressed by their index from push constants or instance
+ * data, the set is bound once per command buffer instead of binding sets per draw
+ * registrations are written when flush is called, once per frame, thread safe
+ *
+ */
+class BindlessTable
+{
+  private:
+    BindlessTableCreateInfoT ci;
+
+  private:
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_set = VK_NULL_HANDLE;
+
+    std::mutex m_mutex;
+    DescriptorWriter m_writer;
+
+    struct SlotsT
+    {
+        uint32_t next = 0U;
+        std::vector<uint32_t> freeIndices;
+    };
+    std::array<SlotsT, static_cast<size_t>(BindlessBindingE::COUNT)> m_slots;
+
+    struct RetiredIndexT
+    {
+        BindlessBindingE binding;
+        uint32_t index;
+        uint64_t flushIndex;
+    };
+    std::deque<RetiredIndexT> m_retired;
+    uint64_t m_flushIndex = 0U;
+
+    [[nodiscard]] uint32_t acquireIndex(const BindlessBindingE binding);
+
+  public:
+    BindlessTable() = delete;
+    BindlessTable(const BindlessTable&) = delete;
+    BindlessTable& operator=(const BindlessTable&) = delete;
+    BindlessTable(BindlessTable&&) = delete;
+    BindlessTable& operator=(BindlessTable&&) = delete;
+
+    explicit BindlessTable(const BindlessTableCreateInfoT createInfo);
+    ~BindlessTable();
+
+    /**
+     * @return the index of the buffer in the storage buffer array, kInvalidBindlessIndex if the
+     * table is full
+     */
+    [[nodiscard]] uint32_t registerBuffer(const VkBuffer buffer, const VkDeviceSize offset = 0,
+                                          const VkDeviceSize range = VK_WHOLE_SIZE);
+    [[nodiscard]] uint32_t registerImage(
+        const VkImageView view,
+        const VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    [[nodiscard]] uint32_t registerSampler(const VkSampler sampler);
+
+    /**
+     * @brief the index can be reused once the frames in flight are done with it
+     *
+     */
+    void release(const BindlessBindingE binding, const uint32_t index);
+
+    /**
+     * @brief write the registrations of this frame, to be called once per frame before submission
+     *
+     */
+    void flush();
+
+    void bind(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint bindPoint,
+              const VkPipelineLayout layout, const uint32_t setIndex = 0U) const;
+
+  public:
+    [[nodiscard]] inline const VkDescriptorSetLayout& getSetLayout() const { return m_setLayout; }
+    [[nodiscard]] inline const VkDescriptorSet& getSet() const { return m_set; }
+    [[nodiscard]] inline uint32_t getCapacity(const BindlessBindingE binding) const
+    {
+        return ci.capacities[static_cast<size_t>(binding)];
+    }
+};
@@ -17,6 +17,7 @@ UniformBuffer::UniformBuffer(std::shared_ptr<DescriptorCreateInfoT> createInfo)
         .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
         .memoryPropertyFlags =
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        .allocationType = AllocationTypeE::UNIFORM,
     });
     ci->devicePtr->mapBufferMemory(buffer, &mappedMemory);
 }
@@ -2,9 +2,8 @@
 
 #include <vulkan/vulkan.h>
 
-#include <vk_mem_alloc.h>
-
 #include "descriptor.hpp"
+#include "memoryallocator.hpp"
 
 struct BufferCreateInfoT
 {
@@ -12,15 +11,29 @@ struct BufferCreateInfoT
     VkBufferUsageFlags usage;
     VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     VkMemoryPropertyFlags memoryPropertyFlags;
+    /**
+     * @brief the device defragmenter may move the buffer, its handle then changes between frames
+     * only for device local buffers whose users read the handle when recording
+     *
+     */
+    bool bMovable = false;
+    AllocationTypeE allocationType = AllocationTypeE::OTHER;
 };
 
 class Buffer
 {
   public:
     VkDeviceSize size;
-    // TODO : make allocation abstraction
-    VmaAllocation memory;
+    VkBufferUsageFlags usage;
+    VkSharingMode sharingMode;
+    std::shared_ptr<AllocationABC> memory;
     VkBuffer handle;
+    /**
+     * @brief incremented each time the buffer is moved, objects made from the handle (descriptor
+     * writes, views) are rebuilt when it changes
+     *
+     */
+    uint32_t generation = 0U;
 };
 
 struct UniformBufferCreateInfoT : public DescriptorCreateInfoT
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+
+#include "buffer.hpp"
+
+#include "defragmenter.hpp"
+
+Defragmenter::Defragmenter(const DefragmenterCreateInfoT createInfo) : ci(createInfo) {}
+
+Defragmenter::~Defragmenter()
+{
+    if (m_bPassInProgress)
+    {
+        ci.device->wait();
+        endPass();
+    }
+
+    if (m_passCount > 0U)
+    {
+        std::cout << "Defragmentation : " << m_movedCount << " moves (" << (m_movedBytes >> 20)
+                  << " MiB) in " << m_passCount << " passes" << std::endl;
+    }
+}
+
+void Defragmenter::registerBuffer(const std::shared_ptr<Buffer>& buffer)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_buffers[buffer->memory.get()] = buffer;
+}
+
+bool Defragmenter::isMoving(const AllocationABC* allocation) const
+{
+    return std::any_of(m_moves.begin(), m_moves.end(), [allocation](const auto& move) {
+        return !move.bIgnore && move.source == allocation;
+    });
+}
+
+bool Defragmenter::releaseBuffer(const std::shared_ptr<Buffer>& buffer)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_buffers.erase(buffer->memory.get()) == 0U)
+        return false;
+
+    if (!isMoving(buffer->memory.get()))
+        return false;
+    m_deferredReleases.push_back(buffer);
+    return true;
+}
+
+bool Defragmenter::moveBuffer(const VkCommandBuffer commandBuffer,
+                              const DefragmentationMoveT& move, Buffer& buffer,
+                              VkBuffer* oldBuffer)
+{
+    auto* cx = ci.device->getContext();
+
+    VkBufferCreateInfo createInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = buffer.size,
+        .usage = buffer.usage,
+        .sharingMode = buffer.sharingMode,
+    };
+    VkBuffer handle = VK_NULL_HANDLE;
+    VkResult res = cx->CreateBuffer(ci.device->getHandle(), &createInfo, nullptr, &handle);
+    if (res != VK_SUCCESS)
+        return false;
+    res = ci.device->getMemoryAllocator()->bindBufferMemory(*move.destination, handle);
+    if (res != VK_SUCCESS)
+    {
+        cx->DestroyBuffer(ci.device->getHandle(), handle, nullptr);
+        return false;
+    }
+
+    VkBufferCopy region = {
+        .srcOffset = 0U,
+        .dstOffset = 0U,
+        .size = buffer.size,
+    };
+    cx->CmdCopyBuffer(commandBuffer, buffer.handle, handle, 1, &region);
+
+    *oldBuffer = buffer.handle;
+    buffer.handle = handle;
+    ++buffer.generation;
+    return true;
+}
+
+void Defragmenter::beginPass(const VkCommandBuffer commandBuffer, const uint32_t frameIndex)
+{
+    auto* cx = ci.device->getContext();
+    auto* allocator = ci.device->getMemoryAllocator();
+
+    if (!allocator->beginDefragmentationPass(ci.bytesPerFrame, &m_moves))
+    {
+        m_bRunning = false;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_moveBuffers.assign(m_moves.size(), nullptr);
+    m_oldBuffers.assign(m_moves.size(), VK_NULL_HANDLE);
+
+    // writes of the previous frames reach the sources before they are copied
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+    };
+    cx->CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                           nullptr);
+
+    // only the registered buffers can be recreated, the allocator keeps the other allocations in
+    // place
+    uint32_t movedCount = 0U;
+    for (size_t i = 0; i < m_moves.size(); ++i)
+    {
+        auto& move = m_moves[i];
+        auto it = move.bIgnore ? m_buffers.end() : m_buffers.find(move.source);
+        if (it == m_buffers.end())
+        {
+            move.bIgnore = true;
+            continue;
+        }
+
+        const std::shared_ptr<Buffer>& buffer = it->second;
+        move.bIgnore = !moveBuffer(commandBuffer, move, *buffer, &m_oldBuffers[i]);
+        if (move.bIgnore)
+            continue;
+
+        m_moveBuffers[i] = buffer;
+        ++movedCount;
+        m_movedBytes += move.source->size;
+    }
+    m_movedCount += movedCount;
+
+    // the moved content is visible to the draws of this frame
+    barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+    };
+    cx->CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                           nullptr);
+
+    ++m_passCount;
+    m_bPassInProgress = true;
+    m_passFrameIndex = frameIndex;
+
+    // what is left to move cannot be moved, the pass has nothing for the device to wait on
+    if (movedCount == 0U)
+    {
+        lock.unlock();
+        endPass();
+        m_bRunning = false;
+    }
+}
+
+void Defragmenter::endPass()
+{
+    auto* cx = ci.device->getContext();
+    auto* allocator = ci.device->getMemoryAllocator();
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    for (size_t i = 0; i < m_moves.size(); ++i)
+    {
+        if (m_oldBuffers[i] != VK_NULL_HANDLE)
+            cx->DestroyBuffer(ci.device->getHandle(), m_oldBuffers[i], nullptr);
+    }
+
+    // the sources describe their new placement from now on
+    allocator->endDefragmentationPass(m_moves);
+    m_moves.clear();
+    m_moveBuffers.clear();
+    m_oldBuffers.clear();
+
+    for (auto& buffer : m_deferredReleases)
+        allocator->destroyBuffer(buffer->handle, buffer->memory);
+    m_deferredReleases.clear();
+
+    m_bPassInProgress = false;
+}
+
+void Defragmenter::record(const VkCommandBuffer commandBuffer, const uint32_t frameIndex)
+{
+    ++m_frameCount;
+
+    // the frame that recorded the pass and every frame before it are done
+    if (m_bPassInProgress && m_passFrameIndex == frameIndex)
+        endPass();
+    if (m_bPassInProgress)
+        return;
+
+    if (!m_bRunning)
+    {
+        if (m_frameCount % ci.checkInterval != 0U)
+            return;
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            if (m_buffers.empty())
+                return;
+        }
+        if (ci.device->getMemoryAllocator()->getStats().getFragmentation() <
+            ci.fragmentationThreshold)
+            return;
+        m_bRunning = true;
+    }
+
+    beginPass(commandBuffer, frameIndex);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "memoryallocator.hpp"
+
+class LogicalDevice;
+class Buffer;
+
+struct DefragmenterCreateInfoT
+{
+    const LogicalDevice* device;
+
+    /**
+     * @brief bytes copied by the moves recorded in a single frame
+     *
+     */
+    VkDeviceSize bytesPerFrame = 16ULL << 20;
+    /**
+     * @brief AllocatorStatsT::getFragmentation above which passes are started
+     *
+     */
+    double fragmentationThreshold = 0.3;
+    /**
+     * @brief frames between two fragmentation checks while no pass runs
+     *
+     */
+    uint32_t checkInterval = 120U;
+};
+
+/**
+ * @brief background compaction of the device memory
+ * buffers created movable are allocated apart and registered by the device, once the memory is
+ * too fragmented the allocator proposes moves of the movable allocations in passes of at most
+ * bytesPerFrame, the buffers are recreated on their new placement, their content copied by the
+ * frame command buffer and their handle swapped in place (Buffer::handle, generation
+ * incremented), so users reading the handle when recording follow the move
+ * images are never moved, the views and bindless entries made from their handle would outlive it
+ * a pass ends when its frame slot comes back, the device is then done with the copies and with
+ * every frame that used the old handles, which are destroyed with the old placement
+ * not thread safe besides registration and release, the render thread records it
+ *
+ */
+class Defragmenter
+{
+  private:
+    const DefragmenterCreateInfoT ci;
+
+  private:
+    std::mutex m_mutex;
+    std::unordered_map<const AllocationABC*, std::shared_ptr<Buffer>> m_buffers;
+
+    /**
+     * @brief pass in progress, the buffers and their old handle follow the moves
+     *
+     */
+    std::vector<DefragmentationMoveT> m_moves;
+    std::vector<std::shared_ptr<Buffer>> m_moveBuffers;
+    std::vector<VkBuffer> m_oldBuffers;
+    /**
+     * @brief moved buffers released during the pass, destroyed when it ends
+     *
+     */
+    std::vector<std::shared_ptr<Buffer>> m_deferredReleases;
+
+    bool m_bPassInProgress = false;
+    uint32_t m_passFrameIndex = 0U;
+    bool m_bRunning = false;
+    uint64_t m_frameCount = 0U;
+
+    uint64_t m_passCount = 0U;
+    uint64_t m_movedCount = 0U;
+    VkDeviceSize m_movedBytes = 0U;
+
+    [[nodiscard]] bool moveBuffer(const VkCommandBuffer commandBuffer,
+                                  const DefragmentationMoveT& move, Buffer& buffer,
+                                  VkBuffer* oldBuffer);
+
+    void beginPass(const VkCommandBuffer commandBuffer, const uint32_t frameIndex);
+    void endPass();
+
+    [[nodiscard]] bool isMoving(const AllocationABC* allocation) const;
+
+  public:
+    Defragmenter() = delete;
+    Defragmenter(const Defragmenter&) = delete;
+    Defragmenter& operator=(const Defragmenter&) = delete;
+    Defragmenter(Defragmenter&&) = delete;
+    Defragmenter& operator=(Defragmenter&&) = delete;
+
+    explicit Defragmenter(const DefragmenterCreateInfoT createInfo);
+    /**
+     * @brief a pass in progress is ended after waiting for the device
+     *
+     */
+    ~Defragmenter();
+
+    void registerBuffer(const std::shared_ptr<Buffer>& buffer);
+    /**
+     * @return true if the buffer is moved by the pass in progress, it is then destroyed when the
+     * pass ends and must not be destroyed by the caller
+     */
+    [[nodiscard]] bool releaseBuffer(const std::shared_ptr<Buffer>& buffer);
+
+    /**
+     * @brief end the pass recorded in this frame slot and record the moves of the next one, must be
+     * recorded outside of a render pass, after the fence of the frame was waited on
+     *
+     */
+    void record(const VkCommandBuffer commandBuffer, const uint32_t frameIndex);
+
+  public:
+    [[nodiscard]] inline bool isRunning() const { return m_bRunning; }
+    [[nodiscard]] inline uint64_t getPassCount() const { return m_passCount; }
+    [[nodiscard]] inline uint64_t getMovedCount() const { return m_movedCount; }
+    [[nodiscard]] inline VkDeviceSize getMovedBytes() const { return m_movedBytes; }
+};
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+
+#include "descriptor_allocator.hpp"
+
+DescriptorAllocator::DescriptorAllocator(const DescriptorAllocatorCreateInfoT createInfo)
+    : ci(createInfo), m_setsPerPool(createInfo.initialSetsPerPool)
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    auto* cx = ci.device->getContext();
+    for (VkDescriptorPool pool : m_fullPools)
+        cx->DestroyDescriptorPool(ci.device->getHandle(), pool, nullptr);
+    for (VkDescriptorPool pool : m_readyPools)
+        cx->DestroyDescriptorPool(ci.device->getHandle(), pool, nullptr);
+}
+
+VkDescriptorPool DescriptorAllocator::createPool(const uint32_t setCount) const
+{
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    poolSizes.reserve(ci.ratios.size());
+    for (const auto& r : ci.ratios)
+    {
+        poolSizes.push_back(VkDescriptorPoolSize{
+            .type = r.type,
+            .descriptorCount = std::max(1U, static_cast<uint32_t>(std::ceil(r.ratio * setCount))),
+        });
+    }
+
+    VkDescriptorPoolCreateInfo createInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = ci.flags,
+        .maxSets = setCount,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    VkDescriptorPool out = VK_NULL_HANDLE;
+    VkResult res =
+        ci.device->getContext()->CreateDescriptorPool(ci.device->getHandle(), &createInfo, nullptr,
+                                                      &out);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create descriptor pool : " << res << std::endl;
+        return VK_NULL_HANDLE;
+    }
+    return out;
+}
+
+VkDescriptorPool DescriptorAllocator::acquirePool()
+{
+    if (!m_readyPools.empty())
+        return m_readyPools.back();
+    return addPool();
+}
+
+VkDescriptorPool DescriptorAllocator::addPool()
+{
+    VkDescriptorPool pool = createPool(m_setsPerPool);
+    if (pool == VK_NULL_HANDLE)
+        return VK_NULL_HANDLE;
+
+    m_setsPerPool = std::min(ci.maxSetsPerPool,
+                             static_cast<uint32_t>(m_setsPerPool * ci.growthFactor));
+    m_readyPools.push_back(pool);
+    return pool;
+}
+
+bool DescriptorAllocator::allocate(const VkDescriptorSetLayout* layouts, const uint32_t count,
+                                   VkDescriptorSet* out, VkDescriptorPool* pool)
+{
+    auto* cx = ci.device->getContext();
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorSetCount = count,
+        .pSetLayouts = layouts,
+    };
+
+    // a pool that cannot hold the sets is considered full, the retry is made on a new pool so a
+    // second failure means the sets do not fit in an empty pool, which stays ready for others
+    VkResult res = VK_ERROR_OUT_OF_POOL_MEMORY;
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        allocInfo.descriptorPool = attempt == 0 ? acquirePool() : addPool();
+        if (allocInfo.descriptorPool == VK_NULL_HANDLE)
+            return false;
+
+        res = cx->AllocateDescriptorSets(ci.device->getHandle(), &allocInfo, out);
+        if (res != VK_ERROR_OUT_OF_POOL_MEMORY && res != VK_ERROR_FRAGMENTED_POOL)
+            break;
+        if (attempt > 0)
+            break;
+
+        m_fullPools.push_back(allocInfo.descriptorPool);
+        m_readyPools.pop_back();
+    }
+
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to allocate descriptor sets : " << res << std::endl;
+        return false;
+    }
+
+    m_allocatedSetCount += count;
+    if (pool)
+        *pool = allocInfo.descriptorPool;
+    return true;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(const VkDescriptorSetLayout layout)
+{
+    VkDescriptorSet out = VK_NULL_HANDLE;
+    allocate(&layout, 1U, &out);
+    return out;
+}
+
+void DescriptorAllocator::free(const VkDescriptorPool pool, const uint32_t count,
+                               const VkDescriptorSet* sets)
+{
+    if (!(ci.flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) || count == 0)
+        return;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    VkResult res = ci.device->getContext()->FreeDescriptorSets(ci.device->getHandle(), pool,
+                                                               count, sets);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to free descriptor sets : " << res << std::endl;
+        return;
+    }
+    m_allocatedSetCount -= count;
+
+    // the pool has room again
+    auto it = std::find(m_fullPools.begin(), m_fullPools.end(), pool);
+    if (it != m_fullPools.end())
+    {
+        m_fullPools.erase(it);
+        m_readyPools.insert(m_readyPools.begin(), pool);
+    }
+}
+
+void DescriptorAllocator::reset()
+{
+    auto* cx = ci.device->getContext();
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    m_readyPools.insert(m_readyPools.end(), m_fullPools.begin(), m_fullPools.end());
+    m_fullPools.clear();
+    for (VkDescriptorPool pool : m_readyPools)
+        cx->ResetDescriptorPool(ci.device->getHandle(), pool, 0);
+
+    m_allocatedSetCount = 0U;
+}
+
+uint32_t DescriptorAllocator::getPoolCount() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return static_cast<uint32_t>(m_fullPools.size() + m_readyPools.size());
+}
+
+uint64_t DescriptorAllocator::getAllocatedSetCount() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_allocatedSetCount;
+}
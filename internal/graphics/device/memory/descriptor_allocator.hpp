@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+
+/**
+ * @brief number of descriptors of a type reserved per descriptor set in a pool
+ *
+ */
+struct DescriptorPoolRatioT
+{
+    VkDescriptorType type;
+    float ratio;
+};
+
+struct DescriptorAllocatorCreateInfoT
+{
+    const LogicalDevice* device;
+
+    std::vector<DescriptorPoolRatioT> ratios = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         2.f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         2.f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          2.f},
+        {VK_DESCRIPTOR_TYPE_SAMPLER,                1.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          1.f},
+    };
+
+    /**
+     * @brief set count of the first pool, each new pool is growthFactor times larger than the
+     * previous one up to maxSetsPerPool
+     *
+     */
+    uint32_t initialSetsPerPool = 64U;
+    uint32_t maxSetsPerPool = 4096U;
+    float growthFactor = 1.5f;
+
+    /**
+     * @brief VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT allows sets to be freed one by one,
+     * transient allocators leave it out and are reset as a whole
+     *
+     */
+    VkDescriptorPoolCreateFlags flags = 0;
+};
+
+/**
+ * @brief descriptor set allocator over a chain of descriptor pools
+ * sets are allocated from the last pool with free space, a larger pool is created when every pool
+ * is full, pools are never destroyed before the allocator
+ * thread safe
+ *
+ */
+class DescriptorAllocator
+{
+  private:
+    const DescriptorAllocatorCreateInfoT ci;
+
+  private:
+    mutable std::mutex m_mutex;
+
+    std::vector<VkDescriptorPool> m_fullPools;
+    std::vector<VkDescriptorPool> m_readyPools;
+    uint32_t m_setsPerPool;
+
+    uint64_t m_allocatedSetCount = 0U;
+
+    [[nodiscard]] VkDescriptorPool createPool(const uint32_t setCount) const;
+    /**
+     * @brief create the next pool of the chain as the last ready pool, the mutex must be held
+     *
+     */
+    [[nodiscard]] VkDescriptorPool addPool();
+    /**
+     * @brief last ready pool or a new one, the mutex must be held
+     *
+     */
+    [[nodiscard]] VkDescriptorPool acquirePool();
+
+  public:
+    DescriptorAllocator() = delete;
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+    DescriptorAllocator(DescriptorAllocator&&) = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator&&) = delete;
+
+    explicit DescriptorAllocator(const DescriptorAllocatorCreateInfoT createInfo);
+    ~DescriptorAllocator();
+
+    /**
+     * @brief allocate one set per layout, all from the same pool
+     *
+     * @param pool if not null, receives the pool the sets were allocated from (needed by free)
+     * @return false if the sets could not be allocated even from a new pool
+     */
+    bool allocate(const VkDescriptorSetLayout* layouts, const uint32_t count, VkDescriptorSet* out,
+                  VkDescriptorPool* pool = nullptr);
+    [[nodiscard]] VkDescriptorSet allocate(const VkDescriptorSetLayout layout);
+
+    /**
+     * @brief only for allocators created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+     *
+     */
+    void free(const VkDescriptorPool pool, const uint32_t count, const VkDescriptorSet* sets);
+
+    /**
+     * @brief return every set to its pool, the sets must not be in use by the device anymore
+     *
+     */
+    void reset();
+
+  public:
+    [[nodiscard]] uint32_t getPoolCount() const;
+    [[nodiscard]] uint64_t getAllocatedSetCount() const;
+};
@@ -0,0 +1,164 @@
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+
+#include "descriptor_writer.hpp"
+
+void DescriptorWriter::writeBuffer(const VkDescriptorSet set, const uint32_t binding,
+                                   const VkDescriptorType type, const VkBuffer buffer,
+                                   const VkDeviceSize offset, const VkDeviceSize range,
+                                   const uint32_t arrayElement)
+{
+    m_infoIndices.push_back(static_cast<uint32_t>(m_bufferInfos.size()));
+    m_bufferInfos.push_back(VkDescriptorBufferInfo{
+        .buffer = buffer,
+        .offset = offset,
+        .range = range,
+    });
+    m_writes.push_back(VkWriteDescriptorSet{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = set,
+        .dstBinding = binding,
+        .dstArrayElement = arrayElement,
+        .descriptorCount = 1,
+        .descriptorType = type,
+    });
+}
+
+void DescriptorWriter::writeImage(const VkDescriptorSet set, const uint32_t binding,
+                                  const VkDescriptorType type, const VkImageView view,
+                                  const VkSampler sampler, const VkImageLayout layout,
+                                  const uint32_t arrayElement)
+{
+    m_infoIndices.push_back(static_cast<uint32_t>(m_imageInfos.size()));
+    m_imageInfos.push_back(VkDescriptorImageInfo{
+        .sampler = sampler,
+        .imageView = view,
+        .imageLayout = layout,
+    });
+    m_writes.push_back(VkWriteDescriptorSet{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = set,
+        .dstBinding = binding,
+        .dstArrayElement = arrayElement,
+        .descriptorCount = 1,
+        .descriptorType = type,
+    });
+}
+
+void DescriptorWriter::flush()
+{
+    if (m_writes.empty())
+        return;
+
+    // the info arrays do not move anymore, the writes can point into them
+    for (int i = 0; i < m_writes.size(); ++i)
+    {
+        auto& write = m_writes[i];
+        switch (write.descriptorType)
+        {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+            write.pImageInfo = &m_imageInfos[m_infoIndices[i]];
+            break;
+        default:
+            write.pBufferInfo = &m_bufferInfos[m_infoIndices[i]];
+            break;
+        }
+    }
+
+    m_device->getContext()->UpdateDescriptorSets(m_device->getHandle(),
+                                                 static_cast<uint32_t>(m_writes.size()),
+                                                 m_writes.data(), 0, nullptr);
+    ++m_flushCount;
+    m_flushedWriteCount += m_writes.size();
+
+    clear();
+}
+
+void DescriptorWriter::clear()
+{
+    m_writes.clear();
+    m_infoIndices.clear();
+    m_bufferInfos.clear();
+    m_imageInfos.clear();
+}
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(
+    const DescriptorUpdateTemplateCreateInfoT createInfo)
+    : ci(createInfo)
+{
+    VkDescriptorUpdateTemplateCreateInfo templateCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+        .descriptorUpdateEntryCount = static_cast<uint32_t>(ci.entries.size()),
+        .pDescriptorUpdateEntries = ci.entries.data(),
+        .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+        .descriptorSetLayout = ci.setLayout,
+    };
+
+    VkResult res = ci.device->getContext()->CreateDescriptorUpdateTemplate(
+        ci.device->getHandle(), &templateCreateInfo, nullptr, &m_handle);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to create descriptor update template : " << res << std::endl;
+}
+
+DescriptorUpdateTemplate::~DescriptorUpdateTemplate()
+{
+    if (m_handle != VK_NULL_HANDLE)
+        ci.device->getContext()->DestroyDescriptorUpdateTemplate(ci.device->getHandle(), m_handle,
+                                                                 nullptr);
+}
+
+std::vector<VkDescriptorUpdateTemplateEntry> DescriptorUpdateTemplate::makePackedEntries(
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings, size_t* size)
+{
+    std::vector<VkDescriptorUpdateTemplateEntry> out;
+    out.reserve(bindings.size());
+
+    size_t offset = 0;
+    for (const auto& b : bindings)
+    {
+        size_t stride;
+        switch (b.descriptorType)
+        {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+            stride = sizeof(VkDescriptorImageInfo);
+            break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            stride = sizeof(VkBufferView);
+            break;
+        default:
+            stride = sizeof(VkDescriptorBufferInfo);
+            break;
+        }
+
+        out.push_back(VkDescriptorUpdateTemplateEntry{
+            .dstBinding = b.binding,
+            .dstArrayElement = 0,
+            .descriptorCount = b.descriptorCount,
+            .descriptorType = b.descriptorType,
+            .offset = offset,
+            .stride = stride,
+        });
+        offset += stride * b.descriptorCount;
+    }
+
+    if (size)
+        *size = offset;
+    return out;
+}
+
+void DescriptorUpdateTemplate::update(const VkDescriptorSet set, const void* data) const
+{
+    ci.device->getContext()->UpdateDescriptorSetWithTemplate(ci.device->getHandle(), set, m_handle,
+                                                             data);
+}
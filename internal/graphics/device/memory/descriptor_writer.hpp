@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+
+/**
+ * @brief accumulates descriptor writes and submits them in a single vkUpdateDescriptorSets call
+ * the writes only reference the descriptor infos when flushed, the info arrays can grow freely
+ * meanwhile
+ * not thread safe, use one writer per thread
+ *
+ */
+class DescriptorWriter
+{
+  private:
+    const LogicalDevice* m_device;
+
+    std::vector<VkWriteDescriptorSet> m_writes;
+    /**
+     * @brief index of the first info of each write in the buffer or image info array
+     *
+     */
+    std::vector<uint32_t> m_infoIndices;
+    std::vector<VkDescriptorBufferInfo> m_bufferInfos;
+    std::vector<VkDescriptorImageInfo> m_imageInfos;
+
+    uint64_t m_flushCount = 0U;
+    uint64_t m_flushedWriteCount = 0U;
+
+  public:
+    DescriptorWriter() = delete;
+    explicit DescriptorWriter(const LogicalDevice* device) : m_device(device) {}
+
+    void writeBuffer(const VkDescriptorSet set, const uint32_t binding,
+                     const VkDescriptorType type, const VkBuffer buffer, const VkDeviceSize offset,
+                     const VkDeviceSize range, const uint32_t arrayElement = 0U);
+    void writeImage(const VkDescriptorSet set, const uint32_t binding, const VkDescriptorType type,
+                    const VkImageView view, const VkSampler sampler, const VkImageLayout layout,
+                    const uint32_t arrayElement = 0U);
+
+    /**
+     * @brief submit every pending write at once, the capacity is kept for the next batch
+     *
+     */
+    void flush();
+    /**
+     * @brief drop the pending writes
+     *
+     */
+    void clear();
+
+  public:
+    [[nodiscard]] inline size_t getPendingCount() const { return m_writes.size(); }
+    [[nodiscard]] inline uint64_t getFlushCount() const { return m_flushCount; }
+    [[nodiscard]] inline uint64_t getFlushedWriteCount() const { return m_flushedWriteCount; }
+};
+
+struct DescriptorUpdateTemplateCreateInfoT
+{
+    const LogicalDevice* device;
+
+    VkDescriptorSetLayout setLayout;
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+};
+
+/**
+ * @brief writes a whole descriptor set of a fixed layout from a packed CPU structure in one call
+ *
+ */
+class DescriptorUpdateTemplate
+{
+  private:
+    const DescriptorUpdateTemplateCreateInfoT ci;
+
+  private:
+    VkDescriptorUpdateTemplate m_handle = VK_NULL_HANDLE;
+
+  public:
+    DescriptorUpdateTemplate() = delete;
+    DescriptorUpdateTemplate(const DescriptorUpdateTemplate&) = delete;
+    DescriptorUpdateTemplate& operator=(const DescriptorUpdateTemplate&) = delete;
+    DescriptorUpdateTemplate(DescriptorUpdateTemplate&&) = delete;
+    DescriptorUpdateTemplate& operator=(DescriptorUpdateTemplate&&) = delete;
+
+    explicit DescriptorUpdateTemplate(const DescriptorUpdateTemplateCreateInfoT createInfo);
+    ~DescriptorUpdateTemplate();
+
+    /**
+     * @brief entries of a structure packing the descriptor infos of every binding in binding order
+     * (VkDescriptorBufferInfo for buffers, VkDescriptorImageInfo for images and samplers,
+     * VkBufferView for texel buffers), arrays are stored contiguously
+     *
+     * @param size receives the size of the packed structure
+     */
+    [[nodiscard]] static std::vector<VkDescriptorUpdateTemplateEntry> makePackedEntries(
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings, size_t* size = nullptr);
+
+    /**
+     * @brief write the set from data laid out as described by the entries
+     *
+     */
+    void update(const VkDescriptorSet set, const void* data) const;
+
+  public:
+    [[nodiscard]] inline const VkDescriptorUpdateTemplate& getHandle() const { return m_handle; }
+};
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <iostream>
+
+#include "device/device.hpp"
+#include "physical_device.hpp"
+
+#include "buffer.hpp"
+
+#include "frame_arena.hpp"
+
+static inline VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+FrameArena::FrameArena(const FrameArenaCreateInfoT createInfo) : ci(createInfo)
+{
+    const auto& limits = ci.device->getPhysicalDevice()->getLimits();
+    m_alignment = std::max({m_alignment, limits.minUniformBufferOffsetAlignment,
+                            limits.minStorageBufferOffsetAlignment});
+
+    m_frames.resize(ci.frameCount);
+    for (auto& frame : m_frames)
+    {
+        frame.blocks.reserve(ci.initialBlockCount);
+        for (uint32_t i = 0; i < ci.initialBlockCount; ++i)
+        {
+            if (!createBlock(frame, ci.blockSize))
+                break;
+        }
+    }
+}
+
+FrameArena::~FrameArena()
+{
+    for (auto& frame : m_frames)
+    {
+        for (auto& block : frame.blocks)
+            destroyBlock(block);
+    }
+}
+
+bool FrameArena::createBlock(FrameT& frame, const VkDeviceSize size)
+{
+    // coherence is not required, non coherent memory is flushed explicitly
+    BlockT block;
+    block.size = size;
+    block.buffer = ci.device->createBuffer(BufferCreateInfoT{
+        .size = size,
+        .usage = ci.usage,
+        .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        .allocationType = AllocationTypeE::TRANSIENT,
+    });
+    if (!block.buffer->memory)
+        return false;
+
+    block.bCoherent = block.buffer->memory->isHostCoherent();
+
+    void* mapped = nullptr;
+    ci.device->mapBufferMemory(block.buffer, &mapped);
+    block.mapped = static_cast<uint8_t*>(mapped);
+
+    frame.blocks.emplace_back(std::move(block));
+    return true;
+}
+
+void FrameArena::destroyBlock(BlockT& block)
+{
+    ci.device->getMemoryAllocator()->unmapMemory(*block.buffer->memory);
+    ci.device->destroyBuffer(block.buffer);
+}
+
+void FrameArena::begin(const uint32_t frameIndex)
+{
+    m_frameIndex = frameIndex % ci.frameCount;
+
+    auto& frame = m_frames[m_frameIndex];
+    frame.currentBlock = 0U;
+    for (auto& block : frame.blocks)
+    {
+        block.head = 0U;
+        block.flushedHead = 0U;
+    }
+    m_usedSize = 0U;
+}
+
+TransientBufferT FrameArena::allocate(const VkDeviceSize size, const VkDeviceSize alignment)
+{
+    const VkDeviceSize align = alignment == 0U ? m_alignment : alignment;
+    auto& frame = m_frames[m_frameIndex];
+
+    // blocks are filled in order, the space left at the end of a block is lost for the frame
+    for (; frame.currentBlock < frame.blocks.size(); ++frame.currentBlock)
+    {
+        auto& block = frame.blocks[frame.currentBlock];
+        const VkDeviceSize offset = alignUp(block.head, align);
+        if (offset + size <= block.size)
+        {
+            block.head = offset + size;
+            m_usedSize += size;
+            m_peakSize = std::max(m_peakSize, m_usedSize);
+            return TransientBufferT{
+                .buffer = block.buffer->handle,
+                .offset = offset,
+                .size = size,
+                .data = block.mapped + offset,
+            };
+        }
+    }
+
+    // the new block stays in the frame, later frames of the same size do not create any
+    if (!createBlock(frame, std::max(ci.blockSize, size)))
+    {
+        std::cerr << "Failed to grow the frame arena for " << size << " bytes" << std::endl;
+        return {};
+    }
+    ++m_grownCount;
+
+    auto& block = frame.blocks.back();
+    block.head = size;
+    m_usedSize += size;
+    m_peakSize = std::max(m_peakSize, m_usedSize);
+    return TransientBufferT{
+        .buffer = block.buffer->handle,
+        .offset = 0U,
+        .size = size,
+        .data = block.mapped,
+    };
+}
+
+void FrameArena::flush()
+{
+    auto* allocator = ci.device->getMemoryAllocator();
+    auto& frame = m_frames[m_frameIndex];
+    for (auto& block : frame.blocks)
+    {
+        if (block.bCoherent || block.head == block.flushedHead)
+            continue;
+
+        // the allocator aligns the range to nonCoherentAtomSize
+        allocator->flush(*block.buffer->memory, block.flushedHead, block.head - block.flushedHead);
+        block.flushedHead = block.head;
+    }
+}
+
+bool FrameArena::isCoherent() const
+{
+    for (const auto& frame : m_frames)
+    {
+        for (const auto& block : frame.blocks)
+        {
+            if (!block.bCoherent)
+                return false;
+        }
+    }
+    return true;
+}
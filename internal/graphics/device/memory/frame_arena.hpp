@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+class Buffer;
+
+struct FrameArenaCreateInfoT
+{
+    const LogicalDevice* device;
+
+    /**
+     * @brief one arena per frame in flight, an arena is only rewound once its frame is done
+     *
+     */
+    uint32_t frameCount;
+    VkDeviceSize blockSize = 8ULL << 20;
+    /**
+     * @brief blocks created per frame up front, more are created when a frame runs out of them
+     *
+     */
+    uint32_t initialBlockCount = 2U;
+    VkBufferUsageFlags usage =
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+};
+
+/**
+ * @brief sub-range of an arena block, valid until the frame it was allocated in is done
+ *
+ */
+struct TransientBufferT
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0U;
+    VkDeviceSize size = 0U;
+    void* data = nullptr;
+
+    [[nodiscard]] inline bool isValid() const { return data != nullptr; }
+};
+
+/**
+ * @brief per frame bump allocator over a few large persistently mapped host visible buffers
+ * short lived data (per frame uploads, constants, indirect arguments, debug geometry) is written
+ * in sub-ranges of the blocks of the current frame instead of getting its own buffer, the frame
+ * blocks are rewound by begin once the frame that used them is done
+ * a frame needing more than its blocks gets a new one, which is kept for the next uses, so the
+ * steady state makes no driver call besides the flush of non coherent memory
+ * not thread safe, the render thread owns it
+ *
+ */
+class FrameArena
+{
+  private:
+    const FrameArenaCreateInfoT ci;
+
+  private:
+    struct BlockT
+    {
+        std::shared_ptr<Buffer> buffer;
+        uint8_t* mapped = nullptr;
+        VkDeviceSize size = 0U;
+        VkDeviceSize head = 0U;
+        VkDeviceSize flushedHead = 0U;
+        /**
+         * @brief a block created later may land in another memory type
+         *
+         */
+        bool bCoherent = true;
+    };
+
+    struct FrameT
+    {
+        std::vector<BlockT> blocks;
+        uint32_t currentBlock = 0U;
+    };
+
+    std::vector<FrameT> m_frames;
+    uint32_t m_frameIndex = 0U;
+
+    VkDeviceSize m_alignment = 16U;
+
+    VkDeviceSize m_usedSize = 0U;
+    VkDeviceSize m_peakSize = 0U;
+    uint32_t m_grownCount = 0U;
+
+    [[nodiscard]] bool createBlock(FrameT& frame, const VkDeviceSize size);
+    void destroyBlock(BlockT& block);
+
+  public:
+    FrameArena() = delete;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    FrameArena(FrameArena&&) = delete;
+    FrameArena& operator=(FrameArena&&) = delete;
+
+    explicit FrameArena(const FrameArenaCreateInfoT createInfo);
+    ~FrameArena();
+
+    /**
+     * @brief rewind the arena of the frame, its previous content must not be in use anymore
+     *
+     */
+    void begin(const uint32_t frameIndex);
+
+    /**
+     * @param alignment 0 for the default alignment, suitable for uniform, storage and indirect
+     * use
+     * @return an invalid range if a new block could not be created
+     */
+    [[nodiscard]] TransientBufferT allocate(const VkDeviceSize size,
+                                            const VkDeviceSize alignment = 0U);
+
+    /**
+     * @brief make the writes of the current frame visible to the device (no-op on coherent
+     * memory), to be called before the submission
+     *
+     */
+    void flush();
+
+  public:
+    [[nodiscard]] inline VkDeviceSize getAlignment() const { return m_alignment; }
+    [[nodiscard]] inline VkDeviceSize getUsedSize() const { return m_usedSize; }
+    /**
+     * @brief largest size used by a single frame
+     *
+     */
+    [[nodiscard]] inline VkDeviceSize getPeakSize() const { return m_peakSize; }
+    /**
+     * @brief blocks created after the construction because a frame ran out of them
+     *
+     */
+    [[nodiscard]] inline uint32_t getGrownCount() const { return m_grownCount; }
+    /**
+     * @brief every block is host coherent, flush has nothing to do
+     *
+     */
+    [[nodiscard]] bool isCoherent() const;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <optional>
+
 #include <vulkan/vulkan.h>
 
-#include <vk_mem_alloc.h>
+#include "memoryallocator.hpp"
 
 struct ImageCreateInfoT
 {
@@ -16,18 +18,20 @@ struct ImageCreateInfoT
     VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT;
     VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    AllocationTypeE allocationType = AllocationTypeE::IMAGE;
 };
 
 class Image
 {
   public:
+    ImageCreateInfoT info;
+    std::shared_ptr<AllocationABC> memory;
+    VkImage handle;
     /**
-     * @brief allocation handle
-     * TODO : handle abstraction
+     * @brief layout of the image between frames, kept up to date by the code transitioning it
      *
      */
-    VmaAllocation memory;
-    VkImage handle;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
 };
 
 struct ImageViewCreateInfoT
@@ -43,6 +47,14 @@ struct ImageViewCreateInfoT
      */
     std::optional<VkFormat> format;
     VkImageAspectFlags aspect;
+    VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+    /**
+     * @brief levels before the base one may not be loaded yet (see Texture)
+     *
+     */
+    uint32_t baseMipLevel = 0U;
+    uint32_t levelCount = 1U;
+    uint32_t layerCount = 1U;
 };
 
 class ImageView
@@ -53,8 +65,22 @@ class ImageView
 
 struct SamplerCreateInfoT
 {
+    VkFilter magFilter = VK_FILTER_LINEAR;
+    VkFilter minFilter = VK_FILTER_LINEAR;
+    VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    /**
+     * @brief 1 disables anisotropic filtering, clamped to maxSamplerAnisotropy, ignored when the
+     * device does not support it
+     *
+     */
+    float maxAnisotropy = 1.f;
+    float maxLod = VK_LOD_CLAMP_NONE;
 };
 
 class Sampler
 {
+  public:
+    SamplerCreateInfoT info;
+    VkSampler handle = VK_NULL_HANDLE;
 };
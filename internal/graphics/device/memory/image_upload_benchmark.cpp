@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "backbuffer.hpp"
+#include "context.hpp"
+#include "device/device.hpp"
+
+#include "buffer.hpp"
+#include "image.hpp"
+#include "image_uploader.hpp"
+
+#include "image_upload_benchmark.hpp"
+
+static constexpr VkFormat kFormat = VK_FORMAT_R8G8B8A8_UNORM;
+static constexpr uint32_t kTexelSize = 4U;
+
+using Clock = std::chrono::steady_clock;
+
+static double getMilliseconds(const Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/**
+ * @brief run task(i) for every image, the images are interleaved across the threads
+ *
+ */
+template <typename TaskT>
+static void runOnThreads(const uint32_t threadCount, const uint32_t imageCount, TaskT task)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([t, threadCount, imageCount, &task]() {
+            for (uint32_t i = t; i < imageCount; i += threadCount)
+                task(i);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+}
+
+static VkBufferImageCopy makeRegion(const uint32_t extent)
+{
+    return VkBufferImageCopy{
+        .bufferOffset = 0U,
+        .bufferRowLength = 0U,
+        .bufferImageHeight = 0U,
+        .imageSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0U,
+                .baseArrayLayer = 0U,
+                .layerCount = 1U,
+            },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {extent, extent, 1U},
+    };
+}
+
+static ImageUploadPathResultT runStagingPath(const LogicalDevice& device,
+                                             const ImageUploadBenchmarkInfoT& info,
+                                             const uint32_t threadCount,
+                                             const std::vector<uint8_t>& texels,
+                                             std::vector<std::shared_ptr<Image>>& images)
+{
+    auto* cx = device.getContext();
+    ImageUploadPathResultT out;
+
+    // a single record takes every upload
+    ImageUploader uploader(ImageUploaderCreateInfoT{
+        .device = &device,
+        .bytesPerFrame = VK_WHOLE_SIZE,
+    });
+
+    const auto start = Clock::now();
+    runOnThreads(threadCount, info.imageCount, [&](const uint32_t i) {
+        auto staging = device.createBuffer(BufferCreateInfoT{
+            .size = texels.size(),
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            .allocationType = AllocationTypeE::STAGING,
+        });
+        void* mapped = nullptr;
+        device.mapBufferMemory(staging, &mapped);
+        if (!mapped)
+        {
+            device.destroyBuffer(staging);
+            return;
+        }
+        std::memcpy(mapped, texels.data(), texels.size());
+        if (!staging->memory->isHostCoherent())
+            device.getMemoryAllocator()->flush(*staging->memory, 0, VK_WHOLE_SIZE);
+        device.getMemoryAllocator()->unmapMemory(*staging->memory);
+
+        uploader.enqueue(ImageUploadT{
+            .image = images[i],
+            .staging = std::move(staging),
+            .regions = {makeRegion(info.extent)},
+        });
+    });
+    const auto hostEnd = Clock::now();
+
+    auto backBuffer = device.createBackBufferAOS(BackBufferCreateInfoT{
+        .submitCountPerCommandBuffer = 0U,
+        .bFenceStartsSignaled = false,
+    });
+    const VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    cx->BeginCommandBuffer(backBuffer->commandBuffer, &beginInfo);
+    uploader.record(backBuffer->commandBuffer, 0U);
+    cx->EndCommandBuffer(backBuffer->commandBuffer);
+
+    const VkSubmitInfo submitInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1U,
+        .pCommandBuffers = &backBuffer->commandBuffer,
+    };
+    VkResult res =
+        cx->QueueSubmit(device.graphicsQueue, 1U, &submitInfo, backBuffer->inFlightFence);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to submit the upload benchmark : " << res << std::endl;
+    else
+        cx->WaitForFences(device.getHandle(), 1U, &backBuffer->inFlightFence, VK_TRUE, UINT64_MAX);
+    const auto end = Clock::now();
+
+    device.destroyBackBufferAOS(backBuffer);
+
+    out.hostMilliseconds = getMilliseconds(hostEnd - start);
+    out.queueMilliseconds = getMilliseconds(end - hostEnd);
+    out.totalMilliseconds = getMilliseconds(end - start);
+    out.transferCommandCount = static_cast<uint32_t>(uploader.getUploadCount());
+    out.hostCopiedBytes = uploader.getUploadedBytes();
+    out.deviceCopiedBytes = uploader.getUploadedBytes();
+    return out;
+}
+
+static ImageUploadPathResultT runHostCopyPath(const LogicalDevice& device,
+                                              const ImageUploadBenchmarkInfoT& info,
+                                              const uint32_t threadCount,
+                                              const std::vector<uint8_t>& texels,
+                                              std::vector<std::shared_ptr<Image>>& images)
+{
+    ImageUploadPathResultT out;
+
+    ImageUploader uploader(ImageUploaderCreateInfoT{.device = &device});
+    const VkBufferImageCopy copy = makeRegion(info.extent);
+    const VkMemoryToImageCopyEXT region = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,
+        .pHostPointer = texels.data(),
+        .imageSubresource = copy.imageSubresource,
+        .imageOffset = copy.imageOffset,
+        .imageExtent = copy.imageExtent,
+    };
+
+    const auto start = Clock::now();
+    runOnThreads(threadCount, info.imageCount, [&](const uint32_t i) {
+        (void)uploader.copyFromHost(images[i], {region}, texels.size(), {});
+    });
+    const auto end = Clock::now();
+
+    out.hostMilliseconds = getMilliseconds(end - start);
+    out.totalMilliseconds = out.hostMilliseconds;
+    out.hostCopiedBytes = uploader.getHostCopiedBytes();
+    return out;
+}
+
+ImageUploadBenchmarkResultT runImageUploadBenchmark(const LogicalDevice& device,
+                                                    const ImageUploadBenchmarkInfoT& info)
+{
+    ImageUploadBenchmarkResultT out;
+    out.threadCount = info.threadCount > 0U
+                          ? info.threadCount
+                          : std::max(std::thread::hardware_concurrency(), 1U);
+
+    // incompressible texels, the same for both paths
+    std::vector<uint8_t> texels(static_cast<size_t>(info.extent) * info.extent * kTexelSize);
+    std::mt19937 generator(1U);
+    std::generate(texels.begin(), texels.end(), [&generator]() {
+        return static_cast<uint8_t>(generator());
+    });
+
+    auto createImages = [&](const VkImageUsageFlags usage) {
+        std::vector<std::shared_ptr<Image>> images(info.imageCount);
+        for (auto& image : images)
+        {
+            image = device.createImage(ImageCreateInfoT{
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = kFormat,
+                .extent = {info.extent, info.extent, 1U},
+                .usage = VK_IMAGE_USAGE_SAMPLED_BIT | usage,
+            });
+        }
+        return images;
+    };
+    auto destroyImages = [&](std::vector<std::shared_ptr<Image>>& images) {
+        for (auto& image : images)
+            device.destroyImage(image);
+    };
+
+    // the images are created up front, only the transfers are measured
+    {
+        auto images = createImages(VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        out.staging = runStagingPath(device, info, out.threadCount, texels, images);
+        destroyImages(images);
+    }
+
+    ImageUploader probe(ImageUploaderCreateInfoT{.device = &device});
+    out.bHostCopySupported = probe.supportsHostCopy(kFormat);
+    if (out.bHostCopySupported)
+    {
+        auto images = createImages(VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT);
+        out.hostCopy = runHostCopyPath(device, info, out.threadCount, texels, images);
+        destroyImages(images);
+    }
+    return out;
+}
+
+static void printPath(const char* name, const ImageUploadPathResultT& result)
+{
+    std::cout << "  " << name << " : " << result.totalMilliseconds << " ms (host "
+              << result.hostMilliseconds << " ms, queue " << result.queueMilliseconds
+              << " ms), " << result.transferCommandCount << " transfer commands, "
+              << (result.hostCopiedBytes >> 20) << " MiB copied by the host, "
+              << (result.deviceCopiedBytes >> 20) << " MiB by the device" << std::endl;
+}
+
+void printImageUploadBenchmark(const ImageUploadBenchmarkResultT& result)
+{
+    std::cout << "Image upload benchmark (" << result.threadCount << " threads) :" << std::endl;
+    printPath("staging", result.staging);
+    if (result.bHostCopySupported)
+        printPath("host copy", result.hostCopy);
+    else
+        std::cout << "  host copy : VK_EXT_host_image_copy is not supported" << std::endl;
+}
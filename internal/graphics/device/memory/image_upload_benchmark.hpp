@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+
+struct ImageUploadBenchmarkInfoT
+{
+    /**
+     * @brief square RGBA8 images of a single level, uploaded together as during heavy streaming
+     *
+     */
+    uint32_t imageCount = 64U;
+    uint32_t extent = 1024U;
+    /**
+     * @brief threads filling the staging buffers or copying from the host, hardware threads if 0
+     *
+     */
+    uint32_t threadCount = 0U;
+};
+
+struct ImageUploadPathResultT
+{
+    /**
+     * @brief the workers filling the staging buffers or writing the images
+     *
+     */
+    double hostMilliseconds = 0.0;
+    /**
+     * @brief recording, submission and completion of the copy commands, 0 for host copies
+     *
+     */
+    double queueMilliseconds = 0.0;
+    double totalMilliseconds = 0.0;
+    /**
+     * @brief bytes written by the host and by the transfer commands, the staging path copies the
+     * texels twice
+     *
+     */
+    uint64_t hostCopiedBytes = 0U;
+    uint64_t deviceCopiedBytes = 0U;
+    uint32_t transferCommandCount = 0U;
+};
+
+struct ImageUploadBenchmarkResultT
+{
+    uint32_t threadCount = 0U;
+    ImageUploadPathResultT staging;
+    /**
+     * @brief left empty when VK_EXT_host_image_copy is not supported
+     *
+     */
+    bool bHostCopySupported = false;
+    ImageUploadPathResultT hostCopy;
+};
+
+/**
+ * @brief upload the same texels through staging buffers and the graphics queue, then straight
+ * from the host with VK_EXT_host_image_copy when the device supports it
+ * the device must be idle, the benchmark submits to the graphics queue and waits for it
+ *
+ */
+[[nodiscard]] ImageUploadBenchmarkResultT runImageUploadBenchmark(
+    const LogicalDevice& device, const ImageUploadBenchmarkInfoT& info);
+
+void printImageUploadBenchmark(const ImageUploadBenchmarkResultT& result);
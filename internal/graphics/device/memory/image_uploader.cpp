@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+#include "device/physical_device.hpp"
+
+#include "buffer.hpp"
+#include "image.hpp"
+
+#include "image_uploader.hpp"
+
+static constexpr VkPipelineStageFlags kShaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+static VkImageMemoryBarrier makeBarrier(const VkImage image, const uint32_t baseLevel,
+                                        const uint32_t levelCount, const VkAccessFlags srcAccess,
+                                        const VkAccessFlags dstAccess,
+                                        const VkImageLayout oldLayout,
+                                        const VkImageLayout newLayout)
+{
+    return VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = baseLevel,
+                .levelCount = levelCount,
+                .baseArrayLayer = 0U,
+                .layerCount = VK_REMAINING_ARRAY_LAYERS,
+            },
+    };
+}
+
+ImageUploader::ImageUploader(const ImageUploaderCreateInfoT createInfo) : ci(createInfo)
+{
+    if (!ci.device->supportsHostImageCopy())
+        return;
+    const auto& layouts = ci.device->getPhysicalDevice()->getHostImageCopyDstLayouts();
+    if (std::find(layouts.begin(), layouts.end(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) !=
+        layouts.end())
+        m_hostCopyLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+ImageUploader::~ImageUploader()
+{
+    if (!m_inFlight.empty())
+        ci.device->wait();
+    for (auto& inFlight : m_inFlight)
+        ci.device->destroyBuffer(inFlight.staging);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (auto& upload : m_pending)
+    {
+        if (upload.staging)
+            ci.device->destroyBuffer(upload.staging);
+    }
+
+    if (m_uploadCount > 0U)
+    {
+        std::cout << "Image uploads : " << m_uploadCount << " images ("
+                  << (m_uploadedBytes >> 20) << " MiB)" << std::endl;
+    }
+    if (getHostCopyCount() > 0U)
+    {
+        std::cout << "Image host copies : " << getHostCopyCount() << " images ("
+                  << (getHostCopiedBytes() >> 20) << " MiB)" << std::endl;
+    }
+}
+
+bool ImageUploader::supportsBlitMips(const PhysicalDevice* physicalDevice, const VkFormat format)
+{
+    const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                          VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                          VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    const VkFormatProperties properties = physicalDevice->getFormatProperties(format);
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+bool ImageUploader::supportsHostCopy(const VkFormat format) const
+{
+    // the entry points may not be resolved by every context
+    const auto* cx = ci.device->getContext();
+    if (!cx->CopyMemoryToImageEXT || !cx->TransitionImageLayoutEXT)
+        return false;
+    return ci.device->supportsHostImageCopy() &&
+           (ci.device->getPhysicalDevice()->getOptimalTilingFeatures2(format) &
+            VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) != 0;
+}
+
+bool ImageUploader::copyFromHost(const std::shared_ptr<Image>& image,
+                                 const std::vector<VkMemoryToImageCopyEXT>& regions,
+                                 const VkDeviceSize size, std::function<void()> onCopied)
+{
+    auto* cx = ci.device->getContext();
+
+    uint32_t firstLevel = image->info.mipLevels, lastLevel = 0U;
+    for (const auto& region : regions)
+    {
+        firstLevel = std::min(firstLevel, region.imageSubresource.mipLevel);
+        lastLevel = std::max(lastLevel, region.imageSubresource.mipLevel + 1);
+    }
+    if (firstLevel >= lastLevel)
+        return false;
+
+    // the layout changes right away, the levels are not read by any submitted work yet
+    const VkHostImageLayoutTransitionInfoEXT transition = {
+        .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,
+        .image = image->handle,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = m_hostCopyLayout,
+        .subresourceRange =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = firstLevel,
+                .levelCount = lastLevel - firstLevel,
+                .baseArrayLayer = 0U,
+                .layerCount = VK_REMAINING_ARRAY_LAYERS,
+            },
+    };
+    VkResult res = cx->TransitionImageLayoutEXT(ci.device->getHandle(), 1U, &transition);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to transition image layout from the host : " << res << std::endl;
+        return false;
+    }
+
+    const VkCopyMemoryToImageInfoEXT copyInfo = {
+        .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT,
+        .dstImage = image->handle,
+        .dstImageLayout = m_hostCopyLayout,
+        .regionCount = static_cast<uint32_t>(regions.size()),
+        .pRegions = regions.data(),
+    };
+    res = cx->CopyMemoryToImageEXT(ci.device->getHandle(), &copyInfo);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to copy memory to image : " << res << std::endl;
+        return false;
+    }
+    image->layout = m_hostCopyLayout;
+
+    m_hostCopyCount.fetch_add(1U, std::memory_order_relaxed);
+    m_hostCopiedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    // nothing to record, the queue submission makes the host writes visible to the device
+    enqueue(ImageUploadT{
+        .image = image,
+        .onRecorded = std::move(onCopied),
+    });
+    return true;
+}
+
+void ImageUploader::enqueue(ImageUploadT upload)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_pending.emplace_back(std::move(upload));
+}
+
+bool ImageUploader::isIdle()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_pending.empty() && m_inFlight.empty();
+}
+
+void ImageUploader::recordMips(const VkCommandBuffer commandBuffer, const Image& image,
+                               const uint32_t firstLevel) const
+{
+    auto* cx = ci.device->getContext();
+
+    int32_t width = static_cast<int32_t>(image.info.extent.width);
+    int32_t height = static_cast<int32_t>(image.info.extent.height);
+    for (uint32_t level = 1; level < firstLevel; ++level)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+
+    // each level is read once the previous blit (or the copy) is done writing it
+    for (uint32_t level = firstLevel; level < image.info.mipLevels; ++level)
+    {
+        const VkImageMemoryBarrier barrier = makeBarrier(
+            image.handle, level - 1, 1U, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        cx->CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                               &barrier);
+
+        const int32_t levelWidth = std::max(width / 2, 1);
+        const int32_t levelHeight = std::max(height / 2, 1);
+        const VkImageBlit blit = {
+            .srcSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level - 1,
+                    .baseArrayLayer = 0U,
+                    .layerCount = image.info.arrayLayers,
+                },
+            .srcOffsets = {{0, 0, 0}, {width, height, 1}},
+            .dstSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0U,
+                    .layerCount = image.info.arrayLayers,
+                },
+            .dstOffsets = {{0, 0, 0}, {levelWidth, levelHeight, 1}},
+        };
+        cx->CmdBlitImage(commandBuffer, image.handle, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         image.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                         VK_FILTER_LINEAR);
+
+        width = levelWidth;
+        height = levelHeight;
+    }
+}
+
+void ImageUploader::recordUpload(const VkCommandBuffer commandBuffer, ImageUploadT& upload) const
+{
+    auto* cx = ci.device->getContext();
+    Image& image = *upload.image;
+    const uint32_t mipLevels = image.info.mipLevels;
+
+    // the levels outside of the regions are left as they are, unless they are generated
+    uint32_t firstLevel = mipLevels, copiedLevels = 0U;
+    for (const auto& region : upload.regions)
+    {
+        firstLevel = std::min(firstLevel, region.imageSubresource.mipLevel);
+        copiedLevels = std::max(copiedLevels, region.imageSubresource.mipLevel + 1);
+    }
+    for (const auto& copy : upload.copies)
+    {
+        firstLevel = std::min(firstLevel, copy.dstSubresource.mipLevel);
+        copiedLevels = std::max(copiedLevels, copy.dstSubresource.mipLevel + 1);
+    }
+    const bool bBlitMips = upload.bGenerateMips && copiedLevels > 0U && copiedLevels < mipLevels;
+    const uint32_t lastLevel = bBlitMips ? mipLevels : copiedLevels;
+    if (firstLevel >= lastLevel)
+        return;
+    const uint32_t levelCount = lastLevel - firstLevel;
+
+    // the source may still be sampled by the previous frames
+    VkImageMemoryBarrier toTransfer[2];
+    toTransfer[0] =
+        makeBarrier(image.handle, firstLevel, levelCount, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    const bool bCopyImage = upload.source && !upload.copies.empty();
+    if (bCopyImage)
+    {
+        toTransfer[1] = makeBarrier(upload.source->handle, 0U, VK_REMAINING_MIP_LEVELS, 0,
+                                    VK_ACCESS_TRANSFER_READ_BIT, upload.source->layout,
+                                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    }
+    cx->CmdPipelineBarrier(commandBuffer,
+                           bCopyImage ? kShaderStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                           bCopyImage ? 2U : 1U, toTransfer);
+
+    if (upload.staging && !upload.regions.empty())
+    {
+        cx->CmdCopyBufferToImage(commandBuffer, upload.staging->handle, image.handle,
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 static_cast<uint32_t>(upload.regions.size()),
+                                 upload.regions.data());
+    }
+    if (bCopyImage)
+    {
+        cx->CmdCopyImage(commandBuffer, upload.source->handle,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.handle,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         static_cast<uint32_t>(upload.copies.size()), upload.copies.data());
+
+        const VkImageMemoryBarrier toSource = makeBarrier(
+            upload.source->handle, 0U, VK_REMAINING_MIP_LEVELS, VK_ACCESS_TRANSFER_READ_BIT,
+            VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upload.source->layout);
+        cx->CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, kShaderStages, 0, 0,
+                               nullptr, 0, nullptr, 1, &toSource);
+    }
+
+    // the blits leave every level but the last one as a transfer source
+    uint32_t barrierCount = 1U;
+    VkImageMemoryBarrier toShader[2];
+    if (bBlitMips)
+    {
+        recordMips(commandBuffer, image, copiedLevels);
+        toShader[0] = makeBarrier(image.handle, firstLevel, levelCount - 1,
+                                  VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        toShader[1] = makeBarrier(image.handle, mipLevels - 1, 1U, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                  VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        barrierCount = 2U;
+    }
+    else
+    {
+        toShader[0] = makeBarrier(image.handle, firstLevel, levelCount,
+                                  VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    cx->CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, kShaderStages, 0, 0,
+                           nullptr, 0, nullptr, barrierCount, toShader);
+
+    image.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void ImageUploader::record(const VkCommandBuffer commandBuffer, const uint32_t frameIndex)
+{
+    // the frame that recorded these copies is done
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end();)
+    {
+        if (it->frameIndex != frameIndex)
+        {
+            ++it;
+            continue;
+        }
+        ci.device->destroyBuffer(it->staging);
+        it = m_inFlight.erase(it);
+    }
+
+    VkDeviceSize recordedBytes = 0U;
+    while (true)
+    {
+        ImageUploadT upload;
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            if (m_pending.empty())
+                return;
+            const auto& staging = m_pending.front().staging;
+            const VkDeviceSize size = staging ? staging->size : 0U;
+            if (recordedBytes > 0U && recordedBytes + size > ci.bytesPerFrame)
+                return;
+            upload = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+
+        // images copied from the host only wait for their callback
+        if (upload.staging || upload.source)
+        {
+            recordUpload(commandBuffer, upload);
+            ++m_uploadCount;
+        }
+        if (upload.staging)
+        {
+            recordedBytes += upload.staging->size;
+            m_uploadedBytes += upload.staging->size;
+
+            m_inFlight.emplace_back(InFlightT{
+                .frameIndex = frameIndex,
+                .staging = std::move(upload.staging),
+            });
+        }
+        if (upload.onRecorded)
+            upload.onRecorded();
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+class PhysicalDevice;
+class Buffer;
+class Image;
+
+struct ImageUploaderCreateInfoT
+{
+    const LogicalDevice* device;
+
+    /**
+     * @brief staging bytes copied by the uploads recorded in a single frame, an upload larger than
+     * that is recorded alone
+     *
+     */
+    VkDeviceSize bytesPerFrame = 32ULL << 20;
+};
+
+struct ImageUploadT
+{
+    std::shared_ptr<Image> image;
+    /**
+     * @brief host visible buffer holding the levels copied by the regions, destroyed by the
+     * uploader once the copy is done, null when the image was copied from the host
+     *
+     */
+    std::shared_ptr<Buffer> staging;
+    std::vector<VkBufferImageCopy> regions;
+    /**
+     * @brief image the copies read from, transitioned back to its layout afterwards, null when
+     * only the staging buffer is copied
+     *
+     */
+    std::shared_ptr<Image> source;
+    std::vector<VkImageCopy> copies;
+    /**
+     * @brief levels after the last copied one are blitted down from it
+     *
+     */
+    bool bGenerateMips = false;
+    /**
+     * @brief called by the render thread once the upload is recorded, the commands recorded after
+     * it can sample the image
+     *
+     */
+    std::function<void()> onRecorded;
+};
+
+/**
+ * @brief records the staging copies of the images loaded by other threads into the frame command
+ * buffer, then transitions them to SHADER_READ_ONLY_OPTIMAL
+ * levels can also be copied from another image, to move a texture into a larger or smaller one
+ * missing levels are generated with linear blits when the format supports it, loaders check
+ * supportsBlitMips and provide every level otherwise
+ * staging buffers are destroyed when the frame slot that recorded their copy comes back
+ * with VK_EXT_host_image_copy, loaders checking supportsHostCopy write the levels from their own
+ * thread instead, with neither staging buffer nor command (copyFromHost)
+ * enqueue and copyFromHost are thread safe, the render thread records
+ *
+ */
+class ImageUploader
+{
+  private:
+    const ImageUploaderCreateInfoT ci;
+
+  private:
+    std::mutex m_mutex;
+    std::deque<ImageUploadT> m_pending;
+
+    struct InFlightT
+    {
+        uint32_t frameIndex;
+        std::shared_ptr<Buffer> staging;
+    };
+    std::vector<InFlightT> m_inFlight;
+
+    uint64_t m_uploadCount = 0U;
+    VkDeviceSize m_uploadedBytes = 0U;
+    std::atomic<uint64_t> m_hostCopyCount = 0U;
+    std::atomic<VkDeviceSize> m_hostCopiedBytes = 0U;
+
+    /**
+     * @brief layout the images copied from the host are left in, SHADER_READ_ONLY_OPTIMAL when
+     * the device can copy to it, GENERAL otherwise
+     *
+     */
+    VkImageLayout m_hostCopyLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    void recordUpload(const VkCommandBuffer commandBuffer, ImageUploadT& upload) const;
+    void recordMips(const VkCommandBuffer commandBuffer, const Image& image,
+                    const uint32_t firstLevel) const;
+
+  public:
+    ImageUploader() = delete;
+    ImageUploader(const ImageUploader&) = delete;
+    ImageUploader& operator=(const ImageUploader&) = delete;
+    ImageUploader(ImageUploader&&) = delete;
+    ImageUploader& operator=(ImageUploader&&) = delete;
+
+    explicit ImageUploader(const ImageUploaderCreateInfoT createInfo);
+    /**
+     * @brief waits for the device before destroying the staging buffers, pending uploads are
+     * dropped
+     *
+     */
+    ~ImageUploader();
+
+    /**
+     * @brief the levels of the regions and copies must be in the UNDEFINED layout, the other
+     * levels are left untouched so that a chain can be uploaded in several parts, the image must
+     * be created with the TRANSFER_DST usage, TRANSFER_SRC as well to generate mips, the source
+     * image with TRANSFER_SRC
+     * an upload with neither staging buffer nor source only calls onRecorded
+     *
+     */
+    void enqueue(ImageUploadT upload);
+
+    /**
+     * @brief destroy the staging buffers of this frame slot and record the next uploads, must be
+     * recorded outside of a render pass, after the fence of the frame was waited on
+     *
+     */
+    void record(const VkCommandBuffer commandBuffer, const uint32_t frameIndex);
+
+    /**
+     * @brief write the levels of the regions from host memory on the calling thread, the image
+     * must be created with the HOST_TRANSFER usage and its levels must not be in use, onCopied is
+     * then called by the render thread at its next record, like ImageUploadT::onRecorded
+     * size is the number of bytes the regions read, for the statistics
+     * @return false if the copy failed, onCopied is not called
+     */
+    [[nodiscard]] bool copyFromHost(const std::shared_ptr<Image>& image,
+                                    const std::vector<VkMemoryToImageCopyEXT>& regions,
+                                    const VkDeviceSize size, std::function<void()> onCopied);
+
+    /**
+     * @brief the format can be blitted from and to with a linear filter
+     *
+     */
+    [[nodiscard]] static bool supportsBlitMips(const PhysicalDevice* physicalDevice,
+                                               const VkFormat format);
+    /**
+     * @brief VK_EXT_host_image_copy is enabled and supports optimal tiling images of the format
+     *
+     */
+    [[nodiscard]] bool supportsHostCopy(const VkFormat format) const;
+
+  public:
+    [[nodiscard]] bool isIdle();
+    [[nodiscard]] inline uint64_t getUploadCount() const { return m_uploadCount; }
+    [[nodiscard]] inline VkDeviceSize getUploadedBytes() const { return m_uploadedBytes; }
+    [[nodiscard]] inline uint64_t getHostCopyCount() const
+    {
+        return m_hostCopyCount.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline VkDeviceSize getHostCopiedBytes() const
+    {
+        return m_hostCopiedBytes.load(std::memory_order_relaxed);
+    }
+};
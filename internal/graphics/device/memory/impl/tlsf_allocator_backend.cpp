@@ -0,0 +1,823 @@
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <iterator>
+
+#include "context.hpp"
+#include "device/device.hpp"
+#include "physical_device.hpp"
+
+#include "tlsf_allocator_backend.hpp"
+
+static inline VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief index of the most significant bit
+ *
+ */
+static inline uint32_t findLastSet(const uint64_t value)
+{
+    return 63U - static_cast<uint32_t>(std::countl_zero(value));
+}
+
+TLSFBlock::TLSFBlock(const VkDeviceSize size) : m_size(size / kGranularity * kGranularity)
+{
+    for (auto& heads : m_freeHeads)
+        heads.fill(kInvalidRegion);
+
+    uint32_t index = newRegion();
+    m_regions[index].offset = 0U;
+    m_regions[index].size = m_size;
+    insertFree(index);
+}
+
+void TLSFBlock::mapping(const VkDeviceSize size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < kSmallSize)
+    {
+        fl = 0U;
+        sl = static_cast<uint32_t>(size / (kSmallSize / kSecondLevelCount));
+        return;
+    }
+
+    const uint32_t msb = findLastSet(size);
+    sl = static_cast<uint32_t>(size >> (msb - kSecondLevelLog2)) ^ kSecondLevelCount;
+    fl = msb - kFirstLevelShift + 1U;
+}
+
+uint32_t TLSFBlock::newRegion()
+{
+    if (!m_unusedRegions.empty())
+    {
+        uint32_t index = m_unusedRegions.back();
+        m_unusedRegions.pop_back();
+        m_regions[index] = RegionT{};
+        return index;
+    }
+    m_regions.emplace_back();
+    return static_cast<uint32_t>(m_regions.size() - 1);
+}
+
+void TLSFBlock::insertFree(const uint32_t index)
+{
+    uint32_t fl, sl;
+    mapping(m_regions[index].size, fl, sl);
+
+    auto& region = m_regions[index];
+    region.bFree = true;
+    region.prevFree = kInvalidRegion;
+    region.nextFree = m_freeHeads[fl][sl];
+    if (region.nextFree != kInvalidRegion)
+        m_regions[region.nextFree].prevFree = index;
+    m_freeHeads[fl][sl] = index;
+
+    m_firstLevelBitmap |= 1U << fl;
+    m_secondLevelBitmaps[fl] |= 1U << sl;
+}
+
+void TLSFBlock::removeFree(const uint32_t index)
+{
+    uint32_t fl, sl;
+    mapping(m_regions[index].size, fl, sl);
+
+    auto& region = m_regions[index];
+    if (region.prevFree != kInvalidRegion)
+        m_regions[region.prevFree].nextFree = region.nextFree;
+    if (region.nextFree != kInvalidRegion)
+        m_regions[region.nextFree].prevFree = region.prevFree;
+    if (m_freeHeads[fl][sl] == index)
+    {
+        m_freeHeads[fl][sl] = region.nextFree;
+        if (region.nextFree == kInvalidRegion)
+        {
+            m_secondLevelBitmaps[fl] &= ~(1U << sl);
+            if (m_secondLevelBitmaps[fl] == 0U)
+                m_firstLevelBitmap &= ~(1U << fl);
+        }
+    }
+    region.bFree = false;
+    region.prevFree = kInvalidRegion;
+    region.nextFree = kInvalidRegion;
+}
+
+void TLSFBlock::split(const uint32_t index, const VkDeviceSize size)
+{
+    uint32_t rest = newRegion();
+    auto& region = m_regions[index];
+
+    m_regions[rest].offset = region.offset + size;
+    m_regions[rest].size = region.size - size;
+    m_regions[rest].prevPhysical = index;
+    m_regions[rest].nextPhysical = region.nextPhysical;
+    if (region.nextPhysical != kInvalidRegion)
+        m_regions[region.nextPhysical].prevPhysical = rest;
+    region.nextPhysical = rest;
+    region.size = size;
+
+    // the region was free, its physical neighbours are not, no merge is needed
+    insertFree(rest);
+}
+
+uint32_t TLSFBlock::allocate(const VkDeviceSize size, const VkDeviceSize alignment,
+                             VkDeviceSize* offset)
+{
+    const VkDeviceSize align = std::max(alignment, kGranularity);
+    const VkDeviceSize alignedSize = alignUp(std::max<VkDeviceSize>(size, 1U), kGranularity);
+    // any range of this size holds an aligned allocation whatever its offset
+    VkDeviceSize searchSize = alignedSize + align - kGranularity;
+    if (searchSize > m_size - m_usedBytes)
+        return kInvalidRegion;
+
+    // round up to the next list so that any range in the list found is large enough
+    if (searchSize >= kSmallSize)
+        searchSize += (1ULL << (findLastSet(searchSize) - kSecondLevelLog2)) - 1;
+    uint32_t fl, sl;
+    mapping(searchSize, fl, sl);
+    if (fl >= kFirstLevelCount)
+        return kInvalidRegion;
+
+    uint32_t secondLevelMap = m_secondLevelBitmaps[fl] & (~0U << sl);
+    if (secondLevelMap == 0U)
+    {
+        if (fl + 1U >= kFirstLevelCount)
+            return kInvalidRegion;
+        const uint32_t firstLevelMap = m_firstLevelBitmap & (~0U << (fl + 1U));
+        if (firstLevelMap == 0U)
+            return kInvalidRegion;
+        fl = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+        secondLevelMap = m_secondLevelBitmaps[fl];
+    }
+    sl = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+
+    const uint32_t index = m_freeHeads[fl][sl];
+    removeFree(index);
+
+    const VkDeviceSize padding = alignUp(m_regions[index].offset, align) - m_regions[index].offset;
+    if (padding > 0U)
+    {
+        // the alignment padding stays free in front of the allocation
+        uint32_t front = newRegion();
+        auto& region = m_regions[index];
+        m_regions[front].offset = region.offset;
+        m_regions[front].size = padding;
+        m_regions[front].prevPhysical = region.prevPhysical;
+        m_regions[front].nextPhysical = index;
+        if (region.prevPhysical != kInvalidRegion)
+            m_regions[region.prevPhysical].nextPhysical = front;
+        region.prevPhysical = front;
+        region.offset += padding;
+        region.size -= padding;
+        insertFree(front);
+    }
+    if (m_regions[index].size > alignedSize)
+        split(index, alignedSize);
+
+    m_usedBytes += m_regions[index].size;
+    ++m_allocationCount;
+    *offset = m_regions[index].offset;
+    return index;
+}
+
+void TLSFBlock::free(const uint32_t region)
+{
+    uint32_t index = region;
+    m_regions[index].userData = nullptr;
+    m_usedBytes -= m_regions[index].size;
+    --m_allocationCount;
+
+    // free neighbours are merged so that no two free ranges are adjacent
+    const uint32_t prev = m_regions[index].prevPhysical;
+    if (prev != kInvalidRegion && m_regions[prev].bFree)
+    {
+        removeFree(prev);
+        m_regions[prev].size += m_regions[index].size;
+        m_regions[prev].nextPhysical = m_regions[index].nextPhysical;
+        if (m_regions[index].nextPhysical != kInvalidRegion)
+            m_regions[m_regions[index].nextPhysical].prevPhysical = prev;
+        m_unusedRegions.push_back(index);
+        index = prev;
+    }
+    const uint32_t next = m_regions[index].nextPhysical;
+    if (next != kInvalidRegion && m_regions[next].bFree)
+    {
+        removeFree(next);
+        m_regions[index].size += m_regions[next].size;
+        m_regions[index].nextPhysical = m_regions[next].nextPhysical;
+        if (m_regions[next].nextPhysical != kInvalidRegion)
+            m_regions[m_regions[next].nextPhysical].prevPhysical = index;
+        m_unusedRegions.push_back(next);
+    }
+
+    insertFree(index);
+}
+
+VkDeviceSize TLSFBlock::getLargestFreeRange() const
+{
+    if (m_firstLevelBitmap == 0U)
+        return 0U;
+
+    // the largest range is in the highest non empty list
+    const uint32_t fl = findLastSet(m_firstLevelBitmap);
+    const uint32_t sl = findLastSet(m_secondLevelBitmaps[fl]);
+    VkDeviceSize out = 0U;
+    for (uint32_t i = m_freeHeads[fl][sl]; i != kInvalidRegion; i = m_regions[i].nextFree)
+        out = std::max(out, m_regions[i].size);
+    return out;
+}
+
+TLSFAllocatorBackend::TLSFAllocatorBackend(const TLSFAllocatorBackendCreateInfoT createInfo)
+    : AllocatorBackendABC(createInfo.device), ci(createInfo)
+{
+    const auto* physicalDevice = m_device->getPhysicalDevice();
+    const auto& limits = physicalDevice->getLimits();
+
+    m_pools.resize(physicalDevice->getMemoryProperties().memoryTypeCount * 2);
+    m_dedicatedTypeBytes.resize(physicalDevice->getMemoryProperties().memoryTypeCount, 0U);
+    m_bMemoryBudget = m_device->isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    m_bSeparateOptimal = limits.bufferImageGranularity > 1;
+    m_nonCoherentAtomSize = std::max<VkDeviceSize>(1U, limits.nonCoherentAtomSize);
+}
+
+TLSFAllocatorBackend::~TLSFAllocatorBackend()
+{
+    auto* cx = m_device->getContext();
+    for (auto& pool : m_pools)
+    {
+        for (auto& block : pool)
+        {
+            if (block->mapped)
+                cx->UnmapMemory(m_device->getHandle(), block->memory);
+            cx->FreeMemory(m_device->getHandle(), block->memory, nullptr);
+        }
+    }
+}
+
+uint32_t TLSFAllocatorBackend::findMemoryTypeIndex(
+    const uint32_t typeBits, const AllocationCreateInfoT& allocationInfo) const
+{
+    const auto& properties = m_device->getPhysicalDevice()->getMemoryProperties();
+
+    uint32_t out = UINT32_MAX;
+    int bestScore = -1;
+    for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+    {
+        const VkMemoryPropertyFlags flags = properties.memoryTypes[i].propertyFlags;
+        if ((typeBits & (1U << i)) == 0U ||
+            (flags & allocationInfo.requiredFlags) != allocationInfo.requiredFlags)
+            continue;
+
+        const int score = std::popcount(flags & allocationInfo.preferredFlags);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            out = i;
+        }
+    }
+    return out;
+}
+
+VkDeviceSize TLSFAllocatorBackend::getBlockSize(const uint32_t memoryTypeIndex) const
+{
+    const auto& properties = m_device->getPhysicalDevice()->getMemoryProperties();
+    const VkDeviceSize heapSize =
+        properties.memoryHeaps[properties.memoryTypes[memoryTypeIndex].heapIndex].size;
+
+    // small heaps (such as the 256 MiB BAR heap) are not taken by a few blocks
+    return std::min(ci.blockSize, heapSize / 8) / TLSFBlock::kGranularity *
+           TLSFBlock::kGranularity;
+}
+
+VkResult TLSFAllocatorBackend::allocate(const VkMemoryRequirements& requirements,
+                                        const AllocationCreateInfoT& allocationInfo,
+                                        const bool bOptimal,
+                                        const VkMemoryDedicatedAllocateInfo& dedicatedInfo,
+                                        std::shared_ptr<TLSFAllocation>& out)
+{
+    auto* cx = m_device->getContext();
+    const auto& properties = m_device->getPhysicalDevice()->getMemoryProperties();
+
+    const uint32_t memoryTypeIndex =
+        findMemoryTypeIndex(requirements.memoryTypeBits, allocationInfo);
+    if (memoryTypeIndex == UINT32_MAX)
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+
+    out = std::make_shared<TLSFAllocation>();
+    out->memoryTypeIndex = memoryTypeIndex;
+    out->memoryProperties = properties.memoryTypes[memoryTypeIndex].propertyFlags;
+    out->size = requirements.size;
+    out->alignment = requirements.alignment;
+
+    const VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+    if (allocationInfo.bDedicated || requirements.size >= ci.dedicatedThreshold ||
+        requirements.size > blockSize / 2)
+        return allocateDedicated(requirements, memoryTypeIndex, dedicatedInfo, *out);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    out->poolIndex = memoryTypeIndex * 2 + (m_bSeparateOptimal && bOptimal ? 1 : 0);
+    auto& pool = m_pools[out->poolIndex];
+    for (auto& block : pool)
+    {
+        out->region = block->allocate(requirements.size, requirements.alignment, &out->offset);
+        if (out->region != TLSFBlock::kInvalidRegion)
+        {
+            block->setUserData(out->region, out.get());
+            out->block = block.get();
+            out->memory = block->memory;
+            return VK_SUCCESS;
+        }
+    }
+
+    auto block = std::make_unique<TLSFBlock>(blockSize);
+    VkMemoryAllocateInfo allocateInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = block->getSize(),
+        .memoryTypeIndex = memoryTypeIndex,
+    };
+    VkResult res =
+        cx->AllocateMemory(m_device->getHandle(), &allocateInfo, nullptr, &block->memory);
+    if (res != VK_SUCCESS)
+        return res;
+    block->memoryTypeIndex = memoryTypeIndex;
+    block->memoryProperties = out->memoryProperties;
+
+    out->region = block->allocate(requirements.size, requirements.alignment, &out->offset);
+    if (out->region == TLSFBlock::kInvalidRegion)
+    {
+        // the alignment does not leave room for the size even in an empty block
+        cx->FreeMemory(m_device->getHandle(), block->memory, nullptr);
+        lock.unlock();
+        return allocateDedicated(requirements, memoryTypeIndex, dedicatedInfo, *out);
+    }
+    block->setUserData(out->region, out.get());
+    out->block = block.get();
+    out->memory = block->memory;
+    pool.emplace_back(std::move(block));
+    return VK_SUCCESS;
+}
+
+VkResult TLSFAllocatorBackend::allocateDedicated(const VkMemoryRequirements& requirements,
+                                                 const uint32_t memoryTypeIndex,
+                                                 const VkMemoryDedicatedAllocateInfo& dedicatedInfo,
+                                                 TLSFAllocation& out)
+{
+    auto* cx = m_device->getContext();
+
+    VkMemoryAllocateInfo allocateInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = &dedicatedInfo,
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = memoryTypeIndex,
+    };
+    VkResult res = cx->AllocateMemory(m_device->getHandle(), &allocateInfo, nullptr, &out.memory);
+    if (res != VK_SUCCESS)
+        return res;
+
+    out.offset = 0U;
+    out.region = TLSFBlock::kInvalidRegion;
+    out.bDedicated = true;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    ++m_dedicatedCount;
+    m_dedicatedBytes += requirements.size;
+    m_dedicatedTypeBytes[memoryTypeIndex] += requirements.size;
+    return VK_SUCCESS;
+}
+
+void TLSFAllocatorBackend::free(TLSFAllocation& allocation)
+{
+    auto* cx = m_device->getContext();
+
+    if (!allocation.block)
+    {
+        if (allocation.mapped)
+            cx->UnmapMemory(m_device->getHandle(), allocation.memory);
+        cx->FreeMemory(m_device->getHandle(), allocation.memory, nullptr);
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        --m_dedicatedCount;
+        m_dedicatedBytes -= allocation.size;
+        m_dedicatedTypeBytes[allocation.memoryTypeIndex] -= allocation.size;
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    TLSFBlock* block = allocation.block;
+    block->free(allocation.region);
+
+    // one empty block per pool is kept to avoid allocating again right away
+    auto& pool = m_pools[allocation.poolIndex];
+    if (block->isEmpty() && pool.size() > 1)
+    {
+        if (block->mapped)
+            cx->UnmapMemory(m_device->getHandle(), block->memory);
+        cx->FreeMemory(m_device->getHandle(), block->memory, nullptr);
+        pool.erase(std::find_if(pool.begin(), pool.end(),
+                                [block](const auto& b) { return b.get() == block; }));
+    }
+}
+
+VkResult TLSFAllocatorBackend::createBuffer(const VkBufferCreateInfo& createInfo,
+                                            const AllocationCreateInfoT& allocationInfo,
+                                            VkBuffer* buffer,
+                                            std::shared_ptr<AllocationABC>* allocation)
+{
+    auto* cx = m_device->getContext();
+
+    VkResult res = cx->CreateBuffer(m_device->getHandle(), &createInfo, nullptr, buffer);
+    if (res != VK_SUCCESS)
+        return res;
+
+    VkMemoryRequirements requirements;
+    cx->GetBufferMemoryRequirements(m_device->getHandle(), *buffer, &requirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .buffer = *buffer,
+    };
+    std::shared_ptr<TLSFAllocation> out;
+    res = allocate(requirements, allocationInfo, false, dedicatedInfo, out);
+    if (res == VK_SUCCESS)
+        res = cx->BindBufferMemory(m_device->getHandle(), *buffer, out->memory, out->offset);
+    if (res != VK_SUCCESS)
+    {
+        if (out && out->memory != VK_NULL_HANDLE)
+            free(*out);
+        cx->DestroyBuffer(m_device->getHandle(), *buffer, nullptr);
+        *buffer = VK_NULL_HANDLE;
+        return res;
+    }
+
+    *allocation = std::move(out);
+    return VK_SUCCESS;
+}
+
+void TLSFAllocatorBackend::destroyBuffer(const VkBuffer buffer,
+                                         std::shared_ptr<AllocationABC>& allocation)
+{
+    m_device->getContext()->DestroyBuffer(m_device->getHandle(), buffer, nullptr);
+    if (allocation)
+        free(static_cast<TLSFAllocation&>(*allocation));
+    allocation.reset();
+}
+
+VkResult TLSFAllocatorBackend::createImage(const VkImageCreateInfo& createInfo,
+                                           const AllocationCreateInfoT& allocationInfo,
+                                           VkImage* image,
+                                           std::shared_ptr<AllocationABC>* allocation)
+{
+    auto* cx = m_device->getContext();
+
+    VkResult res = cx->CreateImage(m_device->getHandle(), &createInfo, nullptr, image);
+    if (res != VK_SUCCESS)
+        return res;
+
+    VkMemoryRequirements requirements;
+    cx->GetImageMemoryRequirements(m_device->getHandle(), *image, &requirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .image = *image,
+    };
+    std::shared_ptr<TLSFAllocation> out;
+    res = allocate(requirements, allocationInfo, createInfo.tiling == VK_IMAGE_TILING_OPTIMAL,
+                   dedicatedInfo, out);
+    if (res == VK_SUCCESS)
+        res = cx->BindImageMemory(m_device->getHandle(), *image, out->memory, out->offset);
+    if (res != VK_SUCCESS)
+    {
+        if (out && out->memory != VK_NULL_HANDLE)
+            free(*out);
+        cx->DestroyImage(m_device->getHandle(), *image, nullptr);
+        *image = VK_NULL_HANDLE;
+        return res;
+    }
+
+    *allocation = std::move(out);
+    return VK_SUCCESS;
+}
+
+void TLSFAllocatorBackend::destroyImage(const VkImage image,
+                                        std::shared_ptr<AllocationABC>& allocation)
+{
+    m_device->getContext()->DestroyImage(m_device->getHandle(), image, nullptr);
+    if (allocation)
+        free(static_cast<TLSFAllocation&>(*allocation));
+    allocation.reset();
+}
+
+VkResult TLSFAllocatorBackend::mapMemory(AllocationABC& allocation, void** ppData)
+{
+    auto* cx = m_device->getContext();
+    auto& a = static_cast<TLSFAllocation&>(allocation);
+    if ((a.memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+        return VK_ERROR_MEMORY_MAP_FAILED;
+
+    if (!a.block)
+    {
+        if (a.mapCount == 0U)
+        {
+            VkResult res =
+                cx->MapMemory(m_device->getHandle(), a.memory, 0, VK_WHOLE_SIZE, 0, &a.mapped);
+            if (res != VK_SUCCESS)
+                return res;
+        }
+        ++a.mapCount;
+        *ppData = a.mapped;
+        return VK_SUCCESS;
+    }
+
+    // the whole block is mapped once, allocations point into it
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (a.block->mapCount == 0U)
+    {
+        VkResult res = cx->MapMemory(m_device->getHandle(), a.block->memory, 0, VK_WHOLE_SIZE, 0,
+                                     &a.block->mapped);
+        if (res != VK_SUCCESS)
+            return res;
+    }
+    ++a.block->mapCount;
+    ++a.mapCount;
+    *ppData = static_cast<uint8_t*>(a.block->mapped) + a.offset;
+    return VK_SUCCESS;
+}
+
+void TLSFAllocatorBackend::unmapMemory(AllocationABC& allocation)
+{
+    auto* cx = m_device->getContext();
+    auto& a = static_cast<TLSFAllocation&>(allocation);
+
+    if (!a.block)
+    {
+        if (a.mapCount > 0U && --a.mapCount == 0U)
+        {
+            cx->UnmapMemory(m_device->getHandle(), a.memory);
+            a.mapped = nullptr;
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (a.mapCount == 0U)
+        return;
+    --a.mapCount;
+    if (--a.block->mapCount == 0U)
+    {
+        cx->UnmapMemory(m_device->getHandle(), a.block->memory);
+        a.block->mapped = nullptr;
+    }
+}
+
+VkMappedMemoryRange TLSFAllocatorBackend::makeRange(const TLSFAllocation& allocation,
+                                                    const VkDeviceSize offset,
+                                                    const VkDeviceSize size) const
+{
+    const VkDeviceSize memorySize =
+        allocation.block ? allocation.block->getSize() : allocation.size;
+    const VkDeviceSize begin =
+        (allocation.offset + offset) / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+    const VkDeviceSize end =
+        size == VK_WHOLE_SIZE ? allocation.offset + allocation.size
+                              : allocation.offset + offset + size;
+
+    // the range is a multiple of nonCoherentAtomSize or ends with the memory
+    return VkMappedMemoryRange{
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .memory = allocation.memory,
+        .offset = begin,
+        .size = std::min(alignUp(end, m_nonCoherentAtomSize), memorySize) - begin,
+    };
+}
+
+void TLSFAllocatorBackend::flush(AllocationABC& allocation, const VkDeviceSize offset,
+                                 const VkDeviceSize size)
+{
+    if (allocation.isHostCoherent() || size == 0U)
+        return;
+
+    VkMappedMemoryRange range = makeRange(static_cast<TLSFAllocation&>(allocation), offset, size);
+    VkResult res =
+        m_device->getContext()->FlushMappedMemoryRanges(m_device->getHandle(), 1, &range);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to flush mapped memory : " << res << std::endl;
+}
+
+void TLSFAllocatorBackend::invalidate(AllocationABC& allocation, const VkDeviceSize offset,
+                                      const VkDeviceSize size)
+{
+    if (allocation.isHostCoherent() || size == 0U)
+        return;
+
+    VkMappedMemoryRange range = makeRange(static_cast<TLSFAllocation&>(allocation), offset, size);
+    VkResult res =
+        m_device->getContext()->InvalidateMappedMemoryRanges(m_device->getHandle(), 1, &range);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to invalidate mapped memory : " << res << std::endl;
+}
+
+VkResult TLSFAllocatorBackend::bindBufferMemory(AllocationABC& allocation, const VkBuffer buffer)
+{
+    return m_device->getContext()->BindBufferMemory(m_device->getHandle(), buffer,
+                                                    allocation.memory, allocation.offset);
+}
+
+VkResult TLSFAllocatorBackend::bindImageMemory(AllocationABC& allocation, const VkImage image)
+{
+    return m_device->getContext()->BindImageMemory(m_device->getHandle(), image,
+                                                   allocation.memory, allocation.offset);
+}
+
+TLSFBlock* TLSFAllocatorBackend::findDefragmentationSource(const uint32_t poolIndex) const
+{
+    const auto& pool = m_pools[poolIndex];
+    if (pool.size() < 2)
+        return nullptr;
+
+    TLSFBlock* out = nullptr;
+    VkDeviceSize freeBytes = 0U;
+    for (const auto& block : pool)
+    {
+        freeBytes += block->getSize() - block->getUsedBytes();
+        if (!out || block->getUsedBytes() < out->getUsedBytes())
+            out = block.get();
+    }
+    freeBytes -= out->getSize() - out->getUsedBytes();
+
+    // moving allocations that cannot all leave the block would only shuffle them
+    return freeBytes >= out->getUsedBytes() ? out : nullptr;
+}
+
+bool TLSFAllocatorBackend::beginDefragmentationPass(const VkDeviceSize maxBytes,
+                                                    std::vector<DefragmentationMoveT>* moves)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    moves->clear();
+    VkDeviceSize movedBytes = 0U;
+    for (uint32_t poolIndex = 0; poolIndex < m_pools.size() && movedBytes < maxBytes; ++poolIndex)
+    {
+        TLSFBlock* source = findDefragmentationSource(poolIndex);
+        if (!source)
+            continue;
+
+        std::vector<TLSFAllocation*> allocations;
+        source->forEachAllocation(
+            [&allocations](void* p) { allocations.push_back(static_cast<TLSFAllocation*>(p)); });
+
+        for (TLSFAllocation* a : allocations)
+        {
+            if (a->mapCount > 0U)
+                continue;
+            if (movedBytes + a->size > maxBytes)
+                break;
+
+            // the destination is reserved now, so that the pass cannot hand it out twice
+            auto destination = std::make_shared<TLSFAllocation>(*a);
+            destination->mapped = nullptr;
+            destination->mapCount = 0U;
+            destination->block = nullptr;
+            for (auto& block : m_pools[poolIndex])
+            {
+                if (block.get() == source)
+                    continue;
+                destination->region = block->allocate(a->size, a->alignment, &destination->offset);
+                if (destination->region != TLSFBlock::kInvalidRegion)
+                {
+                    block->setUserData(destination->region, destination.get());
+                    destination->block = block.get();
+                    destination->memory = block->memory;
+                    break;
+                }
+            }
+            if (!destination->block)
+                break;
+
+            movedBytes += a->size;
+            moves->emplace_back(DefragmentationMoveT{
+                .source = a,
+                .destination = std::move(destination),
+            });
+        }
+    }
+    return !moves->empty();
+}
+
+void TLSFAllocatorBackend::endDefragmentationPass(std::vector<DefragmentationMoveT>& moves)
+{
+    for (auto& move : moves)
+    {
+        auto& destination = static_cast<TLSFAllocation&>(*move.destination);
+        if (!move.bIgnore)
+        {
+            auto& source = static_cast<TLSFAllocation&>(*move.source);
+
+            // the source object takes the new placement, the destination object the old one
+            std::lock_guard<std::mutex> guard(m_mutex);
+            std::swap(source.block, destination.block);
+            std::swap(source.region, destination.region);
+            std::swap(source.offset, destination.offset);
+            std::swap(source.memory, destination.memory);
+            source.block->setUserData(source.region, &source);
+            destination.block->setUserData(destination.region, &destination);
+        }
+        free(destination);
+        move.destination.reset();
+    }
+}
+
+AllocatorStatsT TLSFAllocatorBackend::getStats() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    AllocatorStatsT out;
+    for (const auto& pool : m_pools)
+    {
+        for (const auto& block : pool)
+        {
+            ++out.blockCount;
+            out.allocationCount += block->getAllocationCount();
+            out.reservedBytes += block->getSize();
+            out.usedBytes += block->getUsedBytes();
+            out.largestFreeRange = std::max(out.largestFreeRange, block->getLargestFreeRange());
+        }
+    }
+    out.blockCount += m_dedicatedCount;
+    out.allocationCount += m_dedicatedCount;
+    out.dedicatedAllocationCount = m_dedicatedCount;
+    out.reservedBytes += m_dedicatedBytes;
+    out.usedBytes += m_dedicatedBytes;
+    return out;
+}
+
+void TLSFAllocatorBackend::getHeapBudgets(std::vector<HeapBudgetT>* budgets) const
+{
+    const auto& properties = m_device->getPhysicalDevice()->getMemoryProperties();
+
+    budgets->assign(properties.memoryHeapCount, HeapBudgetT{});
+    for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+    {
+        (*budgets)[i].size = properties.memoryHeaps[i].size;
+        (*budgets)[i].flags = properties.memoryHeaps[i].flags;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        for (const auto& pool : m_pools)
+        {
+            for (const auto& block : pool)
+            {
+                const uint32_t heapIndex = properties.memoryTypes[block->memoryTypeIndex].heapIndex;
+                auto& budget = (*budgets)[heapIndex];
+                budget.reservedBytes += block->getSize();
+                budget.usedBytes += block->getUsedBytes();
+            }
+        }
+        for (uint32_t i = 0; i < m_dedicatedTypeBytes.size(); ++i)
+        {
+            auto& budget = (*budgets)[properties.memoryTypes[i].heapIndex];
+            budget.reservedBytes += m_dedicatedTypeBytes[i];
+            budget.usedBytes += m_dedicatedTypeBytes[i];
+        }
+
+        for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+        {
+            auto& budget = (*budgets)[i];
+            if (m_bMemoryBudget)
+            {
+                budget.usage = m_heapUsage[i];
+                budget.budget = m_heapBudget[i];
+            }
+            else
+            {
+                // same estimate as vma without the extension
+                budget.usage = budget.reservedBytes;
+                budget.budget = budget.size * 8 / 10;
+            }
+        }
+    }
+}
+
+void TLSFAllocatorBackend::setCurrentFrameIndex(const uint32_t frameIndex)
+{
+    if (!m_bMemoryBudget)
+        return;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    };
+    VkPhysicalDeviceMemoryProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+        .pNext = &budgetProperties,
+    };
+    m_device->getContext()->GetPhysicalDeviceMemoryProperties2(
+        m_device->getPhysicalDevice()->getHandle(), &properties);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    std::copy(std::begin(budgetProperties.heapUsage), std::end(budgetProperties.heapUsage),
+              m_heapUsage.begin());
+    std::copy(std::begin(budgetProperties.heapBudget), std::end(budgetProperties.heapBudget),
+              m_heapBudget.begin());
+}
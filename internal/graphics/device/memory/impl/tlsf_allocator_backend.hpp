@@ -0,0 +1,256 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "device/memory/memoryallocator.hpp"
+
+/**
+ * @brief two level segregated fit metadata of a single VkDeviceMemory block
+ * free ranges are kept in lists indexed by a power of two (first level) and a linear subdivision
+ * of it (second level), two bitmaps tell which lists are not empty, so that finding a free range
+ * large enough and releasing one (merged with its free neighbours) are O(1)
+ * offsets and sizes are multiples of kGranularity, ranges must stay below 1 TiB
+ *
+ */
+class TLSFBlock
+{
+  public:
+    static constexpr VkDeviceSize kGranularity = 16U;
+    static constexpr uint32_t kInvalidRegion = UINT32_MAX;
+
+  private:
+    static constexpr uint32_t kSecondLevelLog2 = 5U;
+    static constexpr uint32_t kSecondLevelCount = 1U << kSecondLevelLog2;
+    /**
+     * @brief sizes below this share the first level 0, linearly
+     *
+     */
+    static constexpr uint32_t kFirstLevelShift = kSecondLevelLog2 + 4U;
+    static constexpr VkDeviceSize kSmallSize = 1ULL << kFirstLevelShift;
+    static constexpr uint32_t kFirstLevelMax = 40U;
+    static constexpr uint32_t kFirstLevelCount = kFirstLevelMax - kFirstLevelShift + 1U;
+
+    struct RegionT
+    {
+        VkDeviceSize offset = 0U;
+        VkDeviceSize size = 0U;
+        uint32_t prevPhysical = kInvalidRegion;
+        uint32_t nextPhysical = kInvalidRegion;
+        uint32_t prevFree = kInvalidRegion;
+        uint32_t nextFree = kInvalidRegion;
+        bool bFree = false;
+        /**
+         * @brief owner of an allocated region, null for free and unused regions
+         *
+         */
+        void* userData = nullptr;
+    };
+
+    /**
+     * @brief region nodes, indices stay valid while the block lives
+     *
+     */
+    std::vector<RegionT> m_regions;
+    std::vector<uint32_t> m_unusedRegions;
+
+    uint32_t m_firstLevelBitmap = 0U;
+    std::array<uint32_t, kFirstLevelCount> m_secondLevelBitmaps = {};
+    std::array<std::array<uint32_t, kSecondLevelCount>, kFirstLevelCount> m_freeHeads;
+
+    VkDeviceSize m_size = 0U;
+    VkDeviceSize m_usedBytes = 0U;
+    uint32_t m_allocationCount = 0U;
+
+    static void mapping(const VkDeviceSize size, uint32_t& fl, uint32_t& sl);
+
+    [[nodiscard]] uint32_t newRegion();
+    void insertFree(const uint32_t index);
+    void removeFree(const uint32_t index);
+    /**
+     * @brief cut the region at size, the remainder becomes a free region
+     *
+     */
+    void split(const uint32_t index, const VkDeviceSize size);
+
+  public:
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    uint32_t memoryTypeIndex = 0U;
+    VkMemoryPropertyFlags memoryProperties = 0;
+
+    void* mapped = nullptr;
+    uint32_t mapCount = 0U;
+
+    TLSFBlock() = delete;
+    explicit TLSFBlock(const VkDeviceSize size);
+
+    /**
+     * @return the region index, kInvalidRegion if no free range can hold the request
+     */
+    [[nodiscard]] uint32_t allocate(const VkDeviceSize size, const VkDeviceSize alignment,
+                                    VkDeviceSize* offset);
+    void free(const uint32_t region);
+
+    [[nodiscard]] VkDeviceSize getLargestFreeRange() const;
+
+    inline void setUserData(const uint32_t region, void* userData)
+    {
+        m_regions[region].userData = userData;
+    }
+    template <typename F> void forEachAllocation(F&& f) const
+    {
+        for (const RegionT& region : m_regions)
+        {
+            if (region.userData)
+                f(region.userData);
+        }
+    }
+
+  public:
+    [[nodiscard]] inline VkDeviceSize getSize() const { return m_size; }
+    [[nodiscard]] inline VkDeviceSize getUsedBytes() const { return m_usedBytes; }
+    [[nodiscard]] inline uint32_t getAllocationCount() const { return m_allocationCount; }
+    [[nodiscard]] inline bool isEmpty() const { return m_allocationCount == 0U; }
+};
+
+class TLSFAllocation : public AllocationABC
+{
+  public:
+    /**
+     * @brief null for dedicated allocations
+     *
+     */
+    TLSFBlock* block = nullptr;
+    uint32_t region = TLSFBlock::kInvalidRegion;
+    uint32_t poolIndex = 0U;
+    VkDeviceSize alignment = 1U;
+
+    /**
+     * @brief dedicated allocations are mapped on their own, mapped allocations are not moved
+     *
+     */
+    void* mapped = nullptr;
+    uint32_t mapCount = 0U;
+};
+
+struct TLSFAllocatorBackendCreateInfoT
+{
+    const LogicalDevice* device;
+    VkDeviceSize blockSize = 64ULL << 20;
+    VkDeviceSize dedicatedThreshold = 16ULL << 20;
+};
+
+/**
+ * @brief in-house sub-allocator, large VkDeviceMemory blocks per memory type are divided with TLSF
+ * when bufferImageGranularity is larger than 1, linear resources (buffers, linear images) and
+ * optimal images are placed in separate blocks so that they never share a granularity page
+ * resources larger than the dedicated threshold get their own VkDeviceMemory
+ * a defragmentation pass empties the least used block of a pool into the other blocks of the pool
+ * thread safe
+ *
+ */
+class TLSFAllocatorBackend : public AllocatorBackendABC
+{
+  private:
+    const TLSFAllocatorBackendCreateInfoT ci;
+
+  private:
+    mutable std::mutex m_mutex;
+
+    /**
+     * @brief two pools per memory type, linear and optimal resources
+     *
+     */
+    std::vector<std::vector<std::unique_ptr<TLSFBlock>>> m_pools;
+    bool m_bSeparateOptimal = false;
+    VkDeviceSize m_nonCoherentAtomSize = 1U;
+
+    uint32_t m_dedicatedCount = 0U;
+    VkDeviceSize m_dedicatedBytes = 0U;
+    /**
+     * @brief per memory type
+     *
+     */
+    std::vector<VkDeviceSize> m_dedicatedTypeBytes;
+
+    /**
+     * @brief per heap, reported by VK_EXT_memory_budget when setting the frame index
+     *
+     */
+    bool m_bMemoryBudget = false;
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_heapUsage = {};
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_heapBudget = {};
+
+    [[nodiscard]] uint32_t findMemoryTypeIndex(const uint32_t typeBits,
+                                               const AllocationCreateInfoT& allocationInfo) const;
+    [[nodiscard]] VkDeviceSize getBlockSize(const uint32_t memoryTypeIndex) const;
+
+    /**
+     * @param dedicatedInfo names the resource if the allocation ends up dedicated
+     */
+    [[nodiscard]] VkResult allocate(const VkMemoryRequirements& requirements,
+                                    const AllocationCreateInfoT& allocationInfo,
+                                    const bool bOptimal,
+                                    const VkMemoryDedicatedAllocateInfo& dedicatedInfo,
+                                    std::shared_ptr<TLSFAllocation>& out);
+    /**
+     * @brief memory of its own for this allocation, takes the lock of the backend
+     *
+     */
+    [[nodiscard]] VkResult allocateDedicated(const VkMemoryRequirements& requirements,
+                                             const uint32_t memoryTypeIndex,
+                                             const VkMemoryDedicatedAllocateInfo& dedicatedInfo,
+                                             TLSFAllocation& out);
+    void free(TLSFAllocation& allocation);
+    /**
+     * @brief the least used block of the pool, if the other blocks have room for its allocations
+     *
+     */
+    [[nodiscard]] TLSFBlock* findDefragmentationSource(const uint32_t poolIndex) const;
+
+    [[nodiscard]] VkMappedMemoryRange makeRange(const TLSFAllocation& allocation,
+                                                const VkDeviceSize offset,
+                                                const VkDeviceSize size) const;
+
+  public:
+    TLSFAllocatorBackend() = delete;
+    TLSFAllocatorBackend(const TLSFAllocatorBackend&) = delete;
+    TLSFAllocatorBackend& operator=(const TLSFAllocatorBackend&) = delete;
+
+    explicit TLSFAllocatorBackend(const TLSFAllocatorBackendCreateInfoT createInfo);
+    ~TLSFAllocatorBackend() override;
+
+    [[nodiscard]] VkResult createBuffer(const VkBufferCreateInfo& createInfo,
+                                        const AllocationCreateInfoT& allocationInfo,
+                                        VkBuffer* buffer,
+                                        std::shared_ptr<AllocationABC>* allocation) override;
+    void destroyBuffer(const VkBuffer buffer, std::shared_ptr<AllocationABC>& allocation) override;
+
+    [[nodiscard]] VkResult createImage(const VkImageCreateInfo& createInfo,
+                                       const AllocationCreateInfoT& allocationInfo, VkImage* image,
+                                       std::shared_ptr<AllocationABC>* allocation) override;
+    void destroyImage(const VkImage image, std::shared_ptr<AllocationABC>& allocation) override;
+
+    [[nodiscard]] VkResult mapMemory(AllocationABC& allocation, void** ppData) override;
+    void unmapMemory(AllocationABC& allocation) override;
+
+    void flush(AllocationABC& allocation, const VkDeviceSize offset,
+               const VkDeviceSize size) override;
+    void invalidate(AllocationABC& allocation, const VkDeviceSize offset,
+                    const VkDeviceSize size) override;
+
+    [[nodiscard]] VkResult bindBufferMemory(AllocationABC& allocation,
+                                            const VkBuffer buffer) override;
+    [[nodiscard]] VkResult bindImageMemory(AllocationABC& allocation, const VkImage image) override;
+
+    [[nodiscard]] bool beginDefragmentationPass(const VkDeviceSize maxBytes,
+                                                std::vector<DefragmentationMoveT>* moves) override;
+    void endDefragmentationPass(std::vector<DefragmentationMoveT>& moves) override;
+
+    [[nodiscard]] AllocatorStatsT getStats() const override;
+    void getHeapBudgets(std::vector<HeapBudgetT>* budgets) const override;
+    void setCurrentFrameIndex(const uint32_t frameIndex) override;
+} typedef MyMemoryAllocator;
@@ -0,0 +1,376 @@
+#include <iostream>
+
+#include "context.hpp"
+#include "device/device.hpp"
+#include "instance.hpp"
+#include "physical_device.hpp"
+
+#include "vma_allocator_backend.hpp"
+
+static VmaAllocationCreateInfo makeAllocationCreateInfo(const AllocationCreateInfoT& ci)
+{
+    VmaAllocationCreateInfo out = {};
+    out.flags = ci.bDedicated ? VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT : 0;
+    out.requiredFlags = ci.requiredFlags;
+    out.preferredFlags = ci.preferredFlags;
+    return out;
+}
+
+static uint32_t nextMemoryTypeIndex(const uint32_t memoryTypeIndex)
+{
+    return (memoryTypeIndex + 1U) % VK_MAX_MEMORY_TYPES;
+}
+
+VulkanMemoryAllocatorBackend::VulkanMemoryAllocatorBackend(const LogicalDevice* device)
+    : AllocatorBackendABC(device)
+{
+    auto* cx = m_device->getContext();
+    const auto* physicalDevice = m_device->getPhysicalDevice();
+
+    VmaVulkanFunctions vulkanFunctions = {};
+    vulkanFunctions.vkGetInstanceProcAddr = cx->GetInstanceProcAddr;
+    vulkanFunctions.vkGetDeviceProcAddr = cx->GetDeviceProcAddr;
+
+    VmaAllocatorCreateInfo allocatorCreateInfo = {};
+    // without the extension vma estimates the budget from its own blocks
+    if (m_device->isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+        allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    allocatorCreateInfo.vulkanApiVersion = VK_API_VERSION_1_2;
+    allocatorCreateInfo.physicalDevice = physicalDevice->getHandle();
+    allocatorCreateInfo.device = m_device->getHandle();
+    allocatorCreateInfo.instance = physicalDevice->getInstance()->getHandle();
+    allocatorCreateInfo.pVulkanFunctions = &vulkanFunctions;
+
+    VkResult res = vmaCreateAllocator(&allocatorCreateInfo, &m_allocator);
+    if (res != VK_SUCCESS)
+        std::cerr << "Failed to create memory allocator : " << res << std::endl;
+}
+
+VulkanMemoryAllocatorBackend::~VulkanMemoryAllocatorBackend()
+{
+    if (m_defragmentation != VK_NULL_HANDLE)
+        vmaEndDefragmentation(m_allocator, m_defragmentation, nullptr);
+    for (VmaPool pool : m_movablePools)
+    {
+        if (pool != VK_NULL_HANDLE)
+            vmaDestroyPool(m_allocator, pool);
+    }
+    if (m_allocator != VK_NULL_HANDLE)
+        vmaDestroyAllocator(m_allocator);
+}
+
+void VulkanMemoryAllocatorBackend::fillAllocation(VulkanMemoryAllocation& out) const
+{
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(m_allocator, out.allocation, &info);
+    out.memory = info.deviceMemory;
+    out.offset = info.offset;
+    out.size = info.size;
+    out.memoryTypeIndex = info.memoryType;
+    vmaGetAllocationMemoryProperties(m_allocator, out.allocation, &out.memoryProperties);
+}
+
+VmaPool VulkanMemoryAllocatorBackend::getMovablePool(const VkBufferCreateInfo& createInfo,
+                                                     const VmaAllocationCreateInfo& allocationInfo)
+{
+    uint32_t memoryTypeIndex = 0U;
+    VkResult res = vmaFindMemoryTypeIndexForBufferInfo(m_allocator, &createInfo, &allocationInfo,
+                                                       &memoryTypeIndex);
+    if (res != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    VmaPool& pool = m_movablePools[memoryTypeIndex];
+    if (pool == VK_NULL_HANDLE)
+    {
+        VmaPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.memoryTypeIndex = memoryTypeIndex;
+        res = vmaCreatePool(m_allocator, &poolCreateInfo, &pool);
+        if (res != VK_SUCCESS)
+        {
+            std::cerr << "Failed to create movable memory pool : " << res << std::endl;
+            pool = VK_NULL_HANDLE;
+        }
+    }
+    return pool;
+}
+
+bool VulkanMemoryAllocatorBackend::abandonMove(const VmaAllocation allocation)
+{
+    if (allocation == VK_NULL_HANDLE)
+        return false;
+
+    for (uint32_t i = 0; i < m_passInfo.moveCount; ++i)
+    {
+        VmaDefragmentationMove& move = m_passInfo.pMoves[i];
+        if (move.srcAllocation != allocation)
+            continue;
+        // vma frees the source and the destination when the pass ends
+        move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+        return true;
+    }
+    return false;
+}
+
+VkResult VulkanMemoryAllocatorBackend::createBuffer(const VkBufferCreateInfo& createInfo,
+                                                    const AllocationCreateInfoT& allocationInfo,
+                                                    VkBuffer* buffer,
+                                                    std::shared_ptr<AllocationABC>* allocation)
+{
+    auto out = std::make_shared<VulkanMemoryAllocation>();
+    VmaAllocationCreateInfo vmaInfo = makeAllocationCreateInfo(allocationInfo);
+    // the other allocations are never proposed for a move, nothing tells their owner
+    if (allocationInfo.bMovable)
+        vmaInfo.pool = getMovablePool(createInfo, vmaInfo);
+    VkResult res =
+        vmaCreateBuffer(m_allocator, &createInfo, &vmaInfo, buffer, &out->allocation, nullptr);
+    if (res != VK_SUCCESS)
+        return res;
+
+    fillAllocation(*out);
+    out->bDedicated = allocationInfo.bDedicated;
+    // defragmentation moves are given back with their allocation
+    vmaSetAllocationUserData(m_allocator, out->allocation, out.get());
+    *allocation = std::move(out);
+    return VK_SUCCESS;
+}
+
+void VulkanMemoryAllocatorBackend::destroyBuffer(const VkBuffer buffer,
+                                                 std::shared_ptr<AllocationABC>& allocation)
+{
+    auto* a = static_cast<VulkanMemoryAllocation*>(allocation.get());
+    const VmaAllocation vmaAllocation = a ? a->allocation : VK_NULL_HANDLE;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (abandonMove(vmaAllocation))
+        m_device->getContext()->DestroyBuffer(m_device->getHandle(), buffer, nullptr);
+    else
+        vmaDestroyBuffer(m_allocator, buffer, vmaAllocation);
+    allocation.reset();
+}
+
+VkResult VulkanMemoryAllocatorBackend::createImage(const VkImageCreateInfo& createInfo,
+                                                   const AllocationCreateInfoT& allocationInfo,
+                                                   VkImage* image,
+                                                   std::shared_ptr<AllocationABC>* allocation)
+{
+    auto out = std::make_shared<VulkanMemoryAllocation>();
+    VmaAllocationCreateInfo vmaInfo = makeAllocationCreateInfo(allocationInfo);
+    VkResult res =
+        vmaCreateImage(m_allocator, &createInfo, &vmaInfo, image, &out->allocation, nullptr);
+    if (res != VK_SUCCESS)
+        return res;
+
+    fillAllocation(*out);
+    out->bDedicated = allocationInfo.bDedicated;
+    // defragmentation moves are given back with their allocation
+    vmaSetAllocationUserData(m_allocator, out->allocation, out.get());
+    *allocation = std::move(out);
+    return VK_SUCCESS;
+}
+
+void VulkanMemoryAllocatorBackend::destroyImage(const VkImage image,
+                                                std::shared_ptr<AllocationABC>& allocation)
+{
+    auto* a = static_cast<VulkanMemoryAllocation*>(allocation.get());
+    const VmaAllocation vmaAllocation = a ? a->allocation : VK_NULL_HANDLE;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (abandonMove(vmaAllocation))
+        m_device->getContext()->DestroyImage(m_device->getHandle(), image, nullptr);
+    else
+        vmaDestroyImage(m_allocator, image, vmaAllocation);
+    allocation.reset();
+}
+
+VkResult VulkanMemoryAllocatorBackend::mapMemory(AllocationABC& allocation, void** ppData)
+{
+    return vmaMapMemory(m_allocator, static_cast<VulkanMemoryAllocation&>(allocation).allocation,
+                        ppData);
+}
+
+void VulkanMemoryAllocatorBackend::unmapMemory(AllocationABC& allocation)
+{
+    vmaUnmapMemory(m_allocator, static_cast<VulkanMemoryAllocation&>(allocation).allocation);
+}
+
+void VulkanMemoryAllocatorBackend::flush(AllocationABC& allocation, const VkDeviceSize offset,
+                                         const VkDeviceSize size)
+{
+    // vma skips coherent memory and aligns the range to nonCoherentAtomSize
+    vmaFlushAllocation(m_allocator, static_cast<VulkanMemoryAllocation&>(allocation).allocation,
+                       offset, size);
+}
+
+void VulkanMemoryAllocatorBackend::invalidate(AllocationABC& allocation, const VkDeviceSize offset,
+                                              const VkDeviceSize size)
+{
+    vmaInvalidateAllocation(m_allocator,
+                            static_cast<VulkanMemoryAllocation&>(allocation).allocation, offset,
+                            size);
+}
+
+VkResult VulkanMemoryAllocatorBackend::bindBufferMemory(AllocationABC& allocation,
+                                                        const VkBuffer buffer)
+{
+    return vmaBindBufferMemory(m_allocator,
+                               static_cast<VulkanMemoryAllocation&>(allocation).allocation, buffer);
+}
+
+VkResult VulkanMemoryAllocatorBackend::bindImageMemory(AllocationABC& allocation,
+                                                       const VkImage image)
+{
+    return vmaBindImageMemory(m_allocator,
+                              static_cast<VulkanMemoryAllocation&>(allocation).allocation, image);
+}
+
+bool VulkanMemoryAllocatorBackend::beginDefragmentationPass(
+    const VkDeviceSize maxBytes, std::vector<DefragmentationMoveT>* moves)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    // the movable pools are defragmented one after the other, each is visited once per call
+    VkResult res = VK_SUCCESS;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES && res != VK_INCOMPLETE; ++i)
+    {
+        if (m_defragmentation == VK_NULL_HANDLE)
+        {
+            VmaPool pool = m_movablePools[m_defragmentationTypeIndex];
+            if (pool == VK_NULL_HANDLE)
+            {
+                m_defragmentationTypeIndex = nextMemoryTypeIndex(m_defragmentationTypeIndex);
+                continue;
+            }
+
+            VmaDefragmentationInfo defragmentationInfo = {};
+            defragmentationInfo.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+            defragmentationInfo.pool = pool;
+            defragmentationInfo.maxBytesPerPass = maxBytes;
+
+            res = vmaBeginDefragmentation(m_allocator, &defragmentationInfo, &m_defragmentation);
+            if (res != VK_SUCCESS)
+            {
+                std::cerr << "Failed to begin defragmentation : " << res << std::endl;
+                m_defragmentation = VK_NULL_HANDLE;
+                return false;
+            }
+        }
+
+        // VK_SUCCESS means that there is nothing left to move in this pool
+        res = vmaBeginDefragmentationPass(m_allocator, m_defragmentation, &m_passInfo);
+        if (res == VK_INCOMPLETE)
+            continue;
+        if (res != VK_SUCCESS)
+            std::cerr << "Failed to begin defragmentation pass : " << res << std::endl;
+        vmaEndDefragmentation(m_allocator, m_defragmentation, nullptr);
+        m_defragmentation = VK_NULL_HANDLE;
+        m_passInfo = {};
+        m_defragmentationTypeIndex = nextMemoryTypeIndex(m_defragmentationTypeIndex);
+    }
+    if (res != VK_INCOMPLETE)
+        return false;
+
+    moves->clear();
+    moves->reserve(m_passInfo.moveCount);
+    for (uint32_t i = 0; i < m_passInfo.moveCount; ++i)
+    {
+        const VmaDefragmentationMove& move = m_passInfo.pMoves[i];
+
+        VmaAllocationInfo sourceInfo;
+        vmaGetAllocationInfo(m_allocator, move.srcAllocation, &sourceInfo);
+
+        auto destination = std::make_shared<VulkanMemoryAllocation>();
+        destination->allocation = move.dstTmpAllocation;
+        fillAllocation(*destination);
+
+        auto* source = static_cast<VulkanMemoryAllocation*>(sourceInfo.pUserData);
+        moves->emplace_back(DefragmentationMoveT{
+            .source = source,
+            .destination = std::move(destination),
+            .bIgnore = source == nullptr,
+        });
+    }
+    return true;
+}
+
+void VulkanMemoryAllocatorBackend::endDefragmentationPass(std::vector<DefragmentationMoveT>& moves)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_defragmentation == VK_NULL_HANDLE)
+        return;
+
+    for (uint32_t i = 0; i < m_passInfo.moveCount; ++i)
+    {
+        auto& move = m_passInfo.pMoves[i];
+        // the source was freed during the pass, its object is gone
+        if (move.operation == VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY)
+        {
+            moves[i].bIgnore = true;
+            continue;
+        }
+        move.operation = moves[i].bIgnore ? VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE
+                                          : VMA_DEFRAGMENTATION_MOVE_OPERATION_COPY;
+    }
+
+    // vma swaps the source and destination allocations and frees the old placement
+    VkResult res = vmaEndDefragmentationPass(m_allocator, m_defragmentation, &m_passInfo);
+    m_passInfo = {};
+    for (auto& move : moves)
+    {
+        if (!move.bIgnore)
+            fillAllocation(static_cast<VulkanMemoryAllocation&>(*move.source));
+        move.destination.reset();
+    }
+
+    if (res == VK_SUCCESS)
+    {
+        vmaEndDefragmentation(m_allocator, m_defragmentation, nullptr);
+        m_defragmentation = VK_NULL_HANDLE;
+        m_defragmentationTypeIndex = nextMemoryTypeIndex(m_defragmentationTypeIndex);
+    }
+}
+
+AllocatorStatsT VulkanMemoryAllocatorBackend::getStats() const
+{
+    VmaTotalStatistics stats;
+    vmaCalculateStatistics(m_allocator, &stats);
+
+    const auto& total = stats.total;
+    return AllocatorStatsT{
+        .blockCount = total.statistics.blockCount,
+        .allocationCount = total.statistics.allocationCount,
+        .reservedBytes = total.statistics.blockBytes,
+        .usedBytes = total.statistics.allocationBytes,
+        .largestFreeRange = total.unusedRangeCount > 0 ? total.unusedRangeSizeMax : 0U,
+    };
+}
+
+void VulkanMemoryAllocatorBackend::getHeapBudgets(std::vector<HeapBudgetT>* budgets) const
+{
+    const auto& properties = m_device->getPhysicalDevice()->getMemoryProperties();
+
+    VmaBudget vmaBudgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(m_allocator, vmaBudgets);
+
+    budgets->resize(properties.memoryHeapCount);
+    for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+    {
+        (*budgets)[i] = HeapBudgetT{
+            .size = properties.memoryHeaps[i].size,
+            .flags = properties.memoryHeaps[i].flags,
+            .usage = vmaBudgets[i].usage,
+            .budget = vmaBudgets[i].budget,
+            .reservedBytes = vmaBudgets[i].statistics.blockBytes,
+            .usedBytes = vmaBudgets[i].statistics.allocationBytes,
+        };
+    }
+}
+
+void VulkanMemoryAllocatorBackend::setCurrentFrameIndex(const uint32_t frameIndex)
+{
+    // also fetches the budget from the driver
+    vmaSetCurrentFrameIndex(m_allocator, frameIndex);
+}
+
+#define VMA_IMPLEMENTATION
+#include <vk_mem_alloc.h>
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+
+#include <vk_mem_alloc.h>
+
+#include "device/memory/memoryallocator.hpp"
+
+class VulkanMemoryAllocation : public AllocationABC
+{
+  public:
+    VmaAllocation allocation = VK_NULL_HANDLE;
+};
+
+class VulkanMemoryAllocatorBackend : public AllocatorBackendABC
+{
+  private:
+    VmaAllocator m_allocator = VK_NULL_HANDLE;
+
+    /**
+     * @brief guards the pools and the pass, frees are checked against the moves of the pass
+     *
+     */
+    std::mutex m_mutex;
+
+    /**
+     * @brief per memory type, created on the first movable buffer, only these are defragmented
+     *
+     */
+    std::array<VmaPool, VK_MAX_MEMORY_TYPES> m_movablePools = {};
+
+    /**
+     * @brief defragmentation in progress on the movable pool of m_defragmentationTypeIndex,
+     * passes are started until vma has nothing left to move in any movable pool
+     *
+     */
+    VmaDefragmentationContext m_defragmentation = VK_NULL_HANDLE;
+    uint32_t m_defragmentationTypeIndex = 0U;
+    VmaDefragmentationPassMoveInfo m_passInfo = {};
+
+    void fillAllocation(VulkanMemoryAllocation& out) const;
+    [[nodiscard]] VmaPool getMovablePool(const VkBufferCreateInfo& createInfo,
+                                         const VmaAllocationCreateInfo& allocationInfo);
+    /**
+     * @brief a source of the pass in progress is released by vma when the pass ends, only its
+     * resource is destroyed now, must be called with the lock held
+     *
+     * @return true if the allocation is a source of the pass in progress
+     */
+    [[nodiscard]] bool abandonMove(const VmaAllocation allocation);
+
+  public:
+    VulkanMemoryAllocatorBackend() = delete;
+    VulkanMemoryAllocatorBackend(const VulkanMemoryAllocatorBackend&) = delete;
+    VulkanMemoryAllocatorBackend& operator=(const VulkanMemoryAllocatorBackend&) = delete;
+
+    explicit VulkanMemoryAllocatorBackend(const LogicalDevice* device);
+    ~VulkanMemoryAllocatorBackend() override;
+
+    [[nodiscard]] VkResult createBuffer(const VkBufferCreateInfo& createInfo,
+                                        const AllocationCreateInfoT& allocationInfo,
+                                        VkBuffer* buffer,
+                                        std::shared_ptr<AllocationABC>* allocation) override;
+    void destroyBuffer(const VkBuffer buffer, std::shared_ptr<AllocationABC>& allocation) override;
+
+    [[nodiscard]] VkResult createImage(const VkImageCreateInfo& createInfo,
+                                       const AllocationCreateInfoT& allocationInfo, VkImage* image,
+                                       std::shared_ptr<AllocationABC>* allocation) override;
+    void destroyImage(const VkImage image, std::shared_ptr<AllocationABC>& allocation) override;
+
+    [[nodiscard]] VkResult mapMemory(AllocationABC& allocation, void** ppData) override;
+    void unmapMemory(AllocationABC& allocation) override;
+
+    void flush(AllocationABC& allocation, const VkDeviceSize offset,
+               const VkDeviceSize size) override;
+    void invalidate(AllocationABC& allocation, const VkDeviceSize offset,
+                    const VkDeviceSize size) override;
+
+    [[nodiscard]] VkResult bindBufferMemory(AllocationABC& allocation,
+                                            const VkBuffer buffer) override;
+    [[nodiscard]] VkResult bindImageMemory(AllocationABC& allocation, const VkImage image) override;
+
+    [[nodiscard]] bool beginDefragmentationPass(const VkDeviceSize maxBytes,
+                                                std::vector<DefragmentationMoveT>* moves) override;
+    void endDefragmentationPass(std::vector<DefragmentationMoveT>& moves) override;
+
+    [[nodiscard]] AllocatorStatsT getStats() const override;
+    void getHeapBudgets(std::vector<HeapBudgetT>* budgets) const override;
+    void setCurrentFrameIndex(const uint32_t frameIndex) override;
+
+  public:
+    [[nodiscard]] inline VmaAllocator getHandle() const { return m_allocator; }
+};
@@ -0,0 +1,192 @@
+#include <iostream>
+
+#include "impl/tlsf_allocator_backend.hpp"
+#include "impl/vma_allocator_backend.hpp"
+
+#include "memoryallocator.hpp"
+
+const char* getAllocationTypeName(const AllocationTypeE type)
+{
+    switch (type)
+    {
+    case AllocationTypeE::MESH:
+        return "mesh";
+    case AllocationTypeE::UNIFORM:
+        return "uniform";
+    case AllocationTypeE::IMAGE:
+        return "image";
+    case AllocationTypeE::STAGING:
+        return "staging";
+    case AllocationTypeE::SCENE:
+        return "scene";
+    case AllocationTypeE::TRANSIENT:
+        return "transient";
+    case AllocationTypeE::OTHER:
+    default:
+        return "other";
+    }
+}
+
+MemoryAllocator::MemoryAllocator(const MemoryAllocatorCreateInfoT createInfo) : ci(createInfo)
+{
+    switch (ci.backend)
+    {
+    case AllocatorBackendE::TLSF:
+        m_backend = std::make_unique<TLSFAllocatorBackend>(TLSFAllocatorBackendCreateInfoT{
+            .device = ci.device,
+            .blockSize = ci.blockSize,
+            .dedicatedThreshold = ci.dedicatedThreshold,
+        });
+        break;
+    case AllocatorBackendE::VMA:
+    default:
+        m_backend = std::make_unique<VulkanMemoryAllocatorBackend>(ci.device);
+        break;
+    }
+
+    m_budgetCallback = [](const uint32_t heapIndex, const HeapBudgetT& budget) {
+        std::cerr << "Memory heap " << heapIndex << " close to its budget : "
+                  << (budget.usage >> 20) << " MiB used of " << (budget.budget >> 20) << " MiB"
+                  << std::endl;
+    };
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+    // resources still alive at this point are leaked by their owner
+    AllocatorStatsT stats = m_backend->getStats();
+    if (stats.allocationCount > 0U)
+    {
+        std::cerr << "Memory allocator destroyed with " << stats.allocationCount
+                  << " live allocations (" << stats.usedBytes << " bytes)" << std::endl;
+    }
+}
+
+void MemoryAllocator::account(const AllocationABC& allocation)
+{
+    auto& counters = m_typeCounters[static_cast<size_t>(allocation.type)];
+    ++counters.allocationCount;
+    const VkDeviceSize bytes = counters.bytes += allocation.size;
+
+    VkDeviceSize peak = counters.peakBytes.load();
+    while (bytes > peak && !counters.peakBytes.compare_exchange_weak(peak, bytes))
+    {
+    }
+}
+
+void MemoryAllocator::unaccount(const AllocationABC& allocation)
+{
+    auto& counters = m_typeCounters[static_cast<size_t>(allocation.type)];
+    --counters.allocationCount;
+    counters.bytes -= allocation.size;
+}
+
+VkResult MemoryAllocator::createBuffer(const VkBufferCreateInfo& createInfo,
+                                       const AllocationCreateInfoT& allocationInfo,
+                                       VkBuffer* buffer,
+                                       std::shared_ptr<AllocationABC>* allocation)
+{
+    VkResult res = m_backend->createBuffer(createInfo, allocationInfo, buffer, allocation);
+    if (res == VK_SUCCESS)
+    {
+        (*allocation)->type = allocationInfo.type;
+        account(**allocation);
+    }
+    return res;
+}
+
+void MemoryAllocator::destroyBuffer(const VkBuffer buffer,
+                                    std::shared_ptr<AllocationABC>& allocation)
+{
+    if (allocation)
+        unaccount(*allocation);
+    m_backend->destroyBuffer(buffer, allocation);
+}
+
+VkResult MemoryAllocator::createImage(const VkImageCreateInfo& createInfo,
+                                      const AllocationCreateInfoT& allocationInfo, VkImage* image,
+                                      std::shared_ptr<AllocationABC>* allocation)
+{
+    VkResult res = m_backend->createImage(createInfo, allocationInfo, image, allocation);
+    if (res == VK_SUCCESS)
+    {
+        (*allocation)->type = allocationInfo.type;
+        account(**allocation);
+    }
+    return res;
+}
+
+void MemoryAllocator::destroyImage(const VkImage image, std::shared_ptr<AllocationABC>& allocation)
+{
+    if (allocation)
+        unaccount(*allocation);
+    m_backend->destroyImage(image, allocation);
+}
+
+void MemoryAllocator::setCurrentFrameIndex(const uint32_t frameIndex)
+{
+    m_backend->setCurrentFrameIndex(frameIndex);
+
+    m_backend->getHeapBudgets(&m_heapBudgets);
+    m_overBudgetWarning.resize(m_heapBudgets.size(), false);
+    for (uint32_t i = 0; i < m_heapBudgets.size(); ++i)
+    {
+        // warn once per crossing instead of every frame
+        const bool bOver = m_heapBudgets[i].getUsageRatio() >= ci.budgetWarningRatio;
+        if (bOver && !m_overBudgetWarning[i] && m_budgetCallback)
+            m_budgetCallback(i, m_heapBudgets[i]);
+        m_overBudgetWarning[i] = bOver;
+    }
+}
+
+AllocationTypeStatsT MemoryAllocator::getTypeStats(const AllocationTypeE type) const
+{
+    const auto& counters = m_typeCounters[static_cast<size_t>(type)];
+    return AllocationTypeStatsT{
+        .allocationCount = counters.allocationCount.load(),
+        .bytes = counters.bytes.load(),
+        .peakBytes = counters.peakBytes.load(),
+    };
+}
+
+void MemoryAllocator::dumpJson(std::ostream& os) const
+{
+    const AllocatorStatsT stats = getStats();
+    std::vector<HeapBudgetT> budgets;
+    getHeapBudgets(&budgets);
+
+    os << "{\n";
+    os << "  \"backend\": \"" << (ci.backend == AllocatorBackendE::TLSF ? "tlsf" : "vma")
+       << "\",\n";
+    os << "  \"stats\": {\"blockCount\": " << stats.blockCount
+       << ", \"allocationCount\": " << stats.allocationCount
+       << ", \"dedicatedAllocationCount\": " << stats.dedicatedAllocationCount
+       << ", \"reservedBytes\": " << stats.reservedBytes << ", \"usedBytes\": " << stats.usedBytes
+       << ", \"largestFreeRange\": " << stats.largestFreeRange
+       << ", \"fragmentation\": " << stats.getFragmentation() << "},\n";
+
+    os << "  \"heaps\": [";
+    for (size_t i = 0; i < budgets.size(); ++i)
+    {
+        const auto& b = budgets[i];
+        os << (i == 0 ? "\n" : ",\n") << "    {\"index\": " << i << ", \"size\": " << b.size
+           << ", \"deviceLocal\": "
+           << ((b.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "true" : "false")
+           << ", \"usage\": " << b.usage << ", \"budget\": " << b.budget
+           << ", \"reservedBytes\": " << b.reservedBytes << ", \"usedBytes\": " << b.usedBytes
+           << "}";
+    }
+    os << "\n  ],\n";
+
+    os << "  \"types\": {";
+    for (size_t i = 0; i < m_typeCounters.size(); ++i)
+    {
+        const auto type = static_cast<AllocationTypeE>(i);
+        const AllocationTypeStatsT typeStats = getTypeStats(type);
+        os << (i == 0 ? "\n" : ",\n") << "    \"" << getAllocationTypeName(type)
+           << "\": {\"allocationCount\": " << typeStats.allocationCount
+           << ", \"bytes\": " << typeStats.bytes << ", \"peakBytes\": " << typeStats.peakBytes
+           << "}";
+    }
+    os << "\n  }\n}" << std::endl;
+}
@@ -1,117 +1,421 @@
 #pragma once
 
-#include <deque>
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <ostream>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
-class AllocationI
+class LogicalDevice;
+
+enum class AllocatorBackendE
 {
-  public:
-    virtual ~AllocationI() = 0;
+    /**
+     * @brief Vulkan Memory Allocator
+     *
+     */
+    VMA = 0,
+    /**
+     * @brief in-house TLSF sub-allocator (MyMemoryAllocator)
+     *
+     */
+    TLSF = 1,
 };
 
-class AllocatorI
+/**
+ * @brief what the memory is used for, bytes are accounted per type
+ *
+ */
+enum class AllocationTypeE
 {
-  public:
-    virtual void createAllocatorInstance(VkInstance instance, VkPhysicalDevice pdevice,
-                                         VkDevice ldevice) = 0;
-    virtual void destroyAllocatorInstance(VkDevice ldevice) = 0;
-
-    // TODO : do not use custom class PhysicalDevice as function argument
-    virtual void allocateBufferObjectMemory(VkDevice ldevice, class PhysicalDevice pdevice,
-                                            class VkBufferCreateInfo& createInfo,
-                                            class IVertexBuffer* vbo, uint32_t memoryFlags = 0,
-                                            bool mappable = false) = 0;
-    virtual void destroyBufferObjectMemory(VkDevice ldevice, class IVertexBuffer* vbo) = 0;
-
-    virtual void mapMemory(VkDevice ldevice, AllocationI* allocation, void** ppData) = 0;
-    virtual void unmapMemory(VkDevice ldevice, AllocationI* allocation) = 0;
+    OTHER = 0,
+    MESH = 1,
+    UNIFORM = 2,
+    IMAGE = 3,
+    STAGING = 4,
+    SCENE = 5,
+    TRANSIENT = 6,
+    COUNT = 7,
 };
 
-class AllocatorBackendABC : public AllocatorI
+[[nodiscard]] const char* getAllocationTypeName(const AllocationTypeE type);
+
+struct AllocationCreateInfoT
 {
+    VkMemoryPropertyFlags requiredFlags = 0;
+    /**
+     * @brief used to choose between the memory types having the required flags
+     *
+     */
+    VkMemoryPropertyFlags preferredFlags = 0;
+    /**
+     * @brief the resource gets its own VkDeviceMemory, backends also decide it for large resources
+     *
+     */
+    bool bDedicated = false;
+    /**
+     * @brief the resource follows the defragmentation moves, backends keep it apart from the
+     * memory that must stay in place
+     *
+     */
+    bool bMovable = false;
+    AllocationTypeE type = AllocationTypeE::OTHER;
 };
 
-class MemoryAllocator
+/**
+ * @brief memory bound to a buffer or an image, the backends extend it with their own handle
+ * offsets given to the allocator functions are relative to the allocation
+ *
+ */
+class AllocationABC
 {
-  private:
-    std::unique_ptr<AllocatorBackendABC> m_backend;
+  public:
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    uint32_t memoryTypeIndex = 0;
+    VkMemoryPropertyFlags memoryProperties = 0;
+    bool bDedicated = false;
+    AllocationTypeE type = AllocationTypeE::OTHER;
+
+    virtual ~AllocationABC() = default;
+
+    [[nodiscard]] inline bool isHostCoherent() const
+    {
+        return (memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    }
+};
+
+struct AllocatorStatsT
+{
+    /**
+     * @brief VkDeviceMemory objects, dedicated ones included
+     *
+     */
+    uint32_t blockCount = 0U;
+    uint32_t allocationCount = 0U;
+    uint32_t dedicatedAllocationCount = 0U;
+    /**
+     * @brief bytes of device memory allocated from the driver
+     *
+     */
+    VkDeviceSize reservedBytes = 0U;
+    /**
+     * @brief bytes handed out to resources
+     *
+     */
+    VkDeviceSize usedBytes = 0U;
+    VkDeviceSize largestFreeRange = 0U;
+
+    /**
+     * @brief 0 when the free memory is a single range, close to 1 when it is scattered in small
+     * ranges
+     *
+     */
+    [[nodiscard]] inline double getFragmentation() const
+    {
+        const VkDeviceSize freeBytes = reservedBytes - usedBytes;
+        return freeBytes == 0U ? 0.0 : 1.0 - static_cast<double>(largestFreeRange) / freeBytes;
+    }
 };
 
-// TODO : move below to impl folder
+struct HeapBudgetT
+{
+    VkDeviceSize size = 0U;
+    VkMemoryHeapFlags flags = 0;
+    /**
+     * @brief bytes of the heap used by the process, other allocators and the driver included
+     * when VK_EXT_memory_budget is enabled, the allocator blocks otherwise
+     *
+     */
+    VkDeviceSize usage = 0U;
+    /**
+     * @brief bytes the process can use before allocations fail or degrade, reported by
+     * VK_EXT_memory_budget when enabled, estimated to 80 % of the heap otherwise
+     *
+     */
+    VkDeviceSize budget = 0U;
+    /**
+     * @brief bytes of device memory allocated by the allocator in the heap
+     *
+     */
+    VkDeviceSize reservedBytes = 0U;
+    /**
+     * @brief bytes handed out to resources in the heap
+     *
+     */
+    VkDeviceSize usedBytes = 0U;
 
-// #ifdef USE_VMA
+    [[nodiscard]] inline double getUsageRatio() const
+    {
+        return budget == 0U ? 0.0 : static_cast<double>(usage) / budget;
+    }
+};
 
-#include <vk_mem_alloc.h>
+/**
+ * @brief relocation of an allocation proposed by a defragmentation pass
+ *
+ */
+struct DefragmentationMoveT
+{
+    AllocationABC* source = nullptr;
+    /**
+     * @brief new placement, a new resource is bound to it and the content copied before the pass
+     * ends
+     *
+     */
+    std::shared_ptr<AllocationABC> destination;
+    /**
+     * @brief set by the caller for the moves it cannot perform, the source then stays in place
+     *
+     */
+    bool bIgnore = false;
+};
 
-class VulkanMemoryAllocation : public AllocationI
+class AllocatorI
 {
   public:
-    VmaAllocation allocation;
+    virtual ~AllocatorI() = default;
+
+    [[nodiscard]] virtual VkResult createBuffer(const VkBufferCreateInfo& createInfo,
+                                                const AllocationCreateInfoT& allocationInfo,
+                                                VkBuffer* buffer,
+                                                std::shared_ptr<AllocationABC>* allocation) = 0;
+    virtual void destroyBuffer(const VkBuffer buffer,
+                               std::shared_ptr<AllocationABC>& allocation) = 0;
+
+    [[nodiscard]] virtual VkResult createImage(const VkImageCreateInfo& createInfo,
+                                               const AllocationCreateInfoT& allocationInfo,
+                                               VkImage* image,
+                                               std::shared_ptr<AllocationABC>* allocation) = 0;
+    virtual void destroyImage(const VkImage image, std::shared_ptr<AllocationABC>& allocation) = 0;
+
+    /**
+     * @brief map calls are counted, the memory stays mapped until every map is matched by an unmap
+     *
+     */
+    [[nodiscard]] virtual VkResult mapMemory(AllocationABC& allocation, void** ppData) = 0;
+    virtual void unmapMemory(AllocationABC& allocation) = 0;
+
+    /**
+     * @brief make host writes visible to the device, no-op on host coherent memory
+     *
+     */
+    virtual void flush(AllocationABC& allocation, const VkDeviceSize offset,
+                       const VkDeviceSize size) = 0;
+    /**
+     * @brief make device writes visible to the host, no-op on host coherent memory
+     *
+     */
+    virtual void invalidate(AllocationABC& allocation, const VkDeviceSize offset,
+                            const VkDeviceSize size) = 0;
+
+    [[nodiscard]] virtual VkResult bindBufferMemory(AllocationABC& allocation,
+                                                    const VkBuffer buffer) = 0;
+    [[nodiscard]] virtual VkResult bindImageMemory(AllocationABC& allocation,
+                                                   const VkImage image) = 0;
+
+    /**
+     * @brief propose moves of at most maxBytes toward fewer and fuller blocks
+     * a single pass can be in progress, the caller binds new resources to the destinations,
+     * records the copies, and ends the pass once the device is done with the copies and with the
+     * old resources
+     * only the allocations created movable are proposed, a source freed while the pass is in
+     * progress is released when the pass ends
+     *
+     * @return false when there is nothing left to move, no pass is started then
+     */
+    [[nodiscard]] virtual bool beginDefragmentationPass(
+        const VkDeviceSize maxBytes, std::vector<DefragmentationMoveT>* moves) = 0;
+    /**
+     * @brief the moved source allocations describe their new placement afterwards, their old
+     * placement and the destinations of the ignored moves are released
+     *
+     */
+    virtual void endDefragmentationPass(std::vector<DefragmentationMoveT>& moves) = 0;
+
+    [[nodiscard]] virtual AllocatorStatsT getStats() const = 0;
+    /**
+     * @brief one entry per memory heap, the vector is reused
+     *
+     */
+    virtual void getHeapBudgets(std::vector<HeapBudgetT>* budgets) const = 0;
+    /**
+     * @brief called once per frame, backends refresh the budget reported by the driver
+     *
+     */
+    virtual void setCurrentFrameIndex(const uint32_t frameIndex) = 0;
 };
 
-class VulkanMemoryAllocatorBackend : public AllocatorBackendABC
+class AllocatorBackendABC : public AllocatorI
 {
-  private:
-    VmaAllocator allocator;
+  protected:
+    const LogicalDevice* m_device;
 
   public:
-    void createAllocatorInstance(VkInstance instance, VkPhysicalDevice pdevice,
-                                 VkDevice ldevice) override;
-    void destroyAllocatorInstance(VkDevice ldevice) override;
+    AllocatorBackendABC() = delete;
+    explicit AllocatorBackendABC(const LogicalDevice* device) : m_device(device) {}
+};
+
+struct MemoryAllocatorCreateInfoT
+{
+    const LogicalDevice* device;
+    AllocatorBackendE backend = AllocatorBackendE::VMA;
 
-    void allocateBufferObjectMemory(VkDevice ldevice, class PhysicalDevice pdevice,
-                                    VkBufferCreateInfo& createInfo, class IVertexBuffer* vbo,
-                                    uint32_t memoryFlags = 0, bool mappable = false) override;
-    void destroyBufferObjectMemory(VkDevice ldevice, class IVertexBuffer* vbo) override;
+    /**
+     * @brief size of the VkDeviceMemory blocks sub-allocated by the TLSF backend, reduced on small
+     * heaps
+     *
+     */
+    VkDeviceSize blockSize = 64ULL << 20;
+    /**
+     * @brief resources at least this large get a dedicated allocation with the TLSF backend
+     *
+     */
+    VkDeviceSize dedicatedThreshold = 16ULL << 20;
 
-    void mapMemory(VkDevice ldevice, AllocationI* allocation, void** ppData) override;
-    void unmapMemory(VkDevice ldevice, AllocationI* allocation) override;
+    /**
+     * @brief HeapBudgetT::getUsageRatio above which the budget callback is called
+     *
+     */
+    double budgetWarningRatio = 0.9;
 };
-// #else
-struct MyMemoryAllocator : public AllocatorBackendABC
+
+struct AllocationTypeStatsT
 {
-    struct MemoryBlockT
-    {
-        // memory allocated on the GPU heap
-        VkDeviceMemory memory;
+    uint32_t allocationCount = 0U;
+    VkDeviceSize bytes = 0U;
+    VkDeviceSize peakBytes = 0U;
+};
+
+/**
+ * @brief called when a heap crosses the warning ratio of its budget, again only after it went
+ * back under it
+ *
+ */
+typedef std::function<void(const uint32_t heapIndex, const HeapBudgetT& budget)> BudgetCallbackT;
+
+/**
+ * @brief device memory allocator, every buffer and image memory goes through it
+ * the backend is chosen at creation, users only see AllocationABC
+ * bytes and allocations are accounted per AllocationTypeE on top of the backend statistics
+ *
+ */
+class MemoryAllocator : public AllocatorI
+{
+  private:
+    const MemoryAllocatorCreateInfoT ci;
 
-        size_t usedSpace = 0;
+  private:
+    std::unique_ptr<AllocatorBackendABC> m_backend;
 
-        bool operator==(MemoryBlockT& other) const
-        {
-            return memory == other.memory && usedSpace == other.usedSpace;
-        }
+    struct TypeCountersT
+    {
+        std::atomic<uint32_t> allocationCount = 0U;
+        std::atomic<VkDeviceSize> bytes = 0U;
+        std::atomic<VkDeviceSize> peakBytes = 0U;
     };
+    std::array<TypeCountersT, static_cast<size_t>(AllocationTypeE::COUNT)> m_typeCounters;
 
-    // default block size
-    size_t blockSize = 1024;
-    std::deque<MemoryBlockT> memBlocks;
+    void account(const AllocationABC& allocation);
+    void unaccount(const AllocationABC& allocation);
 
-    MemoryBlockT& findFirstAvailableBlock(VkDevice ldevice, class PhysicalDevice pdevice,
-                                          size_t querySize, VkBuffer& buffer,
-                                          VkMemoryPropertyFlags memProperties);
+    /**
+     * @brief budget check state, only touched by the render thread
+     *
+     */
+    std::vector<HeapBudgetT> m_heapBudgets;
+    std::vector<bool> m_overBudgetWarning;
+    BudgetCallbackT m_budgetCallback;
 
-    void createAllocatorInstance(VkInstance instance, VkPhysicalDevice pdevice,
-                                 VkDevice ldevice) override
+  public:
+    MemoryAllocator() = delete;
+    MemoryAllocator(const MemoryAllocator&) = delete;
+    MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+    MemoryAllocator(MemoryAllocator&&) = delete;
+    MemoryAllocator& operator=(MemoryAllocator&&) = delete;
+
+    explicit MemoryAllocator(const MemoryAllocatorCreateInfoT createInfo);
+    ~MemoryAllocator() override;
+
+    [[nodiscard]] VkResult createBuffer(const VkBufferCreateInfo& createInfo,
+                                        const AllocationCreateInfoT& allocationInfo,
+                                        VkBuffer* buffer,
+                                        std::shared_ptr<AllocationABC>* allocation) override;
+    void destroyBuffer(const VkBuffer buffer, std::shared_ptr<AllocationABC>& allocation) override;
+
+    [[nodiscard]] VkResult createImage(const VkImageCreateInfo& createInfo,
+                                       const AllocationCreateInfoT& allocationInfo, VkImage* image,
+                                       std::shared_ptr<AllocationABC>* allocation) override;
+    void destroyImage(const VkImage image, std::shared_ptr<AllocationABC>& allocation) override;
+
+    [[nodiscard]] VkResult mapMemory(AllocationABC& allocation, void** ppData) override
     {
+        return m_backend->mapMemory(allocation, ppData);
     }
-    void destroyAllocatorInstance(VkDevice ldevice) override;
+    void unmapMemory(AllocationABC& allocation) override { m_backend->unmapMemory(allocation); }
 
-    void allocateBufferObjectMemory(VkDevice ldevice, PhysicalDevice pdevice,
-                                    VkBufferCreateInfo& createInfo, class IVertexBuffer* vbo,
-                                    uint32_t memoryFlags = 0, bool mappable = false) override;
-    void destroyBufferObjectMemory(VkDevice ldevice, IVertexBuffer* vbo) override;
+    void flush(AllocationABC& allocation, const VkDeviceSize offset,
+               const VkDeviceSize size) override
+    {
+        m_backend->flush(allocation, offset, size);
+    }
+    void invalidate(AllocationABC& allocation, const VkDeviceSize offset,
+                    const VkDeviceSize size) override
+    {
+        m_backend->invalidate(allocation, offset, size);
+    }
+
+    [[nodiscard]] VkResult bindBufferMemory(AllocationABC& allocation,
+                                            const VkBuffer buffer) override
+    {
+        return m_backend->bindBufferMemory(allocation, buffer);
+    }
+    [[nodiscard]] VkResult bindImageMemory(AllocationABC& allocation, const VkImage image) override
+    {
+        return m_backend->bindImageMemory(allocation, image);
+    }
+
+    [[nodiscard]] bool beginDefragmentationPass(const VkDeviceSize maxBytes,
+                                                std::vector<DefragmentationMoveT>* moves) override
+    {
+        return m_backend->beginDefragmentationPass(maxBytes, moves);
+    }
+    void endDefragmentationPass(std::vector<DefragmentationMoveT>& moves) override
+    {
+        m_backend->endDefragmentationPass(moves);
+    }
+
+    [[nodiscard]] AllocatorStatsT getStats() const override { return m_backend->getStats(); }
+    void getHeapBudgets(std::vector<HeapBudgetT>* budgets) const override
+    {
+        m_backend->getHeapBudgets(budgets);
+    }
+    /**
+     * @brief refresh the budgets and call the budget callback for the heaps crossing the warning
+     * ratio
+     *
+     */
+    void setCurrentFrameIndex(const uint32_t frameIndex) override;
+
+    [[nodiscard]] AllocationTypeStatsT getTypeStats(const AllocationTypeE type) const;
+
+    /**
+     * @brief the default callback prints a warning
+     *
+     */
+    void setBudgetCallback(BudgetCallbackT callback) { m_budgetCallback = std::move(callback); }
+
+    /**
+     * @brief statistics, heap budgets and per type accounting as a JSON object
+     *
+     */
+    void dumpJson(std::ostream& os) const;
 
-    void mapMemory(VkDevice ldevice, AllocationI* allocation, void** ppData) override;
-    void unmapMemory(VkDevice ldevice, AllocationI* allocation) override;
-};
-class MyAllocation : public AllocationI
-{
   public:
-    // binded memory block
-    struct MyMemoryAllocator::MemoryBlock* memoryBlock = nullptr;
-    size_t memoryOffset = 0;
+    [[nodiscard]] inline AllocatorBackendE getBackendType() const { return ci.backend; }
+    [[nodiscard]] inline AllocatorBackendABC* getBackend() const { return m_backend.get(); }
 };
-// #endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <iostream>
+
+#include "device/device.hpp"
+#include "physical_device.hpp"
+
+#include "buffer.hpp"
+
+#include "uniform_ring.hpp"
+
+UniformRing::UniformRing(const UniformRingCreateInfoT createInfo) : ci(createInfo)
+{
+    const auto& limits = ci.device->getPhysicalDevice()->getLimits();
+    m_alignment = std::max<VkDeviceSize>(1U, limits.minUniformBufferOffsetAlignment);
+
+    // the dynamic offset of the last element plus the binding range must stay in the region
+    m_regionSize = alignUp(std::max(ci.sizePerFrame, ci.bindingRange));
+
+    // coherence is not required, non coherent memory is flushed explicitly
+    m_buffer = ci.device->createBuffer(BufferCreateInfoT{
+        .size = m_regionSize * ci.frameCount,
+        .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        .allocationType = AllocationTypeE::UNIFORM,
+    });
+
+    m_bCoherent = m_buffer->memory->isHostCoherent();
+
+    void* mapped = nullptr;
+    ci.device->mapBufferMemory(m_buffer, &mapped);
+    m_mapped = static_cast<uint8_t*>(mapped);
+}
+
+UniformRing::~UniformRing()
+{
+    if (!m_buffer)
+        return;
+
+    ci.device->getMemoryAllocator()->unmapMemory(*m_buffer->memory);
+    ci.device->destroyBuffer(m_buffer);
+}
+
+void UniformRing::begin(const uint32_t frameIndex)
+{
+    m_regionBase = (frameIndex % ci.frameCount) * m_regionSize;
+    m_head = 0U;
+    m_flushedHead = 0U;
+}
+
+void* UniformRing::allocate(const VkDeviceSize size, uint32_t* dynamicOffset)
+{
+    UniformArrayT array = allocateArray(1U, size);
+    if (dynamicOffset)
+        *dynamicOffset = array.baseOffset;
+    return array.data;
+}
+
+UniformArrayT UniformRing::allocateArray(const uint32_t count, const VkDeviceSize elementSize)
+{
+    const VkDeviceSize stride = alignUp(elementSize);
+    const VkDeviceSize offset = alignUp(m_head);
+    // the last element is read through a whole binding range
+    const VkDeviceSize end =
+        offset + (count > 0 ? (count - 1) * stride + std::max(elementSize, ci.bindingRange) : 0);
+    if (end > m_regionSize)
+    {
+        if (!m_bOverflowReported)
+        {
+            std::cerr << "Uniform ring exhausted : " << end << " bytes requested in a "
+                      << m_regionSize << " bytes frame region" << std::endl;
+            m_bOverflowReported = true;
+        }
+        return {};
+    }
+
+    m_head = offset + count * stride;
+    return UniformArrayT{
+        .data = m_mapped + m_regionBase + offset,
+        .baseOffset = static_cast<uint32_t>(m_regionBase + offset),
+        .stride = static_cast<uint32_t>(stride),
+        .count = count,
+    };
+}
+
+void UniformRing::flush()
+{
+    if (m_bCoherent || m_head == m_flushedHead)
+        return;
+
+    // the allocator aligns the range to nonCoherentAtomSize
+    ci.device->getMemoryAllocator()->flush(*m_buffer->memory, m_regionBase + m_flushedHead,
+                                           m_head - m_flushedHead);
+    m_flushedHead = m_head;
+}
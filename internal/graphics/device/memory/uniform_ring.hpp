@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+class Buffer;
+
+struct UniformRingCreateInfoT
+{
+    const LogicalDevice* device;
+
+    /**
+     * @brief one region per frame in flight, a region is only rewritten once its frame is done
+     *
+     */
+    uint32_t frameCount;
+    VkDeviceSize sizePerFrame = 4ULL << 20;
+    /**
+     * @brief range of the UNIFORM_BUFFER_DYNAMIC descriptors pointing into the ring, the largest
+     * structure read through a single dynamic offset
+     *
+     */
+    VkDeviceSize bindingRange = 256U;
+};
+
+/**
+ * @brief contiguous array of uniform structures in the ring, each element starts at a dynamic
+ * offset aligned to minUniformBufferOffsetAlignment
+ *
+ */
+struct UniformArrayT
+{
+    uint8_t* data = nullptr;
+    uint32_t baseOffset = 0U;
+    uint32_t stride = 0U;
+    uint32_t count = 0U;
+
+    [[nodiscard]] inline bool isValid() const { return data != nullptr; }
+    [[nodiscard]] inline void* at(const uint32_t i) const { return data + i * stride; }
+    [[nodiscard]] inline uint32_t dynamicOffset(const uint32_t i) const
+    {
+        return baseOffset + i * stride;
+    }
+};
+
+/**
+ * @brief per frame linear allocator over a persistently mapped uniform buffer
+ * sub-ranges are handed out with a bump pointer and addressed with dynamic offsets, a frame
+ * region is rewound by begin once the frame that used it is done, writes are flushed before the
+ * submission when the memory is not host coherent
+ * not thread safe, the render thread owns it
+ *
+ */
+class UniformRing
+{
+  private:
+    const UniformRingCreateInfoT ci;
+
+  private:
+    std::shared_ptr<Buffer> m_buffer;
+    uint8_t* m_mapped = nullptr;
+    bool m_bCoherent = true;
+
+    VkDeviceSize m_alignment = 1U;
+    VkDeviceSize m_regionSize = 0U;
+    VkDeviceSize m_regionBase = 0U;
+    VkDeviceSize m_head = 0U;
+    VkDeviceSize m_flushedHead = 0U;
+
+    bool m_bOverflowReported = false;
+
+    [[nodiscard]] inline VkDeviceSize alignUp(const VkDeviceSize value) const
+    {
+        return (value + m_alignment - 1) & ~(m_alignment - 1);
+    }
+
+  public:
+    UniformRing() = delete;
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+    UniformRing(UniformRing&&) = delete;
+    UniformRing& operator=(UniformRing&&) = delete;
+
+    explicit UniformRing(const UniformRingCreateInfoT createInfo);
+    ~UniformRing();
+
+    /**
+     * @brief rewind the region of the frame, its previous content must not be in use anymore
+     *
+     */
+    void begin(const uint32_t frameIndex);
+
+    /**
+     * @brief aligned sub-range of the current frame region
+     *
+     * @return null if the region is exhausted
+     */
+    [[nodiscard]] void* allocate(const VkDeviceSize size, uint32_t* dynamicOffset);
+    /**
+     * @brief count elements of elementSize bytes, each aligned for dynamic offsets, written in a
+     * single pass
+     *
+     */
+    [[nodiscard]] UniformArrayT allocateArray(const uint32_t count, const VkDeviceSize elementSize);
+
+    /**
+     * @brief make the writes of the current frame visible to the device (no-op on coherent
+     * memory), to be called before the submission
+     *
+     */
+    void flush();
+
+  public:
+    [[nodiscard]] inline const std::shared_ptr<Buffer>& getBuffer() const { return m_buffer; }
+    [[nodiscard]] inline VkDeviceSize getBindingRange() const { return ci.bindingRange; }
+    [[nodiscard]] inline VkDeviceSize getAlignment() const { return m_alignment; }
+    [[nodiscard]] inline VkDeviceSize getUsedSize() const { return m_head; }
+    [[nodiscard]] inline bool isCoherent() const { return m_bCoherent; }
+};
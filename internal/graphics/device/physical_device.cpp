@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
 #include <set>
 
 #include "context.hpp"
@@ -13,6 +16,130 @@ void PhysicalDevice::initPhysicalDeviceProperties()
     cx->GetPhysicalDeviceProperties(*m_handle, &props);
     m_properties = props;
     m_limits = m_properties.limits;
+
+    cx->GetPhysicalDeviceMemoryProperties(*m_handle, &m_memoryProperties);
+}
+
+void PhysicalDevice::initPhysicalDeviceFeatures()
+{
+    m_graphicsPipelineLibraryFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+    };
+    m_graphicsPipelineLibraryProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT,
+    };
+    m_shaderObjectFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT,
+    };
+    m_descriptorIndexingFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+    };
+    m_descriptorIndexingProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+    };
+    m_hostImageCopyFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT,
+    };
+    // the layout arrays are filled by a second query, once their sizes are known
+    VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT,
+    };
+
+    // structures of unsupported extensions must not be chained
+    void* featuresChain = nullptr;
+    void* propertiesChain = nullptr;
+    if (isExtensionSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+    {
+        m_graphicsPipelineLibraryFeatures.pNext = featuresChain;
+        featuresChain = &m_graphicsPipelineLibraryFeatures;
+        m_graphicsPipelineLibraryProperties.pNext = propertiesChain;
+        propertiesChain = &m_graphicsPipelineLibraryProperties;
+    }
+    if (isExtensionSupported(VK_EXT_SHADER_OBJECT_EXTENSION_NAME))
+    {
+        m_shaderObjectFeatures.pNext = featuresChain;
+        featuresChain = &m_shaderObjectFeatures;
+    }
+    const bool bHostImageCopy = supportsHostImageCopyExtensions();
+    if (bHostImageCopy)
+    {
+        m_hostImageCopyFeatures.pNext = featuresChain;
+        featuresChain = &m_hostImageCopyFeatures;
+    }
+    // core since Vulkan 1.2
+    if (m_properties.apiVersion >= VK_API_VERSION_1_2 ||
+        isExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+    {
+        m_descriptorIndexingFeatures.pNext = featuresChain;
+        featuresChain = &m_descriptorIndexingFeatures;
+        m_descriptorIndexingProperties.pNext = propertiesChain;
+        propertiesChain = &m_descriptorIndexingProperties;
+    }
+
+    VkPhysicalDeviceFeatures2 features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = featuresChain,
+    };
+    cx->GetPhysicalDeviceFeatures2(*m_handle, &features);
+    m_features = features.features;
+
+    VkPhysicalDeviceProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = propertiesChain,
+    };
+    cx->GetPhysicalDeviceProperties2(*m_handle, &properties);
+
+    if (bHostImageCopy)
+    {
+        properties.pNext = &hostImageCopyProperties;
+        cx->GetPhysicalDeviceProperties2(*m_handle, &properties);
+        m_hostImageCopyDstLayouts.resize(hostImageCopyProperties.copyDstLayoutCount);
+        hostImageCopyProperties.pCopyDstLayouts = m_hostImageCopyDstLayouts.data();
+        cx->GetPhysicalDeviceProperties2(*m_handle, &properties);
+    }
+
+    // the chain points to members, do not keep it
+    m_graphicsPipelineLibraryFeatures.pNext = nullptr;
+    m_graphicsPipelineLibraryProperties.pNext = nullptr;
+    m_shaderObjectFeatures.pNext = nullptr;
+    m_descriptorIndexingFeatures.pNext = nullptr;
+    m_descriptorIndexingProperties.pNext = nullptr;
+    m_hostImageCopyFeatures.pNext = nullptr;
+}
+
+VkFormatProperties PhysicalDevice::getFormatProperties(const VkFormat format) const
+{
+    VkFormatProperties properties;
+    cx->GetPhysicalDeviceFormatProperties(*m_handle, format, &properties);
+    return properties;
+}
+
+VkFormatFeatureFlags2 PhysicalDevice::getOptimalTilingFeatures2(const VkFormat format) const
+{
+    // the 32 bits flags are the low bits of the 64 bits ones
+    if (!supportsFormatFeatureFlags2())
+        return static_cast<VkFormatFeatureFlags2>(getFormatProperties(format).optimalTilingFeatures);
+
+    VkFormatProperties3 properties3 = {
+        .sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3,
+    };
+    VkFormatProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2,
+        .pNext = &properties3,
+    };
+    cx->GetPhysicalDeviceFormatProperties2(*m_handle, format, &properties);
+    return properties3.optimalTilingFeatures;
+}
+
+bool PhysicalDevice::supportsBindless() const
+{
+    const auto& f = m_descriptorIndexingFeatures;
+    return supportsDescriptorIndexingExtensions() && f.runtimeDescriptorArray && f.descriptorBindingPartiallyBound &&
+           f.descriptorBindingUpdateUnusedWhilePending &&
+           f.descriptorBindingStorageBufferUpdateAfterBind &&
+           f.descriptorBindingSampledImageUpdateAfterBind &&
+           f.shaderSampledImageArrayNonUniformIndexing &&
+           f.shaderStorageBufferArrayNonUniformIndexing;
 }
 
 void PhysicalDevice::initQueueFamilyProperties()
@@ -47,7 +174,37 @@ PhysicalDevice::PhysicalDevice(const PhysicalDeviceCreateInfoT createInfo) : cx(
     initQueueFamilyProperties();
     initQueueFamilyIndices(createInfo.surface);
 
-    enumerateAvailableDeviceExtensions();
+    for (const std::string& extension : enumerateAvailableDeviceExtensions())
+        m_availableExtensions.insert(extension);
+
+    initPhysicalDeviceFeatures();
+}
+
+bool PhysicalDevice::isExtensionSupported(const char *extensionName) const
+{
+    return m_availableExtensions.contains(extensionName);
+}
+
+bool PhysicalDevice::supportsFormatFeatureFlags2() const
+{
+    return m_properties.apiVersion >= VK_API_VERSION_1_3 ||
+           isExtensionSupported(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME);
+}
+
+bool PhysicalDevice::supportsHostImageCopyExtensions() const
+{
+    if (!isExtensionSupported(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME))
+        return false;
+    return m_properties.apiVersion >= VK_API_VERSION_1_3 ||
+           (isExtensionSupported(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME) &&
+            isExtensionSupported(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME));
+}
+
+bool PhysicalDevice::supportsDescriptorIndexingExtensions() const
+{
+    return m_properties.apiVersion >= VK_API_VERSION_1_2 ||
+           (isExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+            isExtensionSupported(VK_KHR_MAINTENANCE_3_EXTENSION_NAME));
 }
 
 std::vector<std::string> PhysicalDevice::enumerateAvailableDeviceExtensions(const bool bDump) const
@@ -72,7 +229,8 @@ std::vector<std::string> PhysicalDevice::enumerateAvailableDeviceExtensions(cons
     return out;
 }
 
-std::unique_ptr<LogicalDevice> PhysicalDevice::createDevice() const
+std::unique_ptr<LogicalDevice> PhysicalDevice::createDevice(
+    const AllocatorBackendE allocatorBackend) const
 {
     std::set<uint32_t> uniqueQueueFamilies;
 
@@ -100,20 +258,123 @@ std::unique_ptr<LogicalDevice> PhysicalDevice::createDevice() const
 
     std::vector<const char *> layers = cx->getLayers();
     std::vector<const char *> deviceExtensions = cx->getDeviceExtensions();
+    for (const char *extension : cx->getOptionalDeviceExtensions())
+    {
+        if (std::strcmp(extension, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) == 0)
+        {
+            if (!supportsHostImageCopyExtensions())
+            {
+                std::cout << "optional device extension " << extension
+                          << " or its dependencies are not supported by " << getDeviceName()
+                          << '\n';
+                continue;
+            }
+            // promoted to 1.3, enabled along with it on older devices
+            if (m_properties.apiVersion < VK_API_VERSION_1_3)
+            {
+                deviceExtensions.push_back(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME);
+                deviceExtensions.push_back(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME);
+            }
+        }
+        if (std::strcmp(extension, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0)
+        {
+            // promoted to 1.2, nothing to enable on newer devices
+            if (m_properties.apiVersion >= VK_API_VERSION_1_2)
+                continue;
+            if (!supportsDescriptorIndexingExtensions())
+            {
+                std::cout << "optional device extension " << extension
+                          << " or its dependencies are not supported by " << getDeviceName()
+                          << '\n';
+                continue;
+            }
+            deviceExtensions.push_back(VK_KHR_MAINTENANCE_3_EXTENSION_NAME);
+        }
+        if (isExtensionSupported(extension))
+            deviceExtensions.push_back(extension);
+        else
+            std::cout << "optional device extension " << extension << " is not supported by "
+                      << getDeviceName() << '\n';
+    }
+    auto isEnabled = [&deviceExtensions](const char *extensionName) {
+        return std::any_of(deviceExtensions.begin(), deviceExtensions.end(),
+                           [extensionName](const char *enabled) {
+                               return std::strcmp(enabled, extensionName) == 0;
+                           });
+    };
+
+    // features of the enabled extensions
+    void *featuresChain = nullptr;
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .graphicsPipelineLibrary = m_graphicsPipelineLibraryFeatures.graphicsPipelineLibrary,
+    };
+    if (isEnabled(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+    {
+        graphicsPipelineLibraryFeatures.pNext = featuresChain;
+        featuresChain = &graphicsPipelineLibraryFeatures;
+    }
+    VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT,
+        .shaderObject = m_shaderObjectFeatures.shaderObject,
+    };
+    if (isEnabled(VK_EXT_SHADER_OBJECT_EXTENSION_NAME))
+    {
+        shaderObjectFeatures.pNext = featuresChain;
+        featuresChain = &shaderObjectFeatures;
+    }
+    VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT,
+        .hostImageCopy = m_hostImageCopyFeatures.hostImageCopy,
+    };
+    if (isEnabled(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME))
+    {
+        hostImageCopyFeatures.pNext = featuresChain;
+        featuresChain = &hostImageCopyFeatures;
+    }
+    // bindless descriptors (BindlessTable)
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+    };
+    if (supportsBindless() && (m_properties.apiVersion >= VK_API_VERSION_1_2 ||
+                               isEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)))
+    {
+        descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+        descriptorIndexingFeatures.pNext = featuresChain;
+        featuresChain = &descriptorIndexingFeatures;
+    }
+
+    // anisotropic filtering of the samplers (Sampler), block compressed textures
+    VkPhysicalDeviceFeatures enabledFeatures = {
+        .samplerAnisotropy = m_features.samplerAnisotropy,
+        .textureCompressionBC = m_features.textureCompressionBC,
+    };
 
     VkDeviceCreateInfo createInfo = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = featuresChain,
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
         .enabledLayerCount = static_cast<uint32_t>(layers.size()),
         .ppEnabledLayerNames = layers.data(),
         .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
         .ppEnabledExtensionNames = deviceExtensions.data(),
+        .pEnabledFeatures = &enabledFeatures,
     };
 
     // create device
-    std::unique_ptr<LogicalDevice> out = std::make_unique<LogicalDevice>(
-        LogicalDeviceCreateInfoT{.context = cx, .physicalHandle = this, .createInfo = &createInfo});
+    std::unique_ptr<LogicalDevice> out = std::make_unique<LogicalDevice>(LogicalDeviceCreateInfoT{
+        .context = cx,
+        .physicalHandle = this,
+        .createInfo = &createInfo,
+        .allocatorBackend = allocatorBackend,
+    });
 
     return std::move(out);
 }
@@ -2,10 +2,14 @@
 
 #include <memory>
 #include <optional>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include "device/memory/memoryallocator.hpp"
+
 class ContextABC;
 class Instance;
 class LogicalDevice;
@@ -38,6 +42,22 @@ class PhysicalDevice
 
     VkPhysicalDeviceProperties m_properties;
     VkPhysicalDeviceLimits m_limits;
+    VkPhysicalDeviceMemoryProperties m_memoryProperties;
+
+    VkPhysicalDeviceFeatures m_features;
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT m_graphicsPipelineLibraryFeatures;
+    VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT m_graphicsPipelineLibraryProperties;
+    VkPhysicalDeviceShaderObjectFeaturesEXT m_shaderObjectFeatures;
+    VkPhysicalDeviceDescriptorIndexingFeatures m_descriptorIndexingFeatures;
+    VkPhysicalDeviceDescriptorIndexingProperties m_descriptorIndexingProperties;
+    VkPhysicalDeviceHostImageCopyFeaturesEXT m_hostImageCopyFeatures;
+    /**
+     * @brief layouts an image can be in when copied to from the host
+     *
+     */
+    std::vector<VkImageLayout> m_hostImageCopyDstLayouts;
+
+    std::set<std::string> m_availableExtensions;
 
     std::vector<VkQueueFamilyProperties> m_queueFamilies;
 
@@ -49,6 +69,11 @@ class PhysicalDevice
 #endif
 
     void initPhysicalDeviceProperties();
+    /**
+     * @brief query the extension features and properties through the features2/properties2 chains
+     *
+     */
+    void initPhysicalDeviceFeatures();
     void initQueueFamilyProperties();
     /**
      * specify a surface if one wants this physical device to support presentation
@@ -65,8 +90,27 @@ class PhysicalDevice
     PhysicalDevice(const PhysicalDeviceCreateInfoT createInfo);
 
     std::vector<std::string> enumerateAvailableDeviceExtensions(const bool bDump = true) const;
+    [[nodiscard]] bool isExtensionSupported(const char* extensionName) const;
+    /**
+     * @brief core since Vulkan 1.3, VK_KHR_format_feature_flags2 before
+     *
+     */
+    [[nodiscard]] bool supportsFormatFeatureFlags2() const;
+    /**
+     * @brief VK_EXT_host_image_copy and its dependencies (VK_KHR_copy_commands2 and
+     * VK_KHR_format_feature_flags2 before Vulkan 1.3) are supported
+     *
+     */
+    [[nodiscard]] bool supportsHostImageCopyExtensions() const;
+    /**
+     * @brief core since Vulkan 1.2, VK_EXT_descriptor_indexing and its dependency
+     * VK_KHR_maintenance3 before
+     *
+     */
+    [[nodiscard]] bool supportsDescriptorIndexingExtensions() const;
 
-    [[nodiscard]] std::unique_ptr<LogicalDevice> createDevice() const;
+    [[nodiscard]] std::unique_ptr<LogicalDevice> createDevice(
+        const AllocatorBackendE allocatorBackend = AllocatorBackendE::VMA) const;
 
     [[nodiscard]] std::optional<uint32_t> findQueueFamilyIndex(
         const VkQueueFlags& capabilities) const;
@@ -98,6 +142,57 @@ class PhysicalDevice
     }
 #endif
 
+    [[nodiscard]] const VkPhysicalDeviceProperties& getProperties() const { return m_properties; }
+    [[nodiscard]] const VkPhysicalDeviceLimits& getLimits() const { return m_limits; }
+    [[nodiscard]] const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const
+    {
+        return m_memoryProperties;
+    }
+    [[nodiscard]] const VkPhysicalDeviceFeatures& getFeatures() const { return m_features; }
+    [[nodiscard]] VkFormatProperties getFormatProperties(const VkFormat format) const;
+    /**
+     * @brief optimal tiling features, with the flags only reported in the 64 bits version
+     *
+     */
+    [[nodiscard]] VkFormatFeatureFlags2 getOptimalTilingFeatures2(const VkFormat format) const;
+    [[nodiscard]] const VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT&
+    getGraphicsPipelineLibraryFeatures() const
+    {
+        return m_graphicsPipelineLibraryFeatures;
+    }
+    [[nodiscard]] const VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT&
+    getGraphicsPipelineLibraryProperties() const
+    {
+        return m_graphicsPipelineLibraryProperties;
+    }
+    [[nodiscard]] const VkPhysicalDeviceShaderObjectFeaturesEXT& getShaderObjectFeatures() const
+    {
+        return m_shaderObjectFeatures;
+    }
+    [[nodiscard]] const VkPhysicalDeviceDescriptorIndexingFeatures& getDescriptorIndexingFeatures()
+        const
+    {
+        return m_descriptorIndexingFeatures;
+    }
+    [[nodiscard]] const VkPhysicalDeviceDescriptorIndexingProperties&
+    getDescriptorIndexingProperties() const
+    {
+        return m_descriptorIndexingProperties;
+    }
+    [[nodiscard]] const VkPhysicalDeviceHostImageCopyFeaturesEXT& getHostImageCopyFeatures() const
+    {
+        return m_hostImageCopyFeatures;
+    }
+    [[nodiscard]] const std::vector<VkImageLayout>& getHostImageCopyDstLayouts() const
+    {
+        return m_hostImageCopyDstLayouts;
+    }
+    /**
+     * @brief the features needed by BindlessTable are supported
+     *
+     */
+    [[nodiscard]] bool supportsBindless() const;
+
     [[nodiscard]] VkPhysicalDeviceType getDeviceType() const { return m_properties.deviceType; }
 
     [[nodiscard]] const char* getDeviceName() const { return m_properties.deviceName; }
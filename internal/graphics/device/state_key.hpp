@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief normalized description of a Vulkan object used as a cache key
+ * fields are appended one by one (never whole Vulkan structures) so that padding, sType and pNext
+ * never take part in the comparison
+ *
+ */
+struct StateKeyT
+{
+    std::vector<uint64_t> words;
+    std::size_t hash = 0xcbf29ce484222325ULL;
+
+    template<class T>
+        requires std::is_trivially_copyable<T>::value && (sizeof(T) <= sizeof(uint64_t))
+    StateKeyT& add(const T value)
+    {
+        uint64_t word = 0ULL;
+        std::memcpy(&word, &value, sizeof(T));
+        words.push_back(word);
+
+        // FNV-1a on 64 bits words
+        hash ^= word;
+        hash *= 0x100000001b3ULL;
+        return *this;
+    }
+
+    StateKeyT& add(const std::string_view str)
+    {
+        add(str.size());
+        for (size_t i = 0; i < str.size(); i += sizeof(uint64_t))
+        {
+            uint64_t word = 0ULL;
+            std::memcpy(&word, str.data() + i, std::min(sizeof(uint64_t), str.size() - i));
+            add(word);
+        }
+        return *this;
+    }
+
+    StateKeyT& add(const char* str) { return add(std::string_view(str ? str : "")); }
+
+    /**
+     * @brief nests the key of another object (e.g. a set layout in a pipeline layout)
+     *
+     */
+    StateKeyT& add(const StateKeyT& other)
+    {
+        add(other.words.size());
+        for (const uint64_t word : other.words)
+            add(word);
+        return *this;
+    }
+
+    StateKeyT& add(const float (&values)[4])
+    {
+        for (int i = 0; i < 4; ++i)
+            add(values[i]);
+        return *this;
+    }
+
+    bool operator==(const StateKeyT& other) const
+    {
+        return hash == other.hash && words == other.words;
+    }
+};
+
+struct StateKeyHashT
+{
+    std::size_t operator()(const StateKeyT& key) const { return key.hash; }
+};
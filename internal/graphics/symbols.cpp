@@ -1,4 +1,6 @@
-#pragma once
+#include <algorithm>
+#include <cstring>
+#include <iostream>
 
 #include "context.hpp"
 #include "device/device.hpp"
@@ -6,39 +8,66 @@
 
 #include "symbols.hpp"
 
+static bool hasExtension(const std::vector<const char*>& extensions, const char* extensionName)
+{
+    return std::any_of(extensions.begin(), extensions.end(), [extensionName](const char* name) {
+        return std::strcmp(name, extensionName) == 0;
+    });
+}
+
 void InstanceSymbolsLoaderT::load(ContextABC* cx, f6::bin::DynamicLibraryLoader* loader)
 {
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, CreateInstance);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, DestroyInstance);
     cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetInstanceProcAddr);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, EnumerateInstanceLayerProperties);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, EnumerateInstanceExtensionProperties);
+    if (cx->GetInstanceProcAddr == nullptr)
+    {
+        std::cerr << "Failed to load vkGetInstanceProcAddr from the vulkan library" << std::endl;
+        return;
+    }
 
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetPhysicalDeviceProperties);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetDeviceProcAddr);
+    // global functions, the loader resolves them without an instance
+    VK_GET_INSTANCE_PROC_ADDR(cx, VK_NULL_HANDLE, CreateInstance);
+    VK_GET_INSTANCE_PROC_ADDR(cx, VK_NULL_HANDLE, EnumerateInstanceLayerProperties);
+    VK_GET_INSTANCE_PROC_ADDR(cx, VK_NULL_HANDLE, EnumerateInstanceExtensionProperties);
 }
 
 void InstanceSymbolsLoader2T::load(ContextABC* cx, const Instance* instance)
 {
-    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), CreateDebugUtilsMessengerEXT);
-    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), DestroyDebugUtilsMessengerEXT);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), DestroyInstance);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceProperties);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetDeviceProcAddr);
+
+    const auto extensions = cx->getInstanceExtensions();
+    if (hasExtension(extensions, VK_EXT_DEBUG_UTILS_EXTENSION_NAME))
+    {
+        VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), CreateDebugUtilsMessengerEXT);
+        VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), DestroyDebugUtilsMessengerEXT);
+    }
 
     VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), EnumeratePhysicalDevices);
 
-    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), DestroySurfaceKHR);
+    if (hasExtension(extensions, VK_KHR_SURFACE_EXTENSION_NAME))
+        VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), DestroySurfaceKHR);
 }
 
-void DeviceSymbolsLoaderT::load(ContextABC* cx, f6::bin::DynamicLibraryLoader* loader)
+void DeviceSymbolsLoaderT::load(ContextABC* cx, const Instance* instance)
 {
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, EnumerateDeviceExtensionProperties);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), EnumerateDeviceExtensionProperties);
 
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetPhysicalDeviceQueueFamilyProperties);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, CreateDevice);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetPhysicalDeviceSurfaceSupportKHR);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceFeatures2);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceProperties2);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceMemoryProperties);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceMemoryProperties2);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceFormatProperties);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceFormatProperties2);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceQueueFamilyProperties);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), CreateDevice);
 
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetPhysicalDeviceSurfaceCapabilitiesKHR);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetPhysicalDeviceSurfaceFormatsKHR);
-    cx->GET_PROC_ADDR(*loader, PFN_vk, vk, GetPhysicalDeviceSurfacePresentModesKHR);
+    if (!hasExtension(cx->getInstanceExtensions(), VK_KHR_SURFACE_EXTENSION_NAME))
+        return;
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceSurfaceSupportKHR);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceSurfaceCapabilitiesKHR);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceSurfaceFormatsKHR);
+    VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), GetPhysicalDeviceSurfacePresentModesKHR);
 }
 
 void DeviceSymbolsLoader2T::load(ContextABC* cx, const LogicalDevice* device)
@@ -54,7 +83,8 @@ void DeviceSymbolsLoader2T::load(ContextABC* cx, const LogicalDevice* device)
 
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), MapMemory);
 
-    SwapchainSymbolsLoaderT::load(cx, device);
+    if (device->isExtensionEnabled(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+        SwapchainSymbolsLoaderT::load(cx, device);
     BufferSymbolsLoaderT::load(cx, device);
     ImageSymbolsLoaderT::load(cx, device);
     RenderPassSymbolsLoaderT::load(cx, device);
@@ -62,6 +92,9 @@ void DeviceSymbolsLoader2T::load(ContextABC* cx, const LogicalDevice* device)
     BackBufferSymbolsLoaderT::load(cx, device);
     RenderingSymbolsLoaderT::load(cx, device);
     DescriptorSetSymbolsLoaderT::load(cx, device);
+    DynamicStateSymbolsLoaderT::load(cx, device);
+    if (device->supportsShaderObjects())
+        ShaderObjectSymbolsLoaderT::load(cx, device);
 }
 
 void SwapchainSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
@@ -71,6 +104,7 @@ void SwapchainSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroySwapchainKHR);
 }
 
+#ifndef ENABLE_DYNAMIC_LOADER
 void SDKSymbolsLoaderT::load(ContextABC* cx)
 {
     VK_SDK_FUNCTION(cx, CreateInstance);
@@ -83,6 +117,12 @@ void SDKSymbolsLoaderT::load(ContextABC* cx)
     VK_SDK_FUNCTION(cx, EnumeratePhysicalDevices);
     VK_SDK_FUNCTION(cx, DestroySurfaceKHR);
     VK_SDK_FUNCTION(cx, EnumerateDeviceExtensionProperties);
+    VK_SDK_FUNCTION(cx, GetPhysicalDeviceFeatures2);
+    VK_SDK_FUNCTION(cx, GetPhysicalDeviceProperties2);
+    VK_SDK_FUNCTION(cx, GetPhysicalDeviceMemoryProperties);
+    VK_SDK_FUNCTION(cx, GetPhysicalDeviceMemoryProperties2);
+    VK_SDK_FUNCTION(cx, GetPhysicalDeviceFormatProperties);
+    VK_SDK_FUNCTION(cx, GetPhysicalDeviceFormatProperties2);
     VK_SDK_FUNCTION(cx, GetPhysicalDeviceQueueFamilyProperties);
     VK_SDK_FUNCTION(cx, CreateDevice);
     VK_SDK_FUNCTION(cx, GetPhysicalDeviceSurfaceSupportKHR);
@@ -98,15 +138,23 @@ void SDKSymbolsLoaderT::load(ContextABC* cx)
     VK_SDK_FUNCTION(cx, DestroySwapchainKHR);
     VK_SDK_FUNCTION(cx, CreateImageView);
     VK_SDK_FUNCTION(cx, DestroyImageView);
+    VK_SDK_FUNCTION(cx, CreateSampler);
+    VK_SDK_FUNCTION(cx, DestroySampler);
     VK_SDK_FUNCTION(cx, CreateRenderPass);
     VK_SDK_FUNCTION(cx, DestroyRenderPass);
     VK_SDK_FUNCTION(cx, CreateShaderModule);
     VK_SDK_FUNCTION(cx, DestroyShaderModule);
     VK_SDK_FUNCTION(cx, CreateDescriptorSetLayout);
+    VK_SDK_FUNCTION(cx, DestroyDescriptorSetLayout);
     VK_SDK_FUNCTION(cx, CreatePipelineLayout);
     VK_SDK_FUNCTION(cx, DestroyPipelineLayout);
     VK_SDK_FUNCTION(cx, CreateGraphicsPipelines);
+    VK_SDK_FUNCTION(cx, CreateComputePipelines);
     VK_SDK_FUNCTION(cx, DestroyPipeline);
+    VK_SDK_FUNCTION(cx, CreatePipelineCache);
+    VK_SDK_FUNCTION(cx, DestroyPipelineCache);
+    VK_SDK_FUNCTION(cx, GetPipelineCacheData);
+    VK_SDK_FUNCTION(cx, MergePipelineCaches);
     VK_SDK_FUNCTION(cx, AllocateCommandBuffers);
     VK_SDK_FUNCTION(cx, CreateSemaphore);
     VK_SDK_FUNCTION(cx, DestroySemaphore);
@@ -114,6 +162,17 @@ void SDKSymbolsLoaderT::load(ContextABC* cx)
     VK_SDK_FUNCTION(cx, DestroyFence);
     VK_SDK_FUNCTION(cx, CreateBuffer);
     VK_SDK_FUNCTION(cx, DestroyBuffer);
+    VK_SDK_FUNCTION(cx, GetBufferMemoryRequirements);
+    VK_SDK_FUNCTION(cx, BindBufferMemory);
+    VK_SDK_FUNCTION(cx, AllocateMemory);
+    VK_SDK_FUNCTION(cx, FreeMemory);
+    VK_SDK_FUNCTION(cx, UnmapMemory);
+    VK_SDK_FUNCTION(cx, FlushMappedMemoryRanges);
+    VK_SDK_FUNCTION(cx, InvalidateMappedMemoryRanges);
+    VK_SDK_FUNCTION(cx, CreateImage);
+    VK_SDK_FUNCTION(cx, DestroyImage);
+    VK_SDK_FUNCTION(cx, GetImageMemoryRequirements);
+    VK_SDK_FUNCTION(cx, BindImageMemory);
     VK_SDK_FUNCTION(cx, CreateFramebuffer);
     VK_SDK_FUNCTION(cx, DestroyFramebuffer);
     VK_SDK_FUNCTION(cx, WaitForFences);
@@ -128,6 +187,12 @@ void SDKSymbolsLoaderT::load(ContextABC* cx)
     VK_SDK_FUNCTION(cx, CmdBindVertexBuffers);
     VK_SDK_FUNCTION(cx, CmdBindIndexBuffer);
     VK_SDK_FUNCTION(cx, CmdDrawIndexed);
+    VK_SDK_FUNCTION(cx, CmdDispatch);
+    VK_SDK_FUNCTION(cx, CmdPipelineBarrier);
+    VK_SDK_FUNCTION(cx, CmdCopyBuffer);
+    VK_SDK_FUNCTION(cx, CmdCopyImage);
+    VK_SDK_FUNCTION(cx, CmdCopyBufferToImage);
+    VK_SDK_FUNCTION(cx, CmdBlitImage);
     VK_SDK_FUNCTION(cx, CmdEndRenderPass);
     VK_SDK_FUNCTION(cx, EndCommandBuffer);
     VK_SDK_FUNCTION(cx, QueueSubmit);
@@ -135,10 +200,38 @@ void SDKSymbolsLoaderT::load(ContextABC* cx)
     VK_SDK_FUNCTION(cx, DeviceWaitIdle);
     VK_SDK_FUNCTION(cx, QueueWaitIdle);
     VK_SDK_FUNCTION(cx, CreateDescriptorPool);
+    VK_SDK_FUNCTION(cx, DestroyDescriptorPool);
+    VK_SDK_FUNCTION(cx, ResetDescriptorPool);
     VK_SDK_FUNCTION(cx, AllocateDescriptorSets);
+    VK_SDK_FUNCTION(cx, FreeDescriptorSets);
     VK_SDK_FUNCTION(cx, CmdBindDescriptorSets);
     VK_SDK_FUNCTION(cx, UpdateDescriptorSets);
+    VK_SDK_FUNCTION(cx, CreateDescriptorUpdateTemplate);
+    VK_SDK_FUNCTION(cx, DestroyDescriptorUpdateTemplate);
+    VK_SDK_FUNCTION(cx, UpdateDescriptorSetWithTemplate);
+    VK_SDK_FUNCTION(cx, CmdPushConstants);
     VK_SDK_FUNCTION(cx, MapMemory);
+    VK_SDK_FUNCTION(cx, CmdSetLineWidth);
+    VK_SDK_FUNCTION(cx, CmdSetDepthBias);
+    VK_SDK_FUNCTION(cx, CmdSetBlendConstants);
+    VK_SDK_FUNCTION(cx, CmdSetStencilCompareMask);
+    VK_SDK_FUNCTION(cx, CmdSetStencilWriteMask);
+    VK_SDK_FUNCTION(cx, CmdSetStencilReference);
+    VK_SDK_FUNCTION(cx, CmdSetViewportWithCount);
+    VK_SDK_FUNCTION(cx, CmdSetScissorWithCount);
+    VK_SDK_FUNCTION(cx, CmdSetRasterizerDiscardEnable);
+    VK_SDK_FUNCTION(cx, CmdSetPrimitiveTopology);
+    VK_SDK_FUNCTION(cx, CmdSetPrimitiveRestartEnable);
+    VK_SDK_FUNCTION(cx, CmdSetCullMode);
+    VK_SDK_FUNCTION(cx, CmdSetFrontFace);
+    VK_SDK_FUNCTION(cx, CmdSetDepthBiasEnable);
+    VK_SDK_FUNCTION(cx, CmdSetDepthTestEnable);
+    VK_SDK_FUNCTION(cx, CmdSetDepthWriteEnable);
+    VK_SDK_FUNCTION(cx, CmdSetDepthCompareOp);
+    VK_SDK_FUNCTION(cx, CmdSetStencilTestEnable);
+    VK_SDK_FUNCTION(cx, CmdSetStencilOp);
+    VK_SDK_FUNCTION(cx, CmdSetDepthBounds);
+    VK_SDK_FUNCTION(cx, CmdSetDepthBoundsTestEnable);
 }
 
 void SDKSymbolsLoaderT::load(ContextABC* cx, const Instance* instance)
@@ -147,16 +240,58 @@ void SDKSymbolsLoaderT::load(ContextABC* cx, const Instance* instance)
     VK_GET_INSTANCE_PROC_ADDR(cx, instance->getHandle(), DestroyDebugUtilsMessengerEXT);
 }
 
+void SDKSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
+{
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdPushDescriptorSetKHR);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateShadersEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyShaderEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdBindShadersEXT);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetVertexInputEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetPolygonModeEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetRasterizationSamplesEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetSampleMaskEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetAlphaToCoverageEnableEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetColorBlendEnableEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetColorBlendEquationEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetColorWriteMaskEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthClampEnableEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetLogicOpEnableEXT);
+
+    if (!device->supportsHostImageCopy())
+        return;
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CopyMemoryToImageEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), TransitionImageLayoutEXT);
+}
+#endif
+
 void ImageSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
 {
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateImage);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyImage);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), GetImageMemoryRequirements);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), BindImageMemory);
+
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateImageView);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyImageView);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateSampler);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroySampler);
+
+    if (!device->supportsHostImageCopy())
+        return;
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CopyMemoryToImageEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), TransitionImageLayoutEXT);
 }
 
 void RenderPassSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
 {
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateRenderPass);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyRenderPass);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateFramebuffer);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyFramebuffer);
 }
 
 void PipelineSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
@@ -165,10 +300,17 @@ void PipelineSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyShaderModule);
 
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateDescriptorSetLayout);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyDescriptorSetLayout);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreatePipelineLayout);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyPipelineLayout);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateGraphicsPipelines);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateComputePipelines);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyPipeline);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreatePipelineCache);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyPipelineCache);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), GetPipelineCacheData);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), MergePipelineCaches);
 }
 
 void BackBufferSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
@@ -184,6 +326,14 @@ void BufferSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
 {
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateBuffer);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyBuffer);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), GetBufferMemoryRequirements);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), BindBufferMemory);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), AllocateMemory);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), FreeMemory);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), UnmapMemory);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), FlushMappedMemoryRanges);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), InvalidateMappedMemoryRanges);
 }
 
 void RenderingSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
@@ -202,6 +352,12 @@ void RenderingSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdBindVertexBuffers);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdBindIndexBuffer);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdDrawIndexed);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdDispatch);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdPipelineBarrier);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdCopyBuffer);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdCopyImage);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdCopyBufferToImage);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdBlitImage);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdEndRenderPass);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), EndCommandBuffer);
 
@@ -212,7 +368,193 @@ void RenderingSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
 void DescriptorSetSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
 {
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateDescriptorPool);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyDescriptorPool);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), ResetDescriptorPool);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), AllocateDescriptorSets);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), FreeDescriptorSets);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdBindDescriptorSets);
     VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), UpdateDescriptorSets);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateDescriptorUpdateTemplate);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyDescriptorUpdateTemplate);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), UpdateDescriptorSetWithTemplate);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdPushConstants);
+    if (device->supportsPushDescriptors())
+        VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdPushDescriptorSetKHR);
+}
+
+void DynamicStateSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
+{
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetLineWidth);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthBias);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetBlendConstants);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetStencilCompareMask);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetStencilWriteMask);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetStencilReference);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetViewportWithCount);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetScissorWithCount);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetRasterizerDiscardEnable);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetPrimitiveTopology);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetPrimitiveRestartEnable);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetCullMode);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetFrontFace);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthBiasEnable);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthTestEnable);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthWriteEnable);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthCompareOp);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetStencilTestEnable);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetStencilOp);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthBounds);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthBoundsTestEnable);
+}
+
+void ShaderObjectSymbolsLoaderT::load(ContextABC* cx, const LogicalDevice* device)
+{
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CreateShadersEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), DestroyShaderEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdBindShadersEXT);
+
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetVertexInputEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetPolygonModeEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetRasterizationSamplesEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetSampleMaskEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetAlphaToCoverageEnableEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetColorBlendEnableEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetColorBlendEquationEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetColorWriteMaskEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetDepthClampEnableEXT);
+    VK_GET_DEVICE_PROC_ADDR(cx, device->getHandle(), CmdSetLogicOpEnableEXT);
+}
+
+void DeviceDispatchT::load(const ContextABC* cx, const VkDevice device)
+{
+    VK_GET_DEVICE_DISPATCH(this, cx, device, GetDeviceQueue);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyDevice);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateCommandPool);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyCommandPool);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DeviceWaitIdle);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, QueueWaitIdle);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, MapMemory);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateSwapchainKHR);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroySwapchainKHR);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, GetSwapchainImagesKHR);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateBuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyBuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, GetBufferMemoryRequirements);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, BindBufferMemory);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, AllocateMemory);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, FreeMemory);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, UnmapMemory);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, FlushMappedMemoryRanges);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, InvalidateMappedMemoryRanges);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateImage);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyImage);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, GetImageMemoryRequirements);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, BindImageMemory);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateImageView);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyImageView);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateSampler);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroySampler);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CopyMemoryToImageEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, TransitionImageLayoutEXT);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateRenderPass);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyRenderPass);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateFramebuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyFramebuffer);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateShaderModule);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyShaderModule);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateDescriptorSetLayout);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyDescriptorSetLayout);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreatePipelineLayout);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyPipelineLayout);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateGraphicsPipelines);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateComputePipelines);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyPipeline);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreatePipelineCache);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyPipelineCache);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, GetPipelineCacheData);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, MergePipelineCaches);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, AllocateCommandBuffers);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateSemaphore);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroySemaphore);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateFence);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyFence);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, WaitForFences);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, ResetFences);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, AcquireNextImageKHR);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, ResetCommandBuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, BeginCommandBuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdBeginRenderPass);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetViewport);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetScissor);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdBindPipeline);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdBindVertexBuffers);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdBindIndexBuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdDrawIndexed);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdDispatch);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdPipelineBarrier);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdCopyBuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdCopyImage);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdCopyBufferToImage);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdBlitImage);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdEndRenderPass);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, EndCommandBuffer);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, QueueSubmit);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, QueuePresentKHR);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateDescriptorPool);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyDescriptorPool);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, ResetDescriptorPool);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, AllocateDescriptorSets);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, FreeDescriptorSets);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdBindDescriptorSets);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, UpdateDescriptorSets);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateDescriptorUpdateTemplate);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyDescriptorUpdateTemplate);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, UpdateDescriptorSetWithTemplate);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdPushConstants);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdPushDescriptorSetKHR);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetLineWidth);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthBias);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetBlendConstants);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetStencilCompareMask);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetStencilWriteMask);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetStencilReference);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetViewportWithCount);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetScissorWithCount);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetRasterizerDiscardEnable);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetPrimitiveTopology);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetPrimitiveRestartEnable);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetCullMode);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetFrontFace);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthBiasEnable);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthTestEnable);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthWriteEnable);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthCompareOp);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetStencilTestEnable);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetStencilOp);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthBounds);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthBoundsTestEnable);
+
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CreateShadersEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, DestroyShaderEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdBindShadersEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetVertexInputEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetPolygonModeEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetRasterizationSamplesEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetSampleMaskEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetAlphaToCoverageEnableEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetColorBlendEnableEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetColorBlendEquationEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetColorWriteMaskEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetDepthClampEnableEXT);
+    VK_GET_DEVICE_DISPATCH(this, cx, device, CmdSetLogicOpEnableEXT);
 }
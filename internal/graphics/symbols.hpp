@@ -17,6 +17,9 @@ class LogicalDevice;
 
 #define VK_SDK_FUNCTION(contextPtr, funcName) contextPtr->funcName = &vk##funcName
 
+#define VK_GET_DEVICE_DISPATCH(tablePtr, contextPtr, device, funcName)                             \
+    tablePtr->funcName = (PFN_vk##funcName)contextPtr->GetDeviceProcAddr(device, "vk" #funcName)
+
 /**
  * @brief used to load api functions
  *
@@ -32,6 +35,7 @@ struct SymbolsLoaderI
     virtual void load(ContextABC* cx, const LogicalDevice* device) = 0;
 };
 
+#ifndef ENABLE_DYNAMIC_LOADER
 struct SDKSymbolsLoaderT : public SymbolsLoaderI
 {
   protected:
@@ -39,11 +43,17 @@ struct SDKSymbolsLoaderT : public SymbolsLoaderI
     void load(ContextABC* cx, f6::bin::DynamicLibraryLoader* loader) override {};
 
     void load(ContextABC* cx, const Instance* instance) override;
-    void load(ContextABC* cx, const LogicalDevice* device) override {};
+    /**
+     * @brief extension functions are not exported by the SDK loader library
+     *
+     */
+    void load(ContextABC* cx, const LogicalDevice* device) override;
 };
+#endif
 
 /**
- * @brief before instance creation
+ * @brief before instance creation, the library only exports vkGetInstanceProcAddr to ContextDLL,
+ * the functions needing an instance are resolved once it is created
  *
  */
 struct InstanceSymbolsT
@@ -71,7 +81,7 @@ struct InstanceSymbolsLoaderT : public SymbolsLoaderI
 };
 
 /**
- * @brief after instance creation
+ * @brief after instance creation, extension functions are null if the extension is not enabled
  *
  */
 struct InstanceSymbols2T
@@ -100,6 +110,12 @@ struct DeviceSymbolsT
 {
     PFN_DECLARE(PFN_vk, EnumerateDeviceExtensionProperties);
 
+    PFN_DECLARE(PFN_vk, GetPhysicalDeviceFeatures2);
+    PFN_DECLARE(PFN_vk, GetPhysicalDeviceProperties2);
+    PFN_DECLARE(PFN_vk, GetPhysicalDeviceMemoryProperties);
+    PFN_DECLARE(PFN_vk, GetPhysicalDeviceMemoryProperties2);
+    PFN_DECLARE(PFN_vk, GetPhysicalDeviceFormatProperties);
+    PFN_DECLARE(PFN_vk, GetPhysicalDeviceFormatProperties2);
     PFN_DECLARE(PFN_vk, GetPhysicalDeviceQueueFamilyProperties);
     PFN_DECLARE(PFN_vk, CreateDevice);
     PFN_DECLARE(PFN_vk, GetPhysicalDeviceSurfaceSupportKHR);
@@ -112,9 +128,9 @@ struct DeviceSymbolsLoaderT : public SymbolsLoaderI
 {
   protected:
     void load(ContextABC* cx) override {};
-    void load(ContextABC* cx, f6::bin::DynamicLibraryLoader* loader) override;
+    void load(ContextABC* cx, f6::bin::DynamicLibraryLoader* loader) override {}
 
-    void load(ContextABC* cx, const Instance* instance) override {}
+    void load(ContextABC* cx, const Instance* instance) override;
     void load(ContextABC* cx, const LogicalDevice* device) override {}
 };
 
@@ -138,6 +154,14 @@ struct BufferSymbolsT : public SwapchainSymbolsT
 {
     PFN_DECLARE(PFN_vk, CreateBuffer);
     PFN_DECLARE(PFN_vk, DestroyBuffer);
+    PFN_DECLARE(PFN_vk, GetBufferMemoryRequirements);
+    PFN_DECLARE(PFN_vk, BindBufferMemory);
+
+    PFN_DECLARE(PFN_vk, AllocateMemory);
+    PFN_DECLARE(PFN_vk, FreeMemory);
+    PFN_DECLARE(PFN_vk, UnmapMemory);
+    PFN_DECLARE(PFN_vk, FlushMappedMemoryRanges);
+    PFN_DECLARE(PFN_vk, InvalidateMappedMemoryRanges);
 };
 struct BufferSymbolsLoaderT : public SwapchainSymbolsLoaderT
 {
@@ -151,8 +175,23 @@ struct BufferSymbolsLoaderT : public SwapchainSymbolsLoaderT
 
 struct ImageSymbolsT : public BufferSymbolsT
 {
+    PFN_DECLARE(PFN_vk, CreateImage);
+    PFN_DECLARE(PFN_vk, DestroyImage);
+    PFN_DECLARE(PFN_vk, GetImageMemoryRequirements);
+    PFN_DECLARE(PFN_vk, BindImageMemory);
+
     PFN_DECLARE(PFN_vk, CreateImageView);
     PFN_DECLARE(PFN_vk, DestroyImageView);
+
+    PFN_DECLARE(PFN_vk, CreateSampler);
+    PFN_DECLARE(PFN_vk, DestroySampler);
+
+    /**
+     * @brief VK_EXT_host_image_copy, null if the extension is not enabled
+     *
+     */
+    PFN_DECLARE(PFN_vk, CopyMemoryToImageEXT);
+    PFN_DECLARE(PFN_vk, TransitionImageLayoutEXT);
 };
 struct ImageSymbolsLoaderT : public BufferSymbolsLoaderT
 {
@@ -188,10 +227,17 @@ struct PipelineSymbolsT : public RenderPassSymbolsT
     PFN_DECLARE(PFN_vk, DestroyShaderModule);
 
     PFN_DECLARE(PFN_vk, CreateDescriptorSetLayout);
+    PFN_DECLARE(PFN_vk, DestroyDescriptorSetLayout);
     PFN_DECLARE(PFN_vk, CreatePipelineLayout);
     PFN_DECLARE(PFN_vk, DestroyPipelineLayout);
     PFN_DECLARE(PFN_vk, CreateGraphicsPipelines);
+    PFN_DECLARE(PFN_vk, CreateComputePipelines);
     PFN_DECLARE(PFN_vk, DestroyPipeline);
+
+    PFN_DECLARE(PFN_vk, CreatePipelineCache);
+    PFN_DECLARE(PFN_vk, DestroyPipelineCache);
+    PFN_DECLARE(PFN_vk, GetPipelineCacheData);
+    PFN_DECLARE(PFN_vk, MergePipelineCaches);
 };
 struct PipelineSymbolsLoaderT : public RenderPassSymbolsLoaderT
 {
@@ -234,6 +280,12 @@ struct RenderingSymbolsT : public BackBufferSymbolsT
     PFN_DECLARE(PFN_vk, CmdBindVertexBuffers);
     PFN_DECLARE(PFN_vk, CmdBindIndexBuffer);
     PFN_DECLARE(PFN_vk, CmdDrawIndexed);
+    PFN_DECLARE(PFN_vk, CmdDispatch);
+    PFN_DECLARE(PFN_vk, CmdPipelineBarrier);
+    PFN_DECLARE(PFN_vk, CmdCopyBuffer);
+    PFN_DECLARE(PFN_vk, CmdCopyImage);
+    PFN_DECLARE(PFN_vk, CmdCopyBufferToImage);
+    PFN_DECLARE(PFN_vk, CmdBlitImage);
     PFN_DECLARE(PFN_vk, CmdEndRenderPass);
     PFN_DECLARE(PFN_vk, EndCommandBuffer);
 
@@ -252,9 +304,21 @@ struct RenderingSymbolsLoaderT : public BackBufferSymbolsLoaderT
 struct DescriptorSetSymbolsT : public RenderingSymbolsT
 {
     PFN_DECLARE(PFN_vk, CreateDescriptorPool);
+    PFN_DECLARE(PFN_vk, DestroyDescriptorPool);
+    PFN_DECLARE(PFN_vk, ResetDescriptorPool);
     PFN_DECLARE(PFN_vk, AllocateDescriptorSets);
+    PFN_DECLARE(PFN_vk, FreeDescriptorSets);
     PFN_DECLARE(PFN_vk, CmdBindDescriptorSets);
     PFN_DECLARE(PFN_vk, UpdateDescriptorSets);
+    PFN_DECLARE(PFN_vk, CreateDescriptorUpdateTemplate);
+    PFN_DECLARE(PFN_vk, DestroyDescriptorUpdateTemplate);
+    PFN_DECLARE(PFN_vk, UpdateDescriptorSetWithTemplate);
+    PFN_DECLARE(PFN_vk, CmdPushConstants);
+    /**
+     * @brief VK_KHR_push_descriptor, null if the extension is not enabled
+     *
+     */
+    PFN_DECLARE(PFN_vk, CmdPushDescriptorSetKHR);
 };
 struct DescriptorSetSymbolsLoaderT : public RenderingSymbolsLoaderT
 {
@@ -265,7 +329,76 @@ struct DescriptorSetSymbolsLoaderT : public RenderingSymbolsLoaderT
     void load(ContextABC* cx, const LogicalDevice* device) override;
 };
 
-struct DeviceSymbols2T : public DescriptorSetSymbolsT
+/**
+ * @brief state commands used when the state is not baked in a pipeline
+ *
+ */
+struct DynamicStateSymbolsT : public DescriptorSetSymbolsT
+{
+    PFN_DECLARE(PFN_vk, CmdSetLineWidth);
+    PFN_DECLARE(PFN_vk, CmdSetDepthBias);
+    PFN_DECLARE(PFN_vk, CmdSetBlendConstants);
+    PFN_DECLARE(PFN_vk, CmdSetStencilCompareMask);
+    PFN_DECLARE(PFN_vk, CmdSetStencilWriteMask);
+    PFN_DECLARE(PFN_vk, CmdSetStencilReference);
+    PFN_DECLARE(PFN_vk, CmdSetDepthBounds);
+
+    // core in 1.3
+    PFN_DECLARE(PFN_vk, CmdSetViewportWithCount);
+    PFN_DECLARE(PFN_vk, CmdSetScissorWithCount);
+    PFN_DECLARE(PFN_vk, CmdSetRasterizerDiscardEnable);
+    PFN_DECLARE(PFN_vk, CmdSetPrimitiveTopology);
+    PFN_DECLARE(PFN_vk, CmdSetPrimitiveRestartEnable);
+    PFN_DECLARE(PFN_vk, CmdSetCullMode);
+    PFN_DECLARE(PFN_vk, CmdSetFrontFace);
+    PFN_DECLARE(PFN_vk, CmdSetDepthBiasEnable);
+    PFN_DECLARE(PFN_vk, CmdSetDepthTestEnable);
+    PFN_DECLARE(PFN_vk, CmdSetDepthWriteEnable);
+    PFN_DECLARE(PFN_vk, CmdSetDepthCompareOp);
+    PFN_DECLARE(PFN_vk, CmdSetStencilTestEnable);
+    PFN_DECLARE(PFN_vk, CmdSetStencilOp);
+    PFN_DECLARE(PFN_vk, CmdSetDepthBoundsTestEnable);
+};
+struct DynamicStateSymbolsLoaderT : public DescriptorSetSymbolsLoaderT
+{
+    void load(ContextABC* cx) override {};
+    void load(ContextABC* cx, f6::bin::DynamicLibraryLoader* loader) override {}
+
+    void load(ContextABC* cx, const Instance* instance) override {}
+    void load(ContextABC* cx, const LogicalDevice* device) override;
+};
+
+/**
+ * @brief VK_EXT_shader_object, null if the extension is not enabled
+ *
+ */
+struct ShaderObjectSymbolsT : public DynamicStateSymbolsT
+{
+    PFN_DECLARE(PFN_vk, CreateShadersEXT);
+    PFN_DECLARE(PFN_vk, DestroyShaderEXT);
+    PFN_DECLARE(PFN_vk, CmdBindShadersEXT);
+
+    PFN_DECLARE(PFN_vk, CmdSetVertexInputEXT);
+    PFN_DECLARE(PFN_vk, CmdSetPolygonModeEXT);
+    PFN_DECLARE(PFN_vk, CmdSetRasterizationSamplesEXT);
+    PFN_DECLARE(PFN_vk, CmdSetSampleMaskEXT);
+    PFN_DECLARE(PFN_vk, CmdSetAlphaToCoverageEnableEXT);
+    PFN_DECLARE(PFN_vk, CmdSetColorBlendEnableEXT);
+    PFN_DECLARE(PFN_vk, CmdSetColorBlendEquationEXT);
+    PFN_DECLARE(PFN_vk, CmdSetColorWriteMaskEXT);
+    PFN_DECLARE(PFN_vk, CmdSetDepthClampEnableEXT);
+    PFN_DECLARE(PFN_vk, CmdSetLogicOpEnableEXT);
+};
+struct ShaderObjectSymbolsLoaderT : public DynamicStateSymbolsLoaderT
+{
+    void load(ContextABC* cx) override {};
+    void load(ContextABC* cx, f6::bin::DynamicLibraryLoader* loader) override {}
+
+    void load(ContextABC* cx, const Instance* instance) override {}
+    void load(ContextABC* cx, const LogicalDevice* device) override;
+};
+
+struct DeviceSymbols2T : public ShaderObjectSymbolsT
 {
     PFN_DECLARE(PFN_vk, GetDeviceQueue);
     PFN_DECLARE(PFN_vk, DestroyDevice);
@@ -278,7 +411,7 @@ struct DeviceSymbols2T : public DescriptorSetSymbolsT
 
     PFN_DECLARE(PFN_vk, MapMemory);
 };
-struct DeviceSymbolsLoader2T : public DescriptorSetSymbolsLoaderT
+struct DeviceSymbolsLoader2T : public ShaderObjectSymbolsLoaderT
 {
   protected:
     void load(ContextABC* cx) override {};
@@ -287,3 +420,16 @@ struct DeviceSymbolsLoader2T : public DescriptorSetSymbolsLoaderT
     void load(ContextABC* cx, const Instance* instance) override {}
     void load(ContextABC* cx, const LogicalDevice* device) override;
 };
+
+/**
+ * @brief device level functions of a single device, resolved with vkGetDeviceProcAddr so that
+ * the calls reach the driver directly instead of going through the loader trampolines (which
+ * look up the dispatch table of the handle on every call)
+ * the functions of the context work with any device, the ones of this table only with the device
+ * they were loaded for, extension functions are null when the extension is not enabled
+ *
+ */
+struct DeviceDispatchT : public DeviceSymbols2T
+{
+    void load(const ContextABC* cx, const VkDevice device);
+};
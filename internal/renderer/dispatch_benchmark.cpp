@@ -0,0 +1,139 @@
+#include <chrono>
+#include <iostream>
+
+#include "graphics/backbuffer.hpp"
+#include "graphics/context.hpp"
+#include "graphics/device/device.hpp"
+#include "graphics/device/memory/buffer.hpp"
+
+#include "dispatch_benchmark.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint32_t kCommandsPerDraw = 5U;
+static constexpr uint32_t kPushConstantSize = 128U;
+
+struct DispatchBenchmarkTargetT
+{
+    VkCommandBuffer commandBuffer;
+    VkPipelineLayout layout;
+    VkBuffer buffer;
+};
+
+/**
+ * @brief record one pass through the given functions, the context and the dispatch table declare
+ * the same members
+ *
+ */
+template<class TSymbols>
+static Clock::duration recordPass(const TSymbols* vk, const DispatchBenchmarkTargetT& target,
+                                  const uint32_t drawCount)
+{
+    const VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    const uint8_t constants[kPushConstantSize] = {};
+    const VkViewport viewport = {
+        .width = 1.f,
+        .height = 1.f,
+        .maxDepth = 1.f,
+    };
+    const VkRect2D scissor = {.extent = {1U, 1U}};
+    const VkDeviceSize offset = 0U;
+    const VkCommandBuffer cb = target.commandBuffer;
+
+    vk->ResetCommandBuffer(cb, 0);
+    vk->BeginCommandBuffer(cb, &beginInfo);
+    const auto start = Clock::now();
+    for (uint32_t i = 0; i < drawCount; ++i)
+    {
+        vk->CmdPushConstants(cb, target.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, kPushConstantSize,
+                             constants);
+        vk->CmdBindVertexBuffers(cb, 0, 1, &target.buffer, &offset);
+        vk->CmdBindIndexBuffer(cb, target.buffer, 0, VK_INDEX_TYPE_UINT16);
+        vk->CmdSetViewport(cb, 0, 1, &viewport);
+        vk->CmdSetScissor(cb, 0, 1, &scissor);
+    }
+    const auto end = Clock::now();
+    vk->EndCommandBuffer(cb);
+    return end - start;
+}
+
+DispatchBenchmarkResultT runDispatchBenchmark(const LogicalDevice& device,
+                                              const DispatchBenchmarkInfoT& info)
+{
+    auto* cx = device.getContext();
+    DispatchBenchmarkResultT out;
+
+    const VkPushConstantRange range = {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset = 0U,
+        .size = kPushConstantSize,
+    };
+    const VkPipelineLayoutCreateInfo layoutCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pushConstantRangeCount = 1U,
+        .pPushConstantRanges = &range,
+    };
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkResult res =
+        cx->CreatePipelineLayout(device.getHandle(), &layoutCreateInfo, nullptr, &layout);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create the dispatch benchmark layout : " << res << std::endl;
+        return out;
+    }
+    auto buffer = device.createBuffer(BufferCreateInfoT{
+        .size = 256U,
+        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        .memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+    });
+    auto backBuffer = device.createBackBufferAOS(BackBufferCreateInfoT{
+        .submitCountPerCommandBuffer = 0U,
+        .bFenceStartsSignaled = false,
+    });
+
+    const DispatchBenchmarkTargetT target = {
+        .commandBuffer = backBuffer->commandBuffer,
+        .layout = layout,
+        .buffer = buffer->handle,
+    };
+    const DeviceDispatchT* dispatch = device.getDispatch();
+
+    // one pass each before measuring, the driver grows its command pool on the first one
+    (void)recordPass(cx, target, info.drawCount);
+    (void)recordPass(dispatch, target, info.drawCount);
+
+    Clock::duration contextTime(0);
+    Clock::duration dispatchTime(0);
+    for (uint32_t pass = 0; pass < info.passCount; ++pass)
+    {
+        contextTime += recordPass(cx, target, info.drawCount);
+        dispatchTime += recordPass(dispatch, target, info.drawCount);
+    }
+    cx->ResetCommandBuffer(backBuffer->commandBuffer, 0);
+
+    device.destroyBackBufferAOS(backBuffer);
+    device.destroyBuffer(buffer);
+    cx->DestroyPipelineLayout(device.getHandle(), layout, nullptr);
+
+    out.commandCount = static_cast<uint64_t>(info.drawCount) * kCommandsPerDraw * info.passCount;
+    if (out.commandCount > 0U)
+    {
+        out.contextNanoseconds =
+            std::chrono::duration<double, std::nano>(contextTime).count() / out.commandCount;
+        out.dispatchNanoseconds =
+            std::chrono::duration<double, std::nano>(dispatchTime).count() / out.commandCount;
+    }
+    return out;
+}
+
+void printDispatchBenchmark(const DispatchBenchmarkResultT& result)
+{
+    std::cout << "Dispatch benchmark (" << result.commandCount << " commands per table) :"
+              << std::endl;
+    std::cout << "  context : " << result.contextNanoseconds << " ns per command" << std::endl;
+    std::cout << "  device dispatch table : " << result.dispatchNanoseconds << " ns per command"
+              << std::endl;
+}
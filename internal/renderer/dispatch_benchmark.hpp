@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+class LogicalDevice;
+
+struct DispatchBenchmarkInfoT
+{
+    /**
+     * @brief draws recorded per pass, each one records the commands LegacyRendererBackend::draw
+     * records per object (push constants, vertex and index buffers, viewport and scissor), the
+     * draw itself needs a pipeline and is left out
+     *
+     */
+    uint32_t drawCount = 100000U;
+    /**
+     * @brief passes per function table, alternated so that both warm up the same way
+     *
+     */
+    uint32_t passCount = 10U;
+};
+
+struct DispatchBenchmarkResultT
+{
+    uint64_t commandCount = 0U;
+    /**
+     * @brief per command, through the functions of the context and through the dispatch table of
+     * the device
+     *
+     */
+    double contextNanoseconds = 0.0;
+    double dispatchNanoseconds = 0.0;
+};
+
+/**
+ * @brief record the same commands through both function tables into a command buffer that is
+ * never submitted, only the host cost of the calls is measured
+ *
+ */
+[[nodiscard]] DispatchBenchmarkResultT runDispatchBenchmark(const LogicalDevice& device,
+                                                            const DispatchBenchmarkInfoT& info);
+
+void printDispatchBenchmark(const DispatchBenchmarkResultT& result);
@@ -0,0 +1,317 @@
+#include <cstring>
+
+#include "core/host_arena.hpp"
+#include "graphics/context.hpp"
+#include "graphics/device/asset/pipeline.hpp"
+#include "graphics/device/device.hpp"
+
+#include "dynamic_state_recorder.hpp"
+
+template<class T> bool DynamicStateRecorder::update(std::optional<T>& shadow, const T& value)
+{
+    // Vulkan structures compared here have no padding
+    if (shadow.has_value() && std::memcmp(&shadow.value(), &value, sizeof(T)) == 0)
+    {
+        ++m_stats.filteredCount;
+        return false;
+    }
+
+    shadow = value;
+    ++m_stats.emittedCount;
+    return true;
+}
+
+template<class T>
+bool DynamicStateRecorder::update(std::vector<T>& shadow, const T* value, const size_t count)
+{
+    if (shadow.size() == count && std::memcmp(shadow.data(), value, count * sizeof(T)) == 0)
+    {
+        ++m_stats.filteredCount;
+        return false;
+    }
+
+    shadow.assign(value, value + count);
+    ++m_stats.emittedCount;
+    return true;
+}
+
+void DynamicStateRecorder::forget()
+{
+    ShadowT shadow;
+    shadow.shaders.swap(m_shadow.shaders);
+    shadow.vertexBindings.swap(m_shadow.vertexBindings);
+    shadow.vertexAttributes.swap(m_shadow.vertexAttributes);
+    shadow.colorBlendEnables.swap(m_shadow.colorBlendEnables);
+    shadow.colorBlendEquations.swap(m_shadow.colorBlendEquations);
+    shadow.colorWriteMasks.swap(m_shadow.colorWriteMasks);
+
+    shadow.shaders.clear();
+    shadow.vertexBindings.clear();
+    shadow.vertexAttributes.clear();
+    shadow.colorBlendEnables.clear();
+    shadow.colorBlendEquations.clear();
+    shadow.colorWriteMasks.clear();
+    m_shadow = std::move(shadow);
+}
+
+void DynamicStateRecorder::reset(const LogicalDevice* device, const VkCommandBuffer commandBuffer)
+{
+    m_device = device;
+    m_commandBuffer = commandBuffer;
+    forget();
+}
+
+void DynamicStateRecorder::setViewport(const VkViewport& viewport, const VkRect2D& scissor)
+{
+    const auto* vk = m_device->getDispatch();
+
+    m_shadow.viewport = viewport;
+    m_shadow.scissor = scissor;
+    if (m_shadow.bViewportWithCount)
+    {
+        vk->CmdSetViewportWithCount(m_commandBuffer, 1, &viewport);
+        vk->CmdSetScissorWithCount(m_commandBuffer, 1, &scissor);
+    }
+    else
+    {
+        vk->CmdSetViewport(m_commandBuffer, 0, 1, &viewport);
+        vk->CmdSetScissor(m_commandBuffer, 0, 1, &scissor);
+    }
+    m_stats.emittedCount += 2U;
+}
+
+void DynamicStateRecorder::bind(const Pipeline& pipeline)
+{
+    const auto* vk = m_device->getDispatch();
+
+    if (m_shadow.pipeline == &pipeline)
+    {
+        ++m_stats.filteredCount;
+        return;
+    }
+    m_shadow.pipeline = &pipeline;
+
+    if (!pipeline.usesShaderObjects())
+    {
+        vk->CmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipeline.getBindHandle());
+        ++m_stats.pipelineBindCount;
+
+        // the pipeline overwrote the state, only the viewport and scissor stay dynamic
+        auto viewport = m_shadow.viewport;
+        auto scissor = m_shadow.scissor;
+        bool bViewportWithCount = m_shadow.bViewportWithCount;
+        forget();
+        m_shadow.pipeline = &pipeline;
+        if (viewport.has_value() && scissor.has_value())
+        {
+            if (bViewportWithCount)
+                setViewport(viewport.value(), scissor.value());
+            else
+            {
+                m_shadow.viewport = viewport;
+                m_shadow.scissor = scissor;
+            }
+        }
+        return;
+    }
+
+    const auto& shaders = pipeline.getShaderObjects();
+    if (update(m_shadow.shaders, shaders.data(), shaders.size()))
+    {
+        vk->CmdBindShadersEXT(m_commandBuffer,
+                              static_cast<uint32_t>(pipeline.getShaderObjectStages().size()),
+                              pipeline.getShaderObjectStages().data(),
+                              pipeline.getShaderObjects().data());
+        ++m_stats.shaderObjectBindCount;
+    }
+
+    // shader objects only know the count variants
+    if (!m_shadow.bViewportWithCount && m_shadow.viewport.has_value() &&
+        m_shadow.scissor.has_value())
+    {
+        m_shadow.bViewportWithCount = true;
+        setViewport(m_shadow.viewport.value(), m_shadow.scissor.value());
+    }
+
+    applyVertexInput(pipeline);
+    applyRasterization(pipeline);
+    applyDepthStencil(pipeline);
+    applyColorBlend(pipeline);
+}
+
+void DynamicStateRecorder::applyVertexInput(const Pipeline& pipeline)
+{
+    const auto* vk = m_device->getDispatch();
+    const auto& ci = pipeline.getCreateInfo();
+
+    // the converted descriptions only live until the commands are recorded
+    auto& arena = HostArena::getThreadFrameArena();
+
+    const size_t bindingCount = ci.vertexBindings.size();
+    auto* bindings = arena.allocateArray<VkVertexInputBindingDescription2EXT>(bindingCount);
+    for (int i = 0; i < bindingCount; ++i)
+    {
+        bindings[i] = {
+            .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT,
+            .binding = ci.vertexBindings[i].binding,
+            .stride = ci.vertexBindings[i].stride,
+            .inputRate = ci.vertexBindings[i].inputRate,
+            .divisor = 1,
+        };
+    }
+    const size_t attributeCount = ci.vertexAttributes.size();
+    auto* attributes = arena.allocateArray<VkVertexInputAttributeDescription2EXT>(attributeCount);
+    for (int i = 0; i < attributeCount; ++i)
+    {
+        attributes[i] = {
+            .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT,
+            .location = ci.vertexAttributes[i].location,
+            .binding = ci.vertexAttributes[i].binding,
+            .format = ci.vertexAttributes[i].format,
+            .offset = ci.vertexAttributes[i].offset,
+        };
+    }
+
+    bool bBindingsChanged = update(m_shadow.vertexBindings, bindings, bindingCount);
+    bool bAttributesChanged = update(m_shadow.vertexAttributes, attributes, attributeCount);
+    if (!m_shadow.bVertexInput || bBindingsChanged || bAttributesChanged)
+    {
+        m_shadow.bVertexInput = true;
+        vk->CmdSetVertexInputEXT(m_commandBuffer, static_cast<uint32_t>(bindingCount), bindings,
+                                 static_cast<uint32_t>(attributeCount), attributes);
+    }
+
+    if (update(m_shadow.topology, ci.topology))
+        vk->CmdSetPrimitiveTopology(m_commandBuffer, ci.topology);
+    VkBool32 primitiveRestartEnable = ci.bPrimitiveRestartEnable ? VK_TRUE : VK_FALSE;
+    if (update(m_shadow.primitiveRestartEnable, primitiveRestartEnable))
+        vk->CmdSetPrimitiveRestartEnable(m_commandBuffer, primitiveRestartEnable);
+}
+
+void DynamicStateRecorder::applyRasterization(const Pipeline& pipeline)
+{
+    const auto* vk = m_device->getDispatch();
+    const auto& r = pipeline.getCreateInfo().rasterizerCreateInfo;
+    const auto& m = pipeline.getCreateInfo().multisamplingCreateInfo;
+
+    if (update(m_shadow.rasterizerDiscardEnable, r.rasterizerDiscardEnable))
+        vk->CmdSetRasterizerDiscardEnable(m_commandBuffer, r.rasterizerDiscardEnable);
+    if (update(m_shadow.depthClampEnable, r.depthClampEnable))
+        vk->CmdSetDepthClampEnableEXT(m_commandBuffer, r.depthClampEnable);
+    if (update(m_shadow.polygonMode, r.polygonMode))
+        vk->CmdSetPolygonModeEXT(m_commandBuffer, r.polygonMode);
+    if (update(m_shadow.cullMode, r.cullMode))
+        vk->CmdSetCullMode(m_commandBuffer, r.cullMode);
+    if (update(m_shadow.frontFace, r.frontFace))
+        vk->CmdSetFrontFace(m_commandBuffer, r.frontFace);
+    if (update(m_shadow.lineWidth, r.lineWidth))
+        vk->CmdSetLineWidth(m_commandBuffer, r.lineWidth);
+    if (update(m_shadow.depthBiasEnable, r.depthBiasEnable))
+        vk->CmdSetDepthBiasEnable(m_commandBuffer, r.depthBiasEnable);
+    if (r.depthBiasEnable && update(m_shadow.depthBias, {r.depthBiasConstantFactor,
+                                                         r.depthBiasClamp, r.depthBiasSlopeFactor}))
+    {
+        vk->CmdSetDepthBias(m_commandBuffer, r.depthBiasConstantFactor, r.depthBiasClamp,
+                            r.depthBiasSlopeFactor);
+    }
+
+    if (update(m_shadow.rasterizationSamples, m.rasterizationSamples))
+        vk->CmdSetRasterizationSamplesEXT(m_commandBuffer, m.rasterizationSamples);
+    // pSampleMask null means all samples
+    VkSampleMask sampleMask = m.pSampleMask ? m.pSampleMask[0] : ~0U;
+    if (update(m_shadow.sampleMask, sampleMask))
+        vk->CmdSetSampleMaskEXT(m_commandBuffer, m.rasterizationSamples, &sampleMask);
+    if (update(m_shadow.alphaToCoverageEnable, m.alphaToCoverageEnable))
+        vk->CmdSetAlphaToCoverageEnableEXT(m_commandBuffer, m.alphaToCoverageEnable);
+}
+
+void DynamicStateRecorder::applyDepthStencil(const Pipeline& pipeline)
+{
+    const auto* vk = m_device->getDispatch();
+    const auto& d = pipeline.getCreateInfo().depthStencilCreateInfo;
+
+    if (update(m_shadow.depthTestEnable, d.depthTestEnable))
+        vk->CmdSetDepthTestEnable(m_commandBuffer, d.depthTestEnable);
+    if (update(m_shadow.depthWriteEnable, d.depthWriteEnable))
+        vk->CmdSetDepthWriteEnable(m_commandBuffer, d.depthWriteEnable);
+    if (d.depthTestEnable && update(m_shadow.depthCompareOp, d.depthCompareOp))
+        vk->CmdSetDepthCompareOp(m_commandBuffer, d.depthCompareOp);
+    if (update(m_shadow.depthBoundsTestEnable, d.depthBoundsTestEnable))
+        vk->CmdSetDepthBoundsTestEnable(m_commandBuffer, d.depthBoundsTestEnable);
+    if (d.depthBoundsTestEnable &&
+        update(m_shadow.depthBounds, {d.minDepthBounds, d.maxDepthBounds}))
+    {
+        vk->CmdSetDepthBounds(m_commandBuffer, d.minDepthBounds, d.maxDepthBounds);
+    }
+
+    if (update(m_shadow.stencilTestEnable, d.stencilTestEnable))
+        vk->CmdSetStencilTestEnable(m_commandBuffer, d.stencilTestEnable);
+    if (!d.stencilTestEnable)
+        return;
+
+    const std::pair<VkStencilFaceFlags, const VkStencilOpState*> faces[] = {
+        {VK_STENCIL_FACE_FRONT_BIT, &d.front},
+        {VK_STENCIL_FACE_BACK_BIT,  &d.back },
+    };
+    for (const auto& [face, s] : faces)
+    {
+        auto& shadow = face == VK_STENCIL_FACE_FRONT_BIT ? m_shadow.stencilFront : m_shadow.stencilBack;
+        if (!update(shadow, *s))
+            continue;
+
+        vk->CmdSetStencilOp(m_commandBuffer, face, s->failOp, s->passOp, s->depthFailOp,
+                            s->compareOp);
+        vk->CmdSetStencilCompareMask(m_commandBuffer, face, s->compareMask);
+        vk->CmdSetStencilWriteMask(m_commandBuffer, face, s->writeMask);
+        vk->CmdSetStencilReference(m_commandBuffer, face, s->reference);
+    }
+}
+
+void DynamicStateRecorder::applyColorBlend(const Pipeline& pipeline)
+{
+    const auto* vk = m_device->getDispatch();
+    const auto& ci = pipeline.getCreateInfo();
+
+    // the pipelines never enable the logic op (GraphicsPipelineStatesT), neither does the recorder
+    const VkBool32 logicOpEnable = VK_FALSE;
+    if (update(m_shadow.logicOpEnable, logicOpEnable))
+        vk->CmdSetLogicOpEnableEXT(m_commandBuffer, logicOpEnable);
+
+    const size_t count = ci.colorBlendAttachment.size();
+    if (count == 0)
+        return;
+
+    auto& arena = HostArena::getThreadFrameArena();
+    auto* enables = arena.allocateArray<VkBool32>(count);
+    auto* equations = arena.allocateArray<VkColorBlendEquationEXT>(count);
+    auto* writeMasks = arena.allocateArray<VkColorComponentFlags>(count);
+    for (int i = 0; i < count; ++i)
+    {
+        const auto& a = ci.colorBlendAttachment[i];
+        enables[i] = a.blendEnable;
+        equations[i] = {
+            .srcColorBlendFactor = a.srcColorBlendFactor,
+            .dstColorBlendFactor = a.dstColorBlendFactor,
+            .colorBlendOp = a.colorBlendOp,
+            .srcAlphaBlendFactor = a.srcAlphaBlendFactor,
+            .dstAlphaBlendFactor = a.dstAlphaBlendFactor,
+            .alphaBlendOp = a.alphaBlendOp,
+        };
+        writeMasks[i] = a.colorWriteMask;
+    }
+
+    if (update(m_shadow.colorBlendEnables, enables, count))
+        vk->CmdSetColorBlendEnableEXT(m_commandBuffer, 0, static_cast<uint32_t>(count), enables);
+    if (update(m_shadow.colorBlendEquations, equations, count))
+        vk->CmdSetColorBlendEquationEXT(m_commandBuffer, 0, static_cast<uint32_t>(count),
+                                        equations);
+    if (update(m_shadow.colorWriteMasks, writeMasks, count))
+        vk->CmdSetColorWriteMaskEXT(m_commandBuffer, 0, static_cast<uint32_t>(count),
+                                    writeMasks);
+
+    std::array<float, 4> blendConstants = {ci.blendConstants[0], ci.blendConstants[1],
+                                           ci.blendConstants[2], ci.blendConstants[3]};
+    if (update(m_shadow.blendConstants, blendConstants))
+        vk->CmdSetBlendConstants(m_commandBuffer, ci.blendConstants);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+class Pipeline;
+
+struct DynamicStateRecorderStatsT
+{
+    uint64_t pipelineBindCount = 0U;
+    uint64_t shaderObjectBindCount = 0U;
+    /**
+     * @brief state commands recorded
+     *
+     */
+    uint64_t emittedCount = 0U;
+    /**
+     * @brief state commands skipped because the command buffer already had that state
+     *
+     */
+    uint64_t filteredCount = 0U;
+};
+
+/**
+ * @brief records pipeline binds and, for pipelines using shader objects, the whole pipeline state
+ * through dynamic state commands
+ * a shadow copy of the command buffer state is kept so that redundant commands are not recorded,
+ * it is forgotten when a new command buffer begins and when a VkPipeline is bound (a pipeline
+ * overwrites every state it does not declare dynamic)
+ *
+ */
+class DynamicStateRecorder
+{
+  private:
+    const LogicalDevice* m_device = nullptr;
+    VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
+
+    DynamicStateRecorderStatsT m_stats;
+
+  private:
+    /**
+     * @brief shadow state, empty when unknown
+     *
+     */
+    struct ShadowT
+    {
+        const Pipeline* pipeline = nullptr;
+        std::vector<VkShaderEXT> shaders;
+
+        std::optional<VkViewport> viewport;
+        std::optional<VkRect2D> scissor;
+        bool bViewportWithCount = false;
+
+        std::vector<VkVertexInputBindingDescription2EXT> vertexBindings;
+        std::vector<VkVertexInputAttributeDescription2EXT> vertexAttributes;
+        bool bVertexInput = false;
+        std::optional<VkPrimitiveTopology> topology;
+        std::optional<VkBool32> primitiveRestartEnable;
+
+        std::optional<VkBool32> rasterizerDiscardEnable;
+        std::optional<VkBool32> depthClampEnable;
+        std::optional<VkPolygonMode> polygonMode;
+        std::optional<VkCullModeFlags> cullMode;
+        std::optional<VkFrontFace> frontFace;
+        std::optional<float> lineWidth;
+        std::optional<VkBool32> depthBiasEnable;
+        std::optional<std::array<float, 3>> depthBias;
+
+        std::optional<VkSampleCountFlagBits> rasterizationSamples;
+        std::optional<VkSampleMask> sampleMask;
+        std::optional<VkBool32> alphaToCoverageEnable;
+
+        std::optional<VkBool32> depthTestEnable;
+        std::optional<VkBool32> depthWriteEnable;
+        std::optional<VkCompareOp> depthCompareOp;
+        std::optional<VkBool32> depthBoundsTestEnable;
+        std::optional<std::array<float, 2>> depthBounds;
+        std::optional<VkBool32> stencilTestEnable;
+        std::optional<VkStencilOpState> stencilFront;
+        std::optional<VkStencilOpState> stencilBack;
+
+        std::optional<VkBool32> logicOpEnable;
+        std::vector<VkBool32> colorBlendEnables;
+        std::vector<VkColorBlendEquationEXT> colorBlendEquations;
+        std::vector<VkColorComponentFlags> colorWriteMasks;
+        std::optional<std::array<float, 4>> blendConstants;
+    } m_shadow;
+
+    /**
+     * @brief compares the shadow with the value, updates it and counts the result
+     *
+     * @return true if the command must be recorded
+     */
+    template<class T> bool update(std::optional<T>& shadow, const T& value);
+    template<class T> bool update(std::vector<T>& shadow, const T* value, const size_t count);
+
+    /**
+     * @brief reset the shadow to unknown, the vectors keep their storage for the next binds
+     *
+     */
+    void forget();
+
+    void applyVertexInput(const Pipeline& pipeline);
+    void applyRasterization(const Pipeline& pipeline);
+    void applyDepthStencil(const Pipeline& pipeline);
+    void applyColorBlend(const Pipeline& pipeline);
+
+  public:
+    DynamicStateRecorder() = default;
+
+    /**
+     * @brief start recording a new command buffer, the previous state is forgotten
+     *
+     */
+    void reset(const LogicalDevice* device, const VkCommandBuffer commandBuffer);
+
+    /**
+     * @brief viewport and scissor of the render area
+     *
+     */
+    void setViewport(const VkViewport& viewport, const VkRect2D& scissor);
+
+    /**
+     * @brief bind the pipeline, or its shader objects and its state
+     *
+     */
+    void bind(const Pipeline& pipeline);
+
+  public:
+    [[nodiscard]] inline const DynamicStateRecorderStatsT& getStats() const { return m_stats; }
+};
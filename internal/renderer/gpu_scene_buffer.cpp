@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+
+#include "device/asset/pipeline_cache.hpp"
+#include "device/asset/shader.hpp"
+#include "device/memory/buffer.hpp"
+#include "device/memory/frame_arena.hpp"
+#include "graphics/context.hpp"
+#include "graphics/device/device.hpp"
+
+#include "gpu_scene_buffer.hpp"
+
+static constexpr uint32_t kScatterGroupSize = 64U;
+
+GPUSceneBuffer::GPUSceneBuffer(const GPUSceneBufferCreateInfoT createInfo)
+    : ci(createInfo), m_writer(createInfo.device)
+{
+    m_buffer = ci.device->createBuffer(BufferCreateInfoT{
+        .size = ci.capacity * sizeof(GPUInstanceT),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        .allocationType = AllocationTypeE::SCENE,
+    });
+
+    if (!createScatterPipeline() || !createDescriptorSets())
+        return;
+
+    // shaders index the scene buffer from the bindless set when there is one
+    auto* bindless = ci.device->getBindlessTable();
+    if (bindless)
+        m_bindlessIndex = bindless->registerBuffer(m_buffer->handle, 0, VK_WHOLE_SIZE);
+}
+
+GPUSceneBuffer::~GPUSceneBuffer()
+{
+    auto* cx = ci.device->getContext();
+
+    if (m_frameCount > 0U)
+    {
+        std::cout << "gpu scene : " << getInstanceCount() << " instances, " << m_uploadedCount
+                  << " records uploaded in " << m_frameCount << " frames ("
+                  << m_uploadedCount * (sizeof(GPUInstanceT) + sizeof(uint32_t)) / m_frameCount
+                  << " bytes per frame)" << std::endl;
+    }
+
+    auto* bindless = ci.device->getBindlessTable();
+    if (bindless && m_bindlessIndex != kInvalidBindlessIndex)
+        bindless->release(BindlessBindingE::STORAGE_BUFFER, m_bindlessIndex);
+
+    if (m_pool != VK_NULL_HANDLE)
+        cx->DestroyDescriptorPool(ci.device->getHandle(), m_pool, nullptr);
+    if (m_pipeline != VK_NULL_HANDLE)
+        cx->DestroyPipeline(ci.device->getHandle(), m_pipeline, nullptr);
+    if (m_pipelineLayout != VK_NULL_HANDLE)
+        cx->DestroyPipelineLayout(ci.device->getHandle(), m_pipelineLayout, nullptr);
+    if (m_setLayout != VK_NULL_HANDLE)
+        cx->DestroyDescriptorSetLayout(ci.device->getHandle(), m_setLayout, nullptr);
+
+    if (m_buffer)
+        ci.device->destroyBuffer(m_buffer);
+}
+
+bool GPUSceneBuffer::createScatterPipeline()
+{
+    auto* cx = ci.device->getContext();
+
+    auto shader = ci.scatterShader
+                      ? std::static_pointer_cast<GPUShader>(ci.scatterShader->localResource)
+                      : nullptr;
+    if (!shader)
+    {
+        std::cerr << "Failed to create scene scatter pipeline : missing compute shader"
+                  << std::endl;
+        return false;
+    }
+
+    // scene buffer, scattered records, their indices
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings;
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i] = {
+            .binding = i,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        };
+    }
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+    VkResult res = cx->CreateDescriptorSetLayout(ci.device->getHandle(), &setLayoutCreateInfo,
+                                                 nullptr, &m_setLayout);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create scene scatter descriptor set layout : " << res
+                  << std::endl;
+        return false;
+    }
+
+    VkPushConstantRange pushConstantRange = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(uint32_t),
+    };
+    VkPipelineLayoutCreateInfo layoutCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_setLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    res = cx->CreatePipelineLayout(ci.device->getHandle(), &layoutCreateInfo, nullptr,
+                                   &m_pipelineLayout);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create scene scatter pipeline layout : " << res << std::endl;
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipelineCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = shader->createInfo,
+        .layout = m_pipelineLayout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+    res = cx->CreateComputePipelines(ci.device->getHandle(),
+                                     ci.device->getPipelineCache()->getHandle(), 1,
+                                     &pipelineCreateInfo, nullptr, &m_pipeline);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create scene scatter pipeline : " << res << std::endl;
+        m_pipeline = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+bool GPUSceneBuffer::createDescriptorSets()
+{
+    auto* cx = ci.device->getContext();
+
+    VkDescriptorPoolSize poolSize = {
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 3 * ci.frameCount,
+    };
+    VkDescriptorPoolCreateInfo poolCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = ci.frameCount,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+    VkResult res = cx->CreateDescriptorPool(ci.device->getHandle(), &poolCreateInfo, nullptr,
+                                            &m_pool);
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create scene scatter descriptor pool : " << res << std::endl;
+        return false;
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(ci.frameCount, m_setLayout);
+    m_sets.resize(ci.frameCount);
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_pool,
+        .descriptorSetCount = ci.frameCount,
+        .pSetLayouts = layouts.data(),
+    };
+    res = cx->AllocateDescriptorSets(ci.device->getHandle(), &allocInfo, m_sets.data());
+    if (res != VK_SUCCESS)
+    {
+        std::cerr << "Failed to allocate scene scatter descriptor sets : " << res << std::endl;
+        m_sets.clear();
+        return false;
+    }
+
+    // the scene buffer never moves, the uploads are written when recorded
+    for (uint32_t i = 0; i < ci.frameCount; ++i)
+    {
+        m_writer.writeBuffer(m_sets[i], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_buffer->handle, 0,
+                             VK_WHOLE_SIZE);
+    }
+    m_writer.flush();
+    return true;
+}
+
+void GPUSceneBuffer::markDirty(const uint32_t index)
+{
+    if (m_dirty[index])
+        return;
+    m_dirty[index] = true;
+    m_dirtyIndices.push_back(index);
+}
+
+uint32_t GPUSceneBuffer::add(const GPUInstanceT& instance)
+{
+    uint32_t index;
+    if (!m_freeIndices.empty())
+    {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else if (m_instances.size() < ci.capacity)
+    {
+        index = static_cast<uint32_t>(m_instances.size());
+        m_instances.emplace_back();
+        m_dirty.push_back(false);
+    }
+    else
+    {
+        std::cerr << "GPU scene buffer is full" << std::endl;
+        return -1U;
+    }
+
+    m_instances[index] = instance;
+    markDirty(index);
+    return index;
+}
+
+void GPUSceneBuffer::update(const uint32_t index, const GPUInstanceT& instance)
+{
+    assert(index < m_instances.size());
+    m_instances[index] = instance;
+    markDirty(index);
+}
+
+void GPUSceneBuffer::updateTransform(const uint32_t index, const glm::mat4& transform)
+{
+    assert(index < m_instances.size());
+    m_instances[index].transform = transform;
+    markDirty(index);
+}
+
+void GPUSceneBuffer::remove(const uint32_t index)
+{
+    assert(index < m_instances.size());
+    m_freeIndices.push_back(index);
+}
+
+void GPUSceneBuffer::record(const VkCommandBuffer commandBuffer, const uint32_t frameIndex)
+{
+    ++m_frameCount;
+    m_lastUploadCount = 0U;
+    if (!isValid() || m_dirtyIndices.empty())
+        return;
+
+    auto* cx = ci.device->getContext();
+    const VkDescriptorSet set = m_sets[frameIndex % ci.frameCount];
+
+    // the oldest changes are uploaded first, the others wait for the next frame
+    const uint32_t count =
+        std::min(static_cast<uint32_t>(m_dirtyIndices.size()), ci.maxUploadsPerFrame);
+    const TransientBufferT recordRange = ci.frameArena->allocate(count * sizeof(GPUInstanceT));
+    const TransientBufferT indexRange = ci.frameArena->allocate(count * sizeof(uint32_t));
+    if (!recordRange.isValid() || !indexRange.isValid())
+        return;
+
+    // the set of the frame is not in use anymore, the device is done with the frame
+    m_writer.writeBuffer(set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, recordRange.buffer,
+                         recordRange.offset, recordRange.size);
+    m_writer.writeBuffer(set, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, indexRange.buffer,
+                         indexRange.offset, indexRange.size);
+    m_writer.flush();
+
+    auto* records = static_cast<GPUInstanceT*>(recordRange.data);
+    auto* indices = static_cast<uint32_t*>(indexRange.data);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t index = m_dirtyIndices[i];
+        records[i] = m_instances[index];
+        indices[i] = index;
+        m_dirty[index] = false;
+    }
+    m_dirtyIndices.erase(m_dirtyIndices.begin(), m_dirtyIndices.begin() + count);
+
+    // the previous frames may still read the records being overwritten
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    cx->CmdPipelineBarrier(commandBuffer,
+                           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                           nullptr);
+
+    cx->CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    cx->CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0,
+                              1, &set, 0, nullptr);
+    cx->CmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                         sizeof(uint32_t), &count);
+    cx->CmdDispatch(commandBuffer, (count + kScatterGroupSize - 1) / kScatterGroupSize, 1, 1);
+
+    barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+    };
+    cx->CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    m_lastUploadCount = count;
+    m_uploadedCount += count;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+#include "graphics/device/memory/bindless_table.hpp"
+#include "graphics/device/memory/descriptor_writer.hpp"
+
+class LogicalDevice;
+class Buffer;
+class FrameArena;
+class Shader;
+
+/**
+ * @brief record of an instance in the scene buffer, laid out as the std430 Instance structure of
+ * shaders/scene_scatter.comp
+ *
+ */
+struct GPUInstanceT
+{
+    glm::mat4 transform = glm::mat4(1.f);
+    /**
+     * @brief center in xyz, radius in w, in object space
+     *
+     */
+    glm::vec4 boundingSphere = glm::vec4(0.f);
+    uint32_t materialIndex = 0U;
+    uint32_t padding[3] = {0U, 0U, 0U};
+};
+static_assert(sizeof(GPUInstanceT) % 16 == 0, "GPUInstanceT must match its std430 layout");
+
+struct GPUSceneBufferCreateInfoT
+{
+    const LogicalDevice* device;
+    /**
+     * @brief shaders/scene_scatter.comp
+     *
+     */
+    std::shared_ptr<Shader> scatterShader;
+    /**
+     * @brief the changed records and their indices are written in the transient buffers of the
+     * frame
+     *
+     */
+    FrameArena* frameArena;
+    /**
+     * @brief one scatter descriptor set per frame in flight
+     *
+     */
+    uint32_t frameCount;
+    uint32_t capacity = 65536U;
+    /**
+     * @brief changed records uploaded in a single frame, the remaining ones wait for the next
+     * frames
+     *
+     */
+    uint32_t maxUploadsPerFrame = 4096U;
+};
+
+/**
+ * @brief persistent device local storage buffer holding every instance of the scene
+ * the CPU keeps a mirror of the records and a list of the instances changed since the last upload,
+ * only those are written in the frame arena along with their index, a compute
+ * shader then scatters them into the scene buffer, so that the upload cost follows the number of
+ * changes instead of the number of instances
+ * not thread safe, the render thread owns it
+ *
+ */
+class GPUSceneBuffer
+{
+  private:
+    const GPUSceneBufferCreateInfoT ci;
+
+  private:
+    std::shared_ptr<Buffer> m_buffer;
+
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    /**
+     * @brief one set per frame in flight, pointed at the transient buffers of the frame when it
+     * records
+     *
+     */
+    std::vector<VkDescriptorSet> m_sets;
+    DescriptorWriter m_writer;
+
+    /**
+     * @brief scene buffer slot in the device bindless table, if any
+     *
+     */
+    uint32_t m_bindlessIndex = kInvalidBindlessIndex;
+
+    std::vector<GPUInstanceT> m_instances;
+    std::vector<uint32_t> m_freeIndices;
+    std::vector<uint32_t> m_dirtyIndices;
+    std::vector<bool> m_dirty;
+
+    uint32_t m_lastUploadCount = 0U;
+    uint64_t m_uploadedCount = 0U;
+    uint64_t m_frameCount = 0U;
+
+    void markDirty(const uint32_t index);
+
+    [[nodiscard]] bool createScatterPipeline();
+    [[nodiscard]] bool createDescriptorSets();
+
+  public:
+    GPUSceneBuffer() = delete;
+    GPUSceneBuffer(const GPUSceneBuffer&) = delete;
+    GPUSceneBuffer& operator=(const GPUSceneBuffer&) = delete;
+    GPUSceneBuffer(GPUSceneBuffer&&) = delete;
+    GPUSceneBuffer& operator=(GPUSceneBuffer&&) = delete;
+
+    explicit GPUSceneBuffer(const GPUSceneBufferCreateInfoT createInfo);
+    /**
+     * @brief prints the upload statistics
+     *
+     */
+    ~GPUSceneBuffer();
+
+    /**
+     * @return index of the instance in the scene buffer, -1U if the buffer is full
+     */
+    [[nodiscard]] uint32_t add(const GPUInstanceT& instance);
+    void update(const uint32_t index, const GPUInstanceT& instance);
+    void updateTransform(const uint32_t index, const glm::mat4& transform);
+    /**
+     * @brief the slot is reused by a later add, its record is left as is on the device
+     *
+     */
+    void remove(const uint32_t index);
+
+    /**
+     * @brief upload the changed records and record their scatter, must be recorded outside of a
+     * render pass, before the draws reading the scene buffer
+     * the frame arena must have begun the frame, it flushes the records before the submission
+     *
+     */
+    void record(const VkCommandBuffer commandBuffer, const uint32_t frameIndex);
+
+  public:
+    [[nodiscard]] inline bool isValid() const { return m_pipeline != VK_NULL_HANDLE; }
+    [[nodiscard]] inline const std::shared_ptr<Buffer>& getBuffer() const { return m_buffer; }
+    [[nodiscard]] inline uint32_t getBindlessIndex() const { return m_bindlessIndex; }
+    [[nodiscard]] inline uint32_t getCapacity() const { return ci.capacity; }
+    [[nodiscard]] inline uint32_t getInstanceCount() const
+    {
+        return static_cast<uint32_t>(m_instances.size() - m_freeIndices.size());
+    }
+    [[nodiscard]] inline uint32_t getPendingCount() const
+    {
+        return static_cast<uint32_t>(m_dirtyIndices.size());
+    }
+    [[nodiscard]] inline uint32_t getLastUploadCount() const { return m_lastUploadCount; }
+};
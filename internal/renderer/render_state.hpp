@@ -1,11 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <optional>
 #include <vector>
 
 #include <vulkan/vulkan.hpp>
 
+#include "engine/uniform.hpp"
 #include "graphics/device/asset/pipeline.hpp"
 #include "graphics/device/device.hpp"
+#include "graphics/device/memory/descriptor.hpp"
 
 struct RenderStateCreateInfoT final
 {
@@ -13,31 +17,147 @@ struct RenderStateCreateInfoT final
     PipelineCreateInfoT pipelineCreateInfo;
 };
 
+/**
+ * @brief data of a single draw given to the shaders without descriptor sets
+ *
+ */
+struct PerDrawDataT
+{
+    /**
+     * @brief pushed through the push constant ranges of the pipeline overlapping it
+     *
+     */
+    PushConstantsPerObject constants;
+    /**
+     * @brief written with push descriptors, one per binding of the push descriptor set in binding
+     * order, or into a transient set of the back buffer without VK_KHR_push_descriptor
+     *
+     */
+    std::vector<VkDescriptorBufferInfo> buffers;
+};
+
 class RenderableABC
 {
   public:
     virtual ~RenderableABC() {}
 
+    [[nodiscard]] virtual const PerDrawDataT* getPerDrawData() const { return nullptr; }
+
 } typedef RenderObjectABC, RenderDescriptionABC;
 
 class RenderState final
 {
+  public:
+    /**
+     * @brief how the per draw data of the objects reaches the pipeline, derived from its layout
+     *
+     */
+    struct PerDrawChannelT
+    {
+        /**
+         * @brief parts of PushConstantsPerObject covered by the push constant ranges, each one
+         * with the stages of every range overlapping it, pushed one after the other
+         *
+         */
+        std::vector<VkPushConstantRange> pushConstantRanges;
+        /**
+         * @brief pipeline layout index of the push descriptor set
+         *
+         */
+        std::optional<uint32_t> pushDescriptorSet;
+        VkDescriptorSetLayout pushDescriptorSetLayout = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSetLayoutBinding> pushDescriptorBindings;
+        /**
+         * @brief UNIFORM_BUFFER_DYNAMIC bindings of the per object sets, each one reads the
+         * UniformPerObject of the draw from the uniform ring
+         *
+         */
+        uint32_t dynamicOffsetCount = 0U;
+    };
+
   private:
     std::unique_ptr<Pipeline> pipeline;
 
     std::vector<std::shared_ptr<RenderableABC>> m_objects;
 
+    PerDrawChannelT m_perDrawChannel;
+
+    void initPerDrawChannel()
+    {
+        const auto& ci = pipeline->getCreateInfo();
+
+        // every byte must be pushed with the stages of all the ranges containing it, the bytes
+        // are split at the range bounds
+        constexpr uint32_t kSize = sizeof(PushConstantsPerObject);
+        std::vector<uint32_t> bounds = {0U, kSize};
+        for (const auto& range : ci.pushConstantRanges)
+        {
+            bounds.push_back(std::min(range.offset, kSize));
+            bounds.push_back(std::min(range.offset + range.size, kSize));
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+        for (uint32_t i = 0; i + 1 < bounds.size(); ++i)
+        {
+            VkShaderStageFlags stages = 0;
+            for (const auto& range : ci.pushConstantRanges)
+            {
+                if (range.offset <= bounds[i] && bounds[i + 1] <= range.offset + range.size)
+                    stages |= range.stageFlags;
+            }
+            if (stages == 0)
+                continue;
+
+            auto& ranges = m_perDrawChannel.pushConstantRanges;
+            if (!ranges.empty() && ranges.back().stageFlags == stages &&
+                ranges.back().offset + ranges.back().size == bounds[i])
+                ranges.back().size += bounds[i + 1] - bounds[i];
+            else
+                ranges.push_back({stages, bounds[i], bounds[i + 1] - bounds[i]});
+        }
+        for (const auto& desc : ci.setDescriptions)
+        {
+            if (desc.frequency != DescriptorFrequencyE::PER_OBJECT || desc.bPushDescriptor)
+                continue;
+            for (const auto& binding : desc.setLayoutBindings)
+            {
+                if (binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+                    m_perDrawChannel.dynamicOffsetCount += binding.descriptorCount;
+            }
+        }
+        for (uint32_t i = 0; i < ci.setDescriptions.size(); ++i)
+        {
+            if (!ci.setDescriptions[i].bPushDescriptor)
+                continue;
+            m_perDrawChannel.pushDescriptorSet = pipeline->getFirstSetIndex() + i;
+            m_perDrawChannel.pushDescriptorSetLayout = pipeline->getSetLayouts()[i];
+            m_perDrawChannel.pushDescriptorBindings = ci.setDescriptions[i].setLayoutBindings;
+            break;
+        }
+    }
+
   public:
     RenderState() = delete;
     explicit RenderState(const RenderStateCreateInfoT createInfo)
     {
         pipeline = createInfo.deviceptr->createPipeline(createInfo.pipelineCreateInfo);
+        initPerDrawChannel();
+    }
+    /**
+     * @brief takes ownership of a pipeline already created, e.g. by LogicalDevice::createPipelines
+     *
+     */
+    explicit RenderState(std::unique_ptr<Pipeline> createdPipeline)
+        : pipeline(std::move(createdPipeline))
+    {
+        initPerDrawChannel();
     }
 
     void addObject(std::shared_ptr<RenderableABC> object) { m_objects.push_back(object); }
 
   public:
     [[nodiscard]] const Pipeline* getPipeline() const { return pipeline.get(); }
+    [[nodiscard]] const PerDrawChannelT& getPerDrawChannel() const { return m_perDrawChannel; }
     [[nodiscard]] const std::vector<std::shared_ptr<RenderableABC>>& getObjects() const
     {
         return m_objects;
@@ -1,6 +1,15 @@
+#include <algorithm>
+#include <array>
 #include <iostream>
 
+#include "core/allocation_tracker.hpp"
+#include "device/asset/object_cache.hpp"
 #include "device/memory/descriptor.hpp"
+#include "device/memory/bindless_table.hpp"
+#include "device/memory/defragmenter.hpp"
+#include "device/memory/descriptor_allocator.hpp"
+#include "device/memory/image_uploader.hpp"
+#include "device/memory/uniform_ring.hpp"
 #include "graphics/context.hpp"
 #include "graphics/synchronization.hpp"
 
@@ -18,13 +27,40 @@ LegacyRendererBackend::LegacyRendererBackend(
     m_renderPass = createInfo->device->createRenderPass(ci->renderPassCreateInfo);
 }
 
+LegacyRendererBackend::~LegacyRendererBackend()
+{
+    if (m_recordedFrameCount == 0U)
+        return;
+
+    const auto& stats = m_recorder.getStats();
+    std::cout << "renderer : "
+              << std::chrono::duration<double, std::micro>(m_recordTime).count() /
+                     m_recordedFrameCount
+              << " us recording draws per frame, " << stats.pipelineBindCount
+              << " pipeline binds, " << stats.shaderObjectBindCount << " shader object binds, "
+              << stats.emittedCount << " state commands recorded, " << stats.filteredCount
+              << " filtered" << std::endl;
+}
+
 void RendererBackendABC::wait() const
 {
     auto& bb = m_backBuffers[m_currentBackBufferIndex];
-    auto* cx = m_device->getContext();
-
-    cx->WaitForFences(m_device->getHandle(), 1, &bb->inFlightFence, VK_TRUE, UINT64_MAX);
-    cx->ResetFences(m_device->getHandle(), 1, &bb->inFlightFence);
+    const auto* vk = m_device->getDispatch();
+
+    vk->WaitForFences(m_device->getHandle(), 1, &bb->inFlightFence, VK_TRUE, UINT64_MAX);
+    vk->ResetFences(m_device->getHandle(), 1, &bb->inFlightFence);
+
+    // the device is done with the sets of this back buffer
+    if (bb->transientDescriptorAllocator)
+        bb->transientDescriptorAllocator->reset();
+    // and with its uniforms and transient buffers
+    m_uniformRing->begin(m_currentBackBufferIndex);
+    m_frameArena->begin(m_currentBackBufferIndex);
+
+    // refreshes the heap budgets, warns when a heap gets close to its budget
+    m_device->getMemoryAllocator()->setCurrentFrameIndex(m_currentBackBufferIndex);
+    // and with the samplers, views, render passes and framebuffers released during that frame
+    m_device->getObjectCache()->collect(m_currentBackBufferIndex);
 }
 
 void RendererBackendABC::swap()
@@ -32,18 +68,25 @@ void RendererBackendABC::swap()
     m_currentBackBufferIndex = (m_currentBackBufferIndex + 1) % (uint32_t)m_bufferingType;
 }
 
-std::vector<uint32_t> LegacyRendererBackend::acquire()
+void LegacyRendererBackend::addSwapChain(const SwapChain* swapchain)
 {
-    auto& bb = m_backBuffers[m_currentBackBufferIndex];
-    auto* cx = m_device->getContext();
+    assert(m_swapchains.size() < kMaxSwapChains);
 
-    m_currentSwapchainImageIndices.clear();
+    // sized once here so that acquiring does not touch the heap
+    m_swapchains.emplace_back(swapchain);
     m_currentSwapchainImageIndices.resize(m_swapchains.size());
+}
+
+const std::vector<uint32_t>& LegacyRendererBackend::acquire()
+{
+    auto& bb = m_backBuffers[m_currentBackBufferIndex];
+    const auto* vk = m_device->getDispatch();
+
     for (int i = 0; i < m_swapchains.size(); ++i)
     {
         uint32_t index;
         VkResult res =
-            cx->AcquireNextImageKHR(m_device->getHandle(), m_swapchains[i]->getHandle(), UINT64_MAX,
+            vk->AcquireNextImageKHR(m_device->getHandle(), m_swapchains[i]->getHandle(), UINT64_MAX,
                                     bb->beforeSubmissionSemaphores.has_value()
                                         ? bb->beforeSubmissionSemaphores.value()[i]->handle
                                         : VK_NULL_HANDLE,
@@ -51,7 +94,9 @@ std::vector<uint32_t> LegacyRendererBackend::acquire()
         if (res != VK_SUCCESS)
         {
             std::cerr << "Failed to acquire next image : " << res << std::endl;
-            return {-1U};
+            std::fill(m_currentSwapchainImageIndices.begin(), m_currentSwapchainImageIndices.end(),
+                      -1U);
+            return m_currentSwapchainImageIndices;
         }
 
         m_currentSwapchainImageIndices[i] = index;
@@ -63,21 +108,33 @@ std::vector<uint32_t> LegacyRendererBackend::acquire()
 void LegacyRendererBackend::begin(const Framebuffer* framebuffer) const
 {
     auto& cb = m_backBuffers[m_currentBackBufferIndex]->commandBuffer;
-    auto cx = m_device->getContext();
+    const auto* vk = m_device->getDispatch();
 
-    cx->ResetCommandBuffer(cb, 0);
+    vk->ResetCommandBuffer(cb, 0);
 
     VkCommandBufferBeginInfo commandBufferBeginInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .flags = 0,
         .pInheritanceInfo = nullptr};
-    VkResult res = cx->BeginCommandBuffer(cb, &commandBufferBeginInfo);
+    VkResult res = vk->BeginCommandBuffer(cb, &commandBufferBeginInfo);
     if (res != VK_SUCCESS)
     {
         std::cerr << "Failed to begin recording command buffer : " << res << std::endl;
         return;
     }
 
+    // moved buffers and images get their new handle before anything is recorded with them
+    {
+        AllocationScope scope(AllocationSubsystemE::DEVICE);
+        m_device->getDefragmenter()->record(cb, m_currentBackBufferIndex);
+        // loaded images are readable by the draws of this frame
+        m_device->getImageUploader()->record(cb, m_currentBackBufferIndex);
+    }
+
+    // instance changes land in the scene buffer before any draw reads it
+    if (m_sceneBuffer)
+        m_sceneBuffer->record(cb, m_currentBackBufferIndex);
+
     VkClearValue clearColor = {
         .color = {0.2f, 0.2f, 0.2f, 1.f},
     };
@@ -93,7 +150,7 @@ void LegacyRendererBackend::begin(const Framebuffer* framebuffer) const
         .clearValueCount = static_cast<uint32_t>(clearValues.size()),
         .pClearValues = clearValues.data(),
     };
-    cx->CmdBeginRenderPass(cb, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vk->CmdBeginRenderPass(cb, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
     VkViewport viewport = {
         .x = 0.f,
@@ -103,57 +160,168 @@ void LegacyRendererBackend::begin(const Framebuffer* framebuffer) const
         .minDepth = 0.f,
         .maxDepth = 1.f,
     };
-    cx->CmdSetViewport(cb, 0, 1, &viewport);
     VkRect2D scissor = {
         .offset = {0,                  0                  },
         .extent = {framebuffer->width, framebuffer->height},
     };
-    cx->CmdSetScissor(cb, 0, 1, &scissor);
+    m_recorder.reset(m_device, cb);
+    m_recorder.setViewport(viewport, scissor);
 }
 void LegacyRendererBackend::draw(const std::shared_ptr<Scene> scene) const
 {
     auto& cb = m_backBuffers[m_currentBackBufferIndex]->commandBuffer;
-    auto cx = m_device->getContext();
+    const auto* vk = m_device->getDispatch();
+
+    auto start = std::chrono::steady_clock::now();
+
+    // registrations made since the last frame become visible
+    auto* bindless = m_device->getBindlessTable();
+    if (bindless)
+        bindless->flush();
+    VkPipelineLayout bindlessLayout = VK_NULL_HANDLE;
 
-    auto s = std::static_pointer_cast<GPUScene>(scene->localResource);
+    // raw pointers, copying shared pointers per draw costs atomic reference count updates
+    auto* s = static_cast<const GPUScene*>(scene->localResource.get());
     for (int i = 0; i < s->m_renderStates.size(); ++i)
     {
         auto& rs = s->m_renderStates[i];
 
         const auto& pipeline = rs->getPipeline();
-        cx->CmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getHandle());
+        m_recorder.bind(*pipeline);
+
+        // the bindless set only needs binding again when the pipeline layout changes
+        if (pipeline->usesBindless() && bindlessLayout != pipeline->getLayoutHandle())
+        {
+            bindlessLayout = pipeline->getLayoutHandle();
+            bindless->bind(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, bindlessLayout);
+        }
 
-        for (const auto& obj : rs->getObjects())
+        const auto& objects = rs->getObjects();
+        const auto& channel = rs->getPerDrawChannel();
+        const uint32_t dynamicOffsetCount = channel.dynamicOffsetCount;
+
+        // the uniforms of every object of the render state are written in a single pass, each
+        // draw then only selects its element with a dynamic offset
+        UniformArrayT uniforms;
+        if (dynamicOffsetCount > 0)
         {
-            const auto& sets = pipeline->getDescriptorSetHandles(m_currentBackBufferIndex,
-                                                                 DescriptorFrequencyE::PER_OBJECT);
+            uniforms = m_uniformRing->allocateArray(static_cast<uint32_t>(objects.size()),
+                                                    sizeof(UniformPerObject));
+            // the ring reports the overflow, the draws would read the uniforms of another frame
+            if (!uniforms.isValid())
+                continue;
+            for (uint32_t o = 0; o < uniforms.count; ++o)
+            {
+                const PerDrawDataT* perDraw = objects[o]->getPerDrawData();
+                auto* u = static_cast<UniformPerObject*>(uniforms.at(o));
+                u->viewProj = m_viewProj;
+                u->mvp = perDraw ? m_viewProj * perDraw->constants.model : m_viewProj;
+            }
+        }
+
+        const auto& sets = pipeline->getDescriptorSetHandles(m_currentBackBufferIndex,
+                                                             DescriptorFrequencyE::PER_OBJECT);
+        for (uint32_t o = 0; o < objects.size(); ++o)
+        {
+            const auto& obj = objects[o];
+
             // TODO : this descriptor may not be the first one (index 0), find a way to compute the
             // descriptor set index (with per frame, per pass, per material and per object)
-            cx->CmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                      pipeline->getLayoutHandle(), 0,
-                                      static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+            // bindless pipelines may not have any set of their own
+            if (!sets.empty())
+            {
+                // keeps its capacity, only the first frames allocate
+                m_dynamicOffsets.assign(dynamicOffsetCount,
+                                        uniforms.isValid() ? uniforms.dynamicOffset(o) : 0U);
+                vk->CmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                          pipeline->getLayoutHandle(), pipeline->getFirstSetIndex(),
+                                          static_cast<uint32_t>(sets.size()), sets.data(),
+                                          dynamicOffsetCount, m_dynamicOffsets.data());
+            }
 
-            const auto& mrd = std::dynamic_pointer_cast<MeshRenderDescription>(obj);
+            // per draw data goes through the command buffer, no set is allocated or bound
+            const PerDrawDataT* perDraw = obj->getPerDrawData();
+            if (perDraw)
+                pushPerDrawData(cb, *rs, *perDraw);
+
+            const auto* mrd = dynamic_cast<const MeshRenderDescription*>(obj.get());
             if (mrd)
             {
                 auto view = mrd->getGPUMesh();
                 VkBuffer vbos[] = {view->vertexBuffer->handle};
                 VkDeviceSize offsets[] = {0};
-                cx->CmdBindVertexBuffers(cb, 0, 1, vbos, offsets);
-                cx->CmdBindIndexBuffer(cb, view->indexBuffer->handle, 0, VK_INDEX_TYPE_UINT16);
-                cx->CmdDrawIndexed(cb, view->indexCount, 1, 0, 0, 0);
+                vk->CmdBindVertexBuffers(cb, 0, 1, vbos, offsets);
+                vk->CmdBindIndexBuffer(cb, view->indexBuffer->handle, 0, VK_INDEX_TYPE_UINT16);
+                vk->CmdDrawIndexed(cb, view->indexCount, 1, 0, 0, 0);
             }
         }
     }
+
+    m_recordTime += std::chrono::steady_clock::now() - start;
+    ++m_recordedFrameCount;
+}
+void LegacyRendererBackend::pushPerDrawData(const VkCommandBuffer cb, const RenderState& rs,
+                                            const PerDrawDataT& perDraw) const
+{
+    const auto* vk = m_device->getDispatch();
+    const auto& channel = rs.getPerDrawChannel();
+    const VkPipelineLayout layout = rs.getPipeline()->getLayoutHandle();
+
+    const auto* constants = reinterpret_cast<const uint8_t*>(&perDraw.constants);
+    for (const auto& range : channel.pushConstantRanges)
+    {
+        vk->CmdPushConstants(cb, layout, range.stageFlags, range.offset, range.size,
+                             constants + range.offset);
+    }
+
+    if (!channel.pushDescriptorSet.has_value())
+        return;
+
+    const uint32_t count = static_cast<uint32_t>(
+        std::min({channel.pushDescriptorBindings.size(), perDraw.buffers.size(),
+                  static_cast<size_t>(kMaxPushDescriptorWrites)}));
+    // without VK_KHR_push_descriptor, the set of the draw lives until the back buffer is reused
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    if (!m_device->supportsPushDescriptors())
+    {
+        auto& allocator = m_backBuffers[m_currentBackBufferIndex]->transientDescriptorAllocator;
+        set = allocator->allocate(channel.pushDescriptorSetLayout);
+        if (set == VK_NULL_HANDLE)
+            return;
+    }
+
+    std::array<VkWriteDescriptorSet, kMaxPushDescriptorWrites> writes;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const auto& binding = channel.pushDescriptorBindings[i];
+        writes[i] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = set,
+            .dstBinding = binding.binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = binding.descriptorType,
+            .pBufferInfo = &perDraw.buffers[i],
+        };
+    }
+    if (set == VK_NULL_HANDLE)
+    {
+        vk->CmdPushDescriptorSetKHR(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+                                    channel.pushDescriptorSet.value(), count, writes.data());
+        return;
+    }
+    vk->UpdateDescriptorSets(m_device->getHandle(), count, writes.data(), 0, nullptr);
+    vk->CmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+                              channel.pushDescriptorSet.value(), 1, &set, 0, nullptr);
 }
 void LegacyRendererBackend::end() const
 {
     auto& cb = m_backBuffers[m_currentBackBufferIndex]->commandBuffer;
-    auto cx = m_device->getContext();
+    const auto* vk = m_device->getDispatch();
 
-    cx->CmdEndRenderPass(cb);
+    vk->CmdEndRenderPass(cb);
 
-    VkResult res = cx->EndCommandBuffer(cb);
+    VkResult res = vk->EndCommandBuffer(cb);
     if (res != VK_SUCCESS)
         std::cerr << "Failed to record command buffer : " << res << std::endl;
 }
@@ -161,73 +329,75 @@ void LegacyRendererBackend::submit() const
 {
     auto& bb = m_backBuffers[m_currentBackBufferIndex];
     auto& cb = bb->commandBuffer;
-    auto cx = m_device->getContext();
+    const auto* vk = m_device->getDispatch();
+
+    // uniforms and transient data written while recording must reach the device
+    m_uniformRing->flush();
+    m_frameArena->flush();
 
     // TODO : do not use hardcoded index
     int submitIndex = 0;
 
-    std::vector<VkSemaphore> waitSemaphores;
-    if (bb->beforeSubmissionSemaphores.has_value())
-        waitSemaphores.emplace_back(bb->beforeSubmissionSemaphores.value()[submitIndex]->handle);
+    const bool bWait = bb->beforeSubmissionSemaphores.has_value();
+    VkSemaphore waitSemaphore =
+        bWait ? bb->beforeSubmissionSemaphores.value()[submitIndex]->handle : VK_NULL_HANDLE;
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
 
     assert(m_swapchains.size());
-    std::vector<VkSemaphore> signalSemaphores;
-    signalSemaphores.emplace_back(
+    VkSemaphore signalSemaphore =
         m_swapchains[submitIndex]
             ->m_presentSemaphores[m_currentSwapchainImageIndices[submitIndex]]
-            ->handle);
+            ->handle;
 
     VkSubmitInfo submitInfo = {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()),
-        .pWaitSemaphores = waitSemaphores.data(),
+        .waitSemaphoreCount = bWait ? 1U : 0U,
+        .pWaitSemaphores = &waitSemaphore,
         .pWaitDstStageMask = waitStages,
         .commandBufferCount = 1,
         .pCommandBuffers = &cb,
-        .signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()),
-        .pSignalSemaphores = signalSemaphores.data(),
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &signalSemaphore,
     };
 
-    VkResult res = cx->QueueSubmit(m_device->graphicsQueue, 1, &submitInfo, bb->inFlightFence);
+    VkResult res = vk->QueueSubmit(m_device->graphicsQueue, 1, &submitInfo, bb->inFlightFence);
     if (res != VK_SUCCESS)
         std::cerr << "Failed to submit draw command buffer : " << res << std::endl;
 }
 void LegacyRendererBackend::present() const
 {
     auto& bb = m_backBuffers[m_currentBackBufferIndex];
-    auto cx = m_device->getContext();
+    const auto* vk = m_device->getDispatch();
 
-    std::vector<VkSwapchainKHR> swapchains(m_swapchains.size());
-    std::vector<uint32_t> imageIndices(m_swapchains.size());
-    std::vector<VkSemaphore> waitSemaphores;
-    for (int i = 0; i < m_swapchains.size(); ++i)
+    const uint32_t count = static_cast<uint32_t>(m_swapchains.size());
+    std::array<VkSwapchainKHR, kMaxSwapChains> swapchains;
+    std::array<VkSemaphore, kMaxSwapChains> waitSemaphores;
+    for (uint32_t i = 0; i < count; ++i)
     {
         auto& sc = m_swapchains[i];
         auto& imageIndex = m_currentSwapchainImageIndices[i];
 
         swapchains[i] = sc->getHandle();
-        imageIndices[i] = imageIndex;
-        waitSemaphores.emplace_back(sc->m_presentSemaphores[imageIndex]->handle);
+        waitSemaphores[i] = sc->m_presentSemaphores[imageIndex]->handle;
     }
     VkPresentInfoKHR presentInfo = {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-        .waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()),
+        .waitSemaphoreCount = count,
         .pWaitSemaphores = waitSemaphores.data(),
-        .swapchainCount = static_cast<uint32_t>(swapchains.size()),
+        .swapchainCount = count,
         .pSwapchains = swapchains.data(),
-        .pImageIndices = imageIndices.data(),
+        .pImageIndices = m_currentSwapchainImageIndices.data(),
         .pResults = nullptr,
     };
 
-    VkResult res = cx->QueuePresentKHR(m_device->presentQueue, &presentInfo);
+    VkResult res = vk->QueuePresentKHR(m_device->presentQueue, &presentInfo);
     if (res != VK_SUCCESS)
         std::cerr << "Failed to present : " << res << std::endl;
 }
 
-std::vector<uint32_t> DynamicRendererBackend::acquire()
+const std::vector<uint32_t>& DynamicRendererBackend::acquire()
 {
-    return {-1U};
+    return m_currentSwapchainImageIndices;
 }
 
 void DynamicRendererBackend::begin(const Framebuffer* framebuffer) const
@@ -271,4 +441,29 @@ RendererBackendABC::RendererBackendABC(const std::shared_ptr<RendererBackendCrea
             .bFenceStartsSignaled = true,
         }));
     }
+
+    m_uniformRing = std::make_unique<UniformRing>(UniformRingCreateInfoT{
+        .device = m_device,
+        .frameCount = static_cast<uint32_t>(createInfo->bufferingType),
+        .sizePerFrame = createInfo->uniformRingSizePerFrame,
+        .bindingRange = sizeof(UniformPerObject),
+    });
+    m_frameArena = std::make_unique<FrameArena>(FrameArenaCreateInfoT{
+        .device = m_device,
+        .frameCount = static_cast<uint32_t>(createInfo->bufferingType),
+        .blockSize = createInfo->frameArenaBlockSize,
+    });
+
+    if (createInfo->sceneScatterShader)
+    {
+        m_sceneBuffer = std::make_unique<GPUSceneBuffer>(GPUSceneBufferCreateInfoT{
+            .device = m_device,
+            .scatterShader = createInfo->sceneScatterShader,
+            .frameArena = m_frameArena.get(),
+            .frameCount = static_cast<uint32_t>(createInfo->bufferingType),
+            .capacity = createInfo->sceneCapacity,
+        });
+        if (!m_sceneBuffer->isValid())
+            m_sceneBuffer.reset();
+    }
 }
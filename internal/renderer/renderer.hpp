@@ -1,16 +1,24 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
+#include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
 #include "graphics/backbuffer.hpp"
 #include "graphics/device/asset/render_pass.hpp"
 #include "graphics/device/device.hpp"
+#include "graphics/device/memory/frame_arena.hpp"
+#include "graphics/device/memory/uniform_ring.hpp"
 #include "graphics/framebuffer.hpp"
 #include "graphics/swapchain.hpp"
 
+#include "dynamic_state_recorder.hpp"
+#include "gpu_scene_buffer.hpp"
+#include "render_state.hpp"
+
 class Scene;
 
 class RendererI
@@ -56,10 +64,11 @@ class SwapChainRendererI
     virtual void addSwapChain(const SwapChain* swapchain) = 0;
 
     /**
-     * @brief acquire next swap chain image
+     * @brief acquire next swap chain image, one index per swap chain (-1 on failure), valid until
+     * the next acquire
      *
      */
-    virtual std::vector<uint32_t> acquire() = 0;
+    virtual const std::vector<uint32_t>& acquire() = 0;
     /**
      * @brief present last rendered frame
      *
@@ -72,6 +81,22 @@ struct RendererBackendCreateInfoT
     BufferingTypeE bufferingType = BufferingTypeE::DOUBLE_BUFFERING;
     const LogicalDevice* device;
     uint32_t submitCountPerCommandBuffer;
+    /**
+     * @brief per object uniforms written each frame, per frame in flight
+     *
+     */
+    VkDeviceSize uniformRingSizePerFrame = 4ULL << 20;
+    /**
+     * @brief size of the transient buffer blocks, per frame in flight
+     *
+     */
+    VkDeviceSize frameArenaBlockSize = 8ULL << 20;
+    /**
+     * @brief shaders/scene_scatter.comp, the persistent scene buffer is only created if given
+     *
+     */
+    std::shared_ptr<Shader> sceneScatterShader;
+    uint32_t sceneCapacity = 65536U;
 
   public:
     virtual ~RendererBackendCreateInfoT() {}
@@ -91,6 +116,27 @@ class RendererBackendABC : public RendererI
 
     const LogicalDevice* m_device;
 
+    /**
+     * @brief per frame uniforms, rewound when the back buffer fence is waited on
+     *
+     */
+    std::unique_ptr<UniformRing> m_uniformRing;
+    /**
+     * @brief per frame transient buffers, rewound when the back buffer fence is waited on
+     *
+     */
+    std::unique_ptr<FrameArena> m_frameArena;
+    /**
+     * @brief instance records of the scene, changes are scattered at the start of the frame
+     *
+     */
+    std::unique_ptr<GPUSceneBuffer> m_sceneBuffer;
+    /**
+     * @brief written in the per object uniforms, identity until a camera sets it
+     *
+     */
+    glm::mat4 m_viewProj = glm::mat4(1.f);
+
   public:
     RendererBackendABC() = delete;
     explicit RendererBackendABC(const std::shared_ptr<RendererBackendCreateInfoT> createInfo);
@@ -102,6 +148,12 @@ class RendererBackendABC : public RendererI
 
   public:
     [[nodiscard]] const BufferingTypeE& getBufferingType() const { return m_bufferingType; }
+    [[nodiscard]] uint32_t getCurrentBackBufferIndex() const { return m_currentBackBufferIndex; }
+    [[nodiscard]] const UniformRing* getUniformRing() const { return m_uniformRing.get(); }
+    [[nodiscard]] FrameArena* getFrameArena() { return m_frameArena.get(); }
+    [[nodiscard]] GPUSceneBuffer* getSceneBuffer() { return m_sceneBuffer.get(); }
+
+    void setViewProjection(const glm::mat4& viewProj) { m_viewProj = viewProj; }
 
 } typedef RendererPImplABC;
 
@@ -122,15 +174,54 @@ class LegacyRendererBackend : public RendererBackendABC, public SwapChainRendere
      */
     std::vector<std::vector<std::shared_ptr<Framebuffer>>> m_framebuffers;
 
+    /**
+     * @brief filters redundant state commands, records the state of shader object pipelines
+     *
+     */
+    mutable DynamicStateRecorder m_recorder;
+    /**
+     * @brief time spent recording draws, to compare the pipeline and shader object paths
+     *
+     */
+    mutable std::chrono::nanoseconds m_recordTime = std::chrono::nanoseconds(0);
+    mutable uint64_t m_recordedFrameCount = 0U;
+    /**
+     * @brief dynamic offsets given per draw, one per UNIFORM_BUFFER_DYNAMIC binding of the layout
+     *
+     */
+    mutable std::vector<uint32_t> m_dynamicOffsets;
+
+    /**
+     * @brief push descriptors written per draw, bounded so that the writes stay on the stack
+     *
+     */
+    static constexpr uint32_t kMaxPushDescriptorWrites = 8U;
+    /**
+     * @brief swap chains presented together, bounded so that the present info stays on the stack
+     *
+     */
+    static constexpr uint32_t kMaxSwapChains = 4U;
+
+    /**
+     * @brief push constants and push descriptors of a draw
+     *
+     */
+    void pushPerDrawData(const VkCommandBuffer cb, const RenderState& rs,
+                         const PerDrawDataT& perDraw) const;
+
   public:
     LegacyRendererBackend() = delete;
     LegacyRendererBackend(const std::shared_ptr<RendererBackendCreateInfoT> createInfo);
 
-    ~LegacyRendererBackend() override {}
+    /**
+     * @brief prints the record statistics
+     *
+     */
+    ~LegacyRendererBackend() override;
 
-    void addSwapChain(const SwapChain* swapchain) override { m_swapchains.emplace_back(swapchain); }
+    void addSwapChain(const SwapChain* swapchain) override;
 
-    std::vector<uint32_t> acquire() override;
+    const std::vector<uint32_t>& acquire() override;
 
     void begin(const Framebuffer* framebuffer) const override;
     void draw(const std::shared_ptr<Scene> scene) const override;
@@ -148,6 +239,7 @@ class DynamicRendererBackend : public RendererBackendABC, public SwapChainRender
 {
   private:
     std::vector<const SwapChain*> m_swapchains;
+    std::vector<uint32_t> m_currentSwapchainImageIndices = {-1U};
 
   public:
     DynamicRendererBackend() = delete;
@@ -157,7 +249,7 @@ class DynamicRendererBackend : public RendererBackendABC, public SwapChainRender
 
     void addSwapChain(const SwapChain* swapchain) override { m_swapchains.emplace_back(swapchain); }
 
-    std::vector<uint32_t> acquire() override;
+    const std::vector<uint32_t>& acquire() override;
 
     void begin(const Framebuffer* framebuffer) const override;
     void draw(const std::shared_ptr<Scene> scene) const override;
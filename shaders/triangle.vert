@@ -7,8 +7,15 @@ layout(location = 3) in vec2 aUV;
 
 layout(location = 0) out vec3 vertexColor;
 
+// PushConstantsPerObject
+layout(push_constant) uniform PerDraw
+{
+	mat4 model;
+	uint objectId;
+} perDraw;
+
 void main()
 {
-	gl_Position = vec4(aPos, 1.0);
+	gl_Position = perDraw.model * vec4(aPos, 1.0);
 	vertexColor = aColor.xyz;
 }
\ No newline at end of file
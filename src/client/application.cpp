@@ -1,8 +1,26 @@
 #include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
 
+#include <core/allocation_tracker.hpp>
+#include <core/host_arena.hpp>
+#include <core/thread_pool.hpp>
+#include <graphics/call_tracker.hpp>
 #include <graphics/context.hpp>
 #include <graphics/device/device.hpp>
+#include <graphics/device/asset/pipeline_cache.hpp>
+#include <graphics/device/asset/pipeline_creation_report.hpp>
+#include <graphics/device/asset/shader.hpp>
+#include <graphics/device/memory/defragmenter.hpp>
 #include <graphics/device/memory/image.hpp>
+#include <graphics/device/memory/image_uploader.hpp>
+#ifdef ENABLE_ALLOCATOR_BENCHMARK
+#include <graphics/device/memory/allocator_benchmark.hpp>
+#endif
+#ifdef ENABLE_UPLOAD_BENCHMARK
+#include <graphics/device/memory/image_upload_benchmark.hpp>
+#endif
 #include <graphics/device/physical_device.hpp>
 #include <graphics/instance.hpp>
 #include <graphics/surface.hpp>
@@ -10,16 +28,41 @@
 
 #include <wsi/window_glfw.hpp>
 
+#ifdef ENABLE_DISPATCH_BENCHMARK
+#include <renderer/dispatch_benchmark.hpp>
+#endif
 #include <renderer/renderer.hpp>
 
 #include <data/saved/scene.hpp>
 
 #include <data/resource_manager.hpp>
+#include <data/texture_streamer.hpp>
 
 #include "application.hpp"
 
-Application::Application()
+#ifdef ENABLE_ALLOCATION_TRACKING
+/**
+ * @brief frames filling the pools, arenas and caches before the frame loop must stop allocating
+ *
+ */
+static constexpr uint64_t kAllocationWarmupFrameCount = 16U;
+#endif
+#ifdef ENABLE_CALL_TRACKING
+/**
+ * @brief frames between two dumps of the per frame call counts
+ *
+ */
+static constexpr uint64_t kCallReportFramePeriod = 600U;
+#endif
+
+Application::Application(const ApplicationCreateInfoT createInfo) : ci(createInfo)
 {
+    auto startupBegin = std::chrono::steady_clock::now();
+
+    // transient host data of every thread, on large pages when the system grants them
+    HostArena::setThreadFrameArenaCreateInfo(HostArenaCreateInfoT{.bHugePages = true});
+    m_threadPool = std::make_unique<ThreadPool>(ThreadPoolCreateInfoT{});
+
     m_wsi = std::make_unique<WSILoaderGLFW>();
     m_wsi->init();
 
@@ -27,7 +70,12 @@ Application::Application()
 
     auto ext = m_window->getRequiredExtensions();
     ext.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-    m_context = std::make_unique<ContextSDK>(ContextCreateInfoT{
+#ifdef ENABLE_DYNAMIC_LOADER
+    using ContextT = ContextDLL;
+#else
+    using ContextT = ContextSDK;
+#endif
+    m_context = std::make_unique<ContextT>(ContextCreateInfoT{
         .applicationName = "Renderer",
         // TODO : get the version numbers from cmake
         .applicationVersion = VERSION(0, 0, 0),
@@ -43,6 +91,18 @@ Application::Application()
 #ifdef ENABLE_VIDEO_TRANSCODE
                      VK_KHR_VIDEO_DECODE_H264_EXTENSION_NAME, VK_KHR_VIDEO_DECODE_H265_EXTENSION_NAME,
                      VK_KHR_VIDEO_DECODE_QUEUE_EXTENSION_NAME, VK_KHR_VIDEO_QUEUE_EXTENSION_NAME,
+#endif
+                     },
+        .optionalDeviceExtensions =
+            {
+                     VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+                     VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+                     VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME,
+                     VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+                     VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME,
+                     VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+#ifdef ENABLE_SHADER_OBJECTS
+                     VK_EXT_SHADER_OBJECT_EXTENSION_NAME,
 #endif
                      },
     });
@@ -66,17 +126,61 @@ Application::Application()
         assert(physicalDevice);
 
         m_physicalDevices.push_back(physicalDevice);
+#ifdef ENABLE_TLSF_ALLOCATOR
+        m_devices.emplace_back(physicalDevice->createDevice(AllocatorBackendE::TLSF));
+#else
         m_devices.emplace_back(physicalDevice->createDevice());
+#endif
 
         if (m_currentDeviceIndex < 0 &&
             physicalDevice->getDeviceType() == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
             m_currentDeviceIndex = i;
     }
+    // integrated and software devices (lavapipe, SwiftShader) when there is no discrete one
+    if (m_currentDeviceIndex < 0 && !m_devices.empty())
+        m_currentDeviceIndex = 0;
+
+#ifdef ENABLE_CALL_TRACKING
+    CallTracker::install(m_context.get(), m_devices[m_currentDeviceIndex]->getDispatch());
+#endif
+
+#ifdef ENABLE_ALLOCATOR_BENCHMARK
+    {
+        // both allocators run the same sequence on the device next to its own allocator
+        const LogicalDevice* device = m_devices[m_currentDeviceIndex].get();
+        for (AllocatorBackendE backend : {AllocatorBackendE::VMA, AllocatorBackendE::TLSF})
+        {
+            MemoryAllocator allocator(MemoryAllocatorCreateInfoT{
+                .device = device,
+                .backend = backend,
+            });
+            AllocatorBenchmarkResultT result =
+                runAllocatorBenchmark(allocator, AllocatorBenchmarkInfoT{});
+            printAllocatorBenchmark(backend == AllocatorBackendE::VMA ? "VMA" : "TLSF", result);
+        }
+    }
+#endif
+#ifdef ENABLE_UPLOAD_BENCHMARK
+    printImageUploadBenchmark(
+        runImageUploadBenchmark(*m_devices[m_currentDeviceIndex], ImageUploadBenchmarkInfoT{}));
+#endif
+#ifdef ENABLE_DISPATCH_BENCHMARK
+    printDispatchBenchmark(
+        runDispatchBenchmark(*m_devices[m_currentDeviceIndex], DispatchBenchmarkInfoT{}));
+#endif
 
     auto backendCreateInfo = std::make_shared<LegacyRendererBackendCreateInfoT>();
     backendCreateInfo->bufferingType = BufferingTypeE::DOUBLE_BUFFERING;
     backendCreateInfo->device = m_devices[m_currentDeviceIndex].get();
     backendCreateInfo->submitCountPerCommandBuffer = 1U;
+    {
+        auto scatterShaderLoadInfo = std::make_shared<ShaderLoadInfoT>();
+        scatterShaderLoadInfo->deviceptr = m_devices[m_currentDeviceIndex].get();
+        scatterShaderLoadInfo->filepath = "shaders/scene_scatter.comp.spv";
+        scatterShaderLoadInfo->stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        scatterShaderLoadInfo->entryPoint = "main";
+        backendCreateInfo->sceneScatterShader = ResourceManager::load<Shader>(scatterShaderLoadInfo);
+    }
     backendCreateInfo->renderPassCreateInfo = RenderPassCreateInfoT{
         .colorAttachments =
             {
@@ -155,19 +259,62 @@ Application::Application()
     static_cast<LegacyRendererBackend*>(m_renderer->getBackend())
         ->addSwapChain(m_window->getSwapChain());
 
+    // streamed textures are given it through their load info
+    m_textureStreamer = std::make_unique<TextureStreamer>(TextureStreamerCreateInfoT{
+        .device = m_devices[m_currentDeviceIndex].get(),
+        .threadPool = m_threadPool.get(),
+        .framesInFlight = static_cast<uint32_t>(m_renderer->getBackend()->getBufferingType()),
+    });
+
     auto li = std::make_shared<SceneLoadInfoT>();
     li->deviceptr = m_devices[m_currentDeviceIndex].get();
     li->filepath = ".";
     li->renderPass =
         static_cast<const LegacyRendererBackend*>(m_renderer->getBackend())->getRenderPass();
-    li->type = m_renderer->getBackend()->getBufferingType(),
-    m_scene = ResourceManager::load<Scene>(li);
+    li->type = m_renderer->getBackend()->getBufferingType();
+    li->uniformRing = m_renderer->getBackend()->getUniformRing();
+    li->sceneBuffer = m_renderer->getBackend()->getSceneBuffer();
+    li->threadPool = m_threadPool.get();
+#ifdef ENABLE_SHADER_OBJECTS
+    li->pipelineBackend = PipelineBackendE::SHADER_OBJECT;
+#endif
+    {
+        AllocationScope scope(AllocationSubsystemE::RESOURCES);
+        m_scene = ResourceManager::load<Scene>(li);
+    }
+
+    // startup time is reported along with the pipeline cache state in order to compare cold and
+    // warm launches
+    const PipelineCache* pipelineCache = m_devices[m_currentDeviceIndex]->getPipelineCache();
+    std::cout << "startup : "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - startupBegin)
+                     .count()
+              << " ms (pipeline cache " << (pipelineCache->isWarm() ? "warm" : "cold") << ", "
+              << pipelineCache->getCreationCount() << " pipelines created in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     pipelineCache->getCreationTime())
+                     .count()
+              << " ms)" << std::endl;
+    m_devices[m_currentDeviceIndex]->getPipelineCreationReport()->dump(std::cout);
 }
 
 Application::~Application()
 {
+    // loads still running reference their resource and the device
+    m_threadPool.reset();
     m_devices[m_currentDeviceIndex]->wait();
 
+    // memory state with the scene still loaded, per heap and per resource type
+    if (!ci.memoryReportPath.empty())
+    {
+        std::ofstream memoryReport(ci.memoryReportPath);
+        if (memoryReport)
+            m_devices[m_currentDeviceIndex]->getMemoryAllocator()->dumpJson(memoryReport);
+        else
+            std::cerr << "Failed to open " << ci.memoryReportPath << std::endl;
+    }
+
     m_window.reset();
     m_wsi.reset();
 
@@ -175,6 +322,8 @@ Application::~Application()
     m_scene.reset();
 
     ResourceManager::clearAllResources();
+    // after the streamed textures are removed from it
+    m_textureStreamer.reset();
 
     m_devices.clear();
     m_physicalDevices.clear();
@@ -185,20 +334,44 @@ Application::~Application()
 
 int Application::perFrame()
 {
+    AllocationTracker::beginFrame();
+    CallTracker::beginFrame();
+    HostArena::beginFrame();
+
     if (m_window->shouldClose())
     {
         m_wsi->terminate();
         return 0;
     }
+    if (ci.frameLimit > 0U && m_frameCount >= ci.frameLimit)
+        return 0;
+    ++m_frameCount;
 
-    m_window->pollEvents();
+    {
+        AllocationScope scope(AllocationSubsystemE::WSI);
+        m_window->pollEvents();
+    }
     // TODO : threadpool poll main queue
 
+#ifdef ENABLE_ALLOCATION_TRACKING
+    // passes create the moved resources, such frames are not part of the steady state
+    const Defragmenter* defragmenter = m_devices[m_currentDeviceIndex]->getDefragmenter();
+    bool bDefragmenting = defragmenter->isRunning();
+    // as do the loads running in the background and their uploads
+    ImageUploader* imageUploader = m_devices[m_currentDeviceIndex]->getImageUploader();
+    const bool bLoading = !m_threadPool->isIdle() || !imageUploader->isIdle() ||
+                          !m_textureStreamer->isIdle();
+#endif
+
     auto legacyRenderer = dynamic_cast<LegacyRendererBackend*>(m_renderer->getBackend());
     if (legacyRenderer)
     {
+        AllocationScope scope(AllocationSubsystemE::RENDERER);
+
         legacyRenderer->wait();
-        std::vector<uint32_t> imageIndices = legacyRenderer->acquire();
+        // residency changes are recorded by the image uploader at the start of the frame
+        m_textureStreamer->update(legacyRenderer->getCurrentBackBufferIndex());
+        const std::vector<uint32_t>& imageIndices = legacyRenderer->acquire();
         auto sc = m_window->getSwapChain();
         const Framebuffer* framebuffer = sc->m_framebuffers.value()[imageIndices[0]].get();
 
@@ -208,7 +381,25 @@ int Application::perFrame()
         legacyRenderer->swap();
     }
 
-    m_window->swapBuffers();
+    {
+        AllocationScope scope(AllocationSubsystemE::WSI);
+        m_window->swapBuffers();
+    }
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+    bDefragmenting = bDefragmenting || defragmenter->isRunning();
+    m_bSteadyFrame = m_frameCount > kAllocationWarmupFrameCount && !bDefragmenting && !bLoading;
+    if (m_bSteadyFrame && AllocationTracker::getFrameAllocationCount() > 0U)
+    {
+        ++m_allocatingFrameCount;
+        std::cerr << "Frame " << m_frameCount << " allocated on the heap in the steady state, ";
+        AllocationTracker::dumpFrame(std::cerr);
+    }
+#endif
+#ifdef ENABLE_CALL_TRACKING
+    if (CallTracker::getFrameCount() % kCallReportFramePeriod == 0U)
+        CallTracker::dumpFrame(std::cout);
+#endif
 
     return 1;
 }
\ No newline at end of file
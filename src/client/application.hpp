@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <memory>
 #include <vector>
 
@@ -11,14 +12,40 @@ class PhysicalDevice;
 class LogicalDevice;
 class Renderer;
 class Scene;
+class ThreadPool;
+class TextureStreamer;
+
+struct ApplicationCreateInfoT
+{
+    /**
+     * @brief json memory report (per heap and per resource type) written at exit, none if empty
+     *
+     */
+    std::filesystem::path memoryReportPath;
+    /**
+     * @brief frames rendered before perFrame returns 0, the window closing stops it before, 0 to
+     * run until the window is closed
+     *
+     */
+    uint64_t frameLimit = 0U;
+};
 
 class Application
 {
   private:
+    const ApplicationCreateInfoT ci;
+
     uint32_t width = 1366U, height = 768U;
     std::unique_ptr<WSILoaderI> m_wsi;
     std::unique_ptr<WindowGLFW> m_window;
 
+    /**
+     * @brief workers of the asynchronous resource loads (texture decoding), given through the load
+     * infos
+     *
+     */
+    std::unique_ptr<ThreadPool> m_threadPool;
+
     std::unique_ptr<ContextABC> m_context;
     std::unique_ptr<Instance> m_instance;
 
@@ -26,6 +53,11 @@ class Application
     std::vector<std::unique_ptr<LogicalDevice>> m_devices;
 
     std::unique_ptr<Renderer> m_renderer;
+    /**
+     * @brief residency of the larger levels of the streamed textures, updated once per frame
+     *
+     */
+    std::unique_ptr<TextureStreamer> m_textureStreamer;
 
     std::shared_ptr<Scene> m_scene;
 
@@ -36,9 +68,36 @@ class Application
      */
     int m_currentDeviceIndex = -1;
 
+    uint64_t m_frameCount = 0U;
+    /**
+     * @brief steady state frames (see ENABLE_ALLOCATION_TRACKING) that allocated on the heap
+     *
+     */
+    uint64_t m_allocatingFrameCount = 0U;
+    /**
+     * @brief the last frame was past the warm up, with no load or defragmentation running
+     *
+     */
+    bool m_bSteadyFrame = false;
+
   public:
-    Application();
+    Application() = delete;
+    Application(const Application&) = delete;
+    Application& operator=(const Application&) = delete;
+    Application(Application&&) = delete;
+    Application& operator=(Application&&) = delete;
+
+    explicit Application(const ApplicationCreateInfoT createInfo);
     ~Application();
 
     int perFrame();
+
+  public:
+    [[nodiscard]] inline uint64_t getAllocatingFrameCount() const { return m_allocatingFrameCount; }
+    /**
+     * @brief the frame perFrame just rendered must not have allocated on the heap, its counts are
+     * kept by the AllocationTracker until the next perFrame
+     *
+     */
+    [[nodiscard]] inline bool isSteadyFrame() const { return m_bSteadyFrame; }
 };
\ No newline at end of file
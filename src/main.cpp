@@ -18,6 +18,7 @@
 int main(int argc, char** argv)
 {
     int api = 0;
+    ApplicationCreateInfoT createInfo;
     // TODO : make a standalone argument parser for libraries
     try
     {
@@ -38,6 +39,16 @@ int main(int argc, char** argv)
 
                 if (str == "-vk" || str == "-vulkan")
                     api = 2;
+
+                // -memory-report=<path> : json memory report written at exit
+                const std::string memoryReport = "-memory-report=";
+                if (str.rfind(memoryReport, 0) == 0)
+                    createInfo.memoryReportPath = str.substr(memoryReport.size());
+
+                // -frames=<count> : stop after this many frames
+                const std::string frames = "-frames=";
+                if (str.rfind(frames, 0) == 0)
+                    createInfo.frameLimit = std::stoull(str.substr(frames.size()));
             }
         }
     }
@@ -49,10 +60,18 @@ int main(int argc, char** argv)
 
     try
     {
-        Application app /*(api >= 0 ? (GraphicsApiE)api : GraphicsApiE::VULKAN)*/;
+        Application app(createInfo) /*(api >= 0 ? (GraphicsApiE)api : GraphicsApiE::VULKAN)*/;
         while (app.perFrame())
         {
         }
+        // the steady state check of ENABLE_ALLOCATION_TRACKING, a bounded run (-frames) makes
+        // it usable from a script
+        if (app.getAllocatingFrameCount() > 0U)
+        {
+            std::cerr << app.getAllocatingFrameCount()
+                      << " steady state frames allocated on the heap" << std::endl;
+            return EXIT_FAILURE;
+        }
     }
     catch (const std::exception& ex)
     {
@@ -0,0 +1,108 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <stb_image.h>
+
+#include <core/thread_pool.hpp>
+
+#include <data/codec/bc_encoder.hpp>
+#include <data/codec/ktx2.hpp>
+#include <data/codec/mip_chain.hpp>
+
+// offline block compression of PNG and JPEG files into KTX2 files the texture loader uploads as is
+// usage : texture_compressor input output.ktx2 [-bc1|-bc3|-bc4|-bc5|-bc7] [-fast|-normal|-high]
+//         [-linear] [-nomips]
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage : " << argv[0]
+                  << " input output.ktx2 [-bc1|-bc3|-bc4|-bc5|-bc7] [-fast|-normal|-high] [-linear]"
+                     " [-nomips]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    BCFormatE format = BCFormatE::BC7;
+    BCQualityE quality = BCQualityE::NORMAL;
+    bool bSRGB = true, bMips = true;
+    for (int i = 3; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-bc1")
+            format = BCFormatE::BC1;
+        else if (arg == "-bc3")
+            format = BCFormatE::BC3;
+        else if (arg == "-bc4")
+            format = BCFormatE::BC4;
+        else if (arg == "-bc5")
+            format = BCFormatE::BC5;
+        else if (arg == "-bc7")
+            format = BCFormatE::BC7;
+        else if (arg == "-fast")
+            quality = BCQualityE::FAST;
+        else if (arg == "-normal")
+            quality = BCQualityE::NORMAL;
+        else if (arg == "-high")
+            quality = BCQualityE::HIGH;
+        else if (arg == "-linear")
+            bSRGB = false;
+        else if (arg == "-nomips")
+            bMips = false;
+        else
+        {
+            std::cerr << "Invalid argument : " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* data = stbi_load(argv[1], &width, &height, &channels, 4);
+    if (!data)
+    {
+        std::cerr << "Failed to load " << argv[1] << " : " << stbi_failure_reason() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<uint8_t> pixels(data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(data);
+
+    const uint32_t levelCount = bMips ? getMipLevelCount(width, height) : 1U;
+    const std::vector<MipLevelT> levels = buildMipChain(pixels, width, height, levelCount);
+
+    ThreadPool threadPool(ThreadPoolCreateInfoT{});
+    BCEncoder encoder(BCEncoderCreateInfoT{
+        .quality = quality,
+        .threadPool = &threadPool,
+    });
+
+    Ktx2ImageT image = {
+        .format = getBCVkFormat(format, bSRGB),
+        .width = static_cast<uint32_t>(width),
+        .height = static_cast<uint32_t>(height),
+    };
+    for (const MipLevelT& level : levels)
+    {
+        auto& encoded = image.levels.emplace_back(
+            getBCEncodedSize(format, level.width, level.height));
+        encoder.encode(
+            BCSurfaceT{
+                .pixels = pixels.data() + level.offset,
+                .width = level.width,
+                .height = level.height,
+            },
+            format, encoded.data());
+    }
+
+    if (!writeKtx2(argv[2], image))
+        return EXIT_FAILURE;
+
+    const BCEncodeStatsT& stats = encoder.getStats();
+    std::cout << argv[2] << " : " << getBCFormatName(format) << ", " << width << "x" << height
+              << ", " << levelCount << " levels, "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(stats.duration).count()
+              << " ms on " << stats.threadCount << " threads ("
+              << stats.getMegapixelsPerSecondPerCore() << " MP/s per core)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include <cstdlib>
+#include <iostream>
+
+#include <core/allocation_tracker.hpp>
+
+#include "client/application.hpp"
+
+/**
+ * @brief frames rendered, the warm up and the loads included
+ *
+ */
+static constexpr uint64_t kFrameCount = 256U;
+
+// renders the scene past the warm up and fails if a steady state frame allocated on the heap
+int main()
+{
+    if (!AllocationTracker::isEnabled())
+    {
+        std::cerr << "built without ENABLE_ALLOCATION_TRACKING" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint64_t steadyFrameCount = 0U;
+    uint64_t allocatingFrameCount = 0U;
+    try
+    {
+        Application app(ApplicationCreateInfoT{.frameLimit = kFrameCount});
+        while (app.perFrame())
+        {
+            if (!app.isSteadyFrame())
+                continue;
+            ++steadyFrameCount;
+
+            // the counts of the frame stay until the next perFrame begins a new one
+            if (AllocationTracker::getFrameAllocationCount() > 0U)
+            {
+                ++allocatingFrameCount;
+                AllocationTracker::dumpFrame(std::cerr);
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (steadyFrameCount == 0U)
+    {
+        std::cerr << "no steady state frame within " << kFrameCount << " frames" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (allocatingFrameCount > 0U)
+    {
+        std::cerr << allocatingFrameCount << " of " << steadyFrameCount
+                  << " steady state frames allocated on the heap" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << steadyFrameCount << " steady state frames without heap allocation" << std::endl;
+    return EXIT_SUCCESS;
+}